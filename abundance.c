@@ -104,7 +104,7 @@ void readAbundance(Atmosphere *atmos)
     element->model = NULL;
   }
 
-  if ((fp_abund = fopen(input.abund_input, "r")) == NULL) {
+  if ((fp_abund = fopenInput(input.abund_input)) == NULL) {
     sprintf(messageStr,
 	    "Unable to open input file %s", input.abund_input);
     Error(ERROR_LEVEL_2, routineName, messageStr);
@@ -147,7 +147,7 @@ void readAbundance(Atmosphere *atmos)
   /* --- Open the data file with partition functions and first read the 
          temperature interpolation grid --             -------------- */
 
-  if ((fp_pf = fopen(input.pfData, "r")) == NULL) {
+  if ((fp_pf = fopenInput(input.pfData)) == NULL) {
     sprintf(messageStr,
 	    "Unable to open input file %s for partition function data",
 	    input.pfData);
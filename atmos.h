@@ -57,6 +57,7 @@ typedef struct {
   Atom     *H, *atoms, **activeatoms;
   Molecule *H2, *OH, *CH, *molecules, **activemols;
   RLK_Line *rlk_lines;
+  ZeemanMultiplet **rlk_zm;
   FILE   *fp_atmos;
   flags  *backgrflags;
 } Atmosphere;
@@ -77,9 +78,15 @@ flags passive_bb(double lambda, int nspect, int mu, bool_t to_obs,
 
 flags rlk_opacity(double lambda, int nspect, int mu, bool_t to_obs,
                   double *chi, double *eta, double *scatt, double *chip);
+void  initRLKProfiles(void);
+void  freeRLKProfiles(void);
 
 flags MolecularOpacity(double lambda, int nspect, int mu, bool_t to_obs,
 		       double *chi, double *eta, double *chip);
+void  initMolProfiles(void);
+void  freeMolProfiles(void);
+
+bool_t lineInReach(double lambda0, double qwing);
 
 
 /* --- Moleculear concentrations --                    -------------- */
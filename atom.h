@@ -34,6 +34,10 @@ enum fit_type    {KURUCZ_70, KURUCZ_85, SAUVAL_TATUM_84, IRWIN_81, TSUJI_73};
 enum Hund        {CASE_A, CASE_B};
 enum Barklemtype {SP, PD, DF};
 enum orbit_am    {S_ORBIT=0, P_ORBIT, D_ORBIT, F_ORBIT};
+enum colltype    {COLL_OMEGA, COLL_CE, COLL_CI, COLL_CP, COLL_CR, COLL_CH,
+		  COLL_CH0, COLL_CHP, COLL_SHULL82, COLL_BADNELL,
+		  COLL_AR85_CDI, COLL_AR85_CEA, COLL_AR85_CHP,
+		  COLL_AR85_CHH, COLL_BURGESS};
 
 /* --- Structure prototypes --                         -------------- */
 
@@ -68,7 +72,8 @@ struct AtomicLine {
 typedef struct {
   bool_t  hydrogenic;
   int     i, j, Nlambda, Nblue;
-  double  lambda0, *lambda, isotope_frac, alpha0, *alpha, *Rij, *Rji;
+  double  lambda0, *lambda, isotope_frac, alpha0, *alpha, *alpha_M2,
+         *Rij, *Rji;
   Atom *atom;
   pthread_mutex_t rate_lock;
 } AtomicContinuum;
@@ -94,6 +99,12 @@ typedef struct {
   Atom *atom;
 } FixedTransition;
 
+typedef struct {
+  enum   colltype type;
+  int    i, j, Nitem, Nrow;
+  double sumscl, *T, *coeff, *M2, **table;
+} CollisionData;
+
 struct AtomicTransition {
   enum type type;
   union {
@@ -112,7 +123,8 @@ struct MolTransition {
 };
 
 struct rhthread {
-  double **gij, **Vij, **wla, **chi_up, **chi_down, **Uji_down, *eta;
+  double **gij, **Vij, **wla, **chi_up, **chi_down, **Uji_down, *eta,
+         **slab;
 };
 
 struct Atom {
@@ -127,6 +139,8 @@ struct Atom {
   AtomicLine *line;
   AtomicContinuum *continuum;
   FixedTransition *ft;
+  int     Ncoll;
+  CollisionData *coll;
   struct Ng *Ng_n;
   rhthread *rhth;
   pthread_mutex_t Gamma_lock;
@@ -195,6 +209,7 @@ void   statEquil(Atom *atom, int isum);
 double updatePopulations(int niter);
 
 void CollisionRate(Atom *atom, FILE *atomFile);
+void freeCollisions(Atom *atom);
 double summers(int i, int j, double nne, Atom *atom);
 void Damping(AtomicLine *line, double *adamp);
 void FixedRate(Atom *atom);
@@ -229,6 +244,8 @@ void VanderWaals(AtomicLine *line, double *GvdW);
 void writeAtom(Atom *atom);
 void writePopulations(Atom *atom);
 void zeroRates(bool_t redistribute);
+void openGammaSlabs(void);
+void reduceGammaSlabs(void);
 
 bool_t readRadRate(Atom *atom);
 bool_t writeRadRate(Atom *atom);
@@ -276,6 +293,12 @@ void   PRDAngleScatter(AtomicLine *PRDline,
 		       enum Interpolation representation);
 void   PRDAngleApproxScatter(AtomicLine *PRDline,
 			     enum Interpolation representation);
+void   prdAllocWeights(AtomicLine *PRDline, AtomicLine **XRD,
+		       int Nsubordinate);
+void   prdRedistribute(AtomicLine *PRDline, AtomicLine **XRD,
+		       int Nsubordinate, enum Interpolation representation,
+		       bool_t initialize, double *Pj, double *adamp,
+		       double **Jnu);
 
 
 /* --- Polarization related --                         -------------- */
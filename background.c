@@ -124,8 +124,22 @@
 #define COMMENT_CHAR  "#"
 
 
+/* --- Column data shared by the wavelengths in Background -- ----- */
+
+typedef struct {
+  bool_t  do_fudge;
+  int     Nfudge;
+  long    backgrrecno;
+  double *thomson, *lambda_fudge, **fudge;
+  Atom   *He;
+  BackgroundScratch *scratch;
+} BackgroundWork;
+
+
 /* --- Function prototypes --                          -------------- */
 
+static void backgroundLambda(int nspect, void *argument);
+
 
 /* --- Global variables --                             -------------- */
 
@@ -140,18 +154,15 @@ extern char messageStr[];
 void Background(bool_t write_analyze_output, bool_t equilibria_only)
 {
   const char routineName[] = "Background";
-  register int k, nspect, n, mu, to_obs;
+  register int nspect, n;
 
   static int ne_iter = 0;
   char    inputLine[MAX_LINE_SIZE];
   bool_t  exit_on_EOF, do_fudge, fromscratch;
-  int     backgrrecno, index, Nfudge, NrecStokes;
-  double *chi, *eta, *scatt, wavelength, *thomson, *chi_ai, *eta_ai, *sca_ai,
-          Hmin_fudge, scatt_fudge, metal_fudge, *lambda_fudge, **fudge,
-         *Bnu, *chi_c, *eta_c, *sca_c, *chip, *chip_c;
-  Atom   *He;
+  int     Nfudge, Nscratch;
+  double *lambda_fudge = NULL, **fudge = NULL;
   FILE   *fp_fudge;
-  flags   backgrflags;
+  BackgroundWork bw;
 
   getCPU(2, TIME_START, NULL);
 
@@ -219,78 +230,25 @@ void Background(bool_t write_analyze_output, bool_t equilibria_only)
   } else
     do_fudge = FALSE;
 
-  /* --- Allocate temporary storage space. The quantities are used
-         for the following purposes:
-
-       - chi, eta, scatt: Get contributions to opacity, emissivity,
-         and scattering opacity, respectively, from a specific process
-         for a given wavelength and possibly angle.
-
-       - chi_c, eta_c, sca_c: Collect the total opacity, emissivity
-         and scattering opacity for a given wavelength and possibly
-         angle.
-
-       - chi_ai, eta_ai: Collect the angle-independent part of
-         opacity and emissivity for each wavelength so that these
-         need not be recalculated in an angle-dependent case.
-         When the atmosphere is not moving and has no magnetic fields
-         these just point to the total quantities chi_c and eta_c.
-
-   Note: In case of magnetic fields in the atmosphere chi, eta and
-         chip, and chi_c, eta_c and chip_c contain all four Stokes
-         parameters, and should be allocated a 4 and 3 times larger
-         storage space, respectively.
-         --                                            -------------- */
-
-  if (atmos.Stokes)
-    NrecStokes = 4;
-  else
-    NrecStokes = 1;
-
-  chi_c = (double *) malloc(NrecStokes*atmos.Nspace * sizeof(double));
-  eta_c = (double *) malloc(NrecStokes*atmos.Nspace * sizeof(double));
-  sca_c = (double *) malloc(atmos.Nspace * sizeof(double));
-
-  chi   = (double *) malloc(NrecStokes*atmos.Nspace * sizeof(double));
-  eta   = (double *) malloc(NrecStokes*atmos.Nspace * sizeof(double));
-  scatt = (double *) malloc(atmos.Nspace * sizeof(double));
-
-  if (atmos.Stokes && input.magneto_optical) {
-    chip   = (double *) malloc(3*atmos.Nspace * sizeof(double));
-    chip_c = (double *) malloc(3*atmos.Nspace * sizeof(double));
-  } else {
-    chip   = NULL;
-    chip_c = NULL;
-  }
+  /* --- Scratch space, one set for each thread (see
+         allocBackgroundScratch) --                    -------------- */
 
-  if (atmos.moving || atmos.Stokes) {
-    chi_ai = (double *) malloc(atmos.Nspace * sizeof(double));
-    eta_ai = (double *) malloc(atmos.Nspace * sizeof(double));
-    sca_ai = (double *) malloc(atmos.Nspace * sizeof(double));
-  } else {
-    chi_ai = chi_c;
-    eta_ai = eta_c;
-    sca_ai = sca_c;
-  }
-  Bnu = (double *) malloc(atmos.Nspace * sizeof(double));
+  Nscratch   = MAX(input.Nthreads, 1);
+  bw.scratch = allocBackgroundScratch(Nscratch);
 
   /* --- Thomson scattering by free electrons is wavelength independent
          in non-relativistic limit so we compute it only once -- ---- */
 
-  thomson = (double *) malloc(atmos.Nspace * sizeof(double));
-  Thomson(thomson);
+  bw.thomson = (double *) malloc(atmos.Nspace * sizeof(double));
+  Thomson(bw.thomson);
 
   /* --- Check whether an atomic model is present for He -- --------- */
 
-  He = (atmos.elements[1].model) ? atmos.elements[1].model : NULL;
+  bw.He = (atmos.elements[1].model) ? atmos.elements[1].model : NULL;
 
   /* --- Read background files from Kurucz data file -- ------------- */
 
-  atmos.Nrlk = 0;
-  readKuruczLines(input.KuruczData);
-  if (atmos.Nrlk > 0) {
-    qsort(atmos.rlk_lines, atmos.Nrlk, sizeof(RLK_Line), rlk_ascend);
-  }
+  loadKuruczLines(TRUE);
   /* --- Allocate memory for the boolean array that stores whether
          a wavelength overlaps with a Bound-Bound transition in the
          background, or whether it is polarized --     -------------- */
@@ -304,7 +262,7 @@ void Background(bool_t write_analyze_output, bool_t equilibria_only)
          for each wavelength where to find the background opacity,
          scattering opacity, and emissivity --         -------------- */
 
-  backgrrecno = 0;
+  bw.backgrrecno = 0;
 
   if (atmos.moving || atmos.Stokes) {
     atmos.backgrrecno =
@@ -321,373 +279,525 @@ void Background(bool_t write_analyze_output, bool_t equilibria_only)
 	    input.background_File);
     Error(ERROR_LEVEL_2, routineName, messageStr);
   }
+  /* --- Doppler widths and damping parameters of the background
+         lines within reach of the wavelength grid --  -------------- */
+
+  initRLKProfiles();
+  initMolProfiles();
+  resetPassiveLists();
 
   /* --- Go through the spectrum and add the different opacity and
-         emissivity contributions. This is the main loop --  -------- */
+         emissivity contributions. This is the main loop. With
+         input.Nthreads > 1 the wavelengths are shared out over the
+         thread pool. --                               -------------- */
 
-  for (nspect = 0;  nspect < spectrum.Nspect;  nspect++) {
-    wavelength = spectrum.lambda[nspect];
+  bw.do_fudge     = do_fudge;
+  bw.Nfudge       = Nfudge;
+  bw.lambda_fudge = lambda_fudge;
+  bw.fudge        = fudge;
 
-    /* --- The Planck function at this wavelength --   -------------- */
+  if (input.Nthreads > 1) {
 
-    Planck(atmos.Nspace, atmos.T, wavelength, Bnu);
+    /* --- The free-free routines set up their temperature indices
+           for the atmosphere at the first call, not concurrently -- */
 
-    /* --- Initialize the flags for this wavelength -- -------------- */
+    Hminus_ff(spectrum.lambda[0], bw.scratch[0].chi);
+    H2minus_ff(spectrum.lambda[0], bw.scratch[0].chi);
+    H2plus_ff(spectrum.lambda[0], bw.scratch[0].chi);
 
-    atmos.backgrflags[nspect].hasline     = FALSE;
-    atmos.backgrflags[nspect].ispolarized = FALSE;
+    runThreadPool(spectrum.Nspect, backgroundLambda, &bw);
+  } else {
+    for (nspect = 0;  nspect < spectrum.Nspect;  nspect++)
+      backgroundLambda(nspect, &bw);
+  }
 
-    /* --- Initialize angle-independent quantities --  -------------- */
+  if (write_analyze_output) {
+    /* --- Write background record structure --          ------------ */
 
-    for (k = 0;  k < atmos.Nspace;  k++) {
-      chi_ai[k] = 0.0;
-      eta_ai[k] = 0.0;
-      sca_ai[k] = thomson[k];
-    }
-    /* --- Negative hydrogen ion, bound-free and free-free -- ------- */
+    writeBRS();
 
-    if (Hminus_bf(wavelength, chi, eta)) {
-      for (k = 0;  k < atmos.Nspace;  k++) {
-	chi_ai[k] += chi[k];
-	eta_ai[k] += eta[k];
-      }
-    }
-    if (Hminus_ff(wavelength, chi)) {
-      for (k = 0;  k < atmos.Nspace;  k++) {
-	chi_ai[k] += chi[k];
-	eta_ai[k] += chi[k] * Bnu[k];
-      }
-    }
-    /* --- Opacity fudge factors, applied to Hminus opacity -- ------ */
+    /* --- Write out the metals and molecules --         ------------ */
 
-    if (do_fudge) {
-      Linear(Nfudge, lambda_fudge, fudge[0],
-	     1, &wavelength, &Hmin_fudge, FALSE);
-      for (k = 0;  k < atmos.Nspace;  k++) {
-	chi_ai[k] *= Hmin_fudge;
-	eta_ai[k] *= Hmin_fudge;
-      }
-    }
-    /* --- Opacities from bound-free transitions in OH and CH -- ---- */
+    writeMetals("metals.out");
+    writeMolecules(MOLECULAR_CONCENTRATION_FILE);
+  }
+  /* --- Clean up but keep H, H2, and active atom and/or molecule
+         if appropriate --                               ------------ */
 
-    if (OH_bf_opac(wavelength, chi, eta)) {
-      for (k = 0;  k < atmos.Nspace;  k++) {
-	chi_ai[k] += chi[k];
-	eta_ai[k] += eta[k];
-      }
-    }
-    if (CH_bf_opac(wavelength, chi, eta)) {
-      for (k = 0;  k < atmos.Nspace;  k++) {
-	chi_ai[k] += chi[k];
-	eta_ai[k] += eta[k];
-      }
+  if (atmos.Natom > 1) {
+    for (n = 1;  n < atmos.Natom;  n++)
+      if (!atmos.atoms[n].active  &&
+          !atmos.hydrostatic  &&
+	  input.solve_ne < ITERATION)
+	freeAtom(&atmos.atoms[n]);
+  }
+  if (atmos.Nmolecule > 1) {
+    for (n = 1;  n < atmos.Nmolecule;  n++)
+      if (!atmos.molecules[n].active  &&
+          !atmos.hydrostatic  &&
+	  input.solve_ne < ITERATION)
+	freeMolecule(&atmos.molecules[n]);
+  }
+
+  if (strcmp(input.KuruczData, "none")) {
+    free(atmos.Tpf);  atmos.Tpf = NULL;
+    for (n = 0;  n < atmos.Nelem;  n++) {
+      free(atmos.elements[n].ionpot);
+      freeMatrix((void **) atmos.elements[n].pf);
+      if (atmos.elements[n].n)
+	freeMatrix((void **) atmos.elements[n].n);
     }
-    /* --- Neutral Hydrogen Bound-Free and Free-Free --  ------------ */
+  }
+  getCPU(3, TIME_POLL, "Background Opacity");
 
-    if (Hydrogen_bf(wavelength, chi, eta)) {
-      for (k = 0;  k < atmos.Nspace;  k++) {
-	chi_ai[k] += chi[k];
-	eta_ai[k] += eta[k];
-      }
+  /* --- Free the temporary space allocated in the ff routines -- --- */
+
+  Hminus_ff(0.0, NULL);
+  H2minus_ff(0.0, NULL);
+  H2plus_ff(0.0, NULL);
+
+  freeRLKProfiles();
+  freeMolProfiles();
+
+  freeBackgroundScratch(Nscratch, bw.scratch);
+  free(bw.thomson);
+
+  if (do_fudge) {
+    free(lambda_fudge);
+    freeMatrix((void **) fudge);
+  }
+  getCPU(2, TIME_POLL, "Total Background");
+}
+/* ------- end ---------------------------- Background.c ------------ */
+
+/* ------- begin -------------------------- backgroundLambda.c ------ */
+
+static void backgroundLambda(int nspect, void *argument)
+{
+  register int k, mu, to_obs;
+
+  BackgroundWork *bw = (BackgroundWork *) argument;
+  BackgroundScratch *bs = &bw->scratch[threadSlot()];
+
+  bool_t  do_fudge = bw->do_fudge;
+  int     index, first, Nfudge = bw->Nfudge, NrecStokes = 1;
+  long    recno;
+  double  wavelength, Hmin_fudge, scatt_fudge, metal_fudge,
+         *lambda_fudge = bw->lambda_fudge, **fudge = bw->fudge,
+         *thomson = bw->thomson,
+         *chi = bs->chi, *eta = bs->eta, *scatt = bs->scatt,
+         *Bnu = bs->Bnu, *chip = bs->chip, *chi_c = bs->chi_c,
+         *eta_c = bs->eta_c, *sca_c = bs->sca_c, *chip_c = bs->chip_c,
+         *chi_ai = bs->chi_ai, *eta_ai = bs->eta_ai, *sca_ai = bs->sca_ai;
+  Atom   *He = bw->He;
+  flags   backgrflags;
+
+  /* --- Adds all background contributions at wavelength nspect and
+         writes them to file. Runs in the scratch space of the calling
+         thread, so that wavelengths may be done concurrently. Records
+         are taken off bw->backgrrecno as they are written, so that
+         each wavelength gets its own. --              -------------- */
+
+  wavelength = spectrum.lambda[nspect];
+
+  /* --- The Planck function at this wavelength --   -------------- */
+
+  Planck(atmos.Nspace, atmos.T, wavelength, Bnu);
+
+  /* --- Initialize the flags for this wavelength -- -------------- */
+
+  atmos.backgrflags[nspect].hasline     = FALSE;
+  atmos.backgrflags[nspect].ispolarized = FALSE;
+
+  /* --- Initialize angle-independent quantities --  -------------- */
+
+  for (k = 0;  k < atmos.Nspace;  k++) {
+    chi_ai[k] = 0.0;
+    eta_ai[k] = 0.0;
+    sca_ai[k] = thomson[k];
+  }
+  /* --- Negative hydrogen ion, bound-free and free-free -- ------- */
+
+  if (Hminus_bf(wavelength, chi, eta)) {
+    for (k = 0;  k < atmos.Nspace;  k++) {
+      chi_ai[k] += chi[k];
+      eta_ai[k] += eta[k];
     }
-    Hydrogen_ff(wavelength, chi);
+  }
+  if (Hminus_ff(wavelength, chi)) {
     for (k = 0;  k < atmos.Nspace;  k++) {
       chi_ai[k] += chi[k];
       eta_ai[k] += chi[k] * Bnu[k];
     }
-    /* --- Rayleigh scattering by neutral hydrogen --  -------------- */
+  }
+  /* --- Opacity fudge factors, applied to Hminus opacity -- ------ */
 
-    if (Rayleigh(wavelength, atmos.H, scatt)) {
-      for (k = 0;  k < atmos.Nspace;  k++) {
-	sca_ai[k]  += scatt[k];
-      }
+  if (do_fudge) {
+    Linear(Nfudge, lambda_fudge, fudge[0],
+	   1, &wavelength, &Hmin_fudge, FALSE);
+    for (k = 0;  k < atmos.Nspace;  k++) {
+      chi_ai[k] *= Hmin_fudge;
+      eta_ai[k] *= Hmin_fudge;
     }
-    /* --- Rayleigh scattering by neutral helium --    -------------- */
+  }
+  /* --- Opacities from bound-free transitions in OH and CH -- ---- */
 
-    if (He && Rayleigh(wavelength, He, scatt)) {
-      for (k = 0;  k < atmos.Nspace;  k++) {
-	sca_ai[k]  += scatt[k];
-      }
+  if (OH_bf_opac(wavelength, chi, eta)) {
+    for (k = 0;  k < atmos.Nspace;  k++) {
+      chi_ai[k] += chi[k];
+      eta_ai[k] += eta[k];
     }
-    /* --- Absorption by H + H^+ (referred to as H2plus free-free) -- */
-
-    if (H2plus_ff(wavelength, chi)) {
-      for (k = 0;  k < atmos.Nspace;  k++) {
-	chi_ai[k] += chi[k];
-	eta_ai[k] += chi[k] * Bnu[k];
-      }
+  }
+  if (CH_bf_opac(wavelength, chi, eta)) {
+    for (k = 0;  k < atmos.Nspace;  k++) {
+      chi_ai[k] += chi[k];
+      eta_ai[k] += eta[k];
     }
-    /* --- Rayleigh scattering and free-free absorption by
-           molecular hydrogen --                       -------------- */
+  }
+  /* --- Neutral Hydrogen Bound-Free and Free-Free --  ------------ */
 
-    if (Rayleigh_H2(wavelength, scatt)) {
-      for (k = 0;  k < atmos.Nspace;  k++) {
-	sca_ai[k]  += scatt[k];
-      }
+  if (Hydrogen_bf(wavelength, chi, eta)) {
+    for (k = 0;  k < atmos.Nspace;  k++) {
+      chi_ai[k] += chi[k];
+      eta_ai[k] += eta[k];
     }
-    if (H2minus_ff(wavelength, chi)) {
-      for (k = 0;  k < atmos.Nspace;  k++) {
-	chi_ai[k] += chi[k];
-	eta_ai[k] += chi[k] * Bnu[k];
-      }
+  }
+  Hydrogen_ff(wavelength, chi);
+  for (k = 0;  k < atmos.Nspace;  k++) {
+    chi_ai[k] += chi[k];
+    eta_ai[k] += chi[k] * Bnu[k];
+  }
+  /* --- Rayleigh scattering by neutral hydrogen --  -------------- */
+
+  if (Rayleigh(wavelength, atmos.H, scatt)) {
+    for (k = 0;  k < atmos.Nspace;  k++) {
+      sca_ai[k]  += scatt[k];
     }
-    /* --- Bound-Free opacities due to ``metals'' --   -------------- */
+  }
+  /* --- Rayleigh scattering by neutral helium --    -------------- */
 
-    if (do_fudge) {
-      Linear(Nfudge, lambda_fudge, fudge[2],
-	     1, &wavelength, &metal_fudge, FALSE);
-    } else {
-      metal_fudge = 1.0;
+  if (He && Rayleigh(wavelength, He, scatt)) {
+    for (k = 0;  k < atmos.Nspace;  k++) {
+      sca_ai[k]  += scatt[k];
     }
-    /* --- Note: Hydrogen bound-free opacities are calculated in
-           routine Hydrogen_bf --                      -------------- */
+  }
+  /* --- Absorption by H + H^+ (referred to as H2plus free-free) -- */
 
-    Metal_bf(wavelength, atmos.Natom-1, atmos.atoms+1, chi, eta);
+  if (H2plus_ff(wavelength, chi)) {
     for (k = 0;  k < atmos.Nspace;  k++) {
-      chi_ai[k] += chi[k] * metal_fudge;
-      eta_ai[k] += eta[k] * metal_fudge;
+      chi_ai[k] += chi[k];
+      eta_ai[k] += chi[k] * Bnu[k];
     }
-    /* --- Add the scattering opacity to the absorption part to store
-           the total opacity --                        -------------- */
+  }
+  /* --- Rayleigh scattering and free-free absorption by
+	 molecular hydrogen --                       -------------- */
 
-    if (do_fudge) {
-      Linear(Nfudge, lambda_fudge, fudge[1],
-	     1, &wavelength, &scatt_fudge, FALSE);
-    } else {
-      scatt_fudge = 1.0;
+  if (Rayleigh_H2(wavelength, scatt)) {
+    for (k = 0;  k < atmos.Nspace;  k++) {
+      sca_ai[k]  += scatt[k];
     }
+  }
+  if (H2minus_ff(wavelength, chi)) {
     for (k = 0;  k < atmos.Nspace;  k++) {
-      sca_ai[k] *= scatt_fudge;
-      chi_ai[k] += sca_ai[k];
+      chi_ai[k] += chi[k];
+      eta_ai[k] += chi[k] * Bnu[k];
     }
-    /* --- Now the contributions that may be angle-dependent due to the
-           presence of atomic or molecular lines --    -------------- */
+  }
+  /* --- Bound-Free opacities due to ``metals'' --   -------------- */
 
-    if (atmos.moving || atmos.Stokes) {
-      for (mu = 0;  mu < atmos.Nrays;  mu++) {
-        for (to_obs = 0;  to_obs <= 1;  to_obs++) {
-	  index = 2*(nspect*atmos.Nrays + mu) + to_obs;
+  if (do_fudge) {
+    Linear(Nfudge, lambda_fudge, fudge[2],
+	   1, &wavelength, &metal_fudge, FALSE);
+  } else {
+    metal_fudge = 1.0;
+  }
+  /* --- Note: Hydrogen bound-free opacities are calculated in
+	 routine Hydrogen_bf --                      -------------- */
 
-          /* --- First, copy the angle-independent parts -- --------- */
+  Metal_bf(wavelength, atmos.Natom-1, atmos.atoms+1, chi, eta);
+  for (k = 0;  k < atmos.Nspace;  k++) {
+    chi_ai[k] += chi[k] * metal_fudge;
+    eta_ai[k] += eta[k] * metal_fudge;
+  }
+  /* --- Add the scattering opacity to the absorption part to store
+	 the total opacity --                        -------------- */
 
-	  for (k = 0;  k < atmos.Nspace;  k++) {
-	    chi_c[k] = chi_ai[k];
-	    eta_c[k] = eta_ai[k];
-            sca_c[k] = sca_ai[k];
-	  }
+  if (do_fudge) {
+    Linear(Nfudge, lambda_fudge, fudge[1],
+	   1, &wavelength, &scatt_fudge, FALSE);
+  } else {
+    scatt_fudge = 1.0;
+  }
+  for (k = 0;  k < atmos.Nspace;  k++) {
+    sca_ai[k] *= scatt_fudge;
+    chi_ai[k] += sca_ai[k];
+  }
+  /* --- Now the contributions that may be angle-dependent due to the
+	 presence of atomic or molecular lines --    -------------- */
 
-          /* --- Zero the polarized quantities, if necessary -- ----- */
+  if (atmos.moving || atmos.Stokes) {
+    first = 2*nspect*atmos.Nrays;
+    for (mu = 0;  mu < atmos.Nrays;  mu++) {
+      for (to_obs = 0;  to_obs <= 1;  to_obs++) {
+	index = 2*(nspect*atmos.Nrays + mu) + to_obs;
 
-	  if (atmos.Stokes) {
-           for (k = atmos.Nspace;  k < 4*atmos.Nspace;  k++) {
-              chi_c[k] = 0.0;
-              eta_c[k] = 0.0;
-            }
-            if (input.magneto_optical)
-              for (k = 0;  k < 3*atmos.Nspace;  k++) chip_c[k] = 0.0;
-	  }
-          /* --- Add opacity from passive atomic lines (including
-                 hydrogen) --                          -------------- */
-
-	  if (input.allow_passive_bb) {
-	    backgrflags = passive_bb(wavelength, nspect, mu, to_obs,
-				     chi, eta, chip);
-	    if (backgrflags.hasline) {
-	      atmos.backgrflags[nspect].hasline = TRUE;
-	      if (backgrflags.ispolarized) {
-                NrecStokes = 4;
-                atmos.backgrflags[nspect].ispolarized = TRUE;
-		if (input.magneto_optical) {
-                  for (k = 0;  k < 3*atmos.Nspace;  k++)
-                    chip_c[k] += chip[k];
-                }
-              } else
-                NrecStokes = 1;
-
-              for (k = 0;  k < NrecStokes*atmos.Nspace;  k++) {
-                chi_c[k] += chi[k];
-                eta_c[k] += eta[k];
-              }
+	/* --- First, copy the angle-independent parts -- --------- */
 
-	    }
+	for (k = 0;  k < atmos.Nspace;  k++) {
+	  chi_c[k] = chi_ai[k];
+	  eta_c[k] = eta_ai[k];
+	  sca_c[k] = sca_ai[k];
+	}
+
+	/* --- Zero the polarized quantities, if necessary -- ----- */
+
+	if (atmos.Stokes) {
+	 for (k = atmos.Nspace;  k < 4*atmos.Nspace;  k++) {
+	    chi_c[k] = 0.0;
+	    eta_c[k] = 0.0;
 	  }
-          /* --- Add opacity from Kurucz line list --  -------------- */
-
-          if (atmos.Nrlk > 0) {
-	    backgrflags = rlk_opacity(wavelength, nspect, mu, to_obs,
-				      chi, eta, scatt, chip);
-	    if (backgrflags.hasline) {
-	      atmos.backgrflags[nspect].hasline = TRUE;
-              if (backgrflags.ispolarized) {
-                NrecStokes = 4;
-                atmos.backgrflags[nspect].ispolarized = TRUE;
-                if (input.magneto_optical) {
-                  for (k = 0;  k < 3*atmos.Nspace;  k++)
-                    chip_c[k] += chip[k];
-                }
-              } else
-                NrecStokes = 1;
-
-              for (k = 0;  k < NrecStokes*atmos.Nspace;  k++) {
-                chi_c[k] += chi[k];
-                eta_c[k] += eta[k];
-              }
-	      if (input.rlkscatter) {
-		for (k = 0;  k < atmos.Nspace;  k++) {
-		  sca_c[k] += scatt[k];
-		  chi_c[k] += scatt[k];
-		}
+	  if (input.magneto_optical)
+	    for (k = 0;  k < 3*atmos.Nspace;  k++) chip_c[k] = 0.0;
+	}
+	/* --- Add opacity from passive atomic lines (including
+	       hydrogen) --                          -------------- */
+
+	if (input.allow_passive_bb) {
+	  backgrflags = passive_bb(wavelength, nspect, mu, to_obs,
+				   chi, eta, chip);
+	  if (backgrflags.hasline) {
+	    atmos.backgrflags[nspect].hasline = TRUE;
+	    if (backgrflags.ispolarized) {
+	      NrecStokes = 4;
+	      atmos.backgrflags[nspect].ispolarized = TRUE;
+	      if (input.magneto_optical) {
+		for (k = 0;  k < 3*atmos.Nspace;  k++)
+		  chip_c[k] += chip[k];
 	      }
+	    } else
+	      NrecStokes = 1;
+
+	    for (k = 0;  k < NrecStokes*atmos.Nspace;  k++) {
+	      chi_c[k] += chi[k];
+	      eta_c[k] += eta[k];
 	    }
+
 	  }
-	  /* --- Add opacity from molecular lines --   -------------- */
+	}
+	/* --- Add opacity from Kurucz line list --  -------------- */
 
-	  backgrflags = MolecularOpacity(wavelength, nspect, mu, to_obs,
-					 chi, eta, chip);
+	if (atmos.Nrlk > 0) {
+	  backgrflags = rlk_opacity(wavelength, nspect, mu, to_obs,
+				    chi, eta, scatt, chip);
 	  if (backgrflags.hasline) {
 	    atmos.backgrflags[nspect].hasline = TRUE;
-            if (backgrflags.ispolarized) {
-              NrecStokes = 4;
-              atmos.backgrflags[nspect].ispolarized = TRUE;
-              if (input.magneto_optical) {
-                for (k = 0;  k < 3*atmos.Nspace;  k++)
-                  chip_c[k] += chip[k];
-              }
-            } else
-              NrecStokes = 1;
-
-            for (k = 0;  k < NrecStokes*atmos.Nspace;  k++) {
-              chi_c[k] += chi[k];
-              eta_c[k] += eta[k];
-            }
-	  }
-	  /* --- Store angle-dependent results only if at least one
-                 line was found at this wavelength --  -------------- */
-
-	  atmos.backgrrecno[index] = backgrrecno;
-	  if ((mu == atmos.Nrays-1 && to_obs) ||
-	      (atmos.backgrflags[nspect].hasline &&
-	       (atmos.moving || atmos.backgrflags[nspect].ispolarized))) {
-	    backgrrecno += writeBackground(nspect, mu, to_obs,
-					   chi_c, eta_c, sca_c, chip_c);
+	    if (backgrflags.ispolarized) {
+	      NrecStokes = 4;
+	      atmos.backgrflags[nspect].ispolarized = TRUE;
+	      if (input.magneto_optical) {
+		for (k = 0;  k < 3*atmos.Nspace;  k++)
+		  chip_c[k] += chip[k];
+	      }
+	    } else
+	      NrecStokes = 1;
+
+	    for (k = 0;  k < NrecStokes*atmos.Nspace;  k++) {
+	      chi_c[k] += chi[k];
+	      eta_c[k] += eta[k];
+	    }
+	    if (input.rlkscatter) {
+	      for (k = 0;  k < atmos.Nspace;  k++) {
+		sca_c[k] += scatt[k];
+		chi_c[k] += scatt[k];
+	      }
+	    }
 	  }
 	}
-      }
-    } else {
-      /* --- Angle-independent case. First, add opacity from passive
-	     atomic lines (including hydrogen) --      -------------- */
+	/* --- Add opacity from molecular lines --   -------------- */
 
-      if (input.allow_passive_bb) {
-	backgrflags = passive_bb(wavelength, nspect, 0, TRUE,
-				 chi, eta, NULL);
+	backgrflags = MolecularOpacity(wavelength, nspect, mu, to_obs,
+				       chi, eta, chip);
 	if (backgrflags.hasline) {
 	  atmos.backgrflags[nspect].hasline = TRUE;
-	  for (k = 0;  k < atmos.Nspace;  k++) {
+	  if (backgrflags.ispolarized) {
+	    NrecStokes = 4;
+	    atmos.backgrflags[nspect].ispolarized = TRUE;
+	    if (input.magneto_optical) {
+	      for (k = 0;  k < 3*atmos.Nspace;  k++)
+		chip_c[k] += chip[k];
+	    }
+	  } else
+	    NrecStokes = 1;
+
+	  for (k = 0;  k < NrecStokes*atmos.Nspace;  k++) {
 	    chi_c[k] += chi[k];
 	    eta_c[k] += eta[k];
 	  }
 	}
+	/* --- Store angle-dependent results only if at least one
+	       line was found at this wavelength --  -------------- */
+
+	if ((mu == atmos.Nrays-1 && to_obs) ||
+	    (atmos.backgrflags[nspect].hasline &&
+	     (atmos.moving || atmos.backgrflags[nspect].ispolarized))) {
+
+	  /* --- Angles not stored use the next record written -- --- */
+
+	  recno = __sync_fetch_and_add(&bw->backgrrecno,
+				       backgroundRecords(nspect));
+	  for ( ;  first <= index;  first++)
+	    atmos.backgrrecno[first] = recno;
+	  writeBackground(nspect, mu, to_obs, chi_c, eta_c, sca_c, chip_c);
+	}
       }
-      /* --- Add opacity from Kurucz line list --      -------------- */
+    }
+  } else {
+    /* --- Angle-independent case. First, add opacity from passive
+	   atomic lines (including hydrogen) --      -------------- */
 
-      if (atmos.Nrlk > 0) {
-	backgrflags = rlk_opacity(wavelength, nspect, 0, TRUE,
-				  chi, eta, scatt, NULL);
-	if (backgrflags.hasline) {
-	  atmos.backgrflags[nspect].hasline = TRUE;
-	  for (k = 0;  k < atmos.Nspace;  k++) {
-	    chi_c[k] += chi[k];
-	    eta_c[k] += eta[k];
-	  }
-	  if (input.rlkscatter) {
-	    for (k = 0;  k < atmos.Nspace;  k++) {
-	      sca_c[k] += scatt[k];
-	      chi_c[k] += scatt[k];
-	    }
-	  }
+    if (input.allow_passive_bb) {
+      backgrflags = passive_bb(wavelength, nspect, 0, TRUE,
+			       chi, eta, NULL);
+      if (backgrflags.hasline) {
+	atmos.backgrflags[nspect].hasline = TRUE;
+	for (k = 0;  k < atmos.Nspace;  k++) {
+	  chi_c[k] += chi[k];
+	  eta_c[k] += eta[k];
 	}
       }
-      /* --- Add opacity from molecular lines --       -------------- */
+    }
+    /* --- Add opacity from Kurucz line list --      -------------- */
 
-      backgrflags = MolecularOpacity(wavelength, nspect, 0, TRUE,
-				     chi, eta, NULL);
+    if (atmos.Nrlk > 0) {
+      backgrflags = rlk_opacity(wavelength, nspect, 0, TRUE,
+				chi, eta, scatt, NULL);
       if (backgrflags.hasline) {
 	atmos.backgrflags[nspect].hasline = TRUE;
 	for (k = 0;  k < atmos.Nspace;  k++) {
 	  chi_c[k] += chi[k];
 	  eta_c[k] += eta[k];
 	}
+	if (input.rlkscatter) {
+	  for (k = 0;  k < atmos.Nspace;  k++) {
+	    sca_c[k] += scatt[k];
+	    chi_c[k] += scatt[k];
+	  }
+	}
       }
-      /* --- Store results --                          -------------- */
+    }
+    /* --- Add opacity from molecular lines --       -------------- */
 
-      atmos.backgrrecno[nspect] = backgrrecno;
-      backgrrecno += writeBackground(nspect, 0, 0,
-				     chi_c, eta_c, sca_c, NULL);
+    backgrflags = MolecularOpacity(wavelength, nspect, 0, TRUE,
+				   chi, eta, NULL);
+    if (backgrflags.hasline) {
+      atmos.backgrflags[nspect].hasline = TRUE;
+      for (k = 0;  k < atmos.Nspace;  k++) {
+	chi_c[k] += chi[k];
+	eta_c[k] += eta[k];
+      }
     }
+    /* --- Store results --                          -------------- */
+
+    atmos.backgrrecno[nspect] =
+      __sync_fetch_and_add(&bw->backgrrecno, backgroundRecords(nspect));
+    writeBackground(nspect, 0, 0, chi_c, eta_c, sca_c, NULL);
   }
+}
+/* ------- end ---------------------------- backgroundLambda.c ------ */
 
-  if (write_analyze_output) {
-    /* --- Write background record structure --          ------------ */
+/* ------- begin -------------------------- allocBackgroundScratch.c  */
 
-    writeBRS();
+BackgroundScratch *allocBackgroundScratch(int Nscratch)
+{
+  register int n;
 
-    /* --- Write out the metals and molecules --         ------------ */
+  int NrecStokes;
+  BackgroundScratch *bs;
 
-    writeMetals("metals.out");
-    writeMolecules(MOLECULAR_CONCENTRATION_FILE);
-  }
-  /* --- Clean up but keep H, H2, and active atom and/or molecule
-         if appropriate --                               ------------ */
+  /* --- Allocates Nscratch sets of temporary storage space, one for
+         each thread that computes background opacities. The
+         quantities are used for the following purposes:
 
-  if (atmos.Natom > 1) {
-    for (n = 1;  n < atmos.Natom;  n++)
-      if (!atmos.atoms[n].active  &&
-          !atmos.hydrostatic  &&
-	  input.solve_ne < ITERATION)
-	freeAtom(&atmos.atoms[n]);
-  }
-  if (atmos.Nmolecule > 1) {
-    for (n = 1;  n < atmos.Nmolecule;  n++)
-      if (!atmos.molecules[n].active  &&
-          !atmos.hydrostatic  &&
-	  input.solve_ne < ITERATION)
-	freeMolecule(&atmos.molecules[n]);
-  }
+       - chi, eta, scatt: Get contributions to opacity, emissivity,
+         and scattering opacity, respectively, from a specific process
+         for a given wavelength and possibly angle.
 
-  if (strcmp(input.KuruczData, "none")) {
-    free(atmos.Tpf);  atmos.Tpf = NULL;
-    for (n = 0;  n < atmos.Nelem;  n++) {
-      free(atmos.elements[n].ionpot);
-      freeMatrix((void **) atmos.elements[n].pf);
-      if (atmos.elements[n].n)
-	freeMatrix((void **) atmos.elements[n].n);
-    }
-  }
-  getCPU(3, TIME_POLL, "Background Opacity");
+       - chi_c, eta_c, sca_c: Collect the total opacity, emissivity
+         and scattering opacity for a given wavelength and possibly
+         angle.
 
-  /* --- Free the temporary space allocated in the ff routines -- --- */
+       - chi_ai, eta_ai: Collect the angle-independent part of
+         opacity and emissivity for each wavelength so that these
+         need not be recalculated in an angle-dependent case.
+         When the atmosphere is not moving and has no magnetic fields
+         these just point to the total quantities chi_c and eta_c.
 
-  Hminus_ff(0.0, NULL);
-  H2minus_ff(0.0, NULL);
-  H2plus_ff(0.0, NULL);
+   Note: In case of magnetic fields in the atmosphere chi, eta and
+         chip, and chi_c, eta_c and chip_c contain all four Stokes
+         parameters, and should be allocated a 4 and 3 times larger
+         storage space, respectively.
+         --                                            -------------- */
+
+  if (atmos.Stokes)
+    NrecStokes = 4;
+  else
+    NrecStokes = 1;
 
-  free(chi);    free(eta);  free(scatt);  free(Bnu);  free(thomson);
-  free(chi_c);  free(eta_c);  free(sca_c);
+  bs = (BackgroundScratch *) malloc(Nscratch * sizeof(BackgroundScratch));
 
-  if (atmos.moving || atmos.Stokes) {
-    free(chi_ai);
-    free(eta_ai);
-    free(sca_ai);
-  }
-  if (atmos.Stokes && input.magneto_optical) {
-    free(chip);
-    free(chip_c);
+  for (n = 0;  n < Nscratch;  n++) {
+    bs[n].chi_c = (double *) malloc(NrecStokes*atmos.Nspace * sizeof(double));
+    bs[n].eta_c = (double *) malloc(NrecStokes*atmos.Nspace * sizeof(double));
+    bs[n].sca_c = (double *) malloc(atmos.Nspace * sizeof(double));
+
+    bs[n].chi   = (double *) malloc(NrecStokes*atmos.Nspace * sizeof(double));
+    bs[n].eta   = (double *) malloc(NrecStokes*atmos.Nspace * sizeof(double));
+    bs[n].scatt = (double *) malloc(atmos.Nspace * sizeof(double));
+
+    if (atmos.Stokes && input.magneto_optical) {
+      bs[n].chip   = (double *) malloc(3*atmos.Nspace * sizeof(double));
+      bs[n].chip_c = (double *) malloc(3*atmos.Nspace * sizeof(double));
+    } else {
+      bs[n].chip   = NULL;
+      bs[n].chip_c = NULL;
+    }
+
+    if (atmos.moving || atmos.Stokes) {
+      bs[n].chi_ai = (double *) malloc(atmos.Nspace * sizeof(double));
+      bs[n].eta_ai = (double *) malloc(atmos.Nspace * sizeof(double));
+      bs[n].sca_ai = (double *) malloc(atmos.Nspace * sizeof(double));
+    } else {
+      bs[n].chi_ai = bs[n].chi_c;
+      bs[n].eta_ai = bs[n].eta_c;
+      bs[n].sca_ai = bs[n].sca_c;
+    }
+    bs[n].Bnu = (double *) malloc(atmos.Nspace * sizeof(double));
   }
+  return bs;
+}
+/* ------- end ---------------------------- allocBackgroundScratch.c  */
 
-  if (do_fudge) {
-    free(lambda_fudge);
-    freeMatrix((void **) fudge);
+/* ------- begin -------------------------- freeBackgroundScratch.c - */
+
+void freeBackgroundScratch(int Nscratch, BackgroundScratch *bs)
+{
+  register int n;
+
+  for (n = 0;  n < Nscratch;  n++) {
+    free(bs[n].chi);    free(bs[n].eta);  free(bs[n].scatt);
+    free(bs[n].Bnu);
+    free(bs[n].chi_c);  free(bs[n].eta_c);  free(bs[n].sca_c);
+
+    if (atmos.moving || atmos.Stokes) {
+      free(bs[n].chi_ai);
+      free(bs[n].eta_ai);
+      free(bs[n].sca_ai);
+    }
+    if (atmos.Stokes && input.magneto_optical) {
+      free(bs[n].chip);
+      free(bs[n].chip_c);
+    }
   }
-  getCPU(2, TIME_POLL, "Total Background");
+  free(bs);
 }
-/* ------- end ---------------------------- Background.c ------------ */
+/* ------- end ---------------------------- freeBackgroundScratch.c - */
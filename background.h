@@ -33,6 +33,13 @@ struct Linelist {
   AtomicLine *line;
 };
 
+/* --- Scratch space of one thread in Background --   -------------- */
+
+typedef struct {
+  double *chi, *eta, *scatt, *Bnu, *chi_c, *eta_c, *sca_c, *chip, *chip_c,
+         *chi_ai, *eta_ai, *sca_ai;
+} BackgroundScratch;
+
 /* --- Associated function prototypes --               -------------- */
 
 void   ChemicalEquilibrium(int NmaxIter, double iterLimit);
@@ -51,12 +58,17 @@ void   readBackground(int nspect, int mu, bool_t top_to_bottom);
 int    writeBackground(int nspect, int mu, bool_t to_obs,
 		       double *chi_c, double *eta_c, double *sca_c,
 		       double *chip_c);
+int    backgroundRecords(int nspect);
+BackgroundScratch *allocBackgroundScratch(int Nscratch);
+void   freeBackgroundScratch(int Nscratch, BackgroundScratch *bs);
 void   writeBRS(void);
 void   readBRS(void);
 
 void   readKuruczLines(char *fileName);
 int    rlk_ascend(const void *v1, const void *v2);
 void   rlk_locate(int N, RLK_Line *lines, double lambda, int *low);
+void   loadKuruczLines(bool_t writeCache);
+void   freeKuruczLines(void);
 
 bool_t Hminus_bf(double lambda, double *chi, double *eta);
 bool_t Hminus_ff(double lambda, double *chi);
@@ -70,6 +82,11 @@ bool_t Rayleigh_H2(double lambda, double *chi);
 void   Thomson(double *chi);
 bool_t Metal_bf(double lambda, int Nmetal, Atom *metals,
 		double *chi, double *eta);
+double Metal_bfCross(double lambda, Atom *metal, AtomicContinuum *continuum);
+void   resetPassiveLists(void);
+double Hydrogen_bfCross(double lambda, AtomicContinuum *continuum);
+bool_t RayleighCross(double lambda, Atom *atom, double *sigma);
+bool_t Rayleigh_H2Cross(double lambda, double *sigma);
 bool_t OH_bf_opac(double lambda, double *chi, double *eta);
 bool_t CH_bf_opac(double lambda, double *chi, double *eta);
 
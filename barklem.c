@@ -34,6 +34,7 @@
 #include "atmos.h"
 #include "constant.h"
 #include "error.h"
+#include "inputs.h"
 
 
 #define BARKLEM_SP_DATA     "../../Atoms/Barklem_spdata.dat"
@@ -104,7 +105,7 @@ bool_t readBarklemTable(enum Barklemtype type, Barklemstruct *bs)
     break;
   }
 
-  if ((fp_Barklem = fopen(filename, "r")) == NULL) {
+  if ((fp_Barklem = fopenInput(filename)) == NULL) {
     sprintf(messageStr, "Unable to open input file %s", filename);
     Error(ERROR_LEVEL_1, routineName, messageStr);
     return FALSE;
@@ -455,46 +455,31 @@ int atomnr(char ID[ATOM_ID_WIDTH+1])
 }
 /* ------- end ---------------------------- atomnr.c ---------------- */
 
-/* ------- begin -------------------------- CollisionRate.c --------- */
+/* ------- begin -------------------------- readCollisions.c -------- */
 
 #define MSHELL 5
 
-void CollisionRate(struct Atom *atom, FILE *fp_atom)
+static void readCollisions(struct Atom *atom, FILE *fp_atom)
 {
-  const char routineName[] = "CollisionRate";
-  register int k, n, m, ii;
+  const char routineName[] = "readCollisions";
+  register int n, m;
 
-  char    inputLine[MAX_LINE_SIZE], keyword[MAX_LINE_SIZE], *pointer,
-          labelStr[MAX_LINE_SIZE];
-  bool_t  hunt, exit_on_EOF;
-  int     nitem, i1, i2, i, j, ij, ji, Nlevel = atom->Nlevel, Nitem,
-          status;
-  long    Nspace = atmos.Nspace;
+  char    inputLine[MAX_LINE_SIZE], keyword[MAX_LINE_SIZE], *pointer;
+  bool_t  exit_on_EOF;
+  int     nitem, i1, i2, Nitem, NT = 0, Nalloc = 0, status;
   fpos_t  collpos;
-  double  dE, C0, *T, *coeff, *C, Cdown, Cup, gij, *np, xj, fac, fxj;
-  int      Ncoef, Nrow;
-  double **cdi, **badi;
-  double   acolsh,tcolsh,aradsh,xradsh,adish,bdish,t0sh,t1sh,summrs,tg,cdn,cup;
-  double   ar85t1,ar85t2,ar85a,ar85b,ar85c,ar85d,t4;
-  double   de,zz,betab,cbar,dekt,dekti,wlog,wb, sumscl = 0.0;
-
-  getCPU(3, TIME_START, NULL);
+  double *T = NULL, *u, sumscl = 0.0;
+  CollisionData *cd;
 
-  C0 = ((E_RYDBERG/sqrt(M_ELECTRON)) * PI*SQ(RBOHR)) *
-    sqrt(8.0/(PI*KBOLTZMANN));
-
-  atom->C = matrix_double(SQ(Nlevel), Nspace);
-  for (ij = 0;  ij < SQ(Nlevel);  ij++) {
-    for (k = 0;  k < Nspace;  k++) {
-      atom->C[ij][k] = 0.0;
-    }
-  }
+  /* --- Parses the collisional data once into atom->coll. Each entry
+         keeps the level pair, the coefficients and, for the entries
+         interpolated in temperature, its own copy of the temperature
+         grid and the spline second derivatives. --    -------------- */
 
   fgetpos(fp_atom, &collpos);
 
-  C = (double *) malloc(Nspace * sizeof(double));
-
-  T = coeff = NULL;
+  atom->Ncoll = 0;
+  atom->coll  = NULL;
   while ((status = getLine(fp_atom, COMMENT_CHAR,
 		  inputLine, exit_on_EOF=FALSE)) != EOF) {
     strcpy(keyword, strtok(inputLine, " "));
@@ -503,167 +488,139 @@ void CollisionRate(struct Atom *atom, FILE *fp_atom)
 
       /* --- Read temperature grid --                  -------------- */
 
-      Nitem = atoi(strtok(NULL, " "));
-      T = (double *) realloc(T, Nitem*sizeof(double));
-      for (n = 0, nitem = 0;  n < Nitem;  n++) {
+      Nitem = NT = atoi(strtok(NULL, " "));
+      T = (double *) realloc(T, NT*sizeof(double));
+      for (n = 0, nitem = 0;  n < NT;  n++) {
         if ((pointer = strtok(NULL, " ")) == NULL) break;
 	nitem += sscanf(pointer, "%lf", T+n);
       }
-    } else if (!strcmp(keyword, "OMEGA") || !strcmp(keyword, "CE") ||
-	       !strcmp(keyword, "CI")    || !strcmp(keyword, "CP") ||
-	       !strcmp(keyword, "CH0")   || !strcmp(keyword, "CH+")||
-	       !strcmp(keyword, "CH")    || !strcmp(keyword, "CR") ) {
-
-      /* --- Read level indices and collision coefficients -- ------- */
-
-      i1 = atoi(strtok(NULL, " "));
-      i2 = atoi(strtok(NULL, " "));
-      coeff = (double *) realloc(coeff, Nitem*sizeof(double));
-
-      for (n = 0, nitem = 0;  n < Nitem;  n++) {
-        if ((pointer = strtok(NULL, " ")) == NULL) break;
-	nitem += sscanf(pointer, "%lf", coeff+n);
-      }
-      /* --- Transitions i -> j are stored at index ji, transitions
-	     j -> i are stored under ij. --            -------------- */
-
-      i  = MIN(i1, i2);
-      j  = MAX(i1, i2);
-      ij = i*Nlevel + j;
-      ji = j*Nlevel + i;
-
-    } else if (!strcmp(keyword, "AR85-CHP") || !strcmp(keyword, "AR85-CHH")) {
-
-      i1 = atoi(strtok(NULL, " "));
-      i2 = atoi(strtok(NULL, " "));
-
-      Nitem = 6;
-      coeff = (double *) realloc(coeff, Nitem*sizeof(double));
-
-      for (n = 0, nitem = 0;  n < Nitem;  n++) {
-        if ((pointer = strtok(NULL, " ")) == NULL) break;
-	nitem += sscanf(pointer, "%lf", coeff+n);
+      if (nitem != Nitem) {
+	sprintf(messageStr, "\n Read %d, not %d items (keyword = %s)\n",
+		nitem, Nitem, keyword);
+	Error(ERROR_LEVEL_2, routineName, messageStr);
       }
+      continue;
 
-      i  = MIN(i1, i2);
-      j  = MAX(i1, i2);
-      ij = i*Nlevel + j;
-      ji = j*Nlevel + i;
-
-   } else if (!strcmp(keyword, "AR85-CEA")  ||  !strcmp(keyword, "BURGESS")) {
+    } else if (!strcmp(keyword, "SUMMERS")) {
 
-      i1 = atoi(strtok(NULL, " "));
-      i2 = atoi(strtok(NULL, " "));
+      /* --- Switch for density dependent DR coefficent
 
-      Nitem = 1;
-      coeff = (double *) realloc(coeff, Nitem*sizeof(double));
-      coeff[0] = atof(strtok(NULL, " "));
-      nitem = 1;
+             Give default multiplication factor of summers density
+             dependence of dielectronic recombination:
 
-      i  = MIN(i1, i2);
-      j  = MAX(i1, i2);
-      ij = i*Nlevel + j;
-      ji = j*Nlevel + i;
+	     sumscl = 0.0 means there is no density dependence
+	     sumscl = 1.0 means full summers density dependence
+             --                                        -------------- */
 
-    } else if (!strcmp(keyword, "SHULL82")) {
+      sumscl = atof(strtok(NULL, " "));
+      continue;
 
-      i1 = atoi(strtok(NULL, " "));
-      i2 = atoi(strtok(NULL, " "));
+    } else if (strstr(keyword, "END"))
+      break;
 
-      Nitem = 8;
-      coeff = (double *) realloc(coeff, Nitem*sizeof(double));
+    if (atom->Ncoll == Nalloc) {
+      Nalloc = MAX(2 * Nalloc, 16);
+      atom->coll = (CollisionData *)
+	realloc(atom->coll, Nalloc * sizeof(CollisionData));
+    }
+    cd = atom->coll + atom->Ncoll;
+    cd->T = cd->coeff = cd->M2 = NULL;
+    cd->table  = NULL;
+    cd->Nrow   = 0;
+    cd->sumscl = sumscl;
+
+    if      (!strcmp(keyword, "OMEGA"))    cd->type = COLL_OMEGA;
+    else if (!strcmp(keyword, "CE"))       cd->type = COLL_CE;
+    else if (!strcmp(keyword, "CI"))       cd->type = COLL_CI;
+    else if (!strcmp(keyword, "CP"))       cd->type = COLL_CP;
+    else if (!strcmp(keyword, "CR"))       cd->type = COLL_CR;
+    else if (!strcmp(keyword, "CH"))       cd->type = COLL_CH;
+    else if (!strcmp(keyword, "CH0"))      cd->type = COLL_CH0;
+    else if (!strcmp(keyword, "CH+"))      cd->type = COLL_CHP;
+    else if (!strcmp(keyword, "SHULL82"))  cd->type = COLL_SHULL82;
+    else if (!strcmp(keyword, "BADNELL"))  cd->type = COLL_BADNELL;
+    else if (!strcmp(keyword, "AR85-CDI")) cd->type = COLL_AR85_CDI;
+    else if (!strcmp(keyword, "AR85-CEA")) cd->type = COLL_AR85_CEA;
+    else if (!strcmp(keyword, "AR85-CHP")) cd->type = COLL_AR85_CHP;
+    else if (!strcmp(keyword, "AR85-CHH")) cd->type = COLL_AR85_CHH;
+    else if (!strcmp(keyword, "BURGESS"))  cd->type = COLL_BURGESS;
+    else {
+      sprintf(messageStr, "Unknown keyword: !%s!", keyword);
+      Error(ERROR_LEVEL_1, routineName, messageStr);
+      continue;
+    }
 
-      for (n = 0, nitem = 0;  n < Nitem;  n++) {
-        if ((pointer = strtok(NULL, " ")) == NULL) break;
-	nitem += sscanf(pointer, "%lf", coeff+n);
-      }
+    /* --- Transitions i -> j are stored at index ji, transitions
+           j -> i are stored under ij. --              -------------- */
 
-      i  = MIN(i1, i2);
-      j  = MAX(i1, i2);
-      ij = i*Nlevel + j;
-      ji = j*Nlevel + i;
+    i1 = atoi(strtok(NULL, " "));
+    i2 = atoi(strtok(NULL, " "));
+    cd->i = MIN(i1, i2);
+    cd->j = MAX(i1, i2);
 
-    } else if (!strcmp(keyword,"BADNELL")) {
+    switch (cd->type) {
+    case COLL_BADNELL:
 
       /* --- BADNELL recipe for dielectronic recombination:
              Bhavna Rathore: 20 Jan 2014
              --                                        -------------- */
 
-      i1 = atoi(strtok(NULL, " "));
-      i2 = atoi(strtok(NULL, " "));
-      Ncoef = atoi(strtok(NULL, " "));
-
-      Nrow  = 2;
-      Nitem = Nrow * Ncoef;
-      badi  = matrix_double(Nrow, Ncoef);
+      cd->Nitem = atoi(strtok(NULL, " "));
+      cd->Nrow  = 2;
+      Nitem = cd->Nrow * cd->Nitem;
+      cd->table = matrix_double(cd->Nrow, cd->Nitem);
 
-      for (m = 0, nitem = 0;  m < Nrow;  m++) {
+      for (m = 0, nitem = 0;  m < cd->Nrow;  m++) {
 	status = getLine(fp_atom, COMMENT_CHAR, inputLine,
 			 exit_on_EOF=FALSE);
 
-        badi[m][0] = atof(strtok(inputLine, " "));
+        cd->table[m][0] = atof(strtok(inputLine, " "));
         nitem++;
-	for (n = 1;  n < Ncoef;  n++) {
+	for (n = 1;  n < cd->Nitem;  n++) {
 	  if ((pointer = strtok(NULL, " ")) == NULL) break;
-	  nitem += sscanf(pointer, "%lf", badi[m]+n);
+	  nitem += sscanf(pointer, "%lf", cd->table[m]+n);
 	}
       }
+      break;
 
-      i  = MIN(i1, i2);
-      j  = MAX(i1, i2);
-      ij = i*Nlevel + j;
-      ji = j*Nlevel + i;
-
-    } else if (!strcmp(keyword, "SUMMERS")) {
-
-      /* --- Switch for density dependent DR coefficent
-
-             Give default multiplication factor of summers density
-             dependence of dielectronic recombination:
-
-	     sumscl = 0.0 means there is no density dependence
-	     sumscl = 1.0 means full summers density dependence
-             --                                        -------------- */
-      Nitem = 1;
-      sumscl = atof(strtok(NULL, " "));
-      nitem = 1;
-
-    } else if (!strcmp(keyword, "AR85-CDI")) {
-
-      i1 = atoi(strtok(NULL, " "));
-      i2 = atoi(strtok(NULL, " "));
-      Nrow = atoi(strtok(NULL, " "));
-
-      if (Nrow > MSHELL) {
+    case COLL_AR85_CDI:
+      cd->Nrow = atoi(strtok(NULL, " "));
+      if (cd->Nrow > MSHELL) {
 	sprintf(messageStr, "Nrow: %i greater than mshell %i",
-		Nrow, MSHELL);
+		cd->Nrow, MSHELL);
 	Error(ERROR_LEVEL_2, routineName, messageStr);
       }
+      cd->Nitem = MSHELL;
+      Nitem = cd->Nrow * MSHELL;
+      cd->table = matrix_double(cd->Nrow, MSHELL);
 
-      Nitem = Nrow * MSHELL;
-      cdi = matrix_double(Nrow, MSHELL);
-
-      for (m = 0, nitem = 0;  m < Nrow;  m++) {
+      for (m = 0, nitem = 0;  m < cd->Nrow;  m++) {
 	status = getLine(fp_atom, COMMENT_CHAR, inputLine, exit_on_EOF=FALSE);
 
-        cdi[m][0] = atof(strtok(inputLine, " "));
+        cd->table[m][0] = atof(strtok(inputLine, " "));
         nitem++;
 	for (n = 1;  n < MSHELL;  n++) {
 	  if ((pointer = strtok(NULL, " ")) == NULL) break;
-	  nitem += sscanf(pointer, "%lf", cdi[m]+n);
+	  nitem += sscanf(pointer, "%lf", cd->table[m]+n);
 	}
       }
-
-      i  = MIN(i1, i2);
-      j  = MAX(i1, i2);
-      ij = i*Nlevel + j;
-      ji = j*Nlevel + i;
-
-    } else if (strstr(keyword, "END")) {
       break;
-    } else {
-      sprintf(messageStr, "Unknown keyword: !%s!", keyword);
-      Error(ERROR_LEVEL_1, routineName, messageStr);
+
+    default:
+      switch (cd->type) {
+      case COLL_AR85_CHP:
+      case COLL_AR85_CHH:   Nitem = 6;  break;
+      case COLL_SHULL82:    Nitem = 8;  break;
+      case COLL_AR85_CEA:
+      case COLL_BURGESS:    Nitem = 1;  break;
+      default:              Nitem = NT;
+      }
+      cd->Nitem = Nitem;
+      cd->coeff = (double *) malloc(MAX(Nitem, 1) * sizeof(double));
+      for (n = 0, nitem = 0;  n < Nitem;  n++) {
+        if ((pointer = strtok(NULL, " ")) == NULL) break;
+	nitem += sscanf(pointer, "%lf", cd->coeff+n);
+      }
     }
 
     if (nitem != Nitem) {
@@ -671,22 +628,114 @@ void CollisionRate(struct Atom *atom, FILE *fp_atom)
 	      nitem, Nitem, keyword);
       Error(ERROR_LEVEL_2, routineName, messageStr);
     }
-    /* --- Spline interpolation in temperature T for all spatial
-           locations. Linear if only 2 interpolation points given - - */
-
-    if (!strcmp(keyword, "OMEGA") || !strcmp(keyword, "CE") ||
-	!strcmp(keyword, "CI")    || !strcmp(keyword, "CP") ||
-	!strcmp(keyword, "CH0")   || !strcmp(keyword, "CH+")||
-	!strcmp(keyword, "CH")    || !strcmp(keyword, "CR") ) {
-
-      if (Nitem > 2) {
-	splineCoef(Nitem, T, coeff);
-	splineEval(Nspace, atmos.T, C, hunt=TRUE);
-      } else
-	Linear(Nitem, T, coeff, Nspace, atmos.T, C, hunt=TRUE);
+    /* --- Spline coefficients for interpolation in temperature.
+           Linear if only 2 interpolation points given -- ---------- */
+
+    if (cd->type <= COLL_CHP) {
+      cd->T = (double *) malloc(NT * sizeof(double));
+      for (n = 0;  n < NT;  n++) cd->T[n] = T[n];
+      if (NT > 2) {
+	cd->M2 = (double *) malloc(NT * sizeof(double));
+	u = (double *) malloc(NT * sizeof(double));
+	splineTable(NT, cd->T, cd->coeff, cd->M2, u);
+	free(u);
+      }
     }
+    atom->Ncoll++;
+  }
+
+  if (status == EOF) {
+    sprintf(messageStr, "Reached end of datafile before all data was read");
+    Error(ERROR_LEVEL_1, routineName, messageStr);
+  }
+  /* --- Non-NULL coll marks the data as read, also without entries - */
+
+  if (atom->coll == NULL)
+    atom->coll = (CollisionData *) malloc(sizeof(CollisionData));
+  if (T != NULL) free(T);
+
+  fsetpos(fp_atom, &collpos);
+}
+/* ------- end ---------------------------- readCollisions.c -------- */
+
+/* ------- begin -------------------------- freeCollisions.c -------- */
+
+void freeCollisions(struct Atom *atom)
+{
+  register int n;
+
+  CollisionData *cd;
+
+  for (n = 0;  n < atom->Ncoll;  n++) {
+    cd = atom->coll + n;
+    if (cd->T != NULL)     free(cd->T);
+    if (cd->coeff != NULL) free(cd->coeff);
+    if (cd->M2 != NULL)    free(cd->M2);
+    if (cd->table != NULL) freeMatrix((void **) cd->table);
+  }
+  free(atom->coll);
+  atom->coll  = NULL;
+  atom->Ncoll = 0;
+}
+/* ------- end ---------------------------- freeCollisions.c -------- */
 
-    if (!strcmp(keyword, "OMEGA")) {
+/* ------- begin -------------------------- CollisionRate.c --------- */
+
+void CollisionRate(struct Atom *atom, FILE *fp_atom)
+{
+  register int k, n, m, ii;
+
+  char    labelStr[MAX_LINE_SIZE];
+  bool_t  hunt;
+  int     i, j, ij, ji, Nlevel = atom->Nlevel;
+  long    Nspace = atmos.Nspace;
+  double  dE, C0, *C, Cdown, Cup, gij, *np, xj, fac, fxj, **cdi, **badi;
+  double  acolsh,tcolsh,aradsh,xradsh,adish,bdish,t0sh,t1sh,summrs,tg,cdn,cup;
+  double  ar85t1,ar85t2,ar85a,ar85b,ar85c,ar85d,t4;
+  double  de,zz,betab,cbar,dekt,dekti,wlog,wb, sumscl, *coeff;
+  CollisionData *cd;
+
+  /* --- The collisional data of fp_atom are parsed at the first
+         call only, later calls (e.g., for other columns) evaluate the
+         stored entries for the present atmosphere. -- -------------- */
+
+  getCPU(3, TIME_START, NULL);
+
+  if (atom->coll == NULL) readCollisions(atom, fp_atom);
+
+  C0 = ((E_RYDBERG/sqrt(M_ELECTRON)) * PI*SQ(RBOHR)) *
+    sqrt(8.0/(PI*KBOLTZMANN));
+
+  atom->C = matrix_double(SQ(Nlevel), Nspace);
+  for (ij = 0;  ij < SQ(Nlevel);  ij++) {
+    for (k = 0;  k < Nspace;  k++) {
+      atom->C[ij][k] = 0.0;
+    }
+  }
+  C = (double *) malloc(Nspace * sizeof(double));
+
+  for (n = 0;  n < atom->Ncoll;  n++) {
+    cd = atom->coll + n;
+    i  = cd->i;
+    j  = cd->j;
+    ij = i*Nlevel + j;
+    ji = j*Nlevel + i;
+    coeff  = cd->coeff;
+    sumscl = cd->sumscl;
+
+    /* --- Interpolation in temperature T for all spatial
+           locations --                                -------------- */
+
+    if (cd->type <= COLL_CHP) {
+      if (cd->M2 != NULL)
+	splineTableEval(cd->Nitem, cd->T, coeff, cd->M2,
+			Nspace, atmos.T, C, hunt=TRUE);
+      else
+	Linear(cd->Nitem, cd->T, coeff, Nspace, atmos.T, C, hunt=TRUE);
+    }
+
+    switch (cd->type) {
+    case COLL_OMEGA:
 
       /* --- Collisional excitation of ions --         -------------- */
 
@@ -696,7 +745,9 @@ void CollisionRate(struct Atom *atom, FILE *fp_atom)
 	atom->C[ij][k] += Cdown;
 	atom->C[ji][k] += Cdown * atom->nstar[j][k]/atom->nstar[i][k];
       }
-    } else if (!strcmp(keyword, "CE")) {
+      break;
+
+    case COLL_CE:
 
       /* --- Collisional excitation of neutrals --     -------------- */
 
@@ -706,7 +757,9 @@ void CollisionRate(struct Atom *atom, FILE *fp_atom)
 	atom->C[ij][k] += Cdown;
 	atom->C[ji][k] += Cdown * atom->nstar[j][k]/atom->nstar[i][k];
       }
-    } else if (!strcmp(keyword, "CI")) {
+      break;
+
+    case COLL_CI:
 
       /* --- Collisional ionization --                 -------------- */
 
@@ -717,7 +770,9 @@ void CollisionRate(struct Atom *atom, FILE *fp_atom)
 	atom->C[ji][k] += Cup;
 	atom->C[ij][k] += Cup * atom->nstar[i][k]/atom->nstar[j][k];
       }
-    } else if (!strcmp(keyword, "CR")) {
+      break;
+
+    case COLL_CR:
 
       /* --- Collisional de-excitation by electrons --  -------------- */
 
@@ -725,7 +780,9 @@ void CollisionRate(struct Atom *atom, FILE *fp_atom)
         Cdown =  atmos.ne[k] * C[k];
         atom->C[ij][k] += Cdown;
       }
-    } else if (!strcmp(keyword, "CP")) {
+      break;
+
+    case COLL_CP:
 
       /* --- Collisions with protons --                -------------- */
 
@@ -735,7 +792,9 @@ void CollisionRate(struct Atom *atom, FILE *fp_atom)
 	atom->C[ij][k] += Cdown;
 	atom->C[ji][k] += Cdown * atom->nstar[j][k]/atom->nstar[i][k];
       }
-    } else if (!strcmp(keyword, "CH")) {
+      break;
+
+    case COLL_CH:
 
       /* --- Collisions with neutral hydrogen --       -------------- */
 
@@ -744,22 +803,26 @@ void CollisionRate(struct Atom *atom, FILE *fp_atom)
 	atom->C[ji][k] += Cup;
 	atom->C[ij][k] += Cup * atom->nstar[i][k]/atom->nstar[j][k];
       }
-    } else if (!strcmp(keyword, "CH0")) {
+      break;
+
+    case COLL_CH0:
 
       /* --- Charge exchange with neutral hydrogen --  -------------- */
 
       for (k = 0;  k < Nspace;  k++)
 	atom->C[ij][k] += atmos.H->n[0][k] * C[k];
+      break;
 
-    } else if (!strcmp(keyword, "CH+")) {
+    case COLL_CHP:
 
       /* --- Charge exchange with protons --           -------------- */
 
       np = atmos.H->n[atmos.H->Nlevel-1];
       for (k = 0;  k < Nspace;  k++)
 	atom->C[ji][k] += np[k] * C[k];
+      break;
 
-    } else if (!strcmp(keyword, "SHULL82")) {
+    case COLL_SHULL82:
 
       acolsh = coeff[0];
       tcolsh = coeff[1];
@@ -795,7 +858,10 @@ void CollisionRate(struct Atom *atom, FILE *fp_atom)
 	atom->C[ij][k] += cdn;
 	atom->C[ji][k] += cup;
       }
-    } else if (!strcmp(keyword, "BADNELL")) {
+      break;
+
+    case COLL_BADNELL:
+      badi = cd->table;
 
       /* --- Fit for dielectronic recombination from Badnell
 
@@ -810,7 +876,7 @@ void CollisionRate(struct Atom *atom, FILE *fp_atom)
 	tg = atmos.T[k];
 
       	cdn = 0.0;
-	for (ii=0;  ii < Ncoef;  ii++) {
+	for (ii=0;  ii < cd->Nitem;  ii++) {
 	  cdn += badi[1][ii] * exp(-badi[0][ii] / tg);
 	}
 	cdn *= pow(tg, -1.5) ;
@@ -827,9 +893,10 @@ void CollisionRate(struct Atom *atom, FILE *fp_atom)
 	atom->C[ij][k] += cdn;
 /*	atom->C[ji][k] += cup; */
       }
-      freeMatrix((void **) badi);
+      break;
 
-    } else if (!strcmp(keyword, "AR85-CDI")) {
+    case COLL_AR85_CDI:
+      cdi = cd->table;
 
       /* --- Direct collionisional ionization --       -------------- */
 
@@ -837,7 +904,7 @@ void CollisionRate(struct Atom *atom, FILE *fp_atom)
 	cup = 0.0;
 	tg  = atmos.T[k];
 
-	for (m = 0;  m < Nrow;  m++) {
+	for (m = 0;  m < cd->Nrow;  m++) {
 
 	  xj  = cdi[m][0] * EV / (KBOLTZMANN * tg);
 	  fac = exp(-xj) * sqrt(xj);
@@ -858,9 +925,9 @@ void CollisionRate(struct Atom *atom, FILE *fp_atom)
 	atom->C[ij][k] += cdn;
 	atom->C[ji][k] += cup;
       }
-      freeMatrix((void **) cdi);
+      break;
 
-    } else if (!strcmp(keyword,"AR85-CEA") ) {
+    case COLL_AR85_CEA:
 
       /* --- Autoionization --                         -------------- */
 
@@ -869,8 +936,9 @@ void CollisionRate(struct Atom *atom, FILE *fp_atom)
 	cup = coeff[0]*fac*atmos.ne[k];
 	atom->C[ji][k] += cup;
       }
+      break;
 
-    } else if (!strcmp(keyword, "AR85-CHP")) {
+    case COLL_AR85_CHP:
 
       /* --- Charge transfer with ionized hydrogen -- --------------- */
 
@@ -891,7 +959,9 @@ void CollisionRate(struct Atom *atom, FILE *fp_atom)
 	  atom->C[ji][k] += cup;
 	}
       }
-  } else if (!strcmp(keyword, "AR85-CHH")) {
+      break;
+
+    case COLL_AR85_CHH:
 
       /* --- Charge transfer with neutral hydrogen --  -------------- */
 
@@ -911,7 +981,9 @@ void CollisionRate(struct Atom *atom, FILE *fp_atom)
 	  atom->C[ij][k] += cdn;
 	}
       }
-    } else if (!strcmp(keyword, "BURGESS")) {
+      break;
+
+    case COLL_BURGESS:
 
       /* --- Electron impact ionzation following Burgess & Chidichimo 1983,
 	     MNRAS, 203, 1269-1280
@@ -939,20 +1011,12 @@ void CollisionRate(struct Atom *atom, FILE *fp_atom)
 	atom->C[ji][k] += cup;
 	atom->C[ij][k] += cdn;
       }
+      break;
     }
   }
-
-  if (status == EOF) {
-    sprintf(messageStr, "Reached end of datafile before all data was read");
-    Error(ERROR_LEVEL_1, routineName, messageStr);
-  }
   /* --- Clean up --                                   -------------- */
 
   free(C);
-  free(T);
-  free(coeff);
-
-  fsetpos(fp_atom, &collpos);
 
   sprintf(labelStr, "Collision Rate %2s", atom->ID);
   getCPU(3, TIME_POLL, labelStr);
@@ -25,11 +25,31 @@
        Convention: \Gamma_ij = Gamma[i][j] represents the
                    transition j --> i, so that \Gamma_ij * n_j
 		   is the rate per sec out of level j to level i.
+
+       While the wavelengths are solved in the thread pool (see
+       openGammaSlabs) each thread adds its contributions to Gamma and
+       the radiative rates into private slabs instead, without locks.
+       A slab row is allocated only when the thread first touches it.
+       reduceGammaSlabs adds the slabs of all threads into Gamma and the
+       rates in a fixed pairwise order, so that with STATIC_THREADS the
+       result does not depend on the scheduling of the threads.
        --                                              -------------- */
 
 
+/* --- One slab row to reduce over the threads --     -------------- */
+
+typedef struct {
+  rhthread *rhth;
+  int       index;
+  double   *target;
+} SlabTask;
+
+
 /* --- Function prototypes --                          -------------- */
 
+double *slabRow(rhthread *rhth, int index);
+void    reduceSlab(int task, void *argument);
+
 
 /* --- Global variables --                             -------------- */
 
@@ -38,6 +58,9 @@ extern Spectrum spectrum;
 extern InputData input;
 extern char messageStr[];
 
+static bool_t use_slabs = FALSE;
+static long   slab_peak = 0;
+
 
 /* ------- begin -------------------------- initGammaAtom.c --------- */
 
@@ -85,7 +108,7 @@ void addtoGamma(int nspect, double wmu, double *I, double *Psi)
   register int nact, n, k, m;
 
   int    i, j, ij, ji, jp, nt;
-  double twohnu3_c2, twohc, wlamu, *Ieff,
+  double twohnu3_c2, twohc, wlamu, *Ieff, *Gamma_ij, *Gamma_ji,
         *Stokes_Q, *Stokes_U, *Stokes_V, *eta_Q, *eta_U, *eta_V;
 
   Atom *atom;
@@ -98,7 +121,7 @@ void addtoGamma(int nspect, double wmu, double *I, double *Psi)
   twohc = 2.0*HPLANCK*CLIGHT / CUBE(NM_TO_M);
 
   as = &spectrum.as[nspect];
-  nt = nspect % input.Nthreads;
+  nt = threadSlot();
 
   if (containsActive(as)) {
     Ieff = (double *) malloc(atmos.Nspace * sizeof(double));
@@ -159,22 +182,29 @@ void addtoGamma(int nspect, double wmu, double *I, double *Psi)
 	twohnu3_c2 = 0.0;
       }
 
-      if (input.Nthreads > 1) pthread_mutex_lock(&atom->Gamma_lock);
-      
       ij = i*atom->Nlevel + j;
       ji = j*atom->Nlevel + i;
 
+      if (use_slabs) {
+	Gamma_ij = slabRow(&atom->rhth[nt], ij);
+	Gamma_ji = slabRow(&atom->rhth[nt], ji);
+      } else {
+	if (input.Nthreads > 1) pthread_mutex_lock(&atom->Gamma_lock);
+	Gamma_ij = atom->Gamma[ij];
+	Gamma_ji = atom->Gamma[ji];
+      }
+
       for (k = 0;  k < atmos.Nspace;  k++) {
 	wlamu = atom->rhth[nt].Vij[n][k] * atom->rhth[nt].wla[n][k] * wmu;
 
-	atom->Gamma[ji][k] += Ieff[k] * wlamu;
-	atom->Gamma[ij][k] += (twohnu3_c2 + Ieff[k]) *
+	Gamma_ji[k] += Ieff[k] * wlamu;
+	Gamma_ij[k] += (twohnu3_c2 + Ieff[k]) *
 	  atom->rhth[nt].gij[n][k] * wlamu;
       }
       /* --- Cross-coupling terms, currently only for Stokes_I -- --- */
 
       for (k = 0;  k < atmos.Nspace;  k++) {
-	atom->Gamma[ij][k] -= atom->rhth[nt].chi_up[i][k] *
+	Gamma_ij[k] -= atom->rhth[nt].chi_up[i][k] *
 	  Psi[k]*atom->rhth[nt].Uji_down[j][k] * wmu;
       }
       /* --- If rt->i is also an upper level of another transition that
@@ -193,12 +223,13 @@ void addtoGamma(int nspect, double wmu, double *I, double *Psi)
 	}
 	if (jp == i) {
 	  for (k = 0;  k < atmos.Nspace;  k++) {
-	    atom->Gamma[ji][k] += atom->rhth[nt].chi_down[j][k] *
+	    Gamma_ji[k] += atom->rhth[nt].chi_down[j][k] *
 	      Psi[k]*atom->rhth[nt].Uji_down[i][k] * wmu;
 	  }
 	}
       }
-      if (input.Nthreads > 1) pthread_mutex_unlock(&atom->Gamma_lock); 
+      if (!use_slabs  &&  input.Nthreads > 1)
+	pthread_mutex_unlock(&atom->Gamma_lock);
     }
   }
   /* --- Add the active molecular contributions --     -------------- */
@@ -222,23 +253,31 @@ void addtoGamma(int nspect, double wmu, double *I, double *Psi)
 	twohnu3_c2 = 0.0;
       }
 
-      if (input.Nthreads > 1) pthread_mutex_lock(&molecule->Gamma_lock);
-
       /* --- In case of molecular vibration-rotation transitions -- - */
 
       ij = i*molecule->Nv + j;
       ji = j*molecule->Nv + i;
 
+      if (use_slabs) {
+	Gamma_ij = slabRow(&molecule->rhth[nt], ij);
+	Gamma_ji = slabRow(&molecule->rhth[nt], ji);
+      } else {
+	if (input.Nthreads > 1) pthread_mutex_lock(&molecule->Gamma_lock);
+	Gamma_ij = molecule->Gamma[ij];
+	Gamma_ji = molecule->Gamma[ji];
+      }
+
       for (k = 0;  k < atmos.Nspace;  k++) {
 	if (molecule->n[k]) {
 	  wlamu = molecule->rhth[nt].Vij[n][k] *
 	    molecule->rhth[nt].wla[n][k] * wmu;
-	  molecule->Gamma[ji][k] += I[k] * wlamu;
-	  molecule->Gamma[ij][k] += molecule->rhth[nt].gij[n][k] *
+	  Gamma_ji[k] += I[k] * wlamu;
+	  Gamma_ij[k] += molecule->rhth[nt].gij[n][k] *
 	    (twohnu3_c2 + I[k]) * wlamu;
 	}
       }
-      if (input.Nthreads > 1) pthread_mutex_unlock(&molecule->Gamma_lock);
+      if (!use_slabs  &&  input.Nthreads > 1)
+	pthread_mutex_unlock(&molecule->Gamma_lock);
     }
   }
 
@@ -263,7 +302,7 @@ void addtoCoupling(int nspect)
   twohc = 2.0*HPLANCK*CLIGHT / CUBE(NM_TO_M);
 
   as = &spectrum.as[nspect];
-  nt = nspect % input.Nthreads;
+  nt = threadSlot();
 
   /* --- Zero the cross coupling matrices --           -------------- */
 
@@ -377,7 +416,7 @@ void addtoRates(int nspect, int mu, bool_t to_obs, double wmu,
 {
   register int nact, n, k;
 
-  int    la, lamu, nt;
+  int    la, lamu, nt, kr;
   double twohnu3_c2, twohc, hc_4PI, Bijxhc_4PI, wlamu, *Rij, *Rji,
          up_rate, *Stokes_Q, *Stokes_U, *Stokes_V;
 
@@ -397,7 +436,7 @@ void addtoRates(int nspect, int mu, bool_t to_obs, double wmu,
   twohc = 2.0*HPLANCK*CLIGHT / CUBE(NM_TO_M);
 
   as = &spectrum.as[nspect];
-  nt = nspect % input.Nthreads;
+  nt = threadSlot();
 
   if (input.StokesMode == FULL_STOKES  && containsPolarized(as)){
 
@@ -423,6 +462,7 @@ void addtoRates(int nspect, int mu, bool_t to_obs, double wmu,
 	  twohnu3_c2 = line->Aji / line->Bji;
 
 	  rate_lock = &line->rate_lock;
+	  kr = line - atom->line;
 	}
 	break;
 
@@ -436,6 +476,7 @@ void addtoRates(int nspect, int mu, bool_t to_obs, double wmu,
 	  twohnu3_c2 = twohc / CUBE(spectrum.lambda[nspect]);
 
 	  rate_lock = &continuum->rate_lock;
+	  kr = atom->Nline + (continuum - atom->continuum);
 	}
 	break;
       
@@ -445,7 +486,14 @@ void addtoRates(int nspect, int mu, bool_t to_obs, double wmu,
       /* --- Convention: Rij is the rate for transition i -> j -- ----- */
 
       if (Rij != NULL) {
-	if (input.Nthreads > 1) pthread_mutex_lock(rate_lock);
+	if (use_slabs) {
+
+	  /* --- Slab rows of the rates follow those of Gamma -- ---- */
+
+	  Rij = slabRow(&atom->rhth[nt], SQ(atom->Nlevel) + 2*kr);
+	  Rji = slabRow(&atom->rhth[nt], SQ(atom->Nlevel) + 2*kr + 1);
+	} else if (input.Nthreads > 1)
+	  pthread_mutex_lock(rate_lock);
 
 	for (k = 0;  k < atmos.Nspace;  k++) {
 	  wlamu =
@@ -454,9 +502,203 @@ void addtoRates(int nspect, int mu, bool_t to_obs, double wmu,
 	  Rji[k] += atom->rhth[nt].gij[n][k] * (twohnu3_c2 + I[k]) * wlamu;
 	}
 
-	if (input.Nthreads > 1) pthread_mutex_unlock(rate_lock);
+	if (!use_slabs  &&  input.Nthreads > 1)
+	  pthread_mutex_unlock(rate_lock);
       }
     }
   }
 }
 /* ------- end ---------------------------- addtoRates.c ------------ */
+
+/* ------- begin -------------------------- slabRow.c --------------- */
+
+double *slabRow(rhthread *rhth, int index)
+{
+  /* --- Row index of the calling thread's slab, allocated and zeroed
+         at first touch --                             -------------- */
+
+  if (rhth->slab[index] == NULL)
+    rhth->slab[index] = (double *) calloc(atmos.Nspace, sizeof(double));
+
+  return rhth->slab[index];
+}
+/* ------- end ---------------------------- slabRow.c --------------- */
+
+/* ------- begin -------------------------- openGammaSlabs.c -------- */
+
+void openGammaSlabs(void)
+{
+  register int nact, nt;
+
+  Atom *atom;
+  Molecule *molecule;
+
+  /* --- Switches addtoGamma and addtoRates to the private slabs of
+         the calling threads. An atom has a slab row for every element
+         of Gamma and for Rij and Rji of every transition, a molecule
+         only for Gamma. Must be called outside the thread pool, and
+         be followed by reduceGammaSlabs when the pool is done. -- -- */
+
+  for (nact = 0;  nact < atmos.Nactiveatom;  nact++) {
+    atom = atmos.activeatoms[nact];
+    for (nt = 0;  nt < input.Nthreads;  nt++)
+      atom->rhth[nt].slab = (double **)
+	calloc(SQ(atom->Nlevel) + 2*(atom->Nline + atom->Ncont),
+	       sizeof(double *));
+  }
+  for (nact = 0;  nact < atmos.Nactivemol;  nact++) {
+    molecule = atmos.activemols[nact];
+    for (nt = 0;  nt < input.Nthreads;  nt++)
+      molecule->rhth[nt].slab = (double **)
+	calloc(SQ(molecule->Nv), sizeof(double *));
+  }
+  use_slabs = TRUE;
+}
+/* ------- end ---------------------------- openGammaSlabs.c -------- */
+
+/* ------- begin -------------------------- reduceSlab.c ------------ */
+
+void reduceSlab(int task, void *argument)
+{
+  register int k, nt, stride;
+
+  SlabTask *st = (SlabTask *) argument + task;
+  double  **row;
+
+  /* --- Pairwise sum of one slab row over the threads, in the same
+         order every time: row[nt] += row[nt + stride] for stride
+         1, 2, 4, ... Rows never touched count as zero. -- ---------- */
+
+  row = (double **) malloc(input.Nthreads * sizeof(double *));
+  for (nt = 0;  nt < input.Nthreads;  nt++)
+    row[nt] = st->rhth[nt].slab[st->index];
+
+  for (stride = 1;  stride < input.Nthreads;  stride *= 2) {
+    for (nt = 0;  nt + stride < input.Nthreads;  nt += 2*stride) {
+      if (row[nt + stride] == NULL) continue;
+      if (row[nt] == NULL)
+	row[nt] = row[nt + stride];
+      else
+	for (k = 0;  k < atmos.Nspace;  k++)
+	  row[nt][k] += row[nt + stride][k];
+    }
+  }
+  for (k = 0;  k < atmos.Nspace;  k++) st->target[k] += row[0][k];
+
+  for (nt = 0;  nt < input.Nthreads;  nt++) {
+    if (st->rhth[nt].slab[st->index] != NULL) {
+      free(st->rhth[nt].slab[st->index]);
+      st->rhth[nt].slab[st->index] = NULL;
+    }
+  }
+  free(row);
+}
+/* ------- end ---------------------------- reduceSlab.c ------------ */
+
+/* ------- begin -------------------------- reduceGammaSlabs.c ------ */
+
+void reduceGammaSlabs(void)
+{
+  const char routineName[] = "reduceGammaSlabs";
+  register int nact, nt, ij, kr;
+
+  int       Nlevel, Ntask, Nrow, Nrow_max;
+  long      Nrow_total;
+  double   *target;
+  SlabTask *tasks;
+  Atom     *atom;
+  Molecule *molecule;
+
+  /* --- Adds the private slabs of all threads into Gamma and the
+         radiative rates, one slab row per task in the thread pool,
+         and frees them. --                            -------------- */
+
+  use_slabs = FALSE;
+
+  Nrow_max = 0;
+  for (nact = 0;  nact < atmos.Nactiveatom;  nact++) {
+    atom = atmos.activeatoms[nact];
+    Nrow_max += SQ(atom->Nlevel) + 2*(atom->Nline + atom->Ncont);
+  }
+  for (nact = 0;  nact < atmos.Nactivemol;  nact++)
+    Nrow_max += SQ(atmos.activemols[nact]->Nv);
+  tasks = (SlabTask *) malloc(Nrow_max * sizeof(SlabTask));
+
+  /* --- Collect the rows touched by at least one thread -- -------- */
+
+  Ntask = 0;
+  Nrow_total = 0;
+  for (nact = 0;  nact < atmos.Nactiveatom;  nact++) {
+    atom = atmos.activeatoms[nact];
+    Nlevel = atom->Nlevel;
+
+    for (ij = 0;  ij < SQ(Nlevel) + 2*(atom->Nline + atom->Ncont);  ij++) {
+      if (ij < SQ(Nlevel))
+	target = atom->Gamma[ij];
+      else {
+	kr = (ij - SQ(Nlevel)) / 2;
+	if (kr < atom->Nline)
+	  target = ((ij - SQ(Nlevel)) % 2) ?
+	    atom->line[kr].Rji : atom->line[kr].Rij;
+	else
+	  target = ((ij - SQ(Nlevel)) % 2) ?
+	    atom->continuum[kr - atom->Nline].Rji :
+	    atom->continuum[kr - atom->Nline].Rij;
+      }
+      Nrow = 0;
+      for (nt = 0;  nt < input.Nthreads;  nt++)
+	if (atom->rhth[nt].slab[ij] != NULL) Nrow++;
+      if (Nrow > 0) {
+	tasks[Ntask].rhth   = atom->rhth;
+	tasks[Ntask].index  = ij;
+	tasks[Ntask].target = target;
+	Ntask++;
+	Nrow_total += Nrow;
+      }
+    }
+  }
+  for (nact = 0;  nact < atmos.Nactivemol;  nact++) {
+    molecule = atmos.activemols[nact];
+
+    for (ij = 0;  ij < SQ(molecule->Nv);  ij++) {
+      Nrow = 0;
+      for (nt = 0;  nt < input.Nthreads;  nt++)
+	if (molecule->rhth[nt].slab[ij] != NULL) Nrow++;
+      if (Nrow > 0) {
+	tasks[Ntask].rhth   = molecule->rhth;
+	tasks[Ntask].index  = ij;
+	tasks[Ntask].target = molecule->Gamma[ij];
+	Ntask++;
+	Nrow_total += Nrow;
+      }
+    }
+  }
+  /* --- Report the memory used by the slabs when it grows -- ------ */
+
+  if (Nrow_total * atmos.Nspace * (long) sizeof(double) > slab_peak) {
+    slab_peak = Nrow_total * atmos.Nspace * sizeof(double);
+    sprintf(messageStr, " Private Gamma and rate slabs: %ld rows of %d "
+	    "threads, %.1f MB\n", Nrow_total, input.Nthreads,
+	    slab_peak / 1048576.0);
+    Error(MESSAGE, routineName, messageStr);
+  }
+
+  runThreadPool(Ntask, reduceSlab, tasks);
+  free(tasks);
+
+  for (nact = 0;  nact < atmos.Nactiveatom;  nact++) {
+    atom = atmos.activeatoms[nact];
+    for (nt = 0;  nt < input.Nthreads;  nt++) {
+      free(atom->rhth[nt].slab);
+      atom->rhth[nt].slab = NULL;
+    }
+  }
+  for (nact = 0;  nact < atmos.Nactivemol;  nact++) {
+    molecule = atmos.activemols[nact];
+    for (nt = 0;  nt < input.Nthreads;  nt++) {
+      free(molecule->rhth[nt].slab);
+      molecule->rhth[nt].slab = NULL;
+    }
+  }
+}
+/* ------- end ---------------------------- reduceGammaSlabs.c ------ */
@@ -24,6 +24,35 @@
 
 extern char messageStr[];
 
+/* --- Replaces fopen for input files when set, e.g. to get the file
+       contents from one process that reads them for all --  -------- */
+
+static FILE *(*inputOpener)(const char *fileName) = NULL;
+
+
+/* ------- begin -------------------------- fopenInput.c ------------ */
+
+FILE *fopenInput(const char *fileName)
+{
+  /* --- Opens input file fileName for reading --      -------------- */
+
+  if (inputOpener != NULL)
+    return inputOpener(fileName);
+  else
+    return fopen(fileName, "r");
+}
+/* ------- end ---------------------------- fopenInput.c ------------ */
+
+/* ------- begin -------------------------- setInputOpener.c -------- */
+
+void setInputOpener(FILE *(*opener)(const char *fileName))
+{
+  /* --- Sets the opener used by fopenInput, NULL for plain fopen - - */
+
+  inputOpener = opener;
+}
+/* ------- end ---------------------------- setInputOpener.c -------- */
+
 
 /* ------- begin -------------------------- getLine.c --------------- */
 
@@ -153,6 +153,29 @@ void distribute_nH()
 }
 /* ------- end ---------------------------- distribute_nH.c --------- */
 
+/* ------- begin -------------------------- Hydrogen_bfCross.c ------ */
+
+double Hydrogen_bfCross(double lambda, AtomicContinuum *continuum)
+{
+  /* --- Cross section of hydrogen bound-free transition continuum at
+         wavelength lambda, within its wavelength range --  --------- */
+
+  int     i = continuum->i;
+  double  sigma0, g_bf, n_eff;
+
+  sigma0 = 32.0/(3.0*sqrt(3.0)) * SQ(Q_ELECTRON)/(4.0*PI*EPSILON_0) / 
+    (M_ELECTRON * CLIGHT) * HPLANCK/(2.0*E_RYDBERG);
+
+  /* --- Find the principal quantum number of level i -- ------------ */
+
+  n_eff = sqrt(E_RYDBERG /
+	       (atmos.H->E[continuum->j] - atmos.H->E[continuum->i]));
+
+  g_bf  = Gaunt_bf(lambda, n_eff, atmos.H->stage[i] + 1);
+  return sigma0 * n_eff * g_bf * CUBE(lambda/continuum->lambda0);
+}
+/* ------- end ---------------------------- Hydrogen_bfCross.c ------ */
+
 /* ------- begin -------------------------- Hydrogen_bf.c ----------- */
 
 bool_t Hydrogen_bf(double lambda, double *chi, double *eta)
@@ -165,8 +188,8 @@ bool_t Hydrogen_bf(double lambda, double *chi, double *eta)
 
   bool_t  opaque;
   int     i;
-  double  lambdaEdge, sigma, sigma0, g_bf, twohnu3_c2, twohc, gijk,
-    hc_k, hc_kla, *npstar, expla, n_eff, *np;
+  double  lambdaEdge, sigma, twohnu3_c2, twohc, gijk,
+    hc_k, hc_kla, *npstar, expla, *np;
   AtomicContinuum *continuum;
 
   opaque = FALSE;
@@ -178,8 +201,6 @@ bool_t Hydrogen_bf(double lambda, double *chi, double *eta)
 
   twohc  = (2.0 * HPLANCK * CLIGHT) / CUBE(NM_TO_M);
   hc_k   = (HPLANCK * CLIGHT) / (KBOLTZMANN * NM_TO_M);
-  sigma0 = 32.0/(3.0*sqrt(3.0)) * SQ(Q_ELECTRON)/(4.0*PI*EPSILON_0) / 
-    (M_ELECTRON * CLIGHT) * HPLANCK/(2.0*E_RYDBERG);
 
   npstar = atmos.H->nstar[atmos.H->Nlevel - 1];
 
@@ -191,13 +212,7 @@ bool_t Hydrogen_bf(double lambda, double *chi, double *eta)
     if (lambda <= lambdaEdge  &&  lambda >= continuum->lambda[0]) {
       opaque = TRUE;
 
-      /* --- Find the principal quantum number of level i -- -------- */
-
-      n_eff = sqrt(E_RYDBERG /
-		   (atmos.H->E[continuum->j] - atmos.H->E[continuum->i]));
-
-      g_bf  = Gaunt_bf(lambda, n_eff, atmos.H->stage[i] + 1);
-      sigma = sigma0 * n_eff * g_bf * CUBE(lambda/lambdaEdge);
+      sigma      = Hydrogen_bfCross(lambda, continuum);
       hc_kla     = hc_k / lambda;
       twohnu3_c2 = twohc / CUBE(lambda);
       
@@ -309,13 +324,14 @@ bool_t Hminus_bf(double lambda, double *chi, double *eta)
 
   bool_t hunt;
   long   Nspace = atmos.Nspace;
-  double hc_kla, stimEmis, twohnu3_c2, alpha_bf;
+  double hc_kla, stimEmis, twohnu3_c2, alpha_bf, M2[NBF], u[NBF];
 
   if ((lambda <= lambdaBF[0]) || (lambda >= lambdaBF[NBF-1]))
     return FALSE;
 
-  splineCoef(NBF, lambdaBF, alphaBF);
-  splineEval(1, &lambda, &alpha_bf, hunt=FALSE);
+  splineTable(NBF, lambdaBF, alphaBF, M2, u);
+  splineTableEval(NBF, lambdaBF, alphaBF, M2, 1, &lambda, &alpha_bf,
+		  hunt=FALSE);
   alpha_bf *= 1.0E-21;
 
   hc_kla     = (HPLANCK * CLIGHT) / (KBOLTZMANN * NM_TO_M * lambda);
@@ -341,7 +357,6 @@ bool_t Hminus_ff(double lambda, double *chi)
   register int  k;
 
   static bool_t  initialize=TRUE;
-  static int     index;
   static double *theta_index;
 
   /* --- H-minus Free-Free coefficients (in units of 1.0E-29 m^5/J)
@@ -438,6 +453,7 @@ bool_t Hminus_ff(double lambda, double *chi)
      7.97e+01, 8.32e+01, 8.67e+01, 9.01e+01
   };
   
+  int     index = 0;
   long    Nspace = atmos.Nspace;
   double  theta, pe, lambda_index, kappa;
 
@@ -446,7 +462,10 @@ bool_t Hminus_ff(double lambda, double *chi)
     /* --- When called with zero wavelength free memory for fractional
            indices --                                  -------------- */
 
-    if (theta_index) free(theta_index);
+    if (theta_index) {
+      free(theta_index);
+      theta_index = NULL;
+    }
     initialize = TRUE;
     return FALSE;
   }
@@ -553,7 +572,6 @@ bool_t H2minus_ff(double lambda, double *chi) {
   register int  k;
 
   static  bool_t initialize=TRUE;
-  static   int   index;
   static double *theta_index;
 
   /* --- H2-minus Free-Free absorption coefficients (in units of
@@ -638,6 +656,7 @@ bool_t H2minus_ff(double lambda, double *chi) {
      1.26e+02, 1.38e+02, 1.47e+02
   };
 
+  int     index = 0;
   long    Nspace = atmos.Nspace;
   double  theta, pe, lambda_index, kappa, *nH2;
 
@@ -646,7 +665,10 @@ bool_t H2minus_ff(double lambda, double *chi) {
     /* --- When called with zero wavelength free memory for fractional
            indices --                                  -------------- */
 
-    if (theta_index) free(theta_index);
+    if (theta_index) {
+      free(theta_index);
+      theta_index = NULL;
+    }
     initialize = TRUE;
     return FALSE;
   }
@@ -698,7 +720,6 @@ bool_t H2plus_ff(double lambda, double *chi)
   register int  k;
 
   static  bool_t initialize=TRUE;
-  static   int   index;
   static double *temp_index;
 
   /* --- H2+ Free-Free scattering coefficients in units of 
@@ -759,6 +780,7 @@ bool_t H2plus_ff(double lambda, double *chi)
     1.39, 1.18, 1.02, 0.90, 0.73, 0.60, 0.52, 0.46, 0.37, 0.31
   };
 
+  int     index = 0;
   long    Nspace = atmos.Nspace;
   double  T, lambda_index, kappa, *np;
 
@@ -767,7 +789,10 @@ bool_t H2plus_ff(double lambda, double *chi)
     /* --- When called with zero wavelength free memory for fractional
            indices --                                  -------------- */
 
-    if (temp_index) free(temp_index);
+    if (temp_index) {
+      free(temp_index);
+      temp_index = NULL;
+    }
     initialize = TRUE;
     return FALSE;
   }
@@ -806,15 +831,13 @@ bool_t H2plus_ff(double lambda, double *chi)
 }
 /* ------- end ---------------------------- H2plus_ff.c ------------- */
 
-/* ------- begin -------------------------- Rayleigh_H2.c ----------- */
+/* ------- begin -------------------------- Rayleigh_H2Cross.c ------ */
 
 #define RAYLEIGH_H2_LIMIT  121.57
 #define N_RAYLEIGH_H2      21
 
-bool_t Rayleigh_H2(double lambda, double *scatt)
+bool_t Rayleigh_H2Cross(double lambda, double *sigma_RH2)
 {
-  register int k;
-
   static double a[3] = {8.779E+01, 1.323E+06, 2.245E+10};
 
   static double lambdaRH2[N_RAYLEIGH_H2] = {
@@ -838,20 +861,35 @@ bool_t Rayleigh_H2(double lambda, double *scatt)
          --                                            -------------- */
 
   bool_t hunt;
-  double lambda2, sigma_RH2, *nH2;
-
-  nH2 = atmos.H2->n;
+  double lambda2;
 
   if (lambda >= RAYLEIGH_H2_LIMIT) {
     if (lambda <= lambdaRH2[N_RAYLEIGH_H2 - 1]) {
       Linear(N_RAYLEIGH_H2, lambdaRH2, sigma,
-		   1, &lambda, &sigma_RH2, hunt=FALSE);
+		   1, &lambda, sigma_RH2, hunt=FALSE);
     } else {
       lambda2 = 1.0 / SQ(lambda);
-      sigma_RH2 = (a[0] + (a[1] + a[2]*lambda2) * lambda2) * SQ(lambda2);
+      *sigma_RH2 = (a[0] + (a[1] + a[2]*lambda2) * lambda2) * SQ(lambda2);
     }
-    sigma_RH2 *= MEGABARN_TO_M2;
+    *sigma_RH2 *= MEGABARN_TO_M2;
+
+    return TRUE;
+  } else 
+    return FALSE;
+}
+/* ------- end ---------------------------- Rayleigh_H2Cross.c ------ */
+
+/* ------- begin -------------------------- Rayleigh_H2.c ----------- */
+
+bool_t Rayleigh_H2(double lambda, double *scatt)
+{
+  register int k;
+
+  double sigma_RH2, *nH2;
+
+  nH2 = atmos.H2->n;
 
+  if (Rayleigh_H2Cross(lambda, &sigma_RH2)) {
     for (k = 0;  k < atmos.Nspace;  k++)
       scatt[k] = sigma_RH2 * nH2[k];
 
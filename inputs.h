@@ -26,6 +26,8 @@ enum S_interpol   {S_LINEAR, CUBIC_HERMITE, BEZIER, BEZIER3};
 enum S_interpol_stokes   {DELO_PARABOLIC, DELO_BEZIER3};
 enum order_3D     {LINEAR_3D, BICUBIC_3D};
 enum ne_solution  {NONE, ONCE, ITERATION};
+enum task_order   {ORDER_TASKMAP, ORDER_ATMOS_COST, ORDER_ITERATION_COST,
+                   ORDER_HILBERT};
 
 
 typedef struct {
@@ -58,6 +60,7 @@ typedef struct {
          molecules_input[MAX_VALUE_LENGTH],
          Stokes_input[MAX_VALUE_LENGTH],
          KuruczData[MAX_VALUE_LENGTH],
+         KuruczCache[MAX_VALUE_LENGTH],
          pfData[MAX_VALUE_LENGTH],
          fudgeData[MAX_VALUE_LENGTH],
          atmos_output[MAX_VALUE_LENGTH],
@@ -73,11 +76,14 @@ typedef struct {
          collrateFile[MAX_VALUE_LENGTH],
          dampingFile[MAX_VALUE_LENGTH],
          coolingFile[MAX_VALUE_LENGTH],
-         Itop[MAX_VALUE_LENGTH];
+         Itop[MAX_VALUE_LENGTH],
+         p15d_prev_aux[MAX_VALUE_LENGTH],
+         p15d_prev_indata[MAX_VALUE_LENGTH],
+         p15d_prev_ray[MAX_VALUE_LENGTH];
   bool_t magneto_optical, XRD, Eddington,
          backgr_pol, limit_memory, allow_passive_bb, NonICE,
          rlkscatter, prdh_limit_mem, backgr_in_mem, xdr_endian,
-         old_background, accelerate_mols;
+         old_background, accelerate_mols, static_threads;
   enum   solution startJ;
   enum   StokesMode StokesMode;
   enum   S_interpol S_interpolation;
@@ -98,9 +104,13 @@ typedef struct {
   int    NpescIter;
   /* Tiago, added this for 1.5D version */
   int    p15d_nt, p15d_x0, p15d_x1, p15d_xst, p15d_y0, p15d_y1, p15d_yst;
-  double p15d_tmax;
+  int    p15d_chunk, p15d_checkpoint, p15d_warm, p15d_prev_nt, p15d_wbuf,
+         p15d_wbatch, p15d_nodecache, p15d_bgtable;
+  double p15d_tmax, p15d_reuse_tol;
+  enum   task_order p15d_order;
   bool_t p15d_wxtra, p15d_rerun, p15d_refine, p15d_zcut, p15d_wtau;
-  bool_t p15d_wpop, p15d_wrates;
+  bool_t p15d_wpop, p15d_wrates, p15d_counter, p15d_shard, p15d_prefetch,
+         p15d_tiles, p15d_shared_lines, p15d_bcast, p15d_fused;
   double iterLimit, PRDiterLimit, metallicity;
 
   pthread_attr_t thread_attr;
@@ -111,6 +121,8 @@ typedef struct {
 
 int   getLine(FILE *inputFile, char *commentChar, char *line,
 	      bool_t exit_on_EOF);
+FILE *fopenInput(const char *fileName);
+void  setInputOpener(FILE *(*opener)(const char *fileName));
 void  parse(int argc, char *argv[], int Noption, Option *theOptions);
 void  readInput();
 void  readValues(FILE *fp_keyword, int Nkeyword, Keyword *theKeywords);
@@ -122,6 +134,7 @@ void  setintValue(char *value, void *pointer);
 void  setdoubleValue(char *value, void *pointer);
 void  setstartValue(char *value, void *pointer);
 void  setnesolution(char *value, void *pointer);
+void  setTaskOrder(char *value, void *pointer);
 void  setStokesMode(char *value, void *pointer);
 void  setPRDangle(char *value, void *pointer);
 void  setThreadValue(char *value, void *pointer);
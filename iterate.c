@@ -26,13 +26,13 @@
 
 typedef struct {
   bool_t eval_operator, redistribute;
-  int    nspect;
-  double dJ;
+  int   *queue;
+  double *dJ;
 } threadinfo;
 
 /* --- Function prototypes --                          -------------- */
 
-void *Formal_pthread(void *argument);
+void Formal_pthread(int task, void *argument);
 
 
 /* --- Global variables --                             -------------- */
@@ -205,12 +205,11 @@ void Iterate(int NmaxIter, double iterLimit)
 
 double solveSpectrum(bool_t eval_operator, bool_t redistribute)
 {
-  register int nspect, n, nt, k;
+  register int nspect, n, k;
 
-  int         Nthreads, lambda_max;
+  int         Nqueue, lambda_max;
   double      dJ, dJmax;
-  pthread_t  *thread_id;
-  threadinfo *ti;
+  threadinfo  ti;
 
   /* --- Administers the formal solution for each wavelength. When
          input.Nthreads > 1 the solutions are performed concurrently
@@ -249,52 +248,33 @@ double solveSpectrum(bool_t eval_operator, bool_t redistribute)
 
   if (input.Nthreads > 1) {
 
-    /* --- If input.Nthreads positive then solve Nthreads wavelengths
-           concurrently in separate threads --         -------------- */
+    /* --- Solve the wavelengths concurrently in the persistent pool
+           of input.Nthreads threads (see threadpool.c). The threads
+           take the wavelengths off a queue ordered by estimated cost,
+           most expensive first, so that no thread waits for another
+           to finish a batch. --                       -------------- */
 
-    ti = (threadinfo *) malloc(input.Nthreads * sizeof(threadinfo));
-    for (nt = 0;  nt < input.Nthreads;  nt++) {
-      ti[nt].eval_operator = eval_operator;
-      ti[nt].redistribute  = redistribute;
-    }
-    thread_id = (pthread_t *) malloc(input.Nthreads * sizeof(pthread_t));
+    ti.eval_operator = eval_operator;
+    ti.redistribute  = redistribute;
+    ti.queue = (int *) malloc(spectrum.Nspect * sizeof(int));
+    ti.dJ    = (double *) calloc(spectrum.Nspect, sizeof(double));
 
-    /* --- Thread management is very simple. Submit a batch of as many
-           as input.Nthreads at the same time, then wait till all of
-           these have finished. There is no check on successful
-           submission nor completion. --               -------------- */
+    /* --- The threads add to Gamma and the rates in private slabs,
+           which are summed once all wavelengths are done -- ------- */
 
-    for (nspect = 0;  nspect < spectrum.Nspect;  nspect += input.Nthreads) {
-      if (nspect + input.Nthreads <= spectrum.Nspect)
-	Nthreads = input.Nthreads;
-      else
-	Nthreads = (spectrum.Nspect % input.Nthreads);
-
-      /* --- Start batch of concurrent threads --      -------------- */
-
-      for (nt = 0;  nt < Nthreads;  nt++) {
-	ti[nt].nspect = nspect + nt;
-	if (!redistribute ||
-	    (redistribute && containsPRDline(&spectrum.as[nspect+nt]))) {
-	  pthread_create(&thread_id[nt], &input.thread_attr,
-			 Formal_pthread, &ti[nt]);
-	} else
-	  thread_id[nt] = 0;
-      }
-      /* --- Let the finished threads of the batch join again -- ---- */
-
-      for (nt = 0;  nt < Nthreads;  nt++) {
-	if (thread_id[nt]) {
-	  pthread_join(thread_id[nt], NULL);
-	  if (ti[nt].dJ > dJmax) {
-	    dJmax = ti[nt].dJ;
-	    lambda_max = nspect + nt;
-	  }
-	}
+    Nqueue = spectrumQueue(redistribute, ti.queue);
+    openGammaSlabs();
+    runThreadPool(Nqueue, Formal_pthread, &ti);
+    reduceGammaSlabs();
+
+    for (nspect = 0;  nspect < spectrum.Nspect;  nspect++) {
+      if (ti.dJ[nspect] > dJmax) {
+	dJmax = ti.dJ[nspect];
+	lambda_max = nspect;
       }
     }
-    free(thread_id);
-    free(ti);
+    free(ti.queue);
+    free(ti.dJ);
   } else {
 
     /* --- Else call the solution for wavelengths sequentially -- --- */
@@ -324,14 +304,13 @@ double solveSpectrum(bool_t eval_operator, bool_t redistribute)
 
 /* ------- begin -------------------------- Formal_pthread.c -------- */
 
-void *Formal_pthread(void *argument)
+void Formal_pthread(int task, void *argument)
 {
   threadinfo *ti = (threadinfo *) argument;
+  int nspect = ti->queue[task];
 
-  /* --- Threads wrapper around Formal --              -------------- */
-
-  ti->dJ = Formal(ti->nspect, ti->eval_operator, ti->redistribute);
+  /* --- Thread pool task wrapper around Formal --     -------------- */
 
-  return (NULL);
+  ti->dJ[nspect] = Formal(nspect, ti->eval_operator, ti->redistribute);
 }
 /* ------- end ---------------------------- Formal_pthread.c -------- */
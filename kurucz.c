@@ -61,9 +61,13 @@ FORMAT(F11.4,F7.3,F6.2,F12.3,F5.2,1X,A10,F12.3,F5.2,1X,A10,
        --                                              -------------- */
 
 #include <ctype.h>
+#include <fcntl.h>
 #include <math.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "rh.h"
 #include "atom.h"
@@ -81,18 +85,52 @@ FORMAT(F11.4,F7.3,F6.2,F12.3,F5.2,1X,A10,F12.3,F5.2,1X,A10,
 #define ANGSTROM_TO_NM      0.1
 #define MAX_GAUSS_DOPPLER   7.0
 
+#define RLK_CACHE_MAGIC     "RHRLKBIN"
+#define RLK_CACHE_VERSION   1
+#define RLK_CACHE_HEADER    4096
+
+
+/* --- Header of the binary cache of sorted Kurucz lines (KURUCZ_CACHE).
+       The lines follow at RLK_CACHE_HEADER, as RLK_Line records. stamp
+       sums up size and modification time of the line lists and the
+       partition function file; Stokes and He_abund enter in the
+       polarizability and the Unsoeld cross sections. --  -------------- */
+
+typedef struct {
+  char   magic[8];
+  int    version, recordsize, Nrlk, Stokes;
+  double He_abund;
+  unsigned long stamp;
+} RLK_CacheHeader;
+
+
+/* --- Doppler widths per element and damping parameters per line,
+       per depth, for the present column. Set up by initRLKProfiles
+       for the lines within reach of the wavelength grid, so that
+       RLKProfile does not recompute them for every wavelength and
+       angle. Entries are NULL for elements and lines not needed, and
+       for lines without radiative damping. --         -------------- */
+
+typedef struct {
+  double **vbroad, **sv, **adamp, *pool;
+} RLK_Broadening;
+
 
 /* --- Function prototypes --                          -------------- */
 
-double           RLKProfile(RLK_Line *rlk, int k, int mu, bool_t to_obs,
-			    double lambda,
+double           RLKProfile(RLK_Line *rlk, int n, int k, int mu,
+			    bool_t to_obs, double lambda,
 			    double *phi_Q, double *phi_U, double *phi_V,
 			    double *psi_Q, double *psi_U, double *psi_V);
+double           RLKDamping(RLK_Line *rlk, int k, double vbroad);
 ZeemanMultiplet* RLKZeeman(RLK_Line *rlk);
 void             initRLK(RLK_Line *rlk);
 bool_t           RLKdeterminate(char *labeli, char *labelj, RLK_Line *rlk);
 void             getUnsoldcross(RLK_Line *rlk);
 void             free_BS(Barklemstruct *bs);
+unsigned long    kuruczStamp(char *inputFile);
+bool_t           readKuruczCache(char *cacheFile, char *inputFile);
+void             writeKuruczCache(char *cacheFile, char *inputFile);
 
 
 /* --- Global variables --                             -------------- */
@@ -101,6 +139,8 @@ extern Atmosphere atmos;
 extern InputData input;
 extern char messageStr[];
 
+static RLK_Broadening rlk_broad = {NULL, NULL, NULL, NULL};
+
 
 /* ------- begin -------------------------- readKuruczLines.c ------- */
 
@@ -134,7 +174,7 @@ void readKuruczLines(char *inputFile)
   labeli[RLK_LABEL_LENGTH] = '\0';
   labelj[RLK_LABEL_LENGTH] = '\0';
 
-  if ((fp_Kurucz = fopen(inputFile, "r")) == NULL) {
+  if ((fp_Kurucz = fopenInput(inputFile)) == NULL) {
     sprintf(messageStr, "Unable to open input file %s", inputFile);
     Error(ERROR_LEVEL_1, routineName, messageStr);
     return;
@@ -143,7 +183,7 @@ void readKuruczLines(char *inputFile)
 
   while (getLine(fp_Kurucz, commentChar, listName, FALSE) != EOF) {
     Nread = sscanf(listName, "%s", filename);
-    if ((fp_linelist = fopen(filename, "r")) == NULL) {
+    if ((fp_linelist = fopenInput(filename)) == NULL) {
       sprintf(messageStr, "Unable to open input file %s", filename);
       Error(ERROR_LEVEL_1, routineName, messageStr);
     }
@@ -333,6 +373,182 @@ void readKuruczLines(char *inputFile)
 }
 /* ------- end ---------------------------- readKuruczLines.c ------- */
 
+/* ------- begin -------------------------- loadKuruczLines.c ------- */
+
+void loadKuruczLines(bool_t writeCache)
+{
+  /* --- Gets the Kurucz lines of input.KuruczData sorted by
+         wavelength, from the binary cache input.KuruczCache if it is
+         valid. Otherwise reads the line lists and, if writeCache is
+         set, writes the cache. In rh15d only one process writes it,
+         the others only read it. --                  -------------- */
+
+  atmos.Nrlk = 0;
+  if (readKuruczCache(input.KuruczCache, input.KuruczData)) return;
+
+  readKuruczLines(input.KuruczData);
+  if (atmos.Nrlk > 0) {
+    qsort(atmos.rlk_lines, atmos.Nrlk, sizeof(RLK_Line), rlk_ascend);
+    if (writeCache) writeKuruczCache(input.KuruczCache, input.KuruczData);
+  }
+}
+/* ------- end ---------------------------- loadKuruczLines.c ------- */
+
+/* ------- begin -------------------------- freeKuruczLines.c ------- */
+
+static void  *rlk_map = NULL;
+static size_t rlk_mapsize = 0;
+
+void freeKuruczLines(void)
+{
+  /* --- Frees the Kurucz lines, or unmaps them if from the cache -- */
+
+  if (rlk_map != NULL) {
+    munmap(rlk_map, rlk_mapsize);
+    rlk_map = NULL;
+  } else if (atmos.Nrlk > 0)
+    free(atmos.rlk_lines);
+
+  atmos.rlk_lines = NULL;
+}
+/* ------- end ---------------------------- freeKuruczLines.c ------- */
+
+/* ------- begin -------------------------- kuruczStamp.c ----------- */
+
+unsigned long kuruczStamp(char *inputFile)
+{
+  char   listName[MAX_LINE_SIZE], filename[MAX_LINE_SIZE];
+  unsigned long stamp = 0;
+  struct stat statBuffer;
+  FILE  *fp_Kurucz;
+
+  /* --- Combines size and modification time of the line lists in
+         inputFile and of the partition function data -- ------------ */
+
+  if ((fp_Kurucz = fopenInput(inputFile)) == NULL) return 0;
+  while (getLine(fp_Kurucz, COMMENT_CHAR, listName, FALSE) != EOF) {
+    if (sscanf(listName, "%s", filename) == 1  &&
+	stat(filename, &statBuffer) == 0) {
+      stamp = 31 * stamp + (unsigned long) statBuffer.st_size;
+      stamp = 31 * stamp + (unsigned long) statBuffer.st_mtime;
+    }
+  }
+  fclose(fp_Kurucz);
+
+  if (stat(input.pfData, &statBuffer) == 0) {
+    stamp = 31 * stamp + (unsigned long) statBuffer.st_size;
+    stamp = 31 * stamp + (unsigned long) statBuffer.st_mtime;
+  }
+  return stamp;
+}
+/* ------- end ---------------------------- kuruczStamp.c ----------- */
+
+/* ------- begin -------------------------- readKuruczCache.c ------- */
+
+bool_t readKuruczCache(char *cacheFile, char *inputFile)
+{
+  const char routineName[] = "readKuruczCache";
+
+  int    fd;
+  struct stat statBuffer;
+  RLK_CacheHeader header;
+
+  /* --- Maps the sorted lines of the cache, if it was written for
+         the present line lists and settings. The mapping is private,
+         so that Zeeman patterns can still be added to the lines. -- */
+
+  if (!strcmp(cacheFile, "none")  ||  !strcmp(inputFile, "none"))
+    return FALSE;
+  if ((fd = open(cacheFile, O_RDONLY)) == -1) return FALSE;
+
+  if (fstat(fd, &statBuffer) == -1  ||
+      read(fd, &header, sizeof(RLK_CacheHeader)) !=
+      sizeof(RLK_CacheHeader)  ||
+      memcmp(header.magic, RLK_CACHE_MAGIC, sizeof(header.magic))  ||
+      header.version != RLK_CACHE_VERSION  ||
+      header.recordsize != sizeof(RLK_Line)  ||
+      header.Stokes != atmos.Stokes  ||
+      header.He_abund != atmos.elements[1].abund  ||
+      header.stamp != kuruczStamp(inputFile)  ||
+      header.Nrlk <= 0  ||
+      statBuffer.st_size != RLK_CACHE_HEADER +
+      (off_t) header.Nrlk * sizeof(RLK_Line)) {
+
+    sprintf(messageStr, "Kurucz line cache %s is out of date\n", cacheFile);
+    Error(WARNING, routineName, messageStr);
+    close(fd);
+    return FALSE;
+  }
+  rlk_mapsize = statBuffer.st_size;
+  rlk_map = mmap(NULL, rlk_mapsize, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+		 fd, 0);
+  close(fd);
+  if (rlk_map == MAP_FAILED) {
+    rlk_map = NULL;
+    return FALSE;
+  }
+  atmos.rlk_lines = (RLK_Line *) ((char *) rlk_map + RLK_CACHE_HEADER);
+  atmos.Nrlk = header.Nrlk;
+
+  sprintf(messageStr, "Mapped %d Kurucz lines from cache %s\n",
+	  atmos.Nrlk, cacheFile);
+  Error(MESSAGE, routineName, messageStr);
+  return TRUE;
+}
+/* ------- end ---------------------------- readKuruczCache.c ------- */
+
+/* ------- begin -------------------------- writeKuruczCache.c ------ */
+
+void writeKuruczCache(char *cacheFile, char *inputFile)
+{
+  const char routineName[] = "writeKuruczCache";
+
+  char   tmpName[MAX_LINE_SIZE + 64], hostname[64];
+  char   padding[RLK_CACHE_HEADER];
+  FILE  *fp_cache;
+  RLK_CacheHeader header;
+
+  /* --- Writes the sorted lines to the cache. Writes go to a file of
+         its own that is renamed to cacheFile at the end, so that
+         readers never see a partly written cache, and runs writing
+         the cache at the same time do not mix. --       ----------- */
+
+  if (!strcmp(cacheFile, "none")) return;
+
+  memset(&header, 0, sizeof(RLK_CacheHeader));
+  memcpy(header.magic, RLK_CACHE_MAGIC, sizeof(header.magic));
+  header.version    = RLK_CACHE_VERSION;
+  header.recordsize = sizeof(RLK_Line);
+  header.Nrlk       = atmos.Nrlk;
+  header.Stokes     = atmos.Stokes;
+  header.He_abund   = atmos.elements[1].abund;
+  header.stamp      = kuruczStamp(inputFile);
+
+  gethostname(hostname, sizeof(hostname));
+  hostname[sizeof(hostname) - 1] = '\0';
+  sprintf(tmpName, "%s.%s.%d", cacheFile, hostname, (int) getpid());
+  if ((fp_cache = fopen(tmpName, "w")) == NULL) {
+    sprintf(messageStr, "Unable to write Kurucz line cache %s", tmpName);
+    Error(WARNING, routineName, messageStr);
+    return;
+  }
+  memset(padding, 0, RLK_CACHE_HEADER);
+  memcpy(padding, &header, sizeof(RLK_CacheHeader));
+  if (fwrite(padding, 1, RLK_CACHE_HEADER, fp_cache) != RLK_CACHE_HEADER  ||
+      fwrite(atmos.rlk_lines, sizeof(RLK_Line), atmos.Nrlk, fp_cache) !=
+      (size_t) atmos.Nrlk  ||  fclose(fp_cache) != 0  ||
+      rename(tmpName, cacheFile) != 0) {
+    sprintf(messageStr, "Unable to write Kurucz line cache %s", cacheFile);
+    Error(WARNING, routineName, messageStr);
+    remove(tmpName);
+    return;
+  }
+  sprintf(messageStr, "Wrote %d Kurucz lines to cache %s\n",
+	  atmos.Nrlk, cacheFile);
+  Error(MESSAGE, routineName, messageStr);
+}
+/* ------- end ---------------------------- writeKuruczCache.c ------ */
+
 /* ------- begin -------------------------- rlk_ascend.c ------------ */
 
 int rlk_ascend(const void *v1, const void *v2)
@@ -409,6 +625,114 @@ void rlk_locate(int N, RLK_Line *lines, double lambda, int *low)
 }
 /* ------- end ---------------------------- rlk_locate.c ------------ */
 
+/* ------- begin -------------------------- initRLKProfiles.c ------- */
+
+void initRLKProfiles(void)
+{
+  register int n, k;
+
+  /* --- Tabulates the Doppler widths and damping parameters of the
+         Kurucz lines in the present column, for the lines within reach
+         of the wavelength grid. To be called once the populations of
+         the column are final, before rlk_opacity. The LTE populations
+         of the elements and the Zeeman patterns of polarizable lines
+         that rlk_opacity needs are set up here as well, so that
+         rlk_opacity does not change shared data and may be called
+         for several wavelengths concurrently. --      -------------- */
+
+  bool_t  *elem_used, *line_used;
+  int      ne;
+  long     Nvec;
+  double  *vec, vtherm;
+  RLK_Line *rlk;
+  Element  *element;
+
+  freeRLKProfiles();
+  if (atmos.Nrlk == 0) return;
+
+  /* --- First mark the elements and lines needed, and count -- ----- */
+
+  elem_used = (bool_t *) calloc(atmos.Nelem, sizeof(bool_t));
+  line_used = (bool_t *) calloc(atmos.Nrlk, sizeof(bool_t));
+
+  Nvec = 0;
+  for (n = 0;  n < atmos.Nrlk;  n++) {
+    rlk = &atmos.rlk_lines[n];
+    ne  = rlk->pt_index - 1;
+    element = &atmos.elements[ne];
+
+    if ((rlk->stage < element->Nstage - 1) && element->abundance_set &&
+	lineInReach(rlk->lambda0, Q_WING)) {
+      if (!elem_used[ne]) {
+	elem_used[ne] = TRUE;
+	Nvec += 2;
+      }
+      if (rlk->Grad) {
+	line_used[n] = TRUE;
+	Nvec++;
+      }
+      if (rlk->polarizable) {
+	if (atmos.rlk_zm != NULL) {
+	  if (atmos.rlk_zm[n] == NULL) atmos.rlk_zm[n] = RLKZeeman(rlk);
+	} else if (rlk->zm == NULL)
+	  rlk->zm = RLKZeeman(rlk);
+      }
+    }
+  }
+  rlk_broad.vbroad = (double **) calloc(atmos.Nelem, sizeof(double *));
+  rlk_broad.sv     = (double **) calloc(atmos.Nelem, sizeof(double *));
+  rlk_broad.adamp  = (double **) calloc(atmos.Nrlk, sizeof(double *));
+  rlk_broad.pool   = (double *) malloc(Nvec * atmos.Nspace * sizeof(double));
+  vec = rlk_broad.pool;
+
+  for (ne = 0;  ne < atmos.Nelem;  ne++) {
+    if (!elem_used[ne]) continue;
+
+    element = &atmos.elements[ne];
+    if (element->n == NULL) {
+      element->n = matrix_double(element->Nstage, atmos.Nspace);
+      LTEpops_elem(element);
+    }
+    rlk_broad.vbroad[ne] = vec;  vec += atmos.Nspace;
+    rlk_broad.sv[ne]     = vec;  vec += atmos.Nspace;
+
+    vtherm = 2.0*KBOLTZMANN/(AMU * atmos.elements[ne].weight);
+    for (k = 0;  k < atmos.Nspace;  k++) {
+      rlk_broad.vbroad[ne][k] = sqrt(vtherm*atmos.T[k] +
+				     SQ(atmos.vturb[k]));
+      rlk_broad.sv[ne][k] = 1.0 / (SQRTPI * rlk_broad.vbroad[ne][k]);
+    }
+  }
+  for (n = 0;  n < atmos.Nrlk;  n++) {
+    if (!line_used[n]) continue;
+
+    rlk = &atmos.rlk_lines[n];
+    rlk_broad.adamp[n] = vec;  vec += atmos.Nspace;
+    for (k = 0;  k < atmos.Nspace;  k++)
+      rlk_broad.adamp[n][k] =
+	RLKDamping(rlk, k, rlk_broad.vbroad[rlk->pt_index - 1][k]);
+  }
+  free(elem_used);
+  free(line_used);
+}
+/* ------- end ---------------------------- initRLKProfiles.c ------- */
+
+/* ------- begin -------------------------- freeRLKProfiles.c ------- */
+
+void freeRLKProfiles(void)
+{
+  if (rlk_broad.vbroad == NULL) return;
+
+  free(rlk_broad.vbroad);
+  free(rlk_broad.sv);
+  free(rlk_broad.adamp);
+  free(rlk_broad.pool);
+
+  rlk_broad.vbroad = rlk_broad.sv = rlk_broad.adamp = NULL;
+  rlk_broad.pool   = NULL;
+}
+/* ------- end ---------------------------- freeRLKProfiles.c ------- */
+
 /* ------- begin -------------------------- rlk_opacity.c ----------- */
 
 flags rlk_opacity(double lambda, int nspect, int mu, bool_t to_obs,
@@ -427,7 +751,7 @@ flags rlk_opacity(double lambda, int nspect, int mu, bool_t to_obs,
   Atom *metal;
   AtomicLine *line;
   Element *element;
-  RLK_Line *rlk;
+  RLK_Line *rlk, rlk_local;
   flags backgrflags;
 
   /* --- Calculate the LTE opacity at wavelength lambda due to atomic
@@ -557,7 +881,17 @@ flags rlk_opacity(double lambda, int nspect, int mu, bool_t to_obs,
 	backgrflags.hasline = TRUE;
 	if (rlk->polarizable) {
 	  backgrflags.ispolarized = TRUE;
-	  if (rlk->zm == NULL) rlk->zm = RLKZeeman(rlk);
+	  if (atmos.rlk_zm != NULL) {
+
+	    /* --- Lines are read-only (shared between processes), keep
+	           the Zeeman pattern with a local copy of the line -- */
+
+	    if (atmos.rlk_zm[n] == NULL) atmos.rlk_zm[n] = RLKZeeman(rlk);
+	    rlk_local    = *rlk;
+	    rlk_local.zm = atmos.rlk_zm[n];
+	    rlk = &rlk_local;
+	  } else if (rlk->zm == NULL)
+	    rlk->zm = RLKZeeman(rlk);
 	}
 
         if (element->n == NULL) {
@@ -568,7 +902,7 @@ flags rlk_opacity(double lambda, int nspect, int mu, bool_t to_obs,
 	       atmos.Nspace, atmos.T, pf, hunt=TRUE);
 
 	for (k = 0;  k < atmos.Nspace;  k++) {
-	  phi = RLKProfile(rlk, k, mu, to_obs, lambda,
+	  phi = RLKProfile(rlk, n, k, mu, to_obs, lambda,
 			   &phi_Q, &phi_U, &phi_V,
 			   &psi_Q, &psi_U, &psi_V);
 
@@ -621,7 +955,7 @@ flags rlk_opacity(double lambda, int nspect, int mu, bool_t to_obs,
 
 /* ------- begin -------------------------- RLKProfile.c ------------ */
 
-double RLKProfile(RLK_Line *rlk, int k, int mu, bool_t to_obs,
+double RLKProfile(RLK_Line *rlk, int n, int k, int mu, bool_t to_obs,
                   double lambda,
 		  double *phi_Q, double *phi_U, double *phi_V,
 		  double *psi_Q, double *psi_U, double *psi_V)
@@ -630,15 +964,23 @@ double RLKProfile(RLK_Line *rlk, int k, int mu, bool_t to_obs,
 
   double v, phi_sm, phi_sp, phi_pi, psi_sm, psi_sp, psi_pi, adamp,
          vB, H, F, sv, phi_sigma, phi_delta, sign, sin2_gamma, phi,
-         psi_sigma, psi_delta, vbroad, vtherm, GvdW, *np;
+         psi_sigma, psi_delta, vbroad, vtherm;
   Element *element;
 
-  /* --- Returns the normalized profile for a Kurucz line
-         and calculates the Stokes profile components if necessary -- */
+  /* --- Returns the normalized profile for Kurucz line n
+         and calculates the Stokes profile components if necessary.
+         Doppler width and damping come from initRLKProfiles when
+         tabulated there --                            -------------- */
 
-  element = &atmos.elements[rlk->pt_index - 1];
-  vtherm  = 2.0*KBOLTZMANN/(AMU * element->weight);
-  vbroad  = sqrt(vtherm*atmos.T[k] + SQ(atmos.vturb[k]));
+  if (rlk_broad.vbroad  &&  rlk_broad.vbroad[rlk->pt_index - 1]) {
+    vbroad = rlk_broad.vbroad[rlk->pt_index - 1][k];
+    sv     = rlk_broad.sv[rlk->pt_index - 1][k];
+  } else {
+    element = &atmos.elements[rlk->pt_index - 1];
+    vtherm  = 2.0*KBOLTZMANN/(AMU * element->weight);
+    vbroad  = sqrt(vtherm*atmos.T[k] + SQ(atmos.vturb[k]));
+    sv      = 1.0 / (SQRTPI * vbroad);
+  }
 
   v = (lambda/rlk->lambda0 - 1.0) * CLIGHT/vbroad;
   if (atmos.moving) {
@@ -647,26 +989,12 @@ double RLKProfile(RLK_Line *rlk, int k, int mu, bool_t to_obs,
     else
       v -= vproject(k, mu) / vbroad;
   }
-  sv = 1.0 / (SQRTPI * vbroad);
 
   if (rlk->Grad) {
-    switch (rlk->vdwaals) {
-    case UNSOLD:
-      GvdW = rlk->cross * pow(atmos.T[k], 0.3);
-      break;
-
-    case BARKLEM:
-      GvdW = rlk->cross * pow(atmos.T[k], (1.0 - rlk->alpha)/2.0);
-      break;
-
-    default:
-      GvdW = rlk->GvdWaals;
-      break;
-    }
-    np = atmos.H->n[atmos.H->Nlevel-1];
-    adamp = (rlk->Grad + rlk->GStark * atmos.ne[k] +
-	     GvdW * (atmos.nHtot[k] - np[k])) *
-      (rlk->lambda0  * NM_TO_M) / (4.0*PI * vbroad);
+    if (rlk_broad.adamp  &&  rlk_broad.adamp[n])
+      adamp = rlk_broad.adamp[n][k];
+    else
+      adamp = RLKDamping(rlk, k, vbroad);
   } else {
     phi = (fabs(v) <= MAX_GAUSS_DOPPLER) ? exp(-v*v) : 0.0;
     return phi * sv;
@@ -721,6 +1049,34 @@ double RLKProfile(RLK_Line *rlk, int k, int mu, bool_t to_obs,
 }
 /* ------- end ---------------------------- RLKProfile.c ------------ */
 
+/* ------- begin -------------------------- RLKDamping.c ------------ */
+
+double RLKDamping(RLK_Line *rlk, int k, double vbroad)
+{
+  /* --- Voigt damping parameter of Kurucz line at depth k -- ------- */
+
+  double GvdW, *np;
+
+  switch (rlk->vdwaals) {
+  case UNSOLD:
+    GvdW = rlk->cross * pow(atmos.T[k], 0.3);
+    break;
+
+  case BARKLEM:
+    GvdW = rlk->cross * pow(atmos.T[k], (1.0 - rlk->alpha)/2.0);
+    break;
+
+  default:
+    GvdW = rlk->GvdWaals;
+    break;
+  }
+  np = atmos.H->n[atmos.H->Nlevel-1];
+  return (rlk->Grad + rlk->GStark * atmos.ne[k] +
+	  GvdW * (atmos.nHtot[k] - np[k])) *
+    (rlk->lambda0  * NM_TO_M) / (4.0*PI * vbroad);
+}
+/* ------- end ---------------------------- RLKDamping.c ------------ */
+
 /* ------- begin -------------------------- RLKZeeman.c ------------- */
 
 ZeemanMultiplet* RLKZeeman(RLK_Line *rlk)
@@ -56,8 +56,18 @@
 #define N_MAX_OVERLAP  10
 
 
+/* --- Lines in use at the previous wavelength in passive_bb -- ---- */
+
+typedef struct {
+  int Nlist;
+  struct Linelist *linelist[N_MAX_OVERLAP];
+} PassiveList;
+
+
 /* --- Function prototypes --                          -------------- */
 
+static void initPassiveLists(void);
+
 
 /* --- Global variables --                             -------------- */
 
@@ -65,6 +75,37 @@ extern Atmosphere atmos;
 extern char messageStr[];
 extern InputData input;
 
+static PassiveList   *passive_lists = NULL;
+static pthread_once_t passive_once  = PTHREAD_ONCE_INIT;
+
+
+/* ------- begin -------------------------- Metal_bfCross.c --------- */
+
+double Metal_bfCross(double lambda, Atom *metal, AtomicContinuum *continuum)
+{
+  /* --- Cross section of bound-free transition continuum of metal at
+         wavelength lambda, within its wavelength range --  --------- */
+
+  bool_t   hunt;
+  int      Z;
+  double   alpha_la, n_eff, gbf_0;
+
+  if (continuum->hydrogenic) {
+    Z = metal->stage[continuum->j];
+    n_eff = Z*sqrt(E_RYDBERG / (metal->E[continuum->j] -
+				metal->E[continuum->i]));
+    gbf_0 = Gaunt_bf(continuum->lambda0, n_eff, Z);
+
+    alpha_la = continuum->alpha0 * CUBE(lambda/continuum->lambda0) *
+      Gaunt_bf(lambda, n_eff, Z) / gbf_0;
+  } else {
+    splineTableEval(continuum->Nlambda, continuum->lambda,
+		    continuum->alpha, continuum->alpha_M2, 1, &lambda,
+		    &alpha_la, hunt=FALSE);
+  }
+  return alpha_la;
+}
+/* ------- end ---------------------------- Metal_bfCross.c --------- */
 
 /* ------- begin -------------------------- Metal_bf.c -------------- */
 
@@ -73,10 +114,9 @@ bool_t Metal_bf(double lambda, int Nmetal, struct Atom *metals,
 {  
   register int  m, k, kr;
 
-  bool_t   hunt;
-  int      i, j, Z;
+  int      i, j;
   double   lambdaEdge, alpha_la, twohnu3_c2, twohc, gijk, hc_k, hc_kla,
-         **n, *expla = NULL, n_eff, gbf_0;
+         **n, *expla = NULL;
   Atom *metal;
   AtomicContinuum *continuum;
 
@@ -118,19 +158,7 @@ bool_t Metal_bf(double lambda, int Nmetal, struct Atom *metals,
 	      expla[k] = exp(-hc_kla/atmos.T[k]);
 	  }
 
-	  if (continuum->hydrogenic) {
-	    Z = metal->stage[continuum->j];
-	    n_eff = Z*sqrt(E_RYDBERG / (metal->E[continuum->j] -
-					metal->E[continuum->i]));
-	    gbf_0 = Gaunt_bf(continuum->lambda0, n_eff, Z);
-
-	    alpha_la = continuum->alpha0 * CUBE(lambda/continuum->lambda0) *
-	      Gaunt_bf(lambda, n_eff, Z) / gbf_0;
-	  } else {
-	    splineCoef(continuum->Nlambda, continuum->lambda,
-		       continuum->alpha);
-	    splineEval(1, &lambda, &alpha_la, hunt=FALSE);
-	  }
+	  alpha_la = Metal_bfCross(lambda, metal, continuum);
 
 	  for (k = 0;  k < atmos.Nspace;  k++) {
 	    gijk    = metal->nstar[i][k]/metal->nstar[j][k] * expla[k];
@@ -149,6 +177,47 @@ bool_t Metal_bf(double lambda, int Nmetal, struct Atom *metals,
 }
 /* ------- end ---------------------------- Metal_bf.c -------------- */
 
+/* ------- begin -------------------------- initPassiveLists.c ------ */
+
+static void initPassiveLists(void)
+{
+  /* --- One list of recently used lines per thread for passive_bb,
+         created at the first call --                  -------------- */
+
+  passive_lists = (PassiveList *) calloc(MAX(input.Nthreads, 1),
+					 sizeof(PassiveList));
+}
+/* ------- end ---------------------------- initPassiveLists.c ------ */
+
+/* ------- begin -------------------------- resetPassiveLists.c ----- */
+
+void resetPassiveLists(void)
+{
+  register int n, l;
+
+  PassiveList *plist;
+
+  /* --- Empty the line lists of all threads. The damping parameters
+         in the lists belong to the previous atmosphere (column), so
+         this has to be called before passive_bb is used for a new
+         one. Not thread safe, call outside the thread pool -- ------ */
+
+  pthread_once(&passive_once, initPassiveLists);
+
+  for (n = 0;  n < MAX(input.Nthreads, 1);  n++) {
+    plist = &passive_lists[n];
+    for (l = 0;  l < N_MAX_OVERLAP;  l++) {
+      if (plist->linelist[l]) {
+	if (plist->linelist[l]->adamp) free(plist->linelist[l]->adamp);
+	free(plist->linelist[l]);
+	plist->linelist[l] = NULL;
+      }
+    }
+    plist->Nlist = 0;
+  }
+}
+/* ------- end ---------------------------- resetPassiveLists.c ----- */
+
 /* ------- begin -------------------------- passive_bb.c ------------ */
 
 flags passive_bb(double lambda, int nspect, int mu, bool_t to_obs,
@@ -157,16 +226,14 @@ flags passive_bb(double lambda, int nspect, int mu, bool_t to_obs,
   const char routineName[] = "passive_bb";
   register int k, kr, l, m, nc;
 
-  static bool_t initialize = TRUE;
-  static int Nlist;
-  static struct Linelist *linelist[N_MAX_OVERLAP];
-
   bool_t   add_to_list, linepresent;
-  int      i, j, entry;
+  int      i, j, entry, Nlist;
   double   dlambda, phi, v, twohnu3_c2, hc, fourPI, hc_4PI,
            gij, Vij, **n;
   Atom *atom;
   AtomicLine *line;
+  PassiveList *plist;
+  struct Linelist **linelist;
   flags backgrflags;
 
   /* --- Calculate contribution of bound-bound transitions in the 
@@ -175,17 +242,17 @@ flags passive_bb(double lambda, int nspect, int mu, bool_t to_obs,
  
    Note: A list of lines is maintained to prevent recalculation of
          the damping parameter of the lines for successive wavelengths
-         and angles.
+         and angles. Each thread keeps its own list, so that
+         wavelengths may be done concurrently.
          --                                            -------------- */
 
   backgrflags.hasline     = FALSE;
   backgrflags.ispolarized = FALSE;
 
-  if (initialize) {
-    for (l = 0;  l < N_MAX_OVERLAP;  l++) linelist[l] = NULL;
-    Nlist = 0;
-    initialize = FALSE;
-  }
+  pthread_once(&passive_once, initPassiveLists);
+  plist    = &passive_lists[threadSlot()];
+  Nlist    = plist->Nlist;
+  linelist = plist->linelist;
 
   hc     = HPLANCK * CLIGHT;
   fourPI = 4.0 * PI;
@@ -319,6 +386,7 @@ flags passive_bb(double lambda, int nspect, int mu, bool_t to_obs,
 
   Nlist = 0;
   for (l = 0;  l < N_MAX_OVERLAP;  l++) if (linelist[l]) Nlist++;
+  plist->Nlist = Nlist;
 
   return backgrflags;
 }
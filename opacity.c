@@ -51,6 +51,17 @@ double MolProfile(MolecularLine *mrt, int k, int mu, bool_t to_obs,
 		  double *psi_Q, double *psi_U, double *psi_V);
 
 
+/* --- Per-column broadening of the background molecular lines, set
+       up by initMolProfiles for the lines within reach of the
+       wavelength grid: sv = 1/(sqrt(pi) vbroad) per molecule, and the
+       damping parameter per line, both per depth. Entries are NULL
+       for molecules and lines not needed. --          -------------- */
+
+typedef struct {
+  double **sv, ***adamp;
+} MolBroadening;
+
+
 /* --- Global variables --                             -------------- */
 
 extern Atmosphere atmos;
@@ -58,6 +69,8 @@ extern Spectrum spectrum;
 extern InputData input;
 extern char messageStr[];
 
+static MolBroadening mol_broad = {NULL, NULL};
+
 
 /* ------- begin -------------------------- Opacity.c --------------- */
 
@@ -93,7 +106,7 @@ void Opacity(int nspect, int mu, bool_t to_obs, bool_t initialize)
   hc_k   = hc / (KBOLTZMANN * NM_TO_M);
 
   as = &spectrum.as[nspect];
-  nt = nspect % input.Nthreads;
+  nt = threadSlot();
 
   /* --- If polarized transition is present and we solve for polarized
          radiation we need to fill all four Stokes components -- ---- */
@@ -452,7 +465,7 @@ void alloc_as(int nspect, bool_t crosscoupling)
   ActiveSet *as;
 
   as = &spectrum.as[nspect];
-  nt = nspect % input.Nthreads;
+  nt = threadSlot();
 
   /* --- Allocate space for background opacities and emissivity -- -- */
 
@@ -555,7 +568,7 @@ void free_as(int nspect, bool_t crosscoupling)
   ActiveSet *as;
 
   as = &spectrum.as[nspect];
-  nt = nspect % input.Nthreads;
+  nt = threadSlot();
 
   free(as->chi_c);
   free(as->eta_c);
@@ -752,6 +765,113 @@ void mrt_locate(int N, MolecularLine *lines, double lambda, int *low)
 }
 /* ------- end ---------------------------- mrt_locate.c ------------ */
 
+/* ------- begin -------------------------- lineInReach.c ----------- */
+
+bool_t lineInReach(double lambda0, double qwing)
+{
+  /* --- Is a background line at lambda0 within qwing Doppler widths
+         (of velocity vmicro_char) of any wavelength in the grid? As in
+         rlk_opacity and MolecularOpacity only the nearest wavelengths
+         on either side need checking. --              -------------- */
+
+  int    j, jmax;
+  double lambda;
+
+  Locate(spectrum.Nspect, spectrum.lambda, lambda0, &j);
+  jmax = MIN(j + 1, spectrum.Nspect - 1);
+  for ( ;  j <= jmax;  j++) {
+    lambda = spectrum.lambda[j];
+    if (fabs(lambda0 - lambda) <= lambda * qwing *
+	(atmos.vmicro_char / CLIGHT)) return TRUE;
+  }
+  return FALSE;
+}
+/* ------- end ---------------------------- lineInReach.c ----------- */
+
+/* ------- begin -------------------------- initMolProfiles.c ------- */
+
+void initMolProfiles(void)
+{
+  register int n, k, kr;
+
+  /* --- Tabulates sv and the damping parameters of the molecular lines
+         in the present column, for the passive molecules and the lines
+         within reach of the wavelength grid. To be called once the
+         broadening velocities of the column are set, before
+         MolecularOpacity. The Zeeman patterns of polarizable lines
+         are made here too, so that MolecularOpacity may be called for
+         several wavelengths concurrently. --          -------------- */
+
+  bool_t   *inreach;
+  long      Nvec;
+  double   *vec;
+  Molecule *molecule;
+  MolecularLine *mrt;
+
+  freeMolProfiles();
+  if (atmos.Nmolecule == 0) return;
+
+  mol_broad.sv    = (double **) calloc(atmos.Nmolecule, sizeof(double *));
+  mol_broad.adamp = (double ***) calloc(atmos.Nmolecule, sizeof(double **));
+
+  for (n = 0;  n < atmos.Nmolecule;  n++) {
+    molecule = &atmos.molecules[n];
+    if (molecule->Nrt == 0  ||  molecule->active) continue;
+
+    inreach = (bool_t *) malloc(molecule->Nrt * sizeof(bool_t));
+    Nvec = 1;
+    for (kr = 0;  kr < molecule->Nrt;  kr++) {
+      mrt = &molecule->mrt[kr];
+      inreach[kr] = lineInReach(mrt->lambda0, mrt->qwing);
+      if (inreach[kr]) {
+	Nvec++;
+	if (mrt->polarizable  &&  mrt->zm == NULL) mrt->zm = MolZeeman(mrt);
+      }
+    }
+    /* --- sv comes first, so that mol_broad.sv[n] holds the block -- */
+
+    vec = (double *) malloc(Nvec * atmos.Nspace * sizeof(double));
+    mol_broad.sv[n] = vec;  vec += atmos.Nspace;
+    for (k = 0;  k < atmos.Nspace;  k++)
+      mol_broad.sv[n][k] = 1.0 / (SQRTPI * molecule->vbroad[k]);
+
+    mol_broad.adamp[n] = (double **) calloc(molecule->Nrt, sizeof(double *));
+    for (kr = 0;  kr < molecule->Nrt;  kr++) {
+      if (!inreach[kr]) continue;
+      mrt = &molecule->mrt[kr];
+
+      mol_broad.adamp[n][kr] = vec;  vec += atmos.Nspace;
+      for (k = 0;  k < atmos.Nspace;  k++)
+	mol_broad.adamp[n][kr][k] = mrt->Aji * (mrt->lambda0 * NM_TO_M) /
+	  (4.0*PI * molecule->vbroad[k]);
+    }
+    free(inreach);
+  }
+}
+/* ------- end ---------------------------- initMolProfiles.c ------- */
+
+/* ------- begin -------------------------- freeMolProfiles.c ------- */
+
+void freeMolProfiles(void)
+{
+  register int n;
+
+  if (mol_broad.sv == NULL) return;
+
+  for (n = 0;  n < atmos.Nmolecule;  n++) {
+    if (mol_broad.sv[n] != NULL) {
+      free(mol_broad.sv[n]);
+      free(mol_broad.adamp[n]);
+    }
+  }
+  free(mol_broad.sv);
+  free(mol_broad.adamp);
+
+  mol_broad.sv    = NULL;
+  mol_broad.adamp = NULL;
+}
+/* ------- end ---------------------------- freeMolProfiles.c ------- */
+
 /* ------- begin -------------------------- MolecularOpacity.c ------ */
 
 flags MolecularOpacity(double lambda, int nspect, int mu, bool_t to_obs,
@@ -896,12 +1016,21 @@ double MolProfile(MolecularLine *mrt, int k, int mu, bool_t to_obs,
             vB, H, F, sv, phi_sigma, phi_delta, sign, sin2_gamma, phi,
             psi_sigma, psi_delta;
   Molecule *molecule = mrt->molecule;
+  int       n = molecule - atmos.molecules, kr = mrt - molecule->mrt;
 
   /* --- Returns the normalized profile for a molecular line,
-         and calculates the Stokes profile components if necessary -- */
+         and calculates the Stokes profile components if necessary.
+         Damping and sv come from initMolProfiles when tabulated
+         there --                                      -------------- */
 
-  adamp = mrt->Aji * (mrt->lambda0 * NM_TO_M) / (4.0*PI *
-						 molecule->vbroad[k]);
+  if (mol_broad.sv  &&  mol_broad.adamp[n]  &&  mol_broad.adamp[n][kr]) {
+    adamp = mol_broad.adamp[n][kr][k];
+    sv    = mol_broad.sv[n][k];
+  } else {
+    adamp = mrt->Aji * (mrt->lambda0 * NM_TO_M) / (4.0*PI *
+						   molecule->vbroad[k]);
+    sv    = 1.0 / (SQRTPI * molecule->vbroad[k]);
+  }
   v = (lambda/mrt->lambda0 - 1.0) * CLIGHT/molecule->vbroad[k];
   if (atmos.moving) {
     if (to_obs)
@@ -909,7 +1038,6 @@ double MolProfile(MolecularLine *mrt, int k, int mu, bool_t to_obs,
     else
       v -= vproject(k, mu) / molecule->vbroad[k];
   }
-  sv = 1.0 / (SQRTPI * molecule->vbroad[k]);
 
   if (mrt->polarizable) {
     sin2_gamma = 1.0 - SQ(atmos.cos_gamma[mu][k]);
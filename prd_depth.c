@@ -0,0 +1,380 @@
+/* ------- file: -------------------------- prd_depth.c -------------
+
+       Version:       rh2.0
+       Last modified: Sun Oct 18 2026 --
+
+       --------------------------                      ----------RH-- */
+
+/* --- Scattering integrals of the subordinate lines of a PRD line,
+       depth by depth, for the PRDScatter and PRDAngleApproxScatter
+       versions of both RH and rh15d.
+
+       prdRedistribute adds the integrals to PRDline->rho_prd, over
+       the thread pool when input.Nthreads > 1. prdAllocWeights keeps
+       the redistribution weights of PRDline in memory.
+       --                                              -------------- */
+
+#include <stdlib.h>
+#include <math.h>
+
+#include "rh.h"
+#include "atom.h"
+#include "atmos.h"
+#include "inputs.h"
+#include "constant.h"
+#include "error.h"
+
+#define TENSION  8.0
+
+
+/* --- Scratch space of one thread in prdDepth --     -------------- */
+
+typedef struct {
+  double *J_k, *q_abs, *M2, *u, *qp, *qpp, *J, *gii, *wq;
+} PRDScratch;
+
+/* --- Shared by the depths of one subordinate line -- ------------ */
+
+typedef struct {
+  bool_t  initialize;
+  enum Interpolation representation;
+  double  waveratio, *Pj, *adamp, **Jnu, **gII;
+  AtomicLine *PRDline, *XRDline;
+  PRDScratch *scratch;
+} PRDWork;
+
+
+/* --- Function prototypes --                          -------------- */
+
+static int  prdLimits(double q_emit, double waveratio, double *q0);
+static void prdDepth(int k, void *argument);
+static void prdWeightsFile(AtomicLine *PRDline, AtomicLine **XRD,
+			   int Nsubordinate, bool_t write);
+
+
+/* --- Global variables --                             -------------- */
+
+extern Atmosphere atmos;
+extern InputData input;
+extern char messageStr[];
+
+
+/* ------- begin -------------------------- prdLimits.c ------------- */
+
+static int prdLimits(double q_emit, double waveratio, double *q0)
+{
+  double qN;
+
+  /* --- Lower limit q0 and number of points of the integration over
+         absorption wavelength at emission wavelength q_emit, using
+         only regions where the redistribution function is non-zero.
+         (See also function GII.) --                   -------------- */
+
+  if (fabs(q_emit) < PRD_QCORE) {
+    *q0 = -PRD_QWING;
+    qN  =  PRD_QWING;
+  } else {
+    if (fabs(q_emit) < PRD_QWING) {
+      if (q_emit > 0.0) {
+	*q0 = -PRD_QWING;
+	qN  = waveratio * (q_emit + PRD_QSPREAD);
+      } else {
+	*q0 = waveratio * (q_emit - PRD_QSPREAD);
+	qN  = PRD_QWING;
+      }
+    } else {
+      *q0 = waveratio * (q_emit - PRD_QSPREAD);
+      qN  = waveratio * (q_emit + PRD_QSPREAD);
+    }
+  }
+  return (int) ((qN - *q0) / PRD_DQ) + 1;
+}
+/* ------- end ---------------------------- prdLimits.c ------------- */
+
+/* ------- begin -------------------------- prdAllocWeights.c ------- */
+
+void prdAllocWeights(AtomicLine *PRDline, AtomicLine **XRD,
+		     int Nsubordinate)
+{
+  register int kxrd;
+
+  int    Npmax = 0;
+  double waveratio, range;
+
+  /* --- Keeps the redistribution weights of PRDline in memory, one
+         row for each subordinate line, depth and emission wavelength,
+         long enough for the widest integration range of prdLimits.
+         gII[0][0] < 0 marks weights still to be computed. -- ------ */
+
+  for (kxrd = 0;  kxrd < Nsubordinate;  kxrd++) {
+    waveratio = XRD[kxrd]->lambda0 / PRDline->lambda0;
+    range = MAX(2.0*PRD_QWING,
+		MAX(PRD_QWING + waveratio * (PRD_QWING + PRD_QSPREAD),
+		    2.0*waveratio * PRD_QSPREAD));
+    Npmax = MAX(Npmax, (int) (range / PRD_DQ) + 2);
+  }
+  PRDline->gII = matrix_double(Nsubordinate * atmos.Nspace *
+			       PRDline->Nlambda, Npmax);
+  PRDline->gII[0][0] = -1.0;
+}
+/* ------- end ---------------------------- prdAllocWeights.c ------- */
+
+/* ------- begin -------------------------- prdDepth.c -------------- */
+
+static void prdDepth(int k, void *argument)
+{
+  const char routineName[] = "prdDepth";
+  register int la, lap;
+
+  bool_t  hunt;
+  int     Np, Nread, Nwrite;
+  double  q_emit, q0, *gii, gnorm, Jbar, scatInt, gamma;
+
+  PRDWork    *pw = (PRDWork *) argument;
+  PRDScratch *ps = &pw->scratch[threadSlot()];
+  AtomicLine *PRDline = pw->PRDline, *XRDline = pw->XRDline;
+  Atom       *atom = PRDline->atom;
+
+  /* --- Adds the contribution of subordinate line XRDline to the
+         emission profile ratio rho of PRDline at depth k. Uses only
+         the scratch space of the calling thread, so that depths may
+         be done concurrently when the weights are in memory. -- --- */
+
+  gamma = atom->n[XRDline->i][k] / atom->n[PRDline->j][k] *
+    XRDline->Bij / pw->Pj[k];
+  Jbar = XRDline->Rij[k] / XRDline->Bij;
+
+  /* --- Get local mean intensity and wavelength in Doppler units -- */
+
+  for (la = 0;  la < XRDline->Nlambda;  la++) {
+    ps->J_k[la]   = pw->Jnu[XRDline->Nblue + la][k];
+    ps->q_abs[la] = (XRDline->lambda[la] - XRDline->lambda0) * CLIGHT /
+      (XRDline->lambda0 * atom->vbroad[k]);
+  }
+  switch (pw->representation) {
+  case LINEAR:
+    break;
+  case SPLINE:
+    splineTable(XRDline->Nlambda, ps->q_abs, ps->J_k, ps->M2, ps->u);
+    break;
+  case EXP_SPLINE:
+    exp_splineCoef(XRDline->Nlambda, ps->q_abs, ps->J_k, TENSION);
+    break;
+  }
+  /* --- Outer wavelength loop over emission wavelengths -- --------- */
+
+  for (la = 0;  la < PRDline->Nlambda;  la++) {
+    q_emit = (PRDline->lambda[la] - PRDline->lambda0) * CLIGHT /
+      (PRDline->lambda0 * atom->vbroad[k]);
+
+    Np = prdLimits(q_emit, pw->waveratio, &q0);
+    ps->qp = (double *) realloc(ps->qp,  Np * sizeof(double));
+    for (lap = 1, ps->qp[0] = q0;  lap < Np;  lap++)
+      ps->qp[lap] = ps->qp[lap - 1] + PRD_DQ;
+
+    /* --- Fold interpolation of J for symmetric lines. -- ---------- */
+
+    if (XRDline->symmetric) {
+      ps->qpp = (double *) realloc(ps->qpp,  Np * sizeof(double));
+      for (lap = 0;  lap < Np;  lap++) ps->qpp[lap] = fabs(ps->qp[lap]);
+    }
+
+    /* --- Interpolate mean intensity onto fine grid. Choose linear,
+           spline or exponential spline interpolation -- ------------ */
+
+    ps->J = (double *) realloc(ps->J,  Np * sizeof(double));
+    switch (pw->representation) {
+    case LINEAR:
+      Linear(XRDline->Nlambda, ps->q_abs, ps->J_k, Np,
+	     (XRDline->symmetric) ? ps->qpp : ps->qp, ps->J, hunt=TRUE);
+      break;
+    case SPLINE:
+      splineTableEval(XRDline->Nlambda, ps->q_abs, ps->J_k, ps->M2, Np,
+		      (XRDline->symmetric) ? ps->qpp : ps->qp, ps->J,
+		      hunt=TRUE);
+      break;
+    case EXP_SPLINE:
+      exp_splineEval(Np, (XRDline->symmetric) ? ps->qpp : ps->qp,
+		     ps->J, hunt=TRUE);
+      break;
+    }
+    /* --- Redistribution weights, from memory or from file -- ------ */
+
+    if (pw->gII) {
+      gii = pw->gII[k*PRDline->Nlambda + la];
+    } else {
+      ps->gii = (double *) realloc(ps->gii, Np * sizeof(double));
+      gii = ps->gii;
+    }
+    if (pw->initialize) {
+
+      /* --- Integration weights (See: Press et al. Numerical Recipes,
+	     p. 107, eq. 4.1.12) --                    -------------- */
+
+      ps->wq = (double *) realloc(ps->wq,  Np * sizeof(double));
+      ps->wq[0] = 5.0/12.0  * PRD_DQ;
+      ps->wq[1] = 13.0/12.0 * PRD_DQ;
+      for (lap = 2;  lap < Np-2;  lap++) ps->wq[lap] = PRD_DQ;
+      ps->wq[Np-1] = 5.0/12.0  * PRD_DQ;
+      ps->wq[Np-2] = 13.0/12.0 * PRD_DQ;
+
+      for (lap = 0;  lap < Np;  lap++)
+	gii[lap] = GII(pw->adamp[k], pw->waveratio, q_emit, ps->qp[lap]) *
+	  ps->wq[lap];
+
+      if (pw->gII == NULL  &&
+	  (Nwrite = fwrite(gii, sizeof(double), Np, PRDline->fp_GII)) != Np) {
+	sprintf(messageStr,
+		"Unable to write proper number of redistribution weights\n"
+		" Wrote %d instead of %d.\n Line %d -> %d, la = %d, k = %d",
+		Nwrite, Np, XRDline->j, XRDline->i, la, k);
+	Error(ERROR_LEVEL_2, routineName, messageStr);
+      }
+    } else if (pw->gII == NULL) {
+      if ((Nread = fread(gii, sizeof(double), Np, PRDline->fp_GII)) != Np) {
+	sprintf(messageStr,
+		"Unable to read proper number of redistribution weights\n"
+		" Read %d instead of %d.\n Line %d -> %d, la = %d, k = %d",
+		Nread, Np, XRDline->j, XRDline->i, la, k);
+	Error(ERROR_LEVEL_2, routineName, messageStr);
+      }
+    }
+    /* --- Inner wavelength loop doing actual wavelength integration
+           over absorption wavelengths --              -------------- */
+
+    gnorm   = 0.0;
+    scatInt = 0.0;
+    for (lap = 0;  lap < Np;  lap++) {
+      gnorm   += gii[lap];
+      scatInt += ps->J[lap] * gii[lap];
+    }
+    PRDline->rho_prd[la][k] += gamma*(scatInt/gnorm - Jbar);
+  }
+}
+/* ------- end ---------------------------- prdDepth.c -------------- */
+
+/* ------- begin -------------------------- prdWeightsFile.c -------- */
+
+static void prdWeightsFile(AtomicLine *PRDline, AtomicLine **XRD,
+			   int Nsubordinate, bool_t write)
+{
+  const char routineName[] = "prdWeightsFile";
+  register int kxrd, k, la;
+
+  int    Np, Ndone, row = 0;
+  double q_emit, q0, waveratio;
+  Atom  *atom = PRDline->atom;
+
+  /* --- Copies the redistribution weights in memory to, or from,
+         file PRDline->fp_GII, in the order in which prdDepth would
+         write them when the depths are done one by one. -- -------- */
+
+  for (kxrd = 0;  kxrd < Nsubordinate;  kxrd++) {
+    waveratio = XRD[kxrd]->lambda0 / PRDline->lambda0;
+
+    for (k = 0;  k < atmos.Nspace;  k++) {
+      for (la = 0;  la < PRDline->Nlambda;  la++, row++) {
+	q_emit = (PRDline->lambda[la] - PRDline->lambda0) * CLIGHT /
+	  (PRDline->lambda0 * atom->vbroad[k]);
+	Np = prdLimits(q_emit, waveratio, &q0);
+
+	if (write)
+	  Ndone = fwrite(PRDline->gII[row], sizeof(double), Np,
+			 PRDline->fp_GII);
+	else
+	  Ndone = fread(PRDline->gII[row], sizeof(double), Np,
+			PRDline->fp_GII);
+	if (Ndone != Np) {
+	  sprintf(messageStr,
+		  "Unable to %s proper number of redistribution weights\n"
+		  " Did %d instead of %d.\n Line %d -> %d, la = %d, k = %d",
+		  (write) ? "write" : "read", Ndone, Np,
+		  XRD[kxrd]->j, XRD[kxrd]->i, la, k);
+	  Error(ERROR_LEVEL_2, routineName, messageStr);
+	}
+      }
+    }
+  }
+}
+/* ------- end ---------------------------- prdWeightsFile.c -------- */
+
+/* ------- begin -------------------------- prdRedistribute.c ------- */
+
+void prdRedistribute(AtomicLine *PRDline, AtomicLine **XRD,
+		     int Nsubordinate, enum Interpolation representation,
+		     bool_t initialize, double *Pj, double *adamp,
+		     double **Jnu)
+{
+  register int kxrd, k, n;
+
+  bool_t   threaded;
+  int      Nscratch;
+  PRDWork  pw;
+
+  /* --- Adds the scattering integrals of all subordinate lines to the
+         emission profile ratio rho of PRDline, with mean intensity
+         Jnu. With input.Nthreads > 1 the depths are done over the
+         thread pool. This needs the redistribution weights in memory,
+         since their file can only be read in sequence. They are then
+         read from, or written to, that file once, so that existing
+         weights are still used. With EXP_SPLINE interpolation, which
+         keeps its coefficients in static storage, depths are always
+         done one by one. --                           -------------- */
+
+  threaded = (input.Nthreads > 1  &&  representation != EXP_SPLINE);
+  if (threaded  &&  PRDline->gII == NULL) {
+    prdAllocWeights(PRDline, XRD, Nsubordinate);
+    if (!initialize  &&  PRDline->fp_GII)
+      prdWeightsFile(PRDline, XRD, Nsubordinate, FALSE);
+  }
+  if (PRDline->gII  &&  PRDline->gII[0][0] < 0.0) initialize = TRUE;
+
+  Nscratch   = (threaded) ? input.Nthreads : 1;
+  pw.scratch = (PRDScratch *) calloc(Nscratch, sizeof(PRDScratch));
+
+  pw.PRDline        = PRDline;
+  pw.representation = representation;
+  pw.initialize     = initialize;
+  pw.Pj             = Pj;
+  pw.adamp          = adamp;
+  pw.Jnu            = Jnu;
+
+  for (kxrd = 0;  kxrd < Nsubordinate;  kxrd++) {
+    pw.XRDline   = XRD[kxrd];
+    pw.waveratio = XRD[kxrd]->lambda0 / PRDline->lambda0;
+    pw.gII = (PRDline->gII) ?
+      PRDline->gII + kxrd * atmos.Nspace*PRDline->Nlambda : NULL;
+
+    for (n = 0;  n < Nscratch;  n++) {
+      pw.scratch[n].J_k =
+	realloc(pw.scratch[n].J_k, XRD[kxrd]->Nlambda * sizeof(double));
+      pw.scratch[n].q_abs =
+	realloc(pw.scratch[n].q_abs, XRD[kxrd]->Nlambda * sizeof(double));
+      pw.scratch[n].M2 =
+	realloc(pw.scratch[n].M2, XRD[kxrd]->Nlambda * sizeof(double));
+      pw.scratch[n].u =
+	realloc(pw.scratch[n].u, XRD[kxrd]->Nlambda * sizeof(double));
+    }
+    /* --- Loop over all spatial locations --          -------------- */
+
+    if (threaded)
+      runThreadPool(atmos.Nspace, prdDepth, &pw);
+    else {
+      for (k = 0;  k < atmos.Nspace;  k++) prdDepth(k, &pw);
+    }
+  }
+  /* --- Keep newly computed weights in memory on file as well -- --- */
+
+  if (threaded  &&  initialize  &&  PRDline->fp_GII)
+    prdWeightsFile(PRDline, XRD, Nsubordinate, TRUE);
+
+  for (n = 0;  n < Nscratch;  n++) {
+    free(pw.scratch[n].J_k);  free(pw.scratch[n].q_abs);
+    free(pw.scratch[n].M2);   free(pw.scratch[n].u);
+    free(pw.scratch[n].qp);   free(pw.scratch[n].qpp);
+    free(pw.scratch[n].J);    free(pw.scratch[n].gii);
+    free(pw.scratch[n].wq);
+  }
+  free(pw.scratch);
+}
+/* ------- end ---------------------------- prdRedistribute.c ------- */
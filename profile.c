@@ -50,9 +50,20 @@
 #include "error.h"
 
 
+/* --- Shared by the wavelengths of one line in Profile -- -------- */
+
+typedef struct {
+  int     NrecStokes;
+  double *adamp, **v_los, *vB, *sv, **wphi, **phi;
+  AtomicLine *line;
+  ZeemanMultiplet *zm;
+} ProfileWork;
+
+
 /* --- Function prototypes --                          -------------- */
 
 void freeZeeman(ZeemanMultiplet *zm);
+static void profileLambda(int la, void *argument);
 
 
 /* --- Global variables --                             -------------- */
@@ -62,22 +73,208 @@ extern InputData input;
 extern char messageStr[];
 
 
+/* ------- begin -------------------------- profileLambda.c --------- */
+
+static void profileLambda(int la, void *argument)
+{
+  register int k, mu, n, to_obs, nz;
+
+  int     lamu;
+  double *wphi, **v, H, F, wlamu, vk, phi_pi, phi_sm, phi_sp, phi_delta,
+          phi_sigma, psi_pi, psi_sm, psi_sp, psi_delta, psi_sigma, sign,
+          sin2_gamma, *phi, *phi_Q, *phi_U, *phi_V, *psi_Q, *psi_U, *psi_V;
+
+  ProfileWork *pw = (ProfileWork *) argument;
+  AtomicLine *line = pw->line;
+  Atom *atom = line->atom;
+  ZeemanMultiplet *zm = pw->zm;
+
+  /* --- Profiles of line at wavelength la for all rays and directions.
+         The contribution to the normalization, and with
+         input.limit_memory the profile itself, go to scratch space
+         of the calling thread, so that wavelengths may be done
+         concurrently. --                              -------------- */
+
+  wphi = pw->wphi[threadSlot()];
+  if (input.limit_memory) {
+    phi = pw->phi[threadSlot()];
+    if (pw->NrecStokes > 1) {
+      phi_Q = phi + atmos.Nspace;
+      phi_U = phi + 2*atmos.Nspace;
+      phi_V = phi + 3*atmos.Nspace;
+
+      if (input.magneto_optical) {
+	psi_Q = phi + 4*atmos.Nspace;
+	psi_U = phi + 5*atmos.Nspace;
+	psi_V = phi + 6*atmos.Nspace;
+      }
+    }
+  }
+
+  if (atmos.moving ||
+      (line->polarizable && (input.StokesMode > FIELD_FREE))) {
+
+    v = matrix_double(atmos.Nspace, line->Ncomponent);
+    for (n = 0;  n < line->Ncomponent;  n++) {
+      for (k = 0;  k < atmos.Nspace;  k++) {
+	v[k][n] = (line->lambda[la] - line->lambda0 - line->c_shift[n]) *
+	  CLIGHT / (atom->vbroad[k] * line->lambda0);
+      }
+    }
+
+    for (mu = 0;  mu < atmos.Nrays;  mu++) {
+      wlamu = getwlambda_line(line, la) * 0.5*atmos.wmu[mu];
+
+      for (to_obs = 0;  to_obs <= 1;  to_obs++) {
+	sign = (to_obs) ? 1.0 : -1.0;
+	lamu = 2*(atmos.Nrays*la + mu) + to_obs;
+
+	/* --- Assign pointers to the proper phi and psi arrays and
+	   zero the profiles in case of conservative memory
+	   option. In the normal case the call matrix_double
+	   initializes the whole array to zero -- ------------- */
+
+	if (input.limit_memory) {
+	  for (k = 0;  k< pw->NrecStokes*atmos.Nspace;  k++) phi[k] = 0.0;
+	} else {
+	  phi = line->phi[lamu];
+	  if (line->polarizable && (input.StokesMode > FIELD_FREE)) {
+	    phi_Q = line->phi_Q[lamu];
+	    phi_U = line->phi_U[lamu];
+	    phi_V = line->phi_V[lamu];
+
+	    if (input.magneto_optical) {
+	      psi_Q = line->psi_Q[lamu];
+	      psi_U = line->psi_U[lamu];
+	      psi_V = line->psi_V[lamu];
+	    }
+	  }
+	}
+
+	if (line->polarizable && (input.StokesMode > FIELD_FREE)) {
+	  for (k = 0;  k < atmos.Nspace;  k++) {
+	    sin2_gamma = 1.0 - SQ(atmos.cos_gamma[mu][k]);
+
+	    /* --- For the sign conventions to the phi and psi
+	       contributions depending on the direction along the ray
+
+	       See:
+	       -- A. van Ballegooijen: "Radiation in Strong Magnetic
+		  Fields", in Numerical Radiative Transfer, W. Kalkofen
+		  1987, p. 285 --                    -------------- */
+
+	    /* --- Sum over isotopes --              -------------- */
+
+	    for (n = 0;  n < line->Ncomponent;  n++) {
+	      vk = v[k][n] + sign * pw->v_los[mu][k];
+
+	      phi_sm = phi_pi = phi_sp = 0.0;
+	      psi_sm = psi_pi = psi_sp = 0.0;
+
+	      /* --- Sum over Zeeman sub-levels --   -------------- */
+
+	      for (nz = 0;  nz < zm->Ncomponent;  nz++) {
+		H = Voigt(pw->adamp[k], vk - zm->shift[nz]*pw->vB[k],
+			  &F, HUMLICEK);
+
+		switch (zm->q[nz]) {
+		case -1:
+		  phi_sm += zm->strength[nz] * H;
+		  psi_sm += zm->strength[nz] * F;
+		  break;
+		case  0:
+		  phi_pi += zm->strength[nz] * H;
+		  psi_pi += zm->strength[nz] * F;
+		  break;
+		case  1:
+		  phi_sp += zm->strength[nz] * H;
+		  psi_sp += zm->strength[nz] * F;
+		}
+	      }
+	      phi_sigma = (phi_sp + phi_sm) * line->c_fraction[n];
+	      phi_delta = 0.5*phi_pi * line->c_fraction[n] - 0.25*phi_sigma;
+
+	      phi[k]   += (phi_delta*sin2_gamma + 0.5*phi_sigma) * pw->sv[k];
+	      phi_Q[k] += sign *
+		phi_delta * sin2_gamma * atmos.cos_2chi[mu][k] * pw->sv[k];
+	      phi_U[k] +=
+		phi_delta * sin2_gamma * atmos.sin_2chi[mu][k] * pw->sv[k];
+	      phi_V[k] += sign *
+		0.5*(phi_sp - phi_sm) * atmos.cos_gamma[mu][k] * pw->sv[k];
+
+	      if (input.magneto_optical) {
+		psi_sigma = (psi_sp + psi_sm) * line->c_fraction[n];
+		psi_delta = 0.5*psi_pi * line->c_fraction[n] -
+		  0.25*psi_sigma;
+
+		psi_Q[k] += sign *
+		  psi_delta * sin2_gamma * atmos.cos_2chi[mu][k] * pw->sv[k];
+		psi_U[k] +=
+		  psi_delta * sin2_gamma * atmos.sin_2chi[mu][k] * pw->sv[k];
+		psi_V[k] += sign *
+		  0.5 * (psi_sp - psi_sm) * atmos.cos_gamma[mu][k] * pw->sv[k];
+	      }
+	    }
+	    /* --- Ensure proper normalization of the profile -- -- */
+
+	    wphi[k] += wlamu * phi[k];
+	  }
+	} else {
+
+	  /* --- Field-free case --                  -------------- */
+
+	  for (k = 0;  k < atmos.Nspace;  k++) {
+	    for (n = 0;  n < line->Ncomponent;  n++) {
+	      vk = v[k][n] + sign * pw->v_los[mu][k];
+
+	      phi[k] += Voigt(pw->adamp[k], vk, NULL, ARMSTRONG) *
+		line->c_fraction[n] / (SQRTPI * atom->vbroad[k]);
+	    }
+	    wphi[k] += phi[k] * wlamu;
+	  }
+	}
+	if (input.limit_memory) writeProfile(line, lamu, phi);
+      }
+    }
+    freeMatrix((void **) v);
+  } else {
+
+    /* --- Angle-independent case --                   -------------- */
+
+    wlamu = getwlambda_line(line, la);
+
+    if (input.limit_memory)
+      for (k = 0;  k < atmos.Nspace;  k++) phi[k] = 0.0;
+    else
+      phi = line->phi[la];
+
+    for (k = 0;  k < atmos.Nspace;  k++) {
+      for (n = 0;  n < line->Ncomponent;  n++) {
+	vk = (line->lambda[la] - line->lambda0 - line->c_shift[n]) *
+	  CLIGHT / (line->lambda0 * atom->vbroad[k]);
+	phi[k] += Voigt(pw->adamp[k], vk, NULL, ARMSTRONG) *
+	  line->c_fraction[n] / (SQRTPI * atom->vbroad[k]);
+      }
+      wphi[k] += phi[k] * wlamu;
+    }
+    if (input.limit_memory) writeProfile(line, la, phi);
+  }
+}
+/* ------- end ---------------------------- profileLambda.c --------- */
+
 /* ------- begin -------------------------- Profile.c --------------- */
 
 void Profile(AtomicLine *line)
 {
   const char routineName[] = "Profile";
-  register int la, k, mu, n, to_obs, nz;
+  register int la, k, mu, n;
 
   char    filename[MAX_LINE_SIZE];
-  int     lamu, Nlamu, NrecStokes;
-  double *adamp = NULL, **v, **v_los, *vB, *sv, *vbroad, Larmor, H, F,
-          wlamu, vk, phi_pi, phi_sm, phi_sp, phi_delta, phi_sigma,
-          psi_pi, psi_sm, psi_sp, psi_delta, psi_sigma, sign, sin2_gamma,
-         *phi, *phi_Q, *phi_U, *phi_V, *psi_Q, *psi_U, *psi_V;
+  int     Nlamu, Nslot;
+  double *vbroad, Larmor;
 
   Atom *atom = line->atom;
-  ZeemanMultiplet *zm;
+  ProfileWork pw;
 
   if (!line->Voigt) {
     sprintf(messageStr,
@@ -110,19 +307,30 @@ void Profile(AtomicLine *line)
     line->Qelast = (double *) malloc(atmos.Nspace * sizeof(double));
   }
 
-  vbroad = atom->vbroad;
-  adamp  = (double *) malloc(atmos.Nspace * sizeof(double));
-  if (line->Voigt) Damping(line, adamp);
+  /* --- Everything the wavelengths have in common, the damping
+         parameter, Zeeman pattern and projected velocities, is set
+         up once here and shared by profileLambda --   -------------- */
+
+  pw.line  = line;
+  pw.zm    = NULL;
+  vbroad   = atom->vbroad;
+  pw.adamp = (double *) malloc(atmos.Nspace * sizeof(double));
+  if (line->Voigt) Damping(line, pw.adamp);
 
+  /* --- Normalization and, with input.limit_memory, the profile
+         are accumulated per thread --                 -------------- */
+
+  Nslot      = MAX(input.Nthreads, 1);
   line->wphi = (double *) calloc(atmos.Nspace, sizeof(double));
+  pw.wphi    = matrix_double(Nslot, atmos.Nspace);
 
   if (line->polarizable && (input.StokesMode > FIELD_FREE)) {
     Larmor = (Q_ELECTRON / (4.0*PI*M_ELECTRON)) * (line->lambda0*NM_TO_M);
 
-    zm = Zeeman(line);
+    pw.zm = Zeeman(line);
     sprintf(messageStr,
 	    " -- Atom %2s, line %3d -> %3d has %2d Zeeman components\n",
-	    atom->ID, line->j, line->i, zm->Ncomponent);
+	    atom->ID, line->j, line->i, pw.zm->Ncomponent);
     Error(MESSAGE, routineName, messageStr);
   }
 
@@ -138,25 +346,12 @@ void Profile(AtomicLine *line)
       Error(ERROR_LEVEL_2, routineName, messageStr);
     }
 
-    if (line->polarizable && (input.StokesMode > FIELD_FREE)) {
-      NrecStokes = (input.magneto_optical) ? 7 : 4;
-      phi = (double *) malloc(NrecStokes*atmos.Nspace * sizeof(double));
-
-      /* --- Assign pointers to subarrays of phi --    -------------- */
+    if (line->polarizable && (input.StokesMode > FIELD_FREE))
+      pw.NrecStokes = (input.magneto_optical) ? 7 : 4;
+    else
+      pw.NrecStokes = 1;
 
-      phi_Q = phi + atmos.Nspace;
-      phi_U = phi + 2*atmos.Nspace;
-      phi_V = phi + 3*atmos.Nspace;
-	      
-      if (input.magneto_optical) {
-	psi_Q = phi + 4*atmos.Nspace;
-	psi_U = phi + 5*atmos.Nspace;
-	psi_V = phi + 6*atmos.Nspace;
-      }
-    } else {
-      NrecStokes = 1;
-      phi = (double *) malloc(atmos.Nspace * sizeof(double));
-    }
+    pw.phi = matrix_double(Nslot, pw.NrecStokes*atmos.Nspace);
   } else {
     if (atmos.moving || 
 	(line->polarizable && (input.StokesMode > FIELD_FREE))) {
@@ -183,192 +378,57 @@ void Profile(AtomicLine *line)
     /* --- Temporary storage for inner loop variables, vB is the
            Zeeman splitting due to the local magnetic field -- ------ */  
 
-    vB = (double *) malloc(atmos.Nspace * sizeof(double));
-    sv = (double *) malloc(atmos.Nspace * sizeof(double));
+    pw.vB = (double *) malloc(atmos.Nspace * sizeof(double));
+    pw.sv = (double *) malloc(atmos.Nspace * sizeof(double));
 
     for (k = 0;  k < atmos.Nspace;  k++) {
-      vB[k] = Larmor * atmos.B[k] / vbroad[k];
-      sv[k] = 1.0 / (SQRTPI * vbroad[k]);
+      pw.vB[k] = Larmor * atmos.B[k] / vbroad[k];
+      pw.sv[k] = 1.0 / (SQRTPI * vbroad[k]);
     }
   }
-
-  /* --- Calculate the absorption profile and store for each line -- */
-
   if (atmos.moving ||
       (line->polarizable && (input.StokesMode > FIELD_FREE))) {
 
-    v_los = matrix_double(atmos.Nrays, atmos.Nspace);
+    pw.v_los = matrix_double(atmos.Nrays, atmos.Nspace);
     for (mu = 0;  mu < atmos.Nrays;  mu++) {
       for (k = 0;  k < atmos.Nspace;  k++) {
-	v_los[mu][k] = vproject(k, mu) / vbroad[k];
+	pw.v_los[mu][k] = vproject(k, mu) / vbroad[k];
       }
     }
-    v = matrix_double(atmos.Nspace, line->Ncomponent);
-
-    for (la = 0;  la < line->Nlambda;  la++) {
-      for (n = 0;  n < line->Ncomponent;  n++) {
-	for (k = 0;  k < atmos.Nspace;  k++) {
-	  v[k][n] = (line->lambda[la] - line->lambda0 - line->c_shift[n]) *
-	    CLIGHT / (vbroad[k] * line->lambda0);
-	}
-      }
-
-      for (mu = 0;  mu < atmos.Nrays;  mu++) {
-	wlamu = getwlambda_line(line, la) * 0.5*atmos.wmu[mu];
-
-	for (to_obs = 0;  to_obs <= 1;  to_obs++) {
-	  sign = (to_obs) ? 1.0 : -1.0;
-	  lamu = 2*(atmos.Nrays*la + mu) + to_obs;
-
-	  /* --- Assign pointers to the proper phi and psi arrays and
-	     zero the profiles in case of conservative memory
-	     option. In the normal case the call matrix_double
-	     initializes the whole array to zero -- ------------- */
-
-	  if (input.limit_memory) {
-	    for (k = 0;  k< NrecStokes*atmos.Nspace;  k++) phi[k] = 0.0;
-	  } else {
-	    phi = line->phi[lamu];
-	    if (line->polarizable && (input.StokesMode > FIELD_FREE)) {
-	      phi_Q = line->phi_Q[lamu];
-	      phi_U = line->phi_U[lamu];
-	      phi_V = line->phi_V[lamu];
-
-	      if (input.magneto_optical) {
-		psi_Q = line->psi_Q[lamu];
-		psi_U = line->psi_U[lamu];
-		psi_V = line->psi_V[lamu];
-	      }
-	    }
-	  }
-	    
-	  if (line->polarizable && (input.StokesMode > FIELD_FREE)) {
-	    for (k = 0;  k < atmos.Nspace;  k++) {
-	      sin2_gamma = 1.0 - SQ(atmos.cos_gamma[mu][k]);
-
-	      /* --- For the sign conventions to the phi and psi
-		 contributions depending on the direction along the ray
-
-		 See:
-		 -- A. van Ballegooijen: "Radiation in Strong Magnetic
-		    Fields", in Numerical Radiative Transfer, W. Kalkofen
-		    1987, p. 285 --                    -------------- */
-            
-              /* --- Sum over isotopes --              -------------- */
-
-	      for (n = 0;  n < line->Ncomponent;  n++) {
-		vk = v[k][n] + sign * v_los[mu][k];
-
-		phi_sm = phi_pi = phi_sp = 0.0;
-		psi_sm = psi_pi = psi_sp = 0.0;
-
-                /* --- Sum over Zeeman sub-levels --   -------------- */
-
-		for (nz = 0;  nz < zm->Ncomponent;  nz++) {
-		  H = Voigt(adamp[k], vk - zm->shift[nz]*vB[k],
-			    &F, HUMLICEK);
-
-		  switch (zm->q[nz]) {
-		  case -1:
-		    phi_sm += zm->strength[nz] * H;
-		    psi_sm += zm->strength[nz] * F;
-		    break;
-		  case  0:
-		    phi_pi += zm->strength[nz] * H;
-		    psi_pi += zm->strength[nz] * F;
-		    break;
-		  case  1:
-		    phi_sp += zm->strength[nz] * H;
-		    psi_sp += zm->strength[nz] * F;
-		  }
-		}
-		phi_sigma = (phi_sp + phi_sm) * line->c_fraction[n];
-		phi_delta = 0.5*phi_pi * line->c_fraction[n] - 0.25*phi_sigma;
-
-		phi[k]   += (phi_delta*sin2_gamma + 0.5*phi_sigma) * sv[k];
-		phi_Q[k] += sign *
-		  phi_delta * sin2_gamma * atmos.cos_2chi[mu][k] * sv[k];
-		phi_U[k] +=
-		  phi_delta * sin2_gamma * atmos.sin_2chi[mu][k] * sv[k];
-		phi_V[k] += sign *
-		  0.5*(phi_sp - phi_sm) * atmos.cos_gamma[mu][k] * sv[k];
-
-		if (input.magneto_optical) {
-		  psi_sigma = (psi_sp + psi_sm) * line->c_fraction[n];
-		  psi_delta = 0.5*psi_pi * line->c_fraction[n] -
-		    0.25*psi_sigma;
-
-		  psi_Q[k] += sign *
-		    psi_delta * sin2_gamma * atmos.cos_2chi[mu][k] * sv[k];
-		  psi_U[k] +=
-		    psi_delta * sin2_gamma * atmos.sin_2chi[mu][k] * sv[k];
-		  psi_V[k] += sign *
-		    0.5 * (psi_sp - psi_sm) * atmos.cos_gamma[mu][k] * sv[k];
-		}
-	      }
-              /* --- Ensure proper normalization of the profile -- -- */
-
-	      line->wphi[k] += wlamu * phi[k];
-	    }
-	  } else {
+  }
 
-	    /* --- Field-free case --                  -------------- */
+  /* --- Calculate the absorption profile and store for each line,
+         over the thread pool with input.Nthreads > 1 -- ------------ */
 
-            for (k = 0;  k < atmos.Nspace;  k++) {
-	      for (n = 0;  n < line->Ncomponent;  n++) {
-		vk = v[k][n] + sign * v_los[mu][k];
-	    
-		phi[k] += Voigt(adamp[k], vk, NULL, ARMSTRONG) *
-		  line->c_fraction[n] / (SQRTPI * atom->vbroad[k]);
-	      }
-	      line->wphi[k] += phi[k] * wlamu;
-	    }
-	  }
-	  if (input.limit_memory) writeProfile(line, lamu, phi);
-	}
-      }
-    }
-  } else {
+  if (input.Nthreads > 1)
+    runThreadPool(line->Nlambda, profileLambda, &pw);
+  else {
+    for (la = 0;  la < line->Nlambda;  la++) profileLambda(la, &pw);
+  }
 
-    /* --- Angle-independent case --                   -------------- */   
+  /* --- Store the inverse of the profile normalization, summed
+         over the threads in order of slot --          -------------- */
 
-    for (la = 0;  la < line->Nlambda;  la++) {
-      wlamu = getwlambda_line(line, la);
-      
-      if (input.limit_memory)
-	for (k = 0;  k < atmos.Nspace;  k++) phi[k] = 0.0;
-      else
-	phi = line->phi[la];
-      
-      for (k = 0;  k < atmos.Nspace;  k++) {
-	for (n = 0;  n < line->Ncomponent;  n++) {
-	  vk = (line->lambda[la] - line->lambda0 - line->c_shift[n]) *
-	    CLIGHT / (line->lambda0 * atom->vbroad[k]);
-	  phi[k] += Voigt(adamp[k], vk, NULL, ARMSTRONG) *
-	    line->c_fraction[n] / (SQRTPI * atom->vbroad[k]);
-	}
-	line->wphi[k] += phi[k] * wlamu;
-      }
-      if (input.limit_memory) writeProfile(line, la, phi);
-    }
+  for (n = 0;  n < Nslot;  n++) {
+    for (k = 0;  k < atmos.Nspace;  k++) line->wphi[k] += pw.wphi[n][k];
   }
-  /* --- Store the inverse of the profile normalization -- ---------- */
-
   for (k = 0;  k < atmos.Nspace;  k++) line->wphi[k] = 1.0 / line->wphi[k];
 
   /* --- Clean up --                                     ------------ */
 
-  free(adamp);
-  if (input.limit_memory) free(phi);
+  free(pw.adamp);
+  freeMatrix((void **) pw.wphi);
+  if (input.limit_memory) freeMatrix((void **) pw.phi);
 
-  if (line->polarizable && (input.StokesMode > FIELD_FREE)) {
-    freeZeeman(zm);
-    free(zm);
-    free(vB);
-    free(sv);
+  if (atmos.moving ||
+      (line->polarizable && (input.StokesMode > FIELD_FREE)))
+    freeMatrix((void **) pw.v_los);
 
-    freeMatrix((void **) v);
-    freeMatrix((void **) v_los);
+  if (line->polarizable && (input.StokesMode > FIELD_FREE)) {
+    freeZeeman(pw.zm);
+    free(pw.zm);
+    free(pw.vB);
+    free(pw.sv);
 
     sprintf(messageStr, "Stokes prof %7.1f", line->lambda0);
   } else
@@ -7,11 +7,13 @@ import numpy as np
 
 
 class Rh15dout:
-    def __init__(self, fdir='.', verbose=True):
+    def __init__(self, fdir='.', verbose=True, shards=False):
         self.files = []
         self.params = {}
         self.verbose = verbose
         self.fdir = fdir
+        # with shards=True, read unmerged output of a run with 15D_SHARDS
+        self.read_output = read_hdf5_shards if shards else read_hdf5
         OUTFILE_FUNC = {"output_aux": self.read_aux,
                         "output_indata": self.read_indata,
                         "output_ray": self.read_ray,
@@ -25,7 +27,7 @@ class Rh15dout:
         ''' Reads Aux file. '''
         if infile is None:
             infile = '%s/output_aux.hdf5' % self.fdir
-        self.files.append(read_hdf5(self, infile))
+        self.files.append(self.read_output(self, infile))
         if self.verbose:
             print(('--- Read %s file.' % infile))
 
@@ -33,7 +35,7 @@ class Rh15dout:
         ''' Reads indata file. '''
         if infile is None:
             infile = '%s/output_indata.hdf5' % self.fdir
-        self.files.append(read_hdf5(self, infile))
+        self.files.append(self.read_output(self, infile))
         if self.verbose:
             print(('--- Read %s file.' % infile))
 
@@ -51,7 +53,7 @@ class Rh15dout:
         if infile is None:
             infile = '%s/output_ray.hdf5' % self.fdir
         self.ray = DataHolder()
-        self.files.append(read_hdf5(self.ray, infile))
+        self.files.append(self.read_output(self.ray, infile))
         if self.verbose:
             print(('--- Read %s file.' % infile))
 
@@ -373,6 +375,40 @@ def read_hdf5(inclass, infile):
     return f
 
 
+def read_hdf5_shards(inclass, infile):
+    ''' Reads the output of a run with 15D_SHARDS that was not merged
+        with rh15d_merge. Like read_hdf5 on the shared file infile, but
+        variables written per column are replaced by numpy arrays with
+        the columns of all shards (infile.NNNN) filled in. '''
+    import glob
+    import h5py
+    f = read_hdf5(inclass, infile)
+    merged = {}
+    for shard in sorted(glob.glob(infile + '.[0-9]*')):
+        s = h5py.File(shard, mode='r')
+        axis = s.attrs['column_axis']
+        cols = list(zip(*np.nonzero(s['shard_columns'][:])))
+
+        def copy_columns(name, var):
+            if not isinstance(var, h5py.Dataset) or name == 'shard_columns':
+                return
+            if name not in merged:
+                merged[name] = f[name][:]
+            idx = [slice(None)] * var.ndim
+            for i, j in cols:
+                idx[axis], idx[axis + 1] = i, j
+                merged[name][tuple(idx)] = var[tuple(idx)]
+        s.visititems(copy_columns)
+        s.close()
+    for name, data in merged.items():
+        parts = [p.replace(' ', '_') for p in name.split('/')]
+        holder = inclass
+        for p in parts[:-1]:
+            holder = getattr(holder, p)
+        setattr(holder, parts[-1], data)
+    return f
+
+
 def make_ncdf_atmos(outfile, T, vz, nH, z, x=None, y=None, Bz=None, By=None,
                     Bx=None, rho=None, ne=None, vx=None, vy=None, desc=None,
                     snap=None, boundary=[1, 0], comp=False, complev=2,
@@ -28,23 +28,23 @@ extern Atmosphere atmos;
 extern char messageStr[];
 
 
-/* ------- begin -------------------------- Rayleigh.c -------------- */
+/* ------- begin -------------------------- RayleighCross.c --------- */
 
-bool_t Rayleigh(double lambda, Atom *atom, double *scatt)
+bool_t RayleighCross(double lambda, Atom *atom, double *sigma)
 {
   /* --- Rayleigh scattering by transitions from the ground state of
          neutral atoms. Sums scattering crosssections of all bound-bound
          transitions from the groundstate of the atom with lamda_red
          (the longest wavelength covered by the transition) less than
-         wavelength lambda.
+         wavelength lambda. Returns the cross section per atom in the
+         ground state in sigma.
 
     See: Mihalas (1978) p. 106 --                      -------------- */
 
-  const char routineName[] = "Rayleigh";
-  register int k, kr;
+  const char routineName[] = "RayleighCross";
+  register int kr;
 
-  double lambda_limit, lambda_red, C, sigma_e, fomega, f, lambda2,
-         sigma_Rayleigh;
+  double lambda_limit, lambda_red, C, sigma_e, fomega, f, lambda2;
   AtomicLine *line;
 
   if (atom->stage[0] != 0) {
@@ -85,8 +85,25 @@ bool_t Rayleigh(double lambda, Atom *atom, double *scatt)
 	fomega += f * SQ(lambda2);
       }
     }
-    sigma_Rayleigh = sigma_e * fomega;
+    *sigma = sigma_e * fomega;
+
+    return TRUE;
+  } else
+    return FALSE;
+}
+/* ------- end ---------------------------- RayleighCross.c --------- */
+
+/* ------- begin -------------------------- Rayleigh.c -------------- */
+
+bool_t Rayleigh(double lambda, Atom *atom, double *scatt)
+{
+  /* --- Rayleigh scattering opacity of atom --        -------------- */
+
+  register int k;
+
+  double sigma_Rayleigh;
 
+  if (RayleighCross(lambda, atom, &sigma_Rayleigh)) {
     for (k = 0;  k < atmos.Nspace;  k++)
       scatt[k] = sigma_Rayleigh * atom->n[0][k];
 
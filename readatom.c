@@ -71,7 +71,7 @@ void readAtom(Atom *atom, char *atom_file, bool_t active)
           Nspace = atmos.Nspace,
           Nread, Nrequired, checkPoint, L, nq, status;
   double  f, C, lambda0, lambdamin, vtherm, S, Ju, Jl,
-    c_sum, waveratio, lambda_air;
+    c_sum, waveratio, lambda_air, *u;
 
   AtomicLine *line, *line1;
   AtomicContinuum *continuum;
@@ -84,7 +84,7 @@ void readAtom(Atom *atom, char *atom_file, bool_t active)
   /* --- Open the data file for current model atom --  -------------- */
 
   initAtom(atom);
-  if ((atom->fp_input = fopen(atom_file, "r")) == NULL) {
+  if ((atom->fp_input = fopenInput(atom_file)) == NULL) {
     sprintf(messageStr, "Unable to open input file %s", atom_file);
     Error(ERROR_LEVEL_2, routineName, atom_file);
   } else {
@@ -386,6 +386,15 @@ void readAtom(Atom *atom, char *atom_file, bool_t active)
 	  Error(ERROR_LEVEL_2, routineName, messageStr);
 	}
       }
+      /* --- Spline second derivatives of the cross section, so that
+             Metal_bfCross can interpolate without rebuilding them -- */
+
+      continuum->alpha_M2 =
+	(double *) malloc(continuum->Nlambda * sizeof(double));
+      u = (double *) malloc(continuum->Nlambda * sizeof(double));
+      splineTable(continuum->Nlambda, continuum->lambda,
+		  continuum->alpha, continuum->alpha_M2, u);
+      free(u);
     } else if (strstr(nuDepStr, "HYDROGENIC")) {
       continuum->hydrogenic = TRUE;
       if (lambdamin >= continuum->lambda0) {
@@ -541,7 +550,7 @@ void readAtom(Atom *atom, char *atom_file, bool_t active)
 
     /* --- Allocate space for thread dependent quantities -- -------- */
 
-    atom->rhth = (rhthread *) malloc(input.Nthreads * sizeof(rhthread));
+    atom->rhth = (rhthread *) calloc(input.Nthreads, sizeof(rhthread));
 
     /* --- Store the offset to allow pointing back to the start of the
            collisional data in the atomic input file, and allocate
@@ -613,6 +622,8 @@ void initAtom(Atom *atom)
   atom->line = NULL;
   atom->continuum = NULL;
   atom->ft = NULL;
+  atom->Ncoll = 0;
+  atom->coll = NULL;
   atom->Ng_n = NULL;
   atom->fp_input = NULL;
 }
@@ -670,6 +681,7 @@ void initAtomicContinuum(AtomicContinuum *continuum)
   continuum->lambda = NULL;
   continuum->alpha0 = 0.0;
   continuum->alpha = continuum->Rij = continuum->Rji = NULL;
+  continuum->alpha_M2 = NULL;
   continuum->atom = NULL;
 }
 /* ------- end ---------------------------- initAtomicContinuum.c --- */
@@ -712,6 +724,7 @@ void freeAtom(Atom *atom)
     free(atom->continuum);
   }
   if (atom->ft != NULL) free(atom->ft);
+  if (atom->coll != NULL) freeCollisions(atom);
 }
 /* ------- end ---------------------------- freeAtom.c -------------- */
 
@@ -754,7 +767,8 @@ void freeAtomicContinuum(AtomicContinuum *continuum)
   if (continuum->Rij != NULL)     free(continuum->Rij);
   if (continuum->Rji != NULL)     free(continuum->Rji);
 
-  if (continuum->alpha != NULL)   free(continuum->alpha);
+  if (continuum->alpha != NULL)    free(continuum->alpha);
+  if (continuum->alpha_M2 != NULL) free(continuum->alpha_M2);
 }
 /* ------- end ---------------------------- freeAtomicContinuum.c --- */
 
@@ -778,7 +792,7 @@ void readAtomicModels(void)
 
   /* --- Open input file for atomic models --          -------------- */
 
-  if ((fp_atoms = fopen(input.atoms_input, "r")) == NULL) {
+  if ((fp_atoms = fopenInput(input.atoms_input)) == NULL) {
     sprintf(messageStr, "Unable to open input file %s",
 	    input.atoms_input);
     Error(ERROR_LEVEL_2, routineName, messageStr);
@@ -894,7 +908,7 @@ char *getAtomID(char *atom_file)
   bool_t exit_on_EOF;
   FILE  *fp_atom;
 
-  if ((fp_atom = fopen(atom_file, "r")) == NULL) {
+  if ((fp_atom = fopenInput(atom_file)) == NULL) {
     sprintf(messageStr, "Unable to open inputfile %s", atom_file);
     Error(ERROR_LEVEL_2, routineName, messageStr);
   }
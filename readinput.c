@@ -118,6 +118,8 @@ void readInput()
      setboolValue},
     {"KURUCZ_DATA", "none", FALSE, KEYWORD_OPTIONAL, &input.KuruczData,
      setcharValue},
+    {"KURUCZ_CACHE", "none", FALSE, KEYWORD_OPTIONAL, &input.KuruczCache,
+     setcharValue},
     {"RLK_SCATTER", "FALSE", FALSE, KEYWORD_DEFAULT, &input.rlkscatter,
      setboolValue},
     {"KURUCZ_PF_DATA", "../../Atoms/pf_Kurucz.input", FALSE,
@@ -183,6 +185,8 @@ void readInput()
      setboolValue},
     {"N_THREADS", "0", FALSE, KEYWORD_OPTIONAL, &input.Nthreads,
      setThreadValue},
+    {"STATIC_THREADS", "FALSE", FALSE, KEYWORD_DEFAULT,
+     &input.static_threads, setboolValue},
 
     {"LIMIT_MEMORY", "FALSE", FALSE, KEYWORD_DEFAULT, &input.limit_memory,
      setboolValue},
@@ -238,6 +242,46 @@ void readInput()
     {"15D_WRITE_TAU1", "FALSE",  FALSE, KEYWORD_OPTIONAL, &input.p15d_wtau,
      setboolValue},
     {"15D_WRITE_EXTRA",    "TRUE",  FALSE, KEYWORD_OPTIONAL, &input.p15d_wxtra,
+     setboolValue},
+    {"15D_TASK_ORDER", "NONE", FALSE, KEYWORD_OPTIONAL, &input.p15d_order,
+     setTaskOrder},
+    {"15D_POOL_CHUNK", "1", FALSE, KEYWORD_OPTIONAL, &input.p15d_chunk,
+     setintValue},
+    {"15D_POOL_COUNTER", "FALSE", FALSE, KEYWORD_OPTIONAL, &input.p15d_counter,
+     setboolValue},
+    {"15D_CHECKPOINT", "0", FALSE, KEYWORD_OPTIONAL, &input.p15d_checkpoint,
+     setintValue},
+    {"15D_WARM_START", "0", FALSE, KEYWORD_OPTIONAL, &input.p15d_warm,
+     setintValue},
+    {"15D_PREV_AUX", "none", FALSE, KEYWORD_OPTIONAL, input.p15d_prev_aux,
+     setcharValue},
+    {"15D_PREV_INDATA", "none", FALSE, KEYWORD_OPTIONAL, input.p15d_prev_indata,
+     setcharValue},
+    {"15D_PREV_RAY", "none", FALSE, KEYWORD_OPTIONAL, input.p15d_prev_ray,
+     setcharValue},
+    {"15D_PREV_SNAPSHOT", "-1", FALSE, KEYWORD_OPTIONAL, &input.p15d_prev_nt,
+     setintValue},
+    {"15D_REUSE_TOL", "0.0", FALSE, KEYWORD_OPTIONAL, &input.p15d_reuse_tol,
+     setdoubleValue},
+    {"15D_WRITE_BUFFERS", "0", FALSE, KEYWORD_OPTIONAL, &input.p15d_wbuf,
+     setintValue},
+    {"15D_WRITE_BATCH", "1", FALSE, KEYWORD_OPTIONAL, &input.p15d_wbatch,
+     setintValue},
+    {"15D_SHARDS", "FALSE", FALSE, KEYWORD_OPTIONAL, &input.p15d_shard,
+     setboolValue},
+    {"15D_READ_AHEAD", "FALSE", FALSE, KEYWORD_OPTIONAL, &input.p15d_prefetch,
+     setboolValue},
+    {"15D_READ_TILES", "FALSE", FALSE, KEYWORD_OPTIONAL, &input.p15d_tiles,
+     setboolValue},
+    {"15D_NODE_CACHE", "0", FALSE, KEYWORD_OPTIONAL, &input.p15d_nodecache,
+     setintValue},
+    {"15D_SHARED_LINES", "FALSE", FALSE, KEYWORD_OPTIONAL,
+     &input.p15d_shared_lines, setboolValue},
+    {"15D_BCAST_INPUT", "FALSE", FALSE, KEYWORD_OPTIONAL, &input.p15d_bcast,
+     setboolValue},
+    {"15D_BG_TABLE", "0", FALSE, KEYWORD_OPTIONAL, &input.p15d_bgtable,
+     setintValue},
+    {"15D_FUSED_BG", "FALSE", FALSE, KEYWORD_OPTIONAL, &input.p15d_fused,
      setboolValue}
 
   };
@@ -245,7 +289,7 @@ void readInput()
 
   /* --- Open the input data file --                    ------------- */
 
-  if ((fp_keyword = fopen(commandline.keyword_input, "r")) == NULL) {
+  if ((fp_keyword = fopenInput(commandline.keyword_input)) == NULL) {
     sprintf(messageStr, "Unable to open inputfile %s",
 	    commandline.keyword_input);
     Error(ERROR_LEVEL_2, routineName, messageStr);
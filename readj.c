@@ -266,6 +266,24 @@ void writeImu(int nspect, int mu, bool_t to_obs, double *I)
 }
 /* ------- end ---------------------------- writeImu.c -------------- */
 
+/* ------- begin -------------------------- backgroundRecords.c ----- */
+
+int backgroundRecords(int nspect)
+{
+  /* --- Number of records writeBackground writes for wavelength
+         nspect, given its atmos.backgrflags --        -------------- */
+
+  int NrecStokes;
+
+  NrecStokes = (atmos.backgrflags[nspect].ispolarized) ? 4 : 1;
+
+  if (atmos.backgrflags[nspect].ispolarized && input.magneto_optical)
+    return 2*NrecStokes + 3 + 1;
+  else
+    return 2*NrecStokes + 1;
+}
+/* ------- end ---------------------------- backgroundRecords.c ----- */
+
 /* ------- begin -------------------------- readBackground.c -------- */
 
 void readBackground(int nspect, int mu, bool_t to_obs)
@@ -81,7 +81,7 @@ void readMolecule(Molecule *molecule, char *fileName, bool_t active)
 
   /* --- Open the data file for current molecule --    -------------- */
 
-  if ((fp_molecule = fopen(fileName, "r")) == NULL) {
+  if ((fp_molecule = fopenInput(fileName)) == NULL) {
     sprintf(messageStr, "Unable to open inputfile %s", fileName);
     Error(ERROR_LEVEL_2, routineName, messageStr);
   } else {
@@ -377,7 +377,7 @@ void readMolecule(Molecule *molecule, char *fileName, bool_t active)
     /* --- Allocate space for thread dependent quantities -- -------- */
 
     molecule->rhth =
-      (rhthread *) malloc(input.Nthreads * sizeof(rhthread));
+      (rhthread *) calloc(input.Nthreads, sizeof(rhthread));
   }
 
   fclose(fp_molecule);
@@ -590,7 +590,7 @@ void readMolecularLines(struct Molecule *molecule, char *line_data)
 
   /* --- Open the data file --                         -------------- */
  
-  if ((fp_lines = fopen(line_data, "r")) == NULL) {
+  if ((fp_lines = fopenInput(line_data)) == NULL) {
     sprintf(messageStr, "Unable to open inputfile %s", line_data);
     Error(ERROR_LEVEL_2, routineName, messageStr);
   } else {
@@ -902,7 +902,7 @@ void readMolecularModels(void)
 
   /* --- Open input file for molecular models --       -------------- */
 
-  if ((fp_molecules = fopen(input.molecules_input, "r")) == NULL) {
+  if ((fp_molecules = fopenInput(input.molecules_input)) == NULL) {
     sprintf(messageStr, "Unable to open input file %s",
 	    input.molecules_input);
     Error(ERROR_LEVEL_2, routineName, messageStr);
@@ -1036,7 +1036,7 @@ char *getMoleculeID(char *molecule_file)
   bool_t exit_on_EOF;
   FILE  *fp_molecule;
 
-  if ((fp_molecule = fopen(molecule_file, "r")) == NULL) {
+  if ((fp_molecule = fopenInput(molecule_file)) == NULL) {
     sprintf(messageStr, "Unable to open inputfile %s", molecule_file);
     Error(ERROR_LEVEL_2, routineName, messageStr);
   }
@@ -474,3 +474,29 @@ void setnesolution(char *value, void *pointer)
   memcpy(pointer, &nesolution, sizeof(enum_t));
 }
 /* ------- end ---------------------------- setnesolution.c --------- */
+
+/* ------- begin -------------------------- setTaskOrder.c ---------- */
+
+void setTaskOrder(char *value, void *pointer)
+{
+  const char routineName[] = "setTaskOrder";
+
+  enum task_order order = ORDER_TASKMAP;
+
+  if (!strcmp(value, "NONE"))
+    order = ORDER_TASKMAP;
+  else if (!strcmp(value, "ATMOS_COST"))
+    order = ORDER_ATMOS_COST;
+  else if (!strcmp(value, "ITERATION_COST"))
+    order = ORDER_ITERATION_COST;
+  else if (!strcmp(value, "HILBERT"))
+    order = ORDER_HILBERT;
+  else {
+    sprintf(messageStr,
+             "Invalid value for keyword 15D_TASK_ORDER: %s", value);
+    Error(ERROR_LEVEL_2, routineName, messageStr);
+  }
+
+  memcpy(pointer, &order, sizeof(enum_t));
+}
+/* ------- end ---------------------------- setTaskOrder.c ---------- */
@@ -67,6 +67,11 @@ void   setOptions(int argc, char *argv[]);
 double vproject(int k, int mu);
 void   Bproject(void);
 bool_t StopRequested(void);
+
+void   initThreadPool(void);
+void   runThreadPool(int Ntask, void (*work)(int task, void *arg),
+		     void *arg);
+int    threadSlot(void);
 char **getWords(char *label, char *separator, int *count);
 
 
@@ -96,6 +101,9 @@ double BiLinear(int Na, double *a_table, double a,
 
 void  splineCoef(int Ntable, double *xtable, double *ytable);
 void  splineEval(int N, double *x, double *y, bool_t hunt);
+void  splineTable(int N, double *x, double *y, double *M2, double *u);
+void  splineTableEval(int Ntable, double *xtable, double *ytable,
+		      double *M2, int N, double *x, double *y, bool_t hunt);
 void  exp_splineCoef(int Ntable, double *xtable, double *ytable,
 		     double tension);
 void  exp_splineEval(int N, double *x, double *y, bool_t hunt);
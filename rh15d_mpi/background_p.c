@@ -120,8 +120,20 @@
 
 #define COMMENT_CHAR  "#"
 
+/* --- Column data shared by the wavelengths in Background_p -- --- */
+
+typedef struct {
+  bool_t  use_table, use_fused;
+  double *thomson;
+  Atom   *He;
+  BackgroundScratch *scratch;
+} BackgroundWork;
+
+
 /* --- Function prototypes --                          -------------- */
 void SetLTEQuantities_p(void);
+static void backgroundLambda_p(int nspect, void *argument);
+static void shareKuruczLines(void);
 void loadBackground(int la, int mu, bool_t to_obs);
 void storeBackground(int la, int mu, bool_t to_obs,
 		     double *chi_c, double *eta_c, double *sca_c);
@@ -153,7 +165,7 @@ void init_Background(void)
     /* --- Read wavelength-dependent fudge factors to compensate for
            missing UV backround line haze --           -------------- */
 
-    if ((fp_fudge = fopen(input.fudgeData, "r")) == NULL) {
+    if ((fp_fudge = fopenInput(input.fudgeData)) == NULL) {
       sprintf(messageStr, "Unable to open input file %s", input.fudgeData);
       Error(ERROR_LEVEL_2, routineName, messageStr);
     }
@@ -197,16 +209,70 @@ void init_Background(void)
 
   /* --- Read background files from Kurucz data file -- ------------- */
   atmos.Nrlk = 0;
-  readKuruczLines(input.KuruczData);
-  if (atmos.Nrlk > 0) {
-    qsort(atmos.rlk_lines, atmos.Nrlk, sizeof(RLK_Line), rlk_ascend);
-  }
+  if (input.p15d_shared_lines)
+    shareKuruczLines();
+  else
+    loadKuruczLines(mpi.rank == 0);
+
+  if (input.p15d_bgtable > 0) initBackgroundTable_p();
 
   return;
 
 }
 /* ------- end   -------------------------- init_Background.c ------- */
 
+/* ------- begin -------------------------- shareKuruczLines.c ------ */
+static void shareKuruczLines(void)
+/* Reads and sorts the Kurucz lines in the first process of each node
+   only, and puts them in a shared memory window that all processes of
+   the node use read-only. Zeeman patterns, which rlk_opacity adds to
+   the lines as needed, are then kept per process in atmos.rlk_zm. */
+{
+  int      noderank, disp;
+  MPI_Aint size;
+  MPI_Comm nodecomm, leaders, bcast_comm;
+  MPI_Win  win;
+  RLK_Line *lines;
+
+  MPI_Comm_split_type(mpi.comm, MPI_COMM_TYPE_SHARED, mpi.rank,
+		      MPI_INFO_NULL, &nodecomm);
+  MPI_Comm_rank(nodecomm, &noderank);
+
+  /* Only the readers take part if input files are broadcast */
+  bcast_comm = setInputBcast_p(MPI_COMM_NULL);
+  if (bcast_comm != MPI_COMM_NULL)
+    MPI_Comm_split(bcast_comm, (noderank == 0) ? 0 : MPI_UNDEFINED,
+		   mpi.rank, &leaders);
+  if (noderank == 0) {
+    if (bcast_comm != MPI_COMM_NULL) setInputBcast_p(leaders);
+    loadKuruczLines(mpi.rank == 0);
+    if (bcast_comm != MPI_COMM_NULL) MPI_Comm_free(&leaders);
+  }
+  setInputBcast_p(bcast_comm);
+  MPI_Bcast(&atmos.Nrlk, 1, MPI_INT, 0, nodecomm);
+  if (atmos.Nrlk == 0) {
+    MPI_Comm_free(&nodecomm);
+    return;
+  }
+
+  /* The window lives as long as the lines, until the end of the run */
+  size = (noderank == 0) ? atmos.Nrlk * sizeof(RLK_Line) : 0;
+  MPI_Win_allocate_shared(size, sizeof(RLK_Line), MPI_INFO_NULL, nodecomm,
+			  &lines, &win);
+  MPI_Win_shared_query(win, 0, &size, &disp, &lines);
+  if (noderank == 0) {
+    memcpy(lines, atmos.rlk_lines, atmos.Nrlk * sizeof(RLK_Line));
+    freeKuruczLines();
+  }
+  MPI_Barrier(nodecomm);
+  MPI_Comm_free(&nodecomm);
+
+  atmos.rlk_lines = lines;
+  atmos.rlk_zm    = (ZeemanMultiplet **)
+    calloc(atmos.Nrlk, sizeof(ZeemanMultiplet *));
+}
+/* ------- end   -------------------------- shareKuruczLines.c ------ */
+
 /* ------- begin -------------------------- close_Background.c ------- */
 void close_Background(void)
 {
@@ -217,178 +283,52 @@ void close_Background(void)
 }
 /* ------- end   -------------------------- close_Background.c ------- */
 
-/* ------- begin -------------------------- Background.c ------------ */
+/* ------- begin -------------------------- backgroundLambda_p.c ---- */
 
-void Background_p(bool_t write_analyze_output, bool_t equilibria_only)
+static void backgroundLambda_p(int nspect, void *argument)
 {
-  const char routineName[] = "Background_p";
-  register int k, nspect, mu, to_obs;
-
-  static int ne_iter = 0;
-  bool_t  do_fudge, fromscratch;
-  int     index, Nfudge, NrecStokes;
-  double *chi, *eta, *scatt, wavelength, *thomson, *chi_ai, *eta_ai, *sca_ai,
-          Hmin_fudge, scatt_fudge, metal_fudge, *lambda_fudge, **fudge,
-         *Bnu, *chi_c, *eta_c, *sca_c, *chip, *chip_c;
-  Atom   *He;
-  Element *element;
+  register int k, mu, to_obs;
+
+  BackgroundWork *bw = (BackgroundWork *) argument;
+  BackgroundScratch *bs = &bw->scratch[threadSlot()];
+
+  bool_t  do_fudge = bgdat.do_fudge, use_table = bw->use_table,
+          use_fused = bw->use_fused;
+  int     index, first, Nfudge = bgdat.Nfudge, NrecStokes = 1;
+  long    recno;
+  double  wavelength, Hmin_fudge, scatt_fudge, metal_fudge,
+         *lambda_fudge = bgdat.lambda_fudge, **fudge = bgdat.fudge,
+         *thomson = bw->thomson,
+         *chi = bs->chi, *eta = bs->eta, *scatt = bs->scatt,
+         *Bnu = bs->Bnu, *chip = bs->chip, *chi_c = bs->chi_c,
+         *eta_c = bs->eta_c, *sca_c = bs->sca_c, *chip_c = bs->chip_c,
+         *chi_ai = bs->chi_ai, *eta_ai = bs->eta_ai, *sca_ai = bs->sca_ai;
+  Atom   *He = bw->He;
   flags   backgrflags;
-  char    file_background[MAX_MESSAGE_LENGTH], *fext = FILE_EXT;
-
-  getCPU(2, TIME_START, NULL);
-
-  if (input.solve_ne == ONCE  || input.solve_ne == ITERATION ) {
-    fromscratch = (input.solve_ne == ONCE  ||
-		   (input.solve_ne == ITERATION  &&  ne_iter == 0)) ?
-      TRUE : FALSE;
-    Solve_ne(atmos.ne, fromscratch);
-    ne_iter++;
-  }
-  SetLTEQuantities_p();
-
-  if (input.NonICE)
-    readMolecules(MOLECULAR_CONCENTRATION_FILE);
-  else
-    ChemicalEquilibrium(N_MAX_CHEM_ITER, CHEM_ITER_LIMIT);
-
-  if (equilibria_only) {
-
-    /* --- If we only need ne, LTE populations and collisions, and
-           chemical equilibrium leave here --          -------------- */
-
-    getCPU(2, TIME_POLL, "Total Background");
-    return;
-  }
-
-  getCPU(3, TIME_START, NULL);
-
-  /* Get fudge data */
-  lambda_fudge = bgdat.lambda_fudge;
-  do_fudge     = bgdat.do_fudge;
-  Nfudge       = bgdat.Nfudge;
-  fudge        = bgdat.fudge;
-
-
-  // bcakground data in memory or on file?
-  if (input.backgr_in_mem) {
-    // in memory
-
-    // sanity check
-    if (input.StokesMode != NO_STOKES)
-	Error(ERROR_LEVEL_2,routineName,"Polarized transfer and in-memory backgr. op. is not implemented.");
-
-	if (atmos.chi_b != NULL) freeMatrix((void **) atmos.chi_b);
-	atmos.chi_b = matrix_double(spectrum.Nspect * 2 * atmos.Nrays, atmos.Nspace);
-
-	if (atmos.eta_b != NULL) freeMatrix((void **) atmos.eta_b);
-	atmos.eta_b = matrix_double(spectrum.Nspect * 2 * atmos.Nrays, atmos.Nspace);
-
-	if (atmos.sca_b != NULL) freeMatrix((void **) atmos.sca_b);
-	atmos.sca_b = matrix_double(spectrum.Nspect * 2 * atmos.Nrays, atmos.Nspace);
-
-  } else {
-
-	// on file
 
-	/* --- Open background file --                        ------------- */
+  /* --- Adds all background contributions at wavelength nspect and
+         stores them. Runs in the scratch space of the calling thread,
+         so that wavelengths may be done concurrently. Records on file
+         are taken off mpi.backgrrecno as they are written, so that
+         each wavelength gets its own. --              -------------- */
 
-	/* get file name, with the MPI rank */
-	sprintf(file_background,"%s_p%d%s", input.background_File , mpi.rank, fext);
+  wavelength = spectrum.lambda[nspect];
 
-	if ((atmos.fd_background =
-	     open(file_background, O_RDWR | O_CREAT | O_TRUNC, PERMISSIONS)) == -1) {
-	  sprintf(messageStr, "Unable to open output file %s",
-		  file_background);
-	  Error(ERROR_LEVEL_2, routineName, messageStr);
-	}
+  /* --- Initialize the flags for this wavelength -- -------------- */
 
-	/* Zero record number, as background file is being overwritten */
-	mpi.backgrrecno = 0;
-
- }
-
-
-  /* --- Allocate temporary storage space. The quantities are used
-         for the following purposes:
+  atmos.backgrflags[nspect].hasline     = FALSE;
+  atmos.backgrflags[nspect].ispolarized = FALSE;
 
-       - chi, eta, scatt: Get contributions to opacity, emissivity,
-         and scattering opacity, respectively, from a specific process
-         for a given wavelength and possibly angle.
+  if (use_fused) {
 
-       - chi_c, eta_c, sca_c: Collect the total opacity, emissivity
-         and scattering opacity for a given wavelength and possibly
-         angle.
-
-       - chi_ai, eta_ai: Collect the angle-independent part of
-         opacity and emissivity for each wavelength so that these
-         need not be recalculated in an angle-dependent case.
-         When the atmosphere is not moving and has no magnetic fields
-         these just point to the total quantities chi_c and eta_c.
-
-   Note: In case of magnetic fields in the atmosphere chi, eta and
-         chip, and chi_c, eta_c and chip_c contain all four Stokes
-         parameters, and should be allocated a 4 and 3 times larger
-         storage space, respectively.
-         --                                            -------------- */
-
-  if (atmos.Stokes)
-    NrecStokes = 4;
-  else
-    NrecStokes = 1;
+    /* --- All continuum contributions in one pass -- ------------ */
 
-  chi_c = (double *) malloc(NrecStokes*atmos.Nspace * sizeof(double));
-  eta_c = (double *) malloc(NrecStokes*atmos.Nspace * sizeof(double));
-  sca_c = (double *) malloc(atmos.Nspace * sizeof(double));
-
-  chi   = (double *) malloc(NrecStokes*atmos.Nspace * sizeof(double));
-  eta   = (double *) malloc(NrecStokes*atmos.Nspace * sizeof(double));
-  scatt = (double *) malloc(atmos.Nspace * sizeof(double));
-
-  if (atmos.Stokes && input.magneto_optical) {
-    chip   = (double *) malloc(3*atmos.Nspace * sizeof(double));
-    chip_c = (double *) malloc(3*atmos.Nspace * sizeof(double));
+    fusedContinuum_p(nspect, thomson, chi, eta, chi_ai, eta_ai, sca_ai);
   } else {
-    chip   = NULL;
-    chip_c = NULL;
-  }
-
-  if (atmos.moving || atmos.Stokes) {
-    chi_ai = (double *) malloc(atmos.Nspace * sizeof(double));
-    eta_ai = (double *) malloc(atmos.Nspace * sizeof(double));
-    sca_ai = (double *) malloc(atmos.Nspace * sizeof(double));
-  } else {
-    chi_ai = chi_c;
-    eta_ai = eta_c;
-    sca_ai = sca_c;
-  }
-  Bnu = (double *) malloc(atmos.Nspace * sizeof(double));
-
-  /* --- Thomson scattering by free electrons is wavelength independent
-         in non-relativistic limit so we compute it only once -- ---- */
-
-  thomson = (double *) malloc(atmos.Nspace * sizeof(double));
-  Thomson(thomson);
-
-  /* --- Check whether an atomic model is present for He -- --------- */
-
-  He = (atmos.elements[1].model) ? atmos.elements[1].model : NULL;
-
-
-  /* --- Go through the spectrum and add the different opacity and
-         emissivity contributions. This is the main loop --  -------- */
-
-  for (nspect = 0;  nspect < spectrum.Nspect;  nspect++) {
-    wavelength = spectrum.lambda[nspect];
-
     /* --- The Planck function at this wavelength --   -------------- */
 
     Planck(atmos.Nspace, atmos.T, wavelength, Bnu);
 
-    /* --- Initialize the flags for this wavelength -- -------------- */
-
-    atmos.backgrflags[nspect].hasline     = FALSE;
-    atmos.backgrflags[nspect].ispolarized = FALSE;
-
     /* --- Initialize angle-independent quantities --  -------------- */
 
     for (k = 0;  k < atmos.Nspace;  k++) {
@@ -398,17 +338,25 @@ void Background_p(bool_t write_analyze_output, bool_t equilibria_only)
     }
     /* --- Negative hydrogen ion, bound-free and free-free -- ------- */
 
-    if (Hminus_bf(wavelength, chi, eta)) {
-      for (k = 0;  k < atmos.Nspace;  k++) {
-	chi_ai[k] += chi[k];
-	eta_ai[k] += eta[k];
-      }
-    }
-    if (Hminus_ff(wavelength, chi)) {
+    if (use_table) {
+      tableHminus_p(nspect, chi);
       for (k = 0;  k < atmos.Nspace;  k++) {
 	chi_ai[k] += chi[k];
 	eta_ai[k] += chi[k] * Bnu[k];
       }
+    } else {
+      if (Hminus_bf(wavelength, chi, eta)) {
+	for (k = 0;  k < atmos.Nspace;  k++) {
+	  chi_ai[k] += chi[k];
+	  eta_ai[k] += eta[k];
+	}
+      }
+      if (Hminus_ff(wavelength, chi)) {
+	for (k = 0;  k < atmos.Nspace;  k++) {
+	  chi_ai[k] += chi[k];
+	  eta_ai[k] += chi[k] * Bnu[k];
+	}
+      }
     }
     /* --- Opacity fudge factors, applied to Hminus opacity -- ------ */
 
@@ -442,7 +390,13 @@ void Background_p(bool_t write_analyze_output, bool_t equilibria_only)
 	eta_ai[k] += eta[k];
       }
     }
-    Hydrogen_ff(wavelength, chi);
+    /* --- Free-free of H, H2^+ and H2^- (the last two below if not
+	   tabulated) --                               -------------- */
+
+    if (use_table)
+      tableFreeFree_p(nspect, chi);
+    else
+      Hydrogen_ff(wavelength, chi);
     for (k = 0;  k < atmos.Nspace;  k++) {
       chi_ai[k] += chi[k];
       eta_ai[k] += chi[k] * Bnu[k];
@@ -463,21 +417,21 @@ void Background_p(bool_t write_analyze_output, bool_t equilibria_only)
     }
     /* --- Absorption by H + H^+ (referred to as H2plus free-free) -- */
 
-    if (H2plus_ff(wavelength, chi)) {
+    if (!use_table  &&  H2plus_ff(wavelength, chi)) {
       for (k = 0;  k < atmos.Nspace;  k++) {
 	chi_ai[k] += chi[k];
 	eta_ai[k] += chi[k] * Bnu[k];
       }
     }
     /* --- Rayleigh scattering and free-free absorption by
-           molecular hydrogen --                       -------------- */
+	   molecular hydrogen --                       -------------- */
 
     if (Rayleigh_H2(wavelength, scatt)) {
       for (k = 0;  k < atmos.Nspace;  k++) {
 	sca_ai[k]  += scatt[k];
       }
     }
-    if (H2minus_ff(wavelength, chi)) {
+    if (!use_table  &&  H2minus_ff(wavelength, chi)) {
       for (k = 0;  k < atmos.Nspace;  k++) {
 	chi_ai[k] += chi[k];
 	eta_ai[k] += chi[k] * Bnu[k];
@@ -492,7 +446,7 @@ void Background_p(bool_t write_analyze_output, bool_t equilibria_only)
       metal_fudge = 1.0;
     }
     /* --- Note: Hydrogen bound-free opacities are calculated in
-           routine Hydrogen_bf --                      -------------- */
+	   routine Hydrogen_bf --                      -------------- */
 
     Metal_bf(wavelength, atmos.Natom-1, atmos.atoms+1, chi, eta);
     for (k = 0;  k < atmos.Nspace;  k++) {
@@ -500,7 +454,7 @@ void Background_p(bool_t write_analyze_output, bool_t equilibria_only)
       eta_ai[k] += eta[k] * metal_fudge;
     }
     /* --- Add the scattering opacity to the absorption part to store
-           the total opacity --                        -------------- */
+	   the total opacity --                        -------------- */
 
     if (do_fudge) {
       Linear(Nfudge, lambda_fudge, fudge[1],
@@ -512,170 +466,145 @@ void Background_p(bool_t write_analyze_output, bool_t equilibria_only)
       sca_ai[k] *= scatt_fudge;
       chi_ai[k] += sca_ai[k];
     }
-    /* --- Now the contributions that may be angle-dependent due to the
-           presence of atomic or molecular lines --    -------------- */
+  }
+  /* --- Now the contributions that may be angle-dependent due to the
+	 presence of atomic or molecular lines --    -------------- */
 
-    if (atmos.moving || atmos.Stokes) {
-      for (mu = 0;  mu < atmos.Nrays;  mu++) {
-        for (to_obs = 0;  to_obs <= 1;  to_obs++) {
-	  index = 2*(nspect*atmos.Nrays + mu) + to_obs;
+  if (atmos.moving || atmos.Stokes) {
+    first = 2*nspect*atmos.Nrays;
+    for (mu = 0;  mu < atmos.Nrays;  mu++) {
+      for (to_obs = 0;  to_obs <= 1;  to_obs++) {
+	index = 2*(nspect*atmos.Nrays + mu) + to_obs;
 
-          /* --- First, copy the angle-independent parts -- --------- */
+	/* --- First, copy the angle-independent parts -- --------- */
 
-	  for (k = 0;  k < atmos.Nspace;  k++) {
-	    chi_c[k] = chi_ai[k];
-	    eta_c[k] = eta_ai[k];
-	    sca_c[k] = sca_ai[k];
-	  }
-          /* --- Zero the polarized quantities, if necessary -- ----- */
-
-	  if (atmos.Stokes) {
-           for (k = atmos.Nspace;  k < 4*atmos.Nspace;  k++) {
-              chi_c[k] = 0.0;
-              eta_c[k] = 0.0;
-            }
-            if (input.magneto_optical)
-              for (k = 0;  k < 3*atmos.Nspace;  k++) chip_c[k] = 0.0;
-	  }
-          /* --- Add opacity from passive atomic lines (including
-                 hydrogen) --                          -------------- */
-
-	  if (input.allow_passive_bb) {
-	    backgrflags = passive_bb(wavelength, nspect, mu, to_obs,
-				     chi, eta, chip);
-	    if (backgrflags.hasline) {
-	      atmos.backgrflags[nspect].hasline = TRUE;
-	      if (backgrflags.ispolarized) {
-                NrecStokes = 4;
-                atmos.backgrflags[nspect].ispolarized = TRUE;
-		if (input.magneto_optical) {
-                  for (k = 0;  k < 3*atmos.Nspace;  k++)
-                    chip_c[k] += chip[k];
-                }
-              } else
-                NrecStokes = 1;
-
-              for (k = 0;  k < NrecStokes*atmos.Nspace;  k++) {
-                chi_c[k] += chi[k];
-                eta_c[k] += eta[k];
-              }
+	for (k = 0;  k < atmos.Nspace;  k++) {
+	  chi_c[k] = chi_ai[k];
+	  eta_c[k] = eta_ai[k];
+	  sca_c[k] = sca_ai[k];
+	}
+	/* --- Zero the polarized quantities, if necessary -- ----- */
 
-	    }
-	  }
-          /* --- Add opacity from Kurucz line list --  -------------- */
-
-          if (atmos.Nrlk > 0) {
-	    backgrflags = rlk_opacity(wavelength, nspect, mu, to_obs,
-				      chi, eta, scatt, chip);
-	    if (backgrflags.hasline) {
-	      atmos.backgrflags[nspect].hasline = TRUE;
-              if (backgrflags.ispolarized) {
-                NrecStokes = 4;
-                atmos.backgrflags[nspect].ispolarized = TRUE;
-                if (input.magneto_optical) {
-                  for (k = 0;  k < 3*atmos.Nspace;  k++)
-                    chip_c[k] += chip[k];
-                }
-              } else
-                NrecStokes = 1;
-
-              for (k = 0;  k < NrecStokes*atmos.Nspace;  k++) {
-                chi_c[k] += chi[k];
-                eta_c[k] += eta[k];
-              }
-	      if (input.rlkscatter) {
-		for (k = 0;  k < atmos.Nspace;  k++) {
-		  sca_c[k] += scatt[k];
-		  chi_c[k] += scatt[k];
-		}
-	      }
-	    }
+	if (atmos.Stokes) {
+	 for (k = atmos.Nspace;  k < 4*atmos.Nspace;  k++) {
+	    chi_c[k] = 0.0;
+	    eta_c[k] = 0.0;
 	  }
-	  /* --- Add opacity from molecular lines --   -------------- */
+	  if (input.magneto_optical)
+	    for (k = 0;  k < 3*atmos.Nspace;  k++) chip_c[k] = 0.0;
+	}
+	/* --- Add opacity from passive atomic lines (including
+	       hydrogen) --                          -------------- */
 
-	  backgrflags = MolecularOpacity(wavelength, nspect, mu, to_obs,
-					 chi, eta, chip);
+	if (input.allow_passive_bb) {
+	  backgrflags = passive_bb(wavelength, nspect, mu, to_obs,
+				   chi, eta, chip);
 	  if (backgrflags.hasline) {
 	    atmos.backgrflags[nspect].hasline = TRUE;
-            if (backgrflags.ispolarized) {
-              NrecStokes = 4;
-              atmos.backgrflags[nspect].ispolarized = TRUE;
-              if (input.magneto_optical) {
-                for (k = 0;  k < 3*atmos.Nspace;  k++)
-                  chip_c[k] += chip[k];
-              }
-            } else
-              NrecStokes = 1;
-
-            for (k = 0;  k < NrecStokes*atmos.Nspace;  k++) {
-              chi_c[k] += chi[k];
-              eta_c[k] += eta[k];
-            }
-	  }
-	  /* --- Store angle-dependent results only if at least one
-                 line was found at this wavelength --  -------------- */
-
-	  atmos.backgrrecno[index] = mpi.backgrrecno;
-	  if ((mu == atmos.Nrays-1 && to_obs) ||
-	      (atmos.backgrflags[nspect].hasline &&
-	       (atmos.moving || atmos.backgrflags[nspect].ispolarized))) {
+	    if (backgrflags.ispolarized) {
+	      NrecStokes = 4;
+	      atmos.backgrflags[nspect].ispolarized = TRUE;
+	      if (input.magneto_optical) {
+		for (k = 0;  k < 3*atmos.Nspace;  k++)
+		  chip_c[k] += chip[k];
+	      }
+	    } else
+	      NrecStokes = 1;
 
-	      if (input.backgr_in_mem) {
+	    for (k = 0;  k < NrecStokes*atmos.Nspace;  k++) {
+	      chi_c[k] += chi[k];
+	      eta_c[k] += eta[k];
+	    }
 
-		if ((mu == atmos.Nrays-1 && to_obs) && !(atmos.backgrflags[nspect].hasline &&
-							 (atmos.moving || atmos.backgrflags[nspect].ispolarized)) ){
-		    storeBackground(nspect, 0, 0, chi_c, eta_c, sca_c);
-		} else {
-		    storeBackground(nspect, mu, to_obs, chi_c, eta_c, sca_c);
-		}
+	  }
+	}
+	/* --- Add opacity from Kurucz line list --  -------------- */
 
-	      } else {
+	if (atmos.Nrlk > 0) {
+	  backgrflags = rlk_opacity(wavelength, nspect, mu, to_obs,
+				    chi, eta, scatt, chip);
+	  if (backgrflags.hasline) {
+	    atmos.backgrflags[nspect].hasline = TRUE;
+	    if (backgrflags.ispolarized) {
+	      NrecStokes = 4;
+	      atmos.backgrflags[nspect].ispolarized = TRUE;
+	      if (input.magneto_optical) {
+		for (k = 0;  k < 3*atmos.Nspace;  k++)
+		  chip_c[k] += chip[k];
+	      }
+	    } else
+	      NrecStokes = 1;
 
-		mpi.backgrrecno += writeBackground(nspect, mu, to_obs,
-						   chi_c, eta_c, sca_c, chip_c);
+	    for (k = 0;  k < NrecStokes*atmos.Nspace;  k++) {
+	      chi_c[k] += chi[k];
+	      eta_c[k] += eta[k];
+	    }
+	    if (input.rlkscatter) {
+	      for (k = 0;  k < atmos.Nspace;  k++) {
+		sca_c[k] += scatt[k];
+		chi_c[k] += scatt[k];
+	      }
 	    }
 	  }
 	}
-      }
-
-    } else {
-      /* --- Angle-independent case. First, add opacity from passive
-	     atomic lines (including hydrogen) --      -------------- */
+	/* --- Add opacity from molecular lines --   -------------- */
 
-      if (input.allow_passive_bb) {
-	backgrflags = passive_bb(wavelength, nspect, 0, TRUE,
-				 chi, eta, NULL);
+	backgrflags = MolecularOpacity(wavelength, nspect, mu, to_obs,
+				       chi, eta, chip);
 	if (backgrflags.hasline) {
 	  atmos.backgrflags[nspect].hasline = TRUE;
-	  for (k = 0;  k < atmos.Nspace;  k++) {
+	  if (backgrflags.ispolarized) {
+	    NrecStokes = 4;
+	    atmos.backgrflags[nspect].ispolarized = TRUE;
+	    if (input.magneto_optical) {
+	      for (k = 0;  k < 3*atmos.Nspace;  k++)
+		chip_c[k] += chip[k];
+	    }
+	  } else
+	    NrecStokes = 1;
+
+	  for (k = 0;  k < NrecStokes*atmos.Nspace;  k++) {
 	    chi_c[k] += chi[k];
 	    eta_c[k] += eta[k];
 	  }
 	}
-      }
-      /* --- Add opacity from Kurucz line list --      -------------- */
+	/* --- Store angle-dependent results only if at least one
+	       line was found at this wavelength --  -------------- */
 
-      if (atmos.Nrlk > 0) {
-	backgrflags = rlk_opacity(wavelength, nspect, 0, TRUE,
-				  chi, eta, scatt, NULL);
-	if (backgrflags.hasline) {
-	  atmos.backgrflags[nspect].hasline = TRUE;
-	  for (k = 0;  k < atmos.Nspace;  k++) {
-	    chi_c[k] += chi[k];
-	    eta_c[k] += eta[k];
-	  }
-      	  if (input.rlkscatter) {
-	    for (k = 0;  k < atmos.Nspace;  k++) {
-	      sca_c[k] += scatt[k];
-	      chi_c[k] += scatt[k];
-	    }
+	if ((mu == atmos.Nrays-1 && to_obs) ||
+	    (atmos.backgrflags[nspect].hasline &&
+	     (atmos.moving || atmos.backgrflags[nspect].ispolarized))) {
+
+	    if (input.backgr_in_mem) {
+
+	      if ((mu == atmos.Nrays-1 && to_obs) && !(atmos.backgrflags[nspect].hasline &&
+						       (atmos.moving || atmos.backgrflags[nspect].ispolarized)) ){
+		  storeBackground(nspect, 0, 0, chi_c, eta_c, sca_c);
+	      } else {
+		  storeBackground(nspect, mu, to_obs, chi_c, eta_c, sca_c);
+	      }
+
+	    } else {
+
+	      /* --- Angles not stored use the next record written -- */
+
+	      recno = __sync_fetch_and_add(&mpi.backgrrecno,
+					   backgroundRecords(nspect));
+	      for ( ;  first <= index;  first++)
+		atmos.backgrrecno[first] = recno;
+	      writeBackground(nspect, mu, to_obs, chi_c, eta_c, sca_c, chip_c);
 	  }
 	}
       }
-      /* --- Add opacity from molecular lines --       -------------- */
+    }
+
+  } else {
+    /* --- Angle-independent case. First, add opacity from passive
+	   atomic lines (including hydrogen) --      -------------- */
 
-      backgrflags = MolecularOpacity(wavelength, nspect, 0, TRUE,
-				     chi, eta, NULL);
+    if (input.allow_passive_bb) {
+      backgrflags = passive_bb(wavelength, nspect, 0, TRUE,
+			       chi, eta, NULL);
       if (backgrflags.hasline) {
 	atmos.backgrflags[nspect].hasline = TRUE;
 	for (k = 0;  k < atmos.Nspace;  k++) {
@@ -683,17 +612,177 @@ void Background_p(bool_t write_analyze_output, bool_t equilibria_only)
 	  eta_c[k] += eta[k];
 	}
       }
-      /* --- Store results --                          -------------- */
+    }
+    /* --- Add opacity from Kurucz line list --      -------------- */
 
-      atmos.backgrrecno[nspect] = mpi.backgrrecno;
+    if (atmos.Nrlk > 0) {
+      backgrflags = rlk_opacity(wavelength, nspect, 0, TRUE,
+				chi, eta, scatt, NULL);
+      if (backgrflags.hasline) {
+	atmos.backgrflags[nspect].hasline = TRUE;
+	for (k = 0;  k < atmos.Nspace;  k++) {
+	  chi_c[k] += chi[k];
+	  eta_c[k] += eta[k];
+	}
+	if (input.rlkscatter) {
+	  for (k = 0;  k < atmos.Nspace;  k++) {
+	    sca_c[k] += scatt[k];
+	    chi_c[k] += scatt[k];
+	  }
+	}
+      }
+    }
+    /* --- Add opacity from molecular lines --       -------------- */
 
-      if (input.backgr_in_mem) {
-	storeBackground(nspect, 0, 0, chi_c, eta_c, sca_c);
-      } else {
-	mpi.backgrrecno += writeBackground(nspect, 0, 0,
-					   chi_c, eta_c, sca_c, NULL);
+    backgrflags = MolecularOpacity(wavelength, nspect, 0, TRUE,
+				   chi, eta, NULL);
+    if (backgrflags.hasline) {
+      atmos.backgrflags[nspect].hasline = TRUE;
+      for (k = 0;  k < atmos.Nspace;  k++) {
+	chi_c[k] += chi[k];
+	eta_c[k] += eta[k];
       }
     }
+    /* --- Store results --                          -------------- */
+
+    if (input.backgr_in_mem) {
+      storeBackground(nspect, 0, 0, chi_c, eta_c, sca_c);
+    } else {
+      atmos.backgrrecno[nspect] =
+	__sync_fetch_and_add(&mpi.backgrrecno, backgroundRecords(nspect));
+      writeBackground(nspect, 0, 0, chi_c, eta_c, sca_c, NULL);
+    }
+  }
+}
+/* ------- end ---------------------------- backgroundLambda_p.c ---- */
+
+/* ------- begin -------------------------- Background.c ------------ */
+
+void Background_p(bool_t write_analyze_output, bool_t equilibria_only)
+{
+  const char routineName[] = "Background_p";
+  register int k, nspect;
+
+  static int ne_iter = 0;
+  bool_t  fromscratch;
+  int     Nscratch;
+  Element *element;
+  char    file_background[MAX_MESSAGE_LENGTH], *fext = FILE_EXT;
+  BackgroundWork bw;
+
+  getCPU(2, TIME_START, NULL);
+
+  if (input.solve_ne == ONCE  || input.solve_ne == ITERATION ) {
+    fromscratch = (input.solve_ne == ONCE  ||
+		   (input.solve_ne == ITERATION  &&  ne_iter == 0)) ?
+      TRUE : FALSE;
+    Solve_ne(atmos.ne, fromscratch);
+    ne_iter++;
+  }
+  SetLTEQuantities_p();
+
+  if (input.NonICE)
+    readMolecules(MOLECULAR_CONCENTRATION_FILE);
+  else
+    ChemicalEquilibrium(N_MAX_CHEM_ITER, CHEM_ITER_LIMIT);
+
+  if (equilibria_only) {
+
+    /* --- If we only need ne, LTE populations and collisions, and
+           chemical equilibrium leave here --          -------------- */
+
+    getCPU(2, TIME_POLL, "Total Background");
+    return;
+  }
+
+  getCPU(3, TIME_START, NULL);
+
+  // bcakground data in memory or on file?
+  if (input.backgr_in_mem) {
+    // in memory
+
+    // sanity check
+    if (input.StokesMode != NO_STOKES)
+	Error(ERROR_LEVEL_2,routineName,"Polarized transfer and in-memory backgr. op. is not implemented.");
+
+	if (atmos.chi_b != NULL) freeMatrix((void **) atmos.chi_b);
+	atmos.chi_b = matrix_double(spectrum.Nspect * 2 * atmos.Nrays, atmos.Nspace);
+
+	if (atmos.eta_b != NULL) freeMatrix((void **) atmos.eta_b);
+	atmos.eta_b = matrix_double(spectrum.Nspect * 2 * atmos.Nrays, atmos.Nspace);
+
+	if (atmos.sca_b != NULL) freeMatrix((void **) atmos.sca_b);
+	atmos.sca_b = matrix_double(spectrum.Nspect * 2 * atmos.Nrays, atmos.Nspace);
+
+  } else {
+
+	// on file
+
+	/* --- Open background file --                        ------------- */
+
+	/* get file name, with the MPI rank */
+	sprintf(file_background,"%s_p%d%s", input.background_File , mpi.rank, fext);
+
+	if ((atmos.fd_background =
+	     open(file_background, O_RDWR | O_CREAT | O_TRUNC, PERMISSIONS)) == -1) {
+	  sprintf(messageStr, "Unable to open output file %s",
+		  file_background);
+	  Error(ERROR_LEVEL_2, routineName, messageStr);
+	}
+
+	/* Zero record number, as background file is being overwritten */
+	mpi.backgrrecno = 0;
+
+ }
+
+
+  /* --- Scratch space, one set for each thread (see
+         allocBackgroundScratch) --                    -------------- */
+
+  Nscratch   = MAX(input.Nthreads, 1);
+  bw.scratch = allocBackgroundScratch(Nscratch);
+
+  /* --- Thomson scattering by free electrons is wavelength independent
+         in non-relativistic limit so we compute it only once -- ---- */
+
+  bw.thomson = (double *) malloc(atmos.Nspace * sizeof(double));
+  Thomson(bw.thomson);
+
+  /* --- Check whether an atomic model is present for He -- --------- */
+
+  bw.He = (atmos.elements[1].model) ? atmos.elements[1].model : NULL;
+
+  /* --- Tabulated LTE continuum opacities for this column? -- ------ */
+
+  bw.use_table = setBackgroundTable_p();
+  bw.use_fused = (bw.use_table  &&  input.p15d_fused);
+
+  /* --- Doppler widths and damping parameters of the background
+         lines within reach of the wavelength grid --  -------------- */
+
+  initRLKProfiles();
+  initMolProfiles();
+  resetPassiveLists();
+
+
+  /* --- Go through the spectrum and add the different opacity and
+         emissivity contributions. This is the main loop. With
+         input.Nthreads > 1 the wavelengths are shared out over the
+         thread pool. --                               -------------- */
+
+  if (input.Nthreads > 1) {
+
+    /* --- The free-free routines set up their temperature indices
+           for the column at the first call, not concurrently -- ---- */
+
+    Hminus_ff(spectrum.lambda[0], bw.scratch[0].chi);
+    H2minus_ff(spectrum.lambda[0], bw.scratch[0].chi);
+    H2plus_ff(spectrum.lambda[0], bw.scratch[0].chi);
+
+    runThreadPool(spectrum.Nspect, backgroundLambda_p, &bw);
+  } else {
+    for (nspect = 0;  nspect < spectrum.Nspect;  nspect++)
+      backgroundLambda_p(nspect, &bw);
   }
 
   getCPU(3, TIME_POLL, "Background Opacity");
@@ -704,18 +793,11 @@ void Background_p(bool_t write_analyze_output, bool_t equilibria_only)
   H2minus_ff(0.0, NULL);
   H2plus_ff(0.0, NULL);
 
-  free(chi);    free(eta);  free(scatt);  free(Bnu);  free(thomson);
-  free(chi_c);  free(eta_c);  free(sca_c);
+  freeRLKProfiles();
+  freeMolProfiles();
 
-  if (atmos.moving || atmos.Stokes) {
-    free(chi_ai);
-    free(eta_ai);
-    free(sca_ai);
-  }
-  if (atmos.Stokes && input.magneto_optical) {
-    free(chip);
-    free(chip_c);
-  }
+  freeBackgroundScratch(Nscratch, bw.scratch);
+  free(bw.thomson);
 
   /* --- Free the element populations for species used in rlk_opacity --- */
   for (k = 0;  k < atmos.Nelem;  k++) {
@@ -0,0 +1,87 @@
+/* ------- file: -------------------------- bcastinput_p.c ----------
+
+       Version:       rh2.0, 1.5-D plane-parallel
+       Last modified: Sun Oct 18 2026 --
+
+       --------------------------                      ----------RH-- */
+
+/* --- Broadcast of input files (15D_BCAST_INPUT). While set with
+       setInputBcast_p, every input file opened with fopenInput is read
+       by the first process of the communicator only and broadcast to
+       the others, which parse it from memory. All processes of the
+       communicator must then open the same input files in the same
+       order, as they do while reading the input at the start of a run.
+                                                          --------- */
+
+#include <limits.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "rh.h"
+#include "error.h"
+#include "inputs.h"
+#include "parallel.h"
+
+
+/* --- Global variables --                             -------------- */
+
+static MPI_Comm bcast_comm = MPI_COMM_NULL;
+
+
+/* ------- begin -------------------------- bcastOpen.c ------------ */
+static FILE *bcastOpen(const char *fileName)
+/* Reads fileName in the first process and broadcasts its contents.
+   Returns a stream on a copy of the contents, NULL if the file could
+   not be read. */
+{
+  int    rank, n;
+  long   size = -1, offset;
+  char  *buffer = NULL;
+  FILE  *fp;
+
+  MPI_Comm_rank(bcast_comm, &rank);
+  if (rank == 0  &&  (fp = fopen(fileName, "r")) != NULL) {
+    if (fseek(fp, 0, SEEK_END) == 0  &&  (size = ftell(fp)) >= 0) {
+      rewind(fp);
+      buffer = (char *) malloc(size + 1);
+      if (fread(buffer, 1, size, fp) != (size_t) size) {
+	free(buffer);
+	buffer = NULL;
+	size   = -1;
+      }
+    }
+    fclose(fp);
+  }
+  MPI_Bcast(&size, 1, MPI_LONG, 0, bcast_comm);
+  if (size < 0) return NULL;
+
+  if (rank != 0) buffer = (char *) malloc(size + 1);
+  for (offset = 0;  offset < size;  offset += n) {
+    n = (int) MIN(size - offset, INT_MAX);
+    MPI_Bcast(buffer + offset, n, MPI_CHAR, 0, bcast_comm);
+  }
+
+  /* --- The stream gets its own copy so that it is freed with fclose */
+  fp = fmemopen(NULL, size + 1, "w+");
+  if (fp != NULL) {
+    fwrite(buffer, 1, size, fp);
+    rewind(fp);
+  }
+  free(buffer);
+  return fp;
+}
+/* ------- end   -------------------------- bcastOpen.c ------------ */
+
+/* ------- begin -------------------------- setInputBcast_p.c ------ */
+MPI_Comm setInputBcast_p(MPI_Comm comm)
+/* Broadcasts input files within comm from now on, or opens them in
+   every process again with MPI_COMM_NULL. Returns the previous
+   communicator. */
+{
+  MPI_Comm previous = bcast_comm;
+
+  bcast_comm = comm;
+  setInputOpener((comm == MPI_COMM_NULL) ? NULL : bcastOpen);
+  return previous;
+}
+/* ------- end   -------------------------- setInputBcast_p.c ------ */
@@ -0,0 +1,460 @@
+/* ------- file: -------------------------- bgtable_p.c -------------
+
+       Version:       rh2.0, 1.5-D plane-parallel
+       Last modified: Sun Oct 18 2026 --
+
+       --------------------------                      ----------RH-- */
+
+/* --- Tabulated LTE continuum opacities (15D_BG_TABLE). The H^- bound-
+       free and free-free opacities, and the free-free opacities of H,
+       H2^+ and H2^-, are each a product of densities times a function
+       of wavelength and temperature only:
+
+         chi = nHmin        * f_0(lambda, T)    H^-  bound-free
+             + nH(1) * ne   * f_1(lambda, T)    H^-  free-free
+             + ne    * np   * f_2(lambda, T)    H    free-free
+             + nH(1) * np   * f_3(lambda, T)    H2^+ free-free
+             + nH2   * ne   * f_4(lambda, T)    H2^- free-free
+
+       and all of them emit in LTE, eta = chi * B_nu. The f_i are
+       tabulated once per run on the wavelength grid of the run and a
+       logarithmic temperature grid, with the exact routines of
+       hydrogen.c, and kept in shared memory by the processes of a
+       node. Background_p then only interpolates in temperature.
+       Columns with temperatures beyond the table use the exact
+       routines.
+
+       With 15D_FUSED_BG, fusedContinuum_p adds up all continuum
+       opacities of Background_p, except those of OH and CH, in a
+       single pass over depth per wavelength: the tabulated terms,
+       hydrogen and metal bound-free, Rayleigh scattering by H, He and
+       H2, and Thomson scattering. The stimulated emission factor is
+       evaluated once per depth for the bound-free terms and the
+       Planck function.
+                                                          --------- */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "rh.h"
+#include "atom.h"
+#include "atmos.h"
+#include "spectrum.h"
+#include "background.h"
+#include "error.h"
+#include "inputs.h"
+#include "constant.h"
+#include "geometry.h"
+#include "parallel.h"
+
+#define TABLE_NTERM  5
+#define TABLE_TMIN   500.0
+#define TABLE_TMAX   1.0E7
+#define MAX_EXPONENT 150.0
+
+
+/* --- Bound-free transition at the present wavelength, with
+       cross section alpha from level i to j --         -------------- */
+
+typedef struct {
+  double alpha, *ni, *nstari, *nj, *nstarj;
+} BoundFree;
+
+
+/* --- Global variables --                             -------------- */
+
+extern Atmosphere atmos;
+extern Spectrum spectrum;
+extern InputData input;
+extern char messageStr[];
+extern MPI_data mpi;
+extern BackgroundData bgdat;
+
+static int     NT = 0, *tindex = NULL;
+static long    Nalloc = 0;
+static double *table = NULL, *tweight = NULL, *dens[TABLE_NTERM];
+
+
+/* ------- begin -------------------------- fillTable.c ------------ */
+static void fillTable(int first, int stride)
+/* Fills the table for every stride-th wavelength from first on, by
+   calling the exact routines for an atmosphere of the temperatures
+   of the table with unit densities */
+{
+  register int k, n;
+
+  long    Nspace = atmos.Nspace;
+  double *T = atmos.T, *ne = atmos.ne, *nHmin = atmos.nHmin,
+        **nH = atmos.H->n, *nH2 = atmos.H2->n, *Tgrid, *one, **one_H,
+         *eta, *f, lambda;
+  int     nspect;
+
+  Tgrid = (double *) malloc(NT * sizeof(double));
+  one   = (double *) malloc(NT * sizeof(double));
+  eta   = (double *) malloc(NT * sizeof(double));
+  one_H = (double **) malloc(atmos.H->Nlevel * sizeof(double *));
+  for (k = 0;  k < NT;  k++) {
+    Tgrid[k] = TABLE_TMIN * pow(TABLE_TMAX / TABLE_TMIN, k / (NT - 1.0));
+    one[k]   = 1.0;
+  }
+  for (n = 0;  n < atmos.H->Nlevel;  n++) one_H[n] = one;
+
+  atmos.Nspace = NT;
+  atmos.T      = Tgrid;
+  atmos.ne     = atmos.nHmin = atmos.H2->n = one;
+  atmos.H->n   = one_H;
+  Hminus_ff(0.0, NULL);
+  H2minus_ff(0.0, NULL);
+  H2plus_ff(0.0, NULL);
+
+  for (nspect = first;  nspect < spectrum.Nspect;  nspect += stride) {
+    lambda = spectrum.lambda[nspect];
+    f = table + (long) nspect * TABLE_NTERM * NT;
+
+    if (!Hminus_bf(lambda, f, eta))
+      for (k = 0;  k < NT;  k++) f[k] = 0.0;
+    if (!Hminus_ff(lambda, f + NT))
+      for (k = 0;  k < NT;  k++) f[NT + k] = 0.0;
+    Hydrogen_ff(lambda, f + 2*NT);
+    if (!H2plus_ff(lambda, f + 3*NT))
+      for (k = 0;  k < NT;  k++) f[3*NT + k] = 0.0;
+    if (!H2minus_ff(lambda, f + 4*NT))
+      for (k = 0;  k < NT;  k++) f[4*NT + k] = 0.0;
+  }
+  Hminus_ff(0.0, NULL);
+  H2minus_ff(0.0, NULL);
+  H2plus_ff(0.0, NULL);
+
+  atmos.Nspace = Nspace;
+  atmos.T      = T;
+  atmos.ne     = ne;
+  atmos.nHmin  = nHmin;
+  atmos.H->n   = nH;
+  atmos.H2->n  = nH2;
+
+  free(Tgrid);
+  free(one);
+  free(one_H);
+  free(eta);
+}
+/* ------- end   -------------------------- fillTable.c ------------ */
+
+/* ------- begin -------------------------- initBackgroundTable_p.c  */
+void initBackgroundTable_p(void)
+/* Allocates the table in node shared memory, with the processes of
+   the node each filling part of the wavelengths */
+{
+  const char routineName[] = "initBackgroundTable_p";
+  int      noderank, nodesize, disp;
+  MPI_Aint size;
+  MPI_Comm nodecomm;
+  MPI_Win  win;
+
+  NT = MAX(input.p15d_bgtable, 2);
+
+  MPI_Comm_split_type(mpi.comm, MPI_COMM_TYPE_SHARED, mpi.rank,
+		      MPI_INFO_NULL, &nodecomm);
+  MPI_Comm_rank(nodecomm, &noderank);
+  MPI_Comm_size(nodecomm, &nodesize);
+
+  /* The window lives as long as the table, until the end of the run */
+  size = (noderank == 0) ?
+    (MPI_Aint) spectrum.Nspect * TABLE_NTERM * NT * sizeof(double) : 0;
+  MPI_Win_allocate_shared(size, sizeof(double), MPI_INFO_NULL, nodecomm,
+			  &table, &win);
+  MPI_Win_shared_query(win, 0, &size, &disp, &table);
+
+  fillTable(noderank, nodesize);
+  MPI_Barrier(nodecomm);
+  MPI_Comm_free(&nodecomm);
+
+  if (mpi.rank == 0) {
+    sprintf(messageStr, "Tabulated continuum opacities for %d "
+	    "temperatures, %.1f MB per node\n", NT,
+	    (double) size / (1024.0 * 1024.0));
+    Error(MESSAGE, routineName, messageStr);
+  }
+}
+/* ------- end   -------------------------- initBackgroundTable_p.c  */
+
+/* ------- begin -------------------------- interpolate.c ---------- */
+static void interpolate(int nspect, int Nterm, const int *terms,
+			double *chi)
+/* Adds up the tabulated opacities of terms at wavelength nspect */
+{
+  register int k, t;
+
+  double *f;
+
+  for (k = 0;  k < atmos.Nspace;  k++) chi[k] = 0.0;
+  for (t = 0;  t < Nterm;  t++) {
+    f = table + ((long) nspect * TABLE_NTERM + terms[t]) * NT;
+    for (k = 0;  k < atmos.Nspace;  k++) {
+      chi[k] += dens[terms[t]][k] *
+	(f[tindex[k]] + tweight[k] * (f[tindex[k] + 1] - f[tindex[k]]));
+    }
+  }
+}
+/* ------- end   -------------------------- interpolate.c ---------- */
+
+/* ------- begin -------------------------- checkTable.c ----------- */
+static void checkTable(void)
+/* Reports the largest deviation of the tabulated from the exact
+   opacities in the present column */
+{
+  const char routineName[] = "checkTable";
+  const int terms[TABLE_NTERM] = {0, 1, 2, 3, 4};
+  register int k;
+
+  int     nspect;
+  double *chi, *exact, *tmp, *eta, dev, devmax = 0.0;
+
+  chi   = (double *) malloc(atmos.Nspace * sizeof(double));
+  exact = (double *) malloc(atmos.Nspace * sizeof(double));
+  tmp   = (double *) malloc(atmos.Nspace * sizeof(double));
+  eta   = (double *) malloc(atmos.Nspace * sizeof(double));
+
+  for (nspect = 0;  nspect < spectrum.Nspect;  nspect++) {
+    interpolate(nspect, TABLE_NTERM, terms, chi);
+
+    for (k = 0;  k < atmos.Nspace;  k++) exact[k] = 0.0;
+    if (Hminus_bf(spectrum.lambda[nspect], tmp, eta))
+      for (k = 0;  k < atmos.Nspace;  k++) exact[k] += tmp[k];
+    if (Hminus_ff(spectrum.lambda[nspect], tmp))
+      for (k = 0;  k < atmos.Nspace;  k++) exact[k] += tmp[k];
+    Hydrogen_ff(spectrum.lambda[nspect], tmp);
+    for (k = 0;  k < atmos.Nspace;  k++) exact[k] += tmp[k];
+    if (H2plus_ff(spectrum.lambda[nspect], tmp))
+      for (k = 0;  k < atmos.Nspace;  k++) exact[k] += tmp[k];
+    if (H2minus_ff(spectrum.lambda[nspect], tmp))
+      for (k = 0;  k < atmos.Nspace;  k++) exact[k] += tmp[k];
+
+    for (k = 0;  k < atmos.Nspace;  k++) {
+      if (exact[k] > 0.0) {
+	dev = fabs(chi[k] - exact[k]) / exact[k];
+	if (dev > devmax) devmax = dev;
+      }
+    }
+  }
+  free(chi);
+  free(exact);
+  free(tmp);
+  free(eta);
+
+  sprintf(messageStr, "Largest relative deviation of tabulated from "
+	  "exact continuum opacities: %.2E\n", devmax);
+  Error(MESSAGE, routineName, messageStr);
+}
+/* ------- end   -------------------------- checkTable.c ----------- */
+
+/* ------- begin -------------------------- setBackgroundTable_p.c - */
+bool_t setBackgroundTable_p(void)
+/* Prepares the interpolation for the present column. Returns FALSE
+   if the table is off or does not cover the temperatures of the
+   column, then the exact routines are to be used. */
+{
+  static bool_t checked = FALSE;
+  register int k, t;
+
+  double *np, x, ln_Tmin, dlnT;
+
+  if (table == NULL) return FALSE;
+
+  for (k = 0;  k < atmos.Nspace;  k++)
+    if (atmos.T[k] < TABLE_TMIN  ||  atmos.T[k] > TABLE_TMAX) return FALSE;
+
+  if (atmos.Nspace > Nalloc) {
+    Nalloc  = atmos.Nspace;
+    tindex  = (int *) realloc(tindex, Nalloc * sizeof(int));
+    tweight = (double *) realloc(tweight, Nalloc * sizeof(double));
+    for (t = 0;  t < TABLE_NTERM;  t++)
+      dens[t] = (double *) realloc(dens[t], Nalloc * sizeof(double));
+  }
+  ln_Tmin = log(TABLE_TMIN);
+  dlnT    = log(TABLE_TMAX / TABLE_TMIN) / (NT - 1);
+  np      = atmos.H->n[atmos.H->Nlevel - 1];
+
+  for (k = 0;  k < atmos.Nspace;  k++) {
+    x = (log(atmos.T[k]) - ln_Tmin) / dlnT;
+    tindex[k]  = MIN((int) x, NT - 2);
+    tweight[k] = x - tindex[k];
+
+    dens[0][k] = atmos.nHmin[k];
+    dens[1][k] = atmos.H->n[0][k] * atmos.ne[k];
+    dens[2][k] = atmos.ne[k] * np[k];
+    dens[3][k] = atmos.H->n[0][k] * np[k];
+    dens[4][k] = atmos.H2->n[k] * atmos.ne[k];
+  }
+  if (!checked  &&  mpi.rank == 0) checkTable();
+  checked = TRUE;
+
+  return TRUE;
+}
+/* ------- end   -------------------------- setBackgroundTable_p.c - */
+
+/* ------- begin -------------------------- tableHminus_p.c -------- */
+void tableHminus_p(int nspect, double *chi)
+/* H^- bound-free and free-free opacity at wavelength nspect */
+{
+  const int terms[2] = {0, 1};
+
+  interpolate(nspect, 2, terms, chi);
+}
+/* ------- end   -------------------------- tableHminus_p.c -------- */
+
+/* ------- begin -------------------------- tableFreeFree_p.c ------ */
+void tableFreeFree_p(int nspect, double *chi)
+/* H, H2^+ and H2^- free-free opacity at wavelength nspect */
+{
+  const int terms[3] = {2, 3, 4};
+
+  interpolate(nspect, 3, terms, chi);
+}
+/* ------- end   -------------------------- tableFreeFree_p.c ------ */
+
+/* ------- begin -------------------------- boundFree.c ------------ */
+static int boundFree(double lambda, double metal_fudge, BoundFree *bf)
+/* Lists the passive hydrogen and metal bound-free transitions that
+   absorb at lambda, as Hydrogen_bf and Metal_bf do, and returns
+   their number */
+{
+  register int m, kr;
+
+  int    Nbf = 0;
+  double **n;
+  Atom  *metal;
+  AtomicContinuum *continuum;
+
+  if (!atmos.H->active) {
+    for (kr = 0;  kr < atmos.H->Ncont;  kr++) {
+      continuum = atmos.H->continuum + kr;
+      if (lambda <= continuum->lambda0  &&  lambda >= continuum->lambda[0]) {
+	bf[Nbf].alpha  = Hydrogen_bfCross(lambda, continuum);
+	bf[Nbf].ni     = atmos.H->n[continuum->i];
+	bf[Nbf].nstari = atmos.H->nstar[continuum->i];
+	bf[Nbf].nj     = atmos.H->n[atmos.H->Nlevel - 1];
+	bf[Nbf].nstarj = atmos.H->nstar[atmos.H->Nlevel - 1];
+	Nbf++;
+      }
+    }
+  }
+  for (m = 1;  m < atmos.Natom;  m++) {
+    metal = atmos.atoms + m;
+    if (metal->active) continue;
+
+    n = (metal->n != metal->nstar) ? metal->n : metal->nstar;
+    for (kr = 0;  kr < metal->Ncont;  kr++) {
+      continuum = metal->continuum + kr;
+      if (lambda <= continuum->lambda0  &&  lambda >= continuum->lambda[0]) {
+	bf[Nbf].alpha  = Metal_bfCross(lambda, metal, continuum) *
+	  metal_fudge;
+	bf[Nbf].ni     = n[continuum->i];
+	bf[Nbf].nstari = metal->nstar[continuum->i];
+	bf[Nbf].nj     = n[continuum->j];
+	bf[Nbf].nstarj = metal->nstar[continuum->j];
+	Nbf++;
+      }
+    }
+  }
+  return Nbf;
+}
+/* ------- end   -------------------------- boundFree.c ------------ */
+
+/* ------- begin -------------------------- fusedContinuum_p.c ----- */
+void fusedContinuum_p(int nspect, double *thomson, double *chi,
+		      double *eta, double *chi_ai, double *eta_ai,
+		      double *sca_ai)
+/* Angle-independent continuum opacity, emissivity and scattering
+   opacity at wavelength nspect, as from the exact routines in
+   Background_p. Needs a column prepared with setBackgroundTable_p.
+   chi and eta are scratch space. */
+{
+  register int k, n;
+
+  int     Nbf, Ncont, i0, i1;
+  double  lambda = spectrum.lambda[nspect], hc_kla, twohnu3_c2, x, stim,
+          Bnu, chi_lte, chi_bf, eta_bf, sigma_H, sigma_He, sigma_H2,
+          Hmin_fudge = 1.0, metal_fudge = 1.0, scatt_fudge = 1.0,
+         *f0, *f1, *f2, *f3, *f4, *nH0, *nHe0 = NULL, *nH2, w;
+  Atom   *He = atmos.elements[1].model;
+  BoundFree *bf;
+
+  if (bgdat.do_fudge) {
+    Linear(bgdat.Nfudge, bgdat.lambda_fudge, bgdat.fudge[0],
+	   1, &lambda, &Hmin_fudge, FALSE);
+    Linear(bgdat.Nfudge, bgdat.lambda_fudge, bgdat.fudge[1],
+	   1, &lambda, &scatt_fudge, FALSE);
+    Linear(bgdat.Nfudge, bgdat.lambda_fudge, bgdat.fudge[2],
+	   1, &lambda, &metal_fudge, FALSE);
+  }
+  /* --- OH and CH bound-free keep their own routines -- ---------- */
+
+  for (k = 0;  k < atmos.Nspace;  k++) {
+    chi_ai[k] = 0.0;
+    eta_ai[k] = 0.0;
+  }
+  if (OH_bf_opac(lambda, chi, eta)) {
+    for (k = 0;  k < atmos.Nspace;  k++) {
+      chi_ai[k] += chi[k];
+      eta_ai[k] += eta[k];
+    }
+  }
+  if (CH_bf_opac(lambda, chi, eta)) {
+    for (k = 0;  k < atmos.Nspace;  k++) {
+      chi_ai[k] += chi[k];
+      eta_ai[k] += eta[k];
+    }
+  }
+  /* --- Cross sections at this wavelength --          -------------- */
+
+  Ncont = atmos.H->Ncont;
+  for (n = 1;  n < atmos.Natom;  n++) Ncont += atmos.atoms[n].Ncont;
+  bf  = (BoundFree *) malloc(Ncont * sizeof(BoundFree));
+  Nbf = boundFree(lambda, metal_fudge, bf);
+
+  if (!RayleighCross(lambda, atmos.H, &sigma_H)) sigma_H = 0.0;
+  if (He  &&  RayleighCross(lambda, He, &sigma_He))
+    nHe0 = He->n[0];
+  if (!Rayleigh_H2Cross(lambda, &sigma_H2)) sigma_H2 = 0.0;
+  nH0 = atmos.H->n[0];
+  nH2 = atmos.H2->n;
+
+  f0 = table + (long) nspect * TABLE_NTERM * NT;
+  f1 = f0 + NT;  f2 = f1 + NT;  f3 = f2 + NT;  f4 = f3 + NT;
+
+  hc_kla     = (HPLANCK * CLIGHT) / (KBOLTZMANN * NM_TO_M * lambda);
+  twohnu3_c2 = (2.0 * HPLANCK * CLIGHT) / CUBE(NM_TO_M * lambda);
+
+  /* --- One pass over depth --                        -------------- */
+
+  for (k = 0;  k < atmos.Nspace;  k++) {
+    x    = hc_kla / atmos.T[k];
+    stim = exp(-x);
+    Bnu  = (x <= MAX_EXPONENT) ? twohnu3_c2 * stim / (1.0 - stim) : 0.0;
+
+    i0 = tindex[k];
+    i1 = i0 + 1;
+    w  = tweight[k];
+    chi_lte = Hmin_fudge *
+      (dens[0][k] * (f0[i0] + w * (f0[i1] - f0[i0])) +
+       dens[1][k] * (f1[i0] + w * (f1[i1] - f1[i0]))) +
+      dens[2][k] * (f2[i0] + w * (f2[i1] - f2[i0])) +
+      dens[3][k] * (f3[i0] + w * (f3[i1] - f3[i0])) +
+      dens[4][k] * (f4[i0] + w * (f4[i1] - f4[i0]));
+
+    chi_bf = 0.0;
+    eta_bf = 0.0;
+    for (n = 0;  n < Nbf;  n++) {
+      chi_bf += bf[n].alpha * bf[n].ni[k];
+      eta_bf += bf[n].alpha * bf[n].nj[k] * bf[n].nstari[k] / bf[n].nstarj[k];
+    }
+    sca_ai[k] = scatt_fudge * (thomson[k] + sigma_H * nH0[k] +
+			       sigma_H2 * nH2[k] +
+			       ((nHe0) ? sigma_He * nHe0[k] : 0.0));
+
+    chi_ai[k] += chi_lte + chi_bf * (1.0 - stim) + sca_ai[k];
+    eta_ai[k] += chi_lte * Bnu + eta_bf * twohnu3_c2 * stim;
+  }
+  free(bf);
+}
+/* ------- end   -------------------------- fusedContinuum_p.c ----- */
@@ -0,0 +1,350 @@
+/* ------- file: -------------------------- checkpoint_p.c ----------
+
+       Version:       rh2.0, 1.5-D plane-parallel
+       Last modified: Sun Oct 18 2026 --
+
+       --------------------------                      ----------RH-- */
+
+/* --- Checkpointing of columns that are being iterated.
+
+       Every input.p15d_checkpoint iterations Iterate_p saves the state
+       needed to continue the iteration of the current column: the
+       populations of active atoms and molecules, their Ng acceleration
+       history, and for PRD lines rho_prd and its Ng history. There is
+       one file per column, so that a restarted run can pick it up on
+       any process. Files are written under a temporary name and then
+       renamed, so that a job killed while writing leaves the previous
+       checkpoint intact. The header records the snapshot and the
+       atmosphere ID, so that a checkpoint of another snapshot or
+       atmosphere in the same scratch directory is not picked up.
+       --                                              -------------- */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "rh.h"
+#include "atom.h"
+#include "atmos.h"
+#include "accelerate.h"
+#include "error.h"
+#include "inputs.h"
+#include "parallel.h"
+
+#define CHECKPOINT_VERSION 2
+
+
+/* --- Function prototypes --                          -------------- */
+
+static void checkpointName(Column *col, char *filename);
+static int  Nlamu_prd(AtomicLine *line);
+static bool_t writeNg(FILE *fp, struct Ng *Ngs);
+static bool_t readNg(FILE *fp, struct Ng *Ngs, int N, int Norder);
+static bool_t readInt(FILE *fp, int expected);
+
+
+/* --- Global variables --                             -------------- */
+
+extern Atmosphere atmos;
+extern InputData input;
+extern MPI_data mpi;
+extern char messageStr[];
+
+
+/* ------- begin -------------------------- writeCheckpoint_p.c ----- */
+
+void writeCheckpoint_p(Column *col, int niter, double cswitch)
+{
+  /* --- Saves iteration state of current column. niter is the number
+         of the next iteration to be done --           -------------- */
+
+  const char routineName[] = "writeCheckpoint_p";
+  register int kr, nact;
+
+  char  filename[MAX_LINE_SIZE], tmpname[MAX_LINE_SIZE + 4];
+  char  ID[ATMOS_ID_WIDTH];
+  bool_t result = TRUE;
+  int   header[6], Nlamu;
+  FILE *fp;
+  Atom *atom;
+  AtomicLine *line;
+  Molecule *molecule;
+
+  checkpointName(col, filename);
+  sprintf(tmpname, "%s.tmp", filename);
+
+  if ((fp = fopen(tmpname, "w")) == NULL) {
+    sprintf(messageStr, "Unable to open checkpoint file %s", tmpname);
+    Error(WARNING, routineName, messageStr);
+    return;
+  }
+  header[0] = CHECKPOINT_VERSION;
+  header[1] = atmos.Nspace;
+  header[2] = atmos.Nactiveatom;
+  header[3] = atmos.Nactivemol;
+  header[4] = niter;
+  header[5] = input.p15d_nt;
+  memset(ID, 0, ATMOS_ID_WIDTH);
+  snprintf(ID, ATMOS_ID_WIDTH, "%s", atmos.ID);
+  result &= (fwrite(header, sizeof(int), 6, fp) == 6);
+  result &= (fwrite(ID, 1, ATMOS_ID_WIDTH, fp) == ATMOS_ID_WIDTH);
+  result &= (fwrite(&cswitch, sizeof(double), 1, fp) == 1);
+  result &= (fwrite(&input.prdswitch, sizeof(double), 1, fp) == 1);
+  result &= (fwrite(mpi.dpopsmax_hist[col->slot], sizeof(double),
+		    niter - 1, fp) == niter - 1);
+
+  for (nact = 0;  nact < atmos.Nactiveatom;  nact++) {
+    atom = atmos.activeatoms[nact];
+    result &= (fwrite(&atom->Nlevel, sizeof(int), 1, fp) == 1);
+    result &= (fwrite(atom->n[0], sizeof(double),
+		      atom->Nlevel*atmos.Nspace, fp) == atom->Nlevel*atmos.Nspace);
+    result &= writeNg(fp, atom->Ng_n);
+
+    for (kr = 0;  kr < atom->Nline;  kr++) {
+      line = &atom->line[kr];
+      if (!line->PRD) continue;
+
+      Nlamu = Nlamu_prd(line);
+      result &= (fwrite(&Nlamu, sizeof(int), 1, fp) == 1);
+      result &= (fwrite(line->rho_prd[0], sizeof(double),
+			Nlamu*atmos.Nspace, fp) == Nlamu*atmos.Nspace);
+      result &= writeNg(fp, line->Ng_prd);
+    }
+  }
+  for (nact = 0;  nact < atmos.Nactivemol;  nact++) {
+    molecule = atmos.activemols[nact];
+    result &= (fwrite(&molecule->Nv, sizeof(int), 1, fp) == 1);
+    result &= (fwrite(molecule->nv[0], sizeof(double),
+		      molecule->Nv*atmos.Nspace, fp) == molecule->Nv*atmos.Nspace);
+    result &= writeNg(fp, molecule->Ng_nv);
+  }
+  result &= (fclose(fp) == 0);
+
+  if (!result  ||  rename(tmpname, filename) != 0) {
+    sprintf(messageStr, "Unable to write checkpoint file %s", filename);
+    Error(WARNING, routineName, messageStr);
+    remove(tmpname);
+    return;
+  }
+  sprintf(messageStr, " -- Checkpoint written before iteration %d\n", niter);
+  Error(MESSAGE, routineName, messageStr);
+}
+/* ------- end ---------------------------- writeCheckpoint_p.c ----- */
+
+/* ------- begin -------------------------- readCheckpoint_p.c ------ */
+
+int readCheckpoint_p(Column *col, double *cswitch)
+{
+  /* --- Restores iteration state of current column from its
+         checkpoint file. Returns the number of the next iteration to
+         be done, or 0 if there is no usable checkpoint, in which case
+         the state of the column is left untouched.    -------------- */
+
+  const char routineName[] = "readCheckpoint_p";
+  register int kr, nact;
+
+  char   filename[MAX_LINE_SIZE], ID[ATMOS_ID_WIDTH];
+  bool_t result;
+  int    header[6], niter, Nlamu;
+  long   offset, end;
+  double switches[2];
+  FILE  *fp;
+  Atom  *atom;
+  AtomicLine *line;
+  Molecule *molecule;
+
+  checkpointName(col, filename);
+  if ((fp = fopen(filename, "r")) == NULL) return 0;
+
+  /* --- First pass only checks that the file matches the current
+         column, snapshot, atmosphere and setup, second pass reads the
+         data --                                        ------------ */
+
+  if (fread(header, sizeof(int), 6, fp) != 6  ||
+      fread(ID, 1, ATMOS_ID_WIDTH, fp) != ATMOS_ID_WIDTH  ||
+      fread(switches, sizeof(double), 2, fp) != 2) {
+    result = FALSE;
+  } else {
+    niter  = header[4];
+    result = (header[0] == CHECKPOINT_VERSION  &&
+	      header[1] == atmos.Nspace  &&
+	      header[2] == atmos.Nactiveatom  &&
+	      header[3] == atmos.Nactivemol  &&
+	      header[5] == input.p15d_nt  &&
+	      strncmp(ID, atmos.ID, ATMOS_ID_WIDTH - 1) == 0  &&
+	      niter > 1  &&  niter <= input.NmaxIter + 1);
+  }
+  if (result) {
+    offset = ftell(fp);
+    result = (fseek(fp, (niter - 1) * sizeof(double), SEEK_CUR) == 0);
+
+    for (nact = 0;  nact < atmos.Nactiveatom  &&  result;  nact++) {
+      atom = atmos.activeatoms[nact];
+      result &= readInt(fp, atom->Nlevel);
+      result &= (fseek(fp, atom->Nlevel*atmos.Nspace * sizeof(double),
+		       SEEK_CUR) == 0);
+      result &= readNg(fp, NULL, atom->Nlevel*atmos.Nspace, input.Ngorder);
+
+      for (kr = 0;  kr < atom->Nline  &&  result;  kr++) {
+	line = &atom->line[kr];
+	if (!line->PRD) continue;
+
+	Nlamu = Nlamu_prd(line);
+	result &= readInt(fp, Nlamu);
+	result &= (fseek(fp, Nlamu*atmos.Nspace * sizeof(double),
+			 SEEK_CUR) == 0);
+	result &= readNg(fp, NULL, Nlamu*atmos.Nspace, input.PRD_Ngorder);
+      }
+    }
+    for (nact = 0;  nact < atmos.Nactivemol  &&  result;  nact++) {
+      molecule = atmos.activemols[nact];
+      result &= readInt(fp, molecule->Nv);
+      result &= (fseek(fp, molecule->Nv*atmos.Nspace * sizeof(double),
+		       SEEK_CUR) == 0);
+      result &= readNg(fp, NULL, molecule->Nv*atmos.Nspace, input.Ngorder);
+    }
+    end = ftell(fp);
+    result &= (fseek(fp, 0, SEEK_END) == 0  &&  ftell(fp) == end);
+  }
+  if (!result) {
+    fclose(fp);
+    sprintf(messageStr, "Checkpoint file %s does not match this column, "
+	    "starting from initial solution", filename);
+    Error(WARNING, routineName, messageStr);
+    return 0;
+  }
+
+  /* --- Second pass --                                -------------- */
+
+  fseek(fp, offset, SEEK_SET);
+  fread(mpi.dpopsmax_hist[col->slot], sizeof(double), niter - 1, fp);
+
+  for (nact = 0;  nact < atmos.Nactiveatom;  nact++) {
+    atom = atmos.activeatoms[nact];
+    fseek(fp, sizeof(int), SEEK_CUR);
+    fread(atom->n[0], sizeof(double), atom->Nlevel*atmos.Nspace, fp);
+    readNg(fp, atom->Ng_n, atom->Ng_n->N, atom->Ng_n->Norder);
+
+    for (kr = 0;  kr < atom->Nline;  kr++) {
+      line = &atom->line[kr];
+      if (!line->PRD) continue;
+
+      Nlamu = Nlamu_prd(line);
+      fseek(fp, sizeof(int), SEEK_CUR);
+      fread(line->rho_prd[0], sizeof(double), Nlamu*atmos.Nspace, fp);
+
+      if (line->Ng_prd == NULL)
+	line->Ng_prd = NgInit(Nlamu*atmos.Nspace, input.PRD_Ngdelay,
+			      input.PRD_Ngorder, input.PRD_Ngperiod,
+			      line->rho_prd[0]);
+      readNg(fp, line->Ng_prd, line->Ng_prd->N, line->Ng_prd->Norder);
+    }
+  }
+  for (nact = 0;  nact < atmos.Nactivemol;  nact++) {
+    molecule = atmos.activemols[nact];
+    fseek(fp, sizeof(int), SEEK_CUR);
+    fread(molecule->nv[0], sizeof(double), molecule->Nv*atmos.Nspace, fp);
+    readNg(fp, molecule->Ng_nv, molecule->Ng_nv->N, molecule->Ng_nv->Norder);
+  }
+  fclose(fp);
+
+  *cswitch        = switches[0];
+  input.prdswitch = switches[1];
+  mpi.niter[col->slot] = niter - 1;
+
+  sprintf(messageStr, " -- Resuming from checkpoint at iteration %d\n", niter);
+  Error(MESSAGE, routineName, messageStr);
+
+  return niter;
+}
+/* ------- end ---------------------------- readCheckpoint_p.c ------ */
+
+/* ------- begin -------------------------- removeCheckpoint_p.c ---- */
+
+void removeCheckpoint_p(Column *col)
+{
+  char filename[MAX_LINE_SIZE];
+
+  checkpointName(col, filename);
+  remove(filename);
+}
+/* ------- end ---------------------------- removeCheckpoint_p.c ---- */
+
+/* ------- begin -------------------------- checkpointName.c -------- */
+
+static void checkpointName(Column *col, char *filename)
+{
+  sprintf(filename, CHECKPOINT_FILE_TEMPLATE, col->xi, col->yi);
+}
+/* ------- end ---------------------------- checkpointName.c -------- */
+
+/* ------- begin -------------------------- Nlamu_prd.c ------------- */
+
+static int Nlamu_prd(AtomicLine *line)
+{
+  /* --- Number of rho_prd rows, as allocated in UpdateAtmosDep -- -- */
+
+  if (input.PRD_angle_dep == PRD_ANGLE_DEP)
+    return 2*atmos.Nrays * line->Nlambda;
+  else
+    return line->Nlambda;
+}
+/* ------- end ---------------------------- Nlamu_prd.c ------------- */
+
+/* ------- begin -------------------------- writeNg.c --------------- */
+
+static bool_t writeNg(FILE *fp, struct Ng *Ngs)
+{
+  /* --- Writes size, count and the previous solutions of Ngs. A NULL
+         structure is written as N = 0 --              -------------- */
+
+  int  info[3] = {0, 0, 0};
+  long Nprev;
+
+  if (Ngs != NULL) {
+    info[0] = Ngs->N;
+    info[1] = Ngs->Norder;
+    info[2] = Ngs->count;
+  }
+  if (fwrite(info, sizeof(int), 3, fp) != 3) return FALSE;
+  if (Ngs == NULL) return TRUE;
+
+  Nprev = (long) (Ngs->Norder + 2) * Ngs->N;
+  return (fwrite(Ngs->previous[0], sizeof(double), Nprev, fp) == Nprev);
+}
+/* ------- end ---------------------------- writeNg.c --------------- */
+
+/* ------- begin -------------------------- readNg.c ---------------- */
+
+static bool_t readNg(FILE *fp, struct Ng *Ngs, int N, int Norder)
+{
+  /* --- Reads Ng state written by writeNg into Ngs, checking it has
+         size N and order Norder. With Ngs == NULL the record is only
+         checked and skipped --                        -------------- */
+
+  int  info[3];
+  long Nprev;
+
+  if (fread(info, sizeof(int), 3, fp) != 3) return FALSE;
+  if (info[0] == 0) return TRUE;
+  if (info[0] != N  ||  info[1] != Norder) return FALSE;
+
+  Nprev = (long) (Norder + 2) * N;
+  if (Ngs == NULL)
+    return (fseek(fp, Nprev * sizeof(double), SEEK_CUR) == 0);
+
+  Ngs->count = info[2];
+  return (fread(Ngs->previous[0], sizeof(double), Nprev, fp) == Nprev);
+}
+/* ------- end ---------------------------- readNg.c ---------------- */
+
+/* ------- begin -------------------------- readInt.c --------------- */
+
+static bool_t readInt(FILE *fp, int expected)
+{
+  int value;
+
+  if (fread(&value, sizeof(int), 1, fp) != 1) return FALSE;
+  return (value == expected);
+}
+/* ------- end ---------------------------- readInt.c --------------- */
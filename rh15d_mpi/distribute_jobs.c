@@ -12,8 +12,10 @@
 #include <stdlib.h>
 #include <math.h>
 #include <stdio.h>
+#include <string.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 
 #include "rh.h"
@@ -32,15 +34,46 @@ int   *intrange(int start, int end, int step, int *N);
 long  *get_tasks(long ntotal, int size);
 long **get_taskmap(long remain_tasks, long *ntasks, long *my_start);
 long **matrix_long(long Nrow, long Ncol);
+void   atmos_cost(double *cost);
+bool_t iteration_cost(double *cost);
+void   hilbert_cost(double *cost);
+int    qscost(const void *v1, const void *v2);
+long   reuse_columns(void);
 
 /* --- Global variables --                             -------------- */
 
+extern Atmosphere atmos;
 extern MPI_data mpi;
 extern InputData input;
 extern Input_Atmos_file infile;
 extern Geometry geometry;
 extern char messageStr[];
 
+/* --- Scales for the column cost estimate from the atmosphere: a
+       column with a velocity jump of COST_VSCALE between adjacent
+       points, or a peak temperature of COST_TSCALE, is counted as
+       twice as expensive as a quiet column with the same Nspace -- */
+
+#define COST_VSCALE  5.0e3
+#define COST_TSCALE  2.0e4
+
+/* Iteration counts beyond this are treated as missing (fill values) */
+#define COST_MAXITER 1500
+
+typedef struct {
+  double cost;
+  long   ix, iy, index;
+} TaskCost;
+
+/* One atmosphere variable compared by reuse_columns, with one x slab
+   of the current and previous snapshots */
+typedef struct {
+  hid_t   varid;
+  bool_t  levels, pointwise;
+  int     nlev;
+  double *now, *prev;
+} ReuseVar;
+
 
 /* ------- begin --------------------------   distribute_jobs.c   --- */
 void distribute_jobs(void)
@@ -50,6 +83,7 @@ void distribute_jobs(void)
   long *tasks, remain_tasks, i, j;
 
   mpi.backgrrecno = 0;
+  mpi.reused      = NULL;
 
   /* Sanitise input */
   if ((input.p15d_x0 < 0)) input.p15d_x0 = 0;
@@ -66,7 +100,7 @@ void distribute_jobs(void)
   if ((input.p15d_xst < 1)) input.p15d_xst = 1;
   if ((input.p15d_yst < 1)) input.p15d_yst = 1;
 
-  /* Calculate array maps of (mpi.ix/iy) > xi/yi */
+  /* Calculate array maps of (ix/iy) > xi/yi */
   mpi.xnum = intrange(input.p15d_x0, input.p15d_x1, input.p15d_xst, &mpi.nx);
   mpi.ynum = intrange(input.p15d_y0, input.p15d_y1, input.p15d_yst, &mpi.ny);
 
@@ -92,6 +126,9 @@ void distribute_jobs(void)
     /* If running first time, use all columns */
     remain_tasks = mpi.nx * mpi.ny;
     mpi.rh_converged = matrix_int(mpi.nx, mpi.ny);
+
+    /* Except those that can be copied from a previous snapshot */
+    if (input.p15d_reuse_tol > 0.0) remain_tasks -= reuse_columns();
   }
 
   mpi.total_tasks = remain_tasks;
@@ -169,6 +206,428 @@ long **get_taskmap(long remain_tasks, long *ntasks, long *my_start)
 }
 /* ------- end   --------------------------   get_retaskmap.c --- --- */
 
+/* ------- begin --------------------------   order_tasks.c ----- --- */
+void order_tasks(void)
+/* Reorders the taskmap by decreasing estimated cost of each column, so
+   that the pool hands out the most expensive columns first and the
+   cheap ones fill in at the end. The costs are estimated by rank 0 only
+   and the reordered taskmap is broadcast to all the other processes.
+   With ORDER_HILBERT the "cost" is minus the position along a Hilbert
+   curve, so that consecutive tasks are neighbouring columns. */
+{
+  const char routineName[] = "order_tasks";
+  long      i;
+  double   *cost;
+  TaskCost *tc;
+
+  if ((input.p15d_order == ORDER_TASKMAP) || (mpi.total_tasks < 2)) return;
+
+  if (mpi.rank == 0) {
+    cost = (double *) malloc(mpi.nx * mpi.ny * sizeof(double));
+
+    if ((input.p15d_order == ORDER_ITERATION_COST) && !iteration_cost(cost)) {
+      sprintf(messageStr,
+	      "Could not get iterations from previous %s,\n"
+	      " estimating cost from atmosphere instead.\n", INPUTDATA_FILE);
+      Error(WARNING, routineName, messageStr);
+      input.p15d_order = ORDER_ATMOS_COST;
+    }
+    if (input.p15d_order == ORDER_ATMOS_COST) atmos_cost(cost);
+    if (input.p15d_order == ORDER_HILBERT) hilbert_cost(cost);
+
+    tc = (TaskCost *) malloc(mpi.total_tasks * sizeof(TaskCost));
+    for (i = 0;  i < mpi.total_tasks;  i++) {
+      tc[i].ix    = mpi.taskmap[i][0];
+      tc[i].iy    = mpi.taskmap[i][1];
+      tc[i].index = i;
+      tc[i].cost  = cost[tc[i].ix * mpi.ny + tc[i].iy];
+    }
+    qsort(tc, mpi.total_tasks, sizeof(TaskCost), qscost);
+
+    for (i = 0;  i < mpi.total_tasks;  i++) {
+      mpi.taskmap[i][0] = tc[i].ix;
+      mpi.taskmap[i][1] = tc[i].iy;
+    }
+    if (input.p15d_order == ORDER_HILBERT)
+      sprintf(messageStr, "Ordered %ld tasks along a Hilbert curve\n",
+	      mpi.total_tasks);
+    else
+      sprintf(messageStr, "Ordered %ld tasks by estimated cost, "
+	      "max/min cost = %.2f\n", mpi.total_tasks,
+	      (tc[mpi.total_tasks - 1].cost > 0.0) ?
+	      tc[0].cost / tc[mpi.total_tasks - 1].cost : 0.0);
+    fprintf(mpi.main_logfile, "%s", messageStr);
+    Error(MESSAGE, routineName, messageStr);
+
+    free(tc);
+    free(cost);
+  }
+  MPI_Bcast(mpi.taskmap[0], 2 * mpi.total_tasks, MPI_LONG, 0, mpi.comm);
+
+  return;
+}
+/* ------- end   --------------------------   order_tasks.c ----- --- */
+
+/* ------- begin --------------------------   atmos_cost.c ------ --- */
+void atmos_cost(double *cost)
+/* Estimates the relative cost of each column from the input atmosphere:
+   the number of depth points left after the temperature cut, weighted
+   up by the largest velocity jump and peak temperature below the cut.
+   Reads one x slab of T and vz at a time. */
+{
+  const char routineName[] = "atmos_cost";
+  long     i, j, k, kcut, nz;
+  double  *T, *vz, *Tcol, *vzcol, dvmax, Tpeak;
+  hsize_t  start[] = {0, 0, 0, 0}, count[] = {1, 1, 1, 1}, dims[1];
+  hid_t    file_dspace, mem_dspace;
+
+  if (geometry.atmos_format != HDF5) {
+    /* Single column, nothing to order */
+    for (i = 0;  i < mpi.nx * mpi.ny;  i++) cost[i] = 1.0;
+    return;
+  }
+  nz = infile.nz;
+  T  = (double *) malloc(infile.ny * nz * sizeof(double));
+  vz = (double *) malloc(infile.ny * nz * sizeof(double));
+
+  dims[0] = infile.ny * nz;
+  if (( mem_dspace = H5Screate_simple(1, dims, NULL) ) < 0) HERR(routineName);
+  start[0] = input.p15d_nt;
+  count[2] = infile.ny;
+  count[3] = nz;
+
+  for (i = 0;  i < mpi.nx;  i++) {
+    start[1] = mpi.xnum[i];
+    if (( file_dspace = H5Dget_space(infile.T_varid) ) < 0) HERR(routineName);
+    if (( H5Sselect_hyperslab(file_dspace, H5S_SELECT_SET, start,
+                              NULL, count, NULL) ) < 0) HERR(routineName);
+    if (( H5Dread(infile.T_varid, H5T_NATIVE_DOUBLE, mem_dspace, file_dspace,
+                  H5P_DEFAULT, T) ) < 0) HERR(routineName);
+    if (( H5Dread(infile.vz_varid, H5T_NATIVE_DOUBLE, mem_dspace, file_dspace,
+                  H5P_DEFAULT, vz) ) < 0) HERR(routineName);
+    if (( H5Sclose(file_dspace) ) < 0) HERR(routineName);
+
+    for (j = 0;  j < mpi.ny;  j++) {
+      Tcol  = T  + mpi.ynum[j] * nz;
+      vzcol = vz + mpi.ynum[j] * nz;
+
+      /* Same cut point as setTcut */
+      kcut = 0;
+      if (input.p15d_zcut && (input.p15d_tmax >= 0.0)) {
+        for (k = 0;  k < nz;  k++) {
+          if (Tcol[k] <= input.p15d_tmax) {
+            kcut = k;
+            break;
+          }
+        }
+      }
+      dvmax = 0.0;
+      Tpeak = Tcol[kcut];
+      for (k = kcut + 1;  k < nz;  k++) {
+        dvmax = MAX(dvmax, fabs(vzcol[k] - vzcol[k-1]));
+        Tpeak = MAX(Tpeak, Tcol[k]);
+      }
+      cost[i * mpi.ny + j] = (double) (nz - kcut) *
+        (1.0 + dvmax / COST_VSCALE + Tpeak / COST_TSCALE);
+    }
+  }
+  if (( H5Sclose(mem_dspace) ) < 0) HERR(routineName);
+  free(T);
+  free(vz);
+
+  return;
+}
+/* ------- end   --------------------------   atmos_cost.c ------ --- */
+
+/* ------- begin --------------------------   iteration_cost.c -- --- */
+bool_t iteration_cost(double *cost)
+/* Uses the number of iterations of a previous run (still on disk in
+   the indata file, which is only overwritten later by init_hdf5_indata)
+   as cost. Columns that were not calculated are given the largest
+   cost found. Returns FALSE if the previous run cannot be used. */
+{
+  const char routineName[] = "iteration_cost";
+  int    nx, ny, *niter;
+  long   i, maxiter = 1;
+  hid_t  ncid, ncid_mpi;
+
+  if (access(INPUTDATA_FILE, R_OK) != 0) return FALSE;
+
+  /* Only rank 0 is here, so no MPI-IO */
+  if (( ncid = H5Fopen(INPUTDATA_FILE, H5F_ACC_RDONLY, H5P_DEFAULT) ) < 0)
+    return FALSE;
+  if ((H5LTget_attribute_int(ncid, "/", "nx", &nx) < 0) ||
+      (H5LTget_attribute_int(ncid, "/", "ny", &ny) < 0) ||
+      (nx != mpi.nx) || (ny != mpi.ny)) {
+    H5Fclose(ncid);
+    return FALSE;
+  }
+  if (( ncid_mpi = H5Gopen(ncid, "mpi", H5P_DEFAULT) ) < 0) HERR(routineName);
+  niter = (int *) malloc(nx * ny * sizeof(int));
+  if (( H5LTread_dataset_int(ncid_mpi, ITER_NAME, niter) ) < 0)
+    HERR(routineName);
+  if (( H5Gclose(ncid_mpi) ) < 0) HERR(routineName);
+  if (( H5Fclose(ncid) ) < 0) HERR(routineName);
+
+  for (i = 0;  i < nx * ny;  i++) {
+    if ((niter[i] > 0) && (niter[i] <= COST_MAXITER))
+      maxiter = MAX(maxiter, niter[i]);
+  }
+  for (i = 0;  i < nx * ny;  i++) {
+    if ((niter[i] > 0) && (niter[i] <= COST_MAXITER))
+      cost[i] = (double) niter[i];
+    else
+      cost[i] = (double) maxiter;
+  }
+  free(niter);
+
+  return TRUE;
+}
+/* ------- end   --------------------------   iteration_cost.c -- --- */
+
+/* ------- begin --------------------------   hilbert_cost.c ---- --- */
+void hilbert_cost(double *cost)
+/* Sets the cost of each column to minus its distance along a Hilbert
+   curve covering the (ix, iy) grid, so that sorting by decreasing cost
+   walks along the curve. */
+{
+  long i, j, n, s, x, y, rx, ry, d, tmp;
+
+  for (n = 1;  n < MAX(mpi.nx, mpi.ny);  n *= 2);
+
+  for (i = 0;  i < mpi.nx;  i++) {
+    for (j = 0;  j < mpi.ny;  j++) {
+      x = i;
+      y = j;
+      d = 0;
+      for (s = n / 2;  s > 0;  s /= 2) {
+	rx = (x & s) > 0;
+	ry = (y & s) > 0;
+	d += s * s * ((3 * rx) ^ ry);
+	/* Rotate quadrant */
+	if (ry == 0) {
+	  if (rx == 1) {
+	    x = n - 1 - x;
+	    y = n - 1 - y;
+	  }
+	  tmp = x;  x = y;  y = tmp;
+	}
+      }
+      cost[i * mpi.ny + j] = -(double) d;
+    }
+  }
+}
+/* ------- end   --------------------------   hilbert_cost.c ---- --- */
+
+/* ------- begin --------------------------   qscost.c ---------- --- */
+int qscost(const void *v1, const void *v2)
+/* Sorts TaskCost by decreasing cost, keeping taskmap order for ties */
+{
+  const TaskCost *t1 = (const TaskCost *) v1, *t2 = (const TaskCost *) v2;
+
+  if (t1->cost > t2->cost)
+    return -1;
+  else if (t1->cost < t2->cost)
+    return 1;
+  else
+    return (t1->index < t2->index) ? -1 : (t1->index > t2->index);
+}
+/* ------- end   --------------------------   qscost.c ---------- --- */
+
+/* ------- begin --------------------------   read_xslab.c ------ --- */
+static void read_xslab(ReuseVar *var, int nt, int xi, double *buf)
+/* Reads the (y, z) slab at x index xi of snapshot nt */
+{
+  const char routineName[] = "read_xslab";
+  hsize_t  start[] = {0, 0, 0, 0, 0}, count[] = {1, 1, 1, 1, 1}, dims[1];
+  hid_t    file_dspace, mem_dspace;
+
+  start[0] = nt;
+  if (var->levels) {
+    /* hydrogen_populations is (nt, nhydr, nx, ny, nz) */
+    count[1] = var->nlev;
+    start[2] = xi;
+    count[3] = infile.ny;
+    count[4] = infile.nz;
+  } else {
+    start[1] = xi;
+    count[2] = infile.ny;
+    count[3] = infile.nz;
+  }
+  dims[0] = var->nlev * infile.ny * infile.nz;
+  if (( mem_dspace = H5Screate_simple(1, dims, NULL) ) < 0) HERR(routineName);
+  if (( file_dspace = H5Dget_space(var->varid) ) < 0) HERR(routineName);
+  if (( H5Sselect_hyperslab(file_dspace, H5S_SELECT_SET, start,
+                            NULL, count, NULL) ) < 0) HERR(routineName);
+  if (( H5Dread(var->varid, H5T_NATIVE_DOUBLE, mem_dspace, file_dspace,
+                H5P_DEFAULT, buf) ) < 0) HERR(routineName);
+  if (( H5Sclose(file_dspace) ) < 0) HERR(routineName);
+  if (( H5Sclose(mem_dspace) ) < 0) HERR(routineName);
+}
+/* ------- end   --------------------------   read_xslab.c ------ --- */
+
+/* ------- begin --------------------------   reuse_columns.c --- --- */
+long reuse_columns(void)
+/* Marks in mpi.reused (and as done in mpi.rh_converged) the columns
+   that converged in a previous run and whose atmosphere has not
+   changed since, within 15D_REUSE_TOL. Their output is copied from
+   the previous run by copyReused instead of being recomputed.
+   Temperature, electron density (or hydrogen populations, if n_e is
+   not read) are compared point by point, relative to the previous
+   value. Velocity and magnetic field are compared relative to the
+   largest absolute previous value in the column. Depths above the
+   temperature cut are ignored. Only rank 0 reads the atmosphere, the
+   result is broadcast. Returns the number of reused columns. */
+{
+  const char routineName[] = "reuse_columns";
+  bool_t   same;
+  int     *conv, nx, ny, nvar = 0, v, l;
+  long     i, j, k, kcut, nz, nreuse = 0;
+  double  *Tnow, *Tprev, *a, *b, vmax;
+  hsize_t  dims[5];
+  hid_t    ncid, ncid_mpi, file_dspace;
+  ReuseVar var[6];
+
+  if (geometry.atmos_format != HDF5) {
+    sprintf(messageStr, "15D_REUSE_TOL needs an HDF5 atmosphere, ignored\n");
+    Error(WARNING, routineName, messageStr);
+    return 0;
+  }
+  if (input.p15d_prev_nt < 0) input.p15d_prev_nt = input.p15d_nt - 1;
+  if ((input.p15d_prev_nt < 0)  ||  (input.p15d_prev_nt == input.p15d_nt)) {
+    sprintf(messageStr, "No previous snapshot to compare with snapshot %d"
+	    " (set 15D_PREV_SNAPSHOT)", input.p15d_nt);
+    Error(ERROR_LEVEL_2, routineName, messageStr);
+  }
+  if (!strcmp(input.p15d_prev_ray, "none")  ||
+      !strcmp(input.p15d_prev_aux, "none")  ||
+      !strcmp(input.p15d_prev_indata, "none")) {
+    sprintf(messageStr, "15D_REUSE_TOL needs the output files of the "
+	    "previous run in 15D_PREV_RAY, 15D_PREV_AUX and 15D_PREV_INDATA");
+    Error(ERROR_LEVEL_2, routineName, messageStr);
+  }
+
+  mpi.reused = matrix_int(mpi.nx, mpi.ny);
+
+  if (mpi.rank == 0) {
+    /* --- Convergence of previous run (only rank 0, no MPI-IO) --- */
+    if (( ncid = H5Fopen(input.p15d_prev_indata, H5F_ACC_RDONLY,
+                         H5P_DEFAULT) ) < 0) HERR(routineName);
+    check_prev_columns(ncid, input.p15d_prev_indata);
+    nx = mpi.nx;
+    ny = mpi.ny;
+    if (( ncid_mpi = H5Gopen(ncid, "mpi", H5P_DEFAULT) ) < 0)
+      HERR(routineName);
+    conv = (int *) malloc(nx * ny * sizeof(int));
+    if (( H5LTread_dataset_int(ncid_mpi, CONV_NAME, conv) ) < 0)
+      HERR(routineName);
+    if (( H5Gclose(ncid_mpi) ) < 0) HERR(routineName);
+    if (( H5Fclose(ncid) ) < 0) HERR(routineName);
+
+    /* --- Check previous snapshot is in the atmosphere file --- */
+    if (( file_dspace = H5Dget_space(infile.T_varid) ) < 0) HERR(routineName);
+    if (( H5Sget_simple_extent_dims(file_dspace, dims, NULL) ) < 0)
+      HERR(routineName);
+    if (( H5Sclose(file_dspace) ) < 0) HERR(routineName);
+    if (input.p15d_prev_nt >= (int) dims[0]) {
+      sprintf(messageStr, "15D_PREV_SNAPSHOT = %d, but %s has only %d "
+	      "snapshots", input.p15d_prev_nt, infile.file_name, (int) dims[0]);
+      Error(ERROR_LEVEL_2, routineName, messageStr);
+    }
+
+    /* --- Variables to compare, temperature first --- */
+    for (v = 0;  v < 6;  v++) {
+      var[v].levels = FALSE;
+      var[v].nlev   = 1;
+    }
+    var[nvar].varid = infile.T_varid;   var[nvar++].pointwise = TRUE;
+    if (input.solve_ne == NONE) {
+      var[nvar].varid = infile.ne_varid;  var[nvar++].pointwise = TRUE;
+    } else {
+      var[nvar].varid = infile.nh_varid;  var[nvar].levels = TRUE;
+      var[nvar].nlev  = infile.NHydr;     var[nvar++].pointwise = TRUE;
+    }
+    var[nvar].varid = infile.vz_varid;  var[nvar++].pointwise = FALSE;
+    if (atmos.Stokes) {
+      var[nvar].varid = infile.Bx_varid;  var[nvar++].pointwise = FALSE;
+      var[nvar].varid = infile.By_varid;  var[nvar++].pointwise = FALSE;
+      var[nvar].varid = infile.Bz_varid;  var[nvar++].pointwise = FALSE;
+    }
+    nz = infile.nz;
+    for (v = 0;  v < nvar;  v++) {
+      var[v].now  = (double *) malloc(var[v].nlev * infile.ny * nz *
+                                      sizeof(double));
+      var[v].prev = (double *) malloc(var[v].nlev * infile.ny * nz *
+                                      sizeof(double));
+    }
+
+    for (i = 0;  i < mpi.nx;  i++) {
+      for (v = 0;  v < nvar;  v++) {
+        read_xslab(&var[v], input.p15d_nt, mpi.xnum[i], var[v].now);
+        read_xslab(&var[v], input.p15d_prev_nt, mpi.xnum[i], var[v].prev);
+      }
+      for (j = 0;  j < mpi.ny;  j++) {
+        if (conv[i * mpi.ny + j] != 1) continue;
+        Tnow  = var[0].now  + mpi.ynum[j] * nz;
+        Tprev = var[0].prev + mpi.ynum[j] * nz;
+
+        /* Same cut point as setTcut, the shallower of both snapshots */
+        kcut = 0;
+        if (input.p15d_zcut && (input.p15d_tmax >= 0.0)) {
+          for (k = 0;  k < nz;  k++) {
+            if ((Tnow[k] <= input.p15d_tmax) ||
+                (Tprev[k] <= input.p15d_tmax)) {
+              kcut = k;
+              break;
+            }
+          }
+        }
+        same = TRUE;
+        for (v = 0;  v < nvar  &&  same;  v++) {
+          for (l = 0;  l < var[v].nlev  &&  same;  l++) {
+            a = var[v].now  + (l * infile.ny + mpi.ynum[j]) * nz;
+            b = var[v].prev + (l * infile.ny + mpi.ynum[j]) * nz;
+            vmax = 0.0;
+            if (!var[v].pointwise)
+              for (k = kcut;  k < nz;  k++) vmax = MAX(vmax, fabs(b[k]));
+            for (k = kcut;  k < nz;  k++) {
+              if (fabs(a[k] - b[k]) > input.p15d_reuse_tol *
+                  ((var[v].pointwise) ? fabs(b[k]) : vmax)) {
+                same = FALSE;
+                break;
+              }
+            }
+          }
+        }
+        if (same) {
+          mpi.reused[i][j] = 1;
+          nreuse++;
+        }
+      }
+    }
+    for (v = 0;  v < nvar;  v++) {
+      free(var[v].now);
+      free(var[v].prev);
+    }
+    free(conv);
+
+    sprintf(messageStr, "Reusing %ld of %d columns from snapshot %d "
+	    "(tolerance %.2e)\n", nreuse, mpi.nx * mpi.ny,
+	    input.p15d_prev_nt, input.p15d_reuse_tol);
+    fprintf(mpi.main_logfile, "%s", messageStr);
+    Error(MESSAGE, routineName, messageStr);
+  }
+  MPI_Bcast(mpi.reused[0], mpi.nx * mpi.ny, MPI_INT, 0, mpi.comm);
+  MPI_Bcast(&nreuse, 1, MPI_LONG, 0, mpi.comm);
+
+  for (i = 0;  i < mpi.nx;  i++)
+    for (j = 0;  j < mpi.ny;  j++)
+      if (mpi.reused[i][j]) mpi.rh_converged[i][j] = 1;
+
+  return nreuse;
+}
+/* ------- end   --------------------------   reuse_columns.c --- --- */
+
 /* ------- begin --------------------------   intrange.c -------- --- */
 int *intrange(int start, int end, int step, int *N)
 /* Mimics Python's range function. Also gives a pointer
@@ -127,7 +127,7 @@ void Escape(Atom *atom) {
         as = spectrum.as + nspect;
         alloc_as(nspect, FALSE);
         
-        nt = nspect % input.Nthreads;
+        nt = threadSlot();
 
         /* Get line and background opacity */
         Opacity(nspect, 0, to_obs=TRUE, initialize=TRUE); 
@@ -48,6 +48,9 @@ typedef struct {
 
 
 /* --- Associated function prototypes --               -------------- */
+
+struct Column;  /* Column of the atmosphere, see parallel.h */
+
 void convertScales(Atmosphere *atmos, Geometry *geometry);
 void getAngleQuad(Geometry *geometry);
 void getBoundary(Geometry *geometry);
@@ -56,20 +59,23 @@ void writeGeometry(Geometry *geometry);
 
 void init_atmos(Atmosphere *atmos, Geometry *geometry,
                 Input_Atmos_file *infile);
-void readAtmos(int xi, int yi, Atmosphere *atmos, Geometry *geometry,
-		       Input_Atmos_file *infile);
+void readAtmos(struct Column *col, Atmosphere *atmos, Geometry *geometry,
+	       Input_Atmos_file *infile);
+void prefetchAtmos(int xi, int yi, Geometry *geometry);
 void close_atmos(Atmosphere *atmos, Geometry *geometry,
                  Input_Atmos_file *infile);
 void init_hdf5_atmos(Atmosphere *atmos, Geometry *geometry,
                      Input_Atmos_file *infile);
-void readAtmos_hdf5(int xi, int yi, Atmosphere *atmos, Geometry *geometry,
-		            Input_Atmos_file *infile);
+void readAtmos_hdf5(struct Column *col, Atmosphere *atmos,
+		    Geometry *geometry, Input_Atmos_file *infile);
+void prefetchAtmos_hdf5(int xi, int yi);
 void close_hdf5_atmos(Atmosphere *atmos, Geometry *geometry,
                       Input_Atmos_file *infile);
 void readAtmos_multi(Atmosphere *atmos, Geometry *geometry,
                       Input_Atmos_file *infile);
 void convertScales(Atmosphere *atmos, Geometry *geometry);
-void setTcut(Atmosphere *atmos, Geometry *geometry, double Tmax);
+void setTcut(struct Column *col, Atmosphere *atmos, Geometry *geometry,
+	     double Tmax);
 void realloc_ndep(Atmosphere *atmos, Geometry *geometry);
 void depth_refine(Atmosphere *atmos, Geometry *geometry, double tmax);
 
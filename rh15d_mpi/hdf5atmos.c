@@ -3,6 +3,7 @@
 */
 
 #include <ctype.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
@@ -24,14 +25,74 @@
 
 #define FAIL -1
 #define MULTI_COMMENT_CHAR  "*"
+#define TILE_MAXBYTES       (64 * 1024 * 1024)
+
+
+/* --- Tile of nbx x nby columns at all heights, as in the file: 4-D
+       variables are [nbx][nby][nz], nH is [NHydr][nbx][nby][nz], and
+       z is [nz] when given once per snapshot --          -------------- */
+
+typedef struct {
+  bool_t  valid;
+  int     x0, y0, nbx, nby;
+  double *T, *ne, *vz, *vturb, *Bx, *By, *Bz, *z, *nH;
+} AtmosBlock;
+
+/* --- Node cache (15D_NODE_CACHE): a directory of Nslot tiles, shared
+       by the processes of a node, in front of the tiles themselves.
+       The lock and condition are shared between processes. -- ------- */
+
+#define NODE_EMPTY    0
+#define NODE_LOADING  1
+#define NODE_READY    2
+
+typedef struct {
+  int  tile, state, pins, x0, y0, nbx, nby;
+  long used;
+} NodeSlot;
+
+typedef struct {
+  pthread_mutex_t lock;
+  pthread_cond_t  loaded;
+  long            clock;
+} NodeCache;
+
+/* --- Column reader: the current tile and the one read ahead by the
+       reader thread. (qx, qy) is the column asked for next, busy is
+       set while the thread reads the tile of (rx, ry). With the node
+       cache, view has the tiles of the shared window instead, of
+       which pinned is in use. --                         -------------- */
+
+typedef struct {
+  bool_t            threaded, busy, done, request, Stokes, node;
+  int               tx, ty, qx, qy, rx, ry, cur, NHydr, Nslot, pinned;
+  AtmosBlock        blk[2], *view;
+  NodeCache        *nc;
+  NodeSlot         *slot;
+  MPI_Comm          nodecomm;
+  MPI_Win           win;
+  Input_Atmos_file *infile;
+  pthread_t         thread;
+  pthread_mutex_t   lock;
+  pthread_cond_t    cond;
+} ColumnReader;
+
 
 /* --- Function prototypes --                          -------------- */
 
+static void initColumnReader(Atmosphere *atmos, Input_Atmos_file *infile);
+static void closeColumnReader(void);
+static void *reader_pthread(void *argument);
+static void readBlock(AtmosBlock *blk, int xi, int yi);
+static bool_t inBlock(AtmosBlock *blk, int xi, int yi);
+
 /* --- Global variables --                             -------------- */
 extern MPI_data mpi;
 extern InputData input;
 extern char messageStr[];
 
+static ColumnReader rd;
+
 
 /* ------- begin --------------------------   init_hdf5_atmos   ----- */
 void init_hdf5_atmos(Atmosphere *atmos, Geometry *geometry,
@@ -193,108 +254,506 @@ void init_hdf5_atmos(Atmosphere *atmos, Geometry *geometry,
   atmos->chi_b = NULL;
   atmos->eta_b = NULL;
   atmos->sca_b = NULL;
+
+  initColumnReader(atmos, infile);
 }
 /* ------- end ---------------------------- init_hdf5_atmos  -------- */
 
+/* ------- begin -------------------------- tileSize.c ------------- */
+static long tileSize(void)
+/* Number of doubles in a tile of rd.tx x rd.ty columns */
+{
+  long ncol = (long) rd.tx * rd.ty, nz = rd.infile->nz;
+
+  return ncol * nz * (4 + ((rd.Stokes) ? 3 : 0) + rd.NHydr) +
+    ((mpi.ndims_z == 4) ? ncol : 1) * nz;
+}
+/* ------- end   -------------------------- tileSize.c ------------- */
+
+/* ------- begin -------------------------- setBlock.c ------------- */
+static void setBlock(AtmosBlock *blk, double *data)
+/* Points the variables of blk into data, of tileSize() doubles */
+{
+  long ncol = (long) rd.tx * rd.ty, nz = rd.infile->nz;
+
+  blk->valid = FALSE;
+  blk->T     = data;
+  blk->ne    = blk->T  + ncol * nz;
+  blk->vz    = blk->ne + ncol * nz;
+  blk->vturb = blk->vz + ncol * nz;
+  blk->nH    = blk->vturb + ncol * nz;
+  blk->z     = blk->nH + rd.NHydr * ncol * nz;
+  if (rd.Stokes) {
+    blk->Bx  = blk->z  + ((mpi.ndims_z == 4) ? ncol : 1) * nz;
+    blk->By  = blk->Bx + ncol * nz;
+    blk->Bz  = blk->By + ncol * nz;
+  } else {
+    blk->Bx  = blk->By = blk->Bz = NULL;
+  }
+}
+/* ------- end   -------------------------- setBlock.c ------------- */
+
+/* ------- begin -------------------------- initNodeCache.c -------- */
+static void initNodeCache(void)
+/* Allocates the tile cache shared by the processes of this node. The
+   first process of the node sets up the directory. */
+{
+  const char routineName[] = "initNodeCache";
+  int      n, nodesize, noderank, disp;
+  char    *base;
+  size_t   head;
+  MPI_Aint size;
+  pthread_mutexattr_t mattr;
+  pthread_condattr_t  cattr;
+
+  MPI_Comm_split_type(mpi.comm, MPI_COMM_TYPE_SHARED, mpi.rank,
+		      MPI_INFO_NULL, &rd.nodecomm);
+  MPI_Comm_size(rd.nodecomm, &nodesize);
+  MPI_Comm_rank(rd.nodecomm, &noderank);
+
+  /* Every process pins at most one tile, so one each is always enough */
+  rd.Nslot = MAX(input.p15d_nodecache, nodesize);
+  head = sizeof(NodeCache) + rd.Nslot * sizeof(NodeSlot);
+  head = (head + 63) / 64 * 64;
+  size = (noderank == 0) ?
+    head + rd.Nslot * tileSize() * sizeof(double) : 0;
+  MPI_Win_allocate_shared(size, 1, MPI_INFO_NULL, rd.nodecomm, &base,
+			  &rd.win);
+  MPI_Win_shared_query(rd.win, 0, &size, &disp, &base);
+  rd.nc   = (NodeCache *) base;
+  rd.slot = (NodeSlot *) (rd.nc + 1);
+
+  if (noderank == 0) {
+    pthread_mutexattr_init(&mattr);
+    pthread_mutexattr_setpshared(&mattr, PTHREAD_PROCESS_SHARED);
+    pthread_condattr_init(&cattr);
+    pthread_condattr_setpshared(&cattr, PTHREAD_PROCESS_SHARED);
+    if (pthread_mutex_init(&rd.nc->lock, &mattr)  ||
+	pthread_cond_init(&rd.nc->loaded, &cattr)) {
+      sprintf(messageStr, "Unable to set up the node cache lock");
+      Error(ERROR_LEVEL_2, routineName, messageStr);
+    }
+    pthread_mutexattr_destroy(&mattr);
+    pthread_condattr_destroy(&cattr);
+    rd.nc->clock = 0;
+    for (n = 0;  n < rd.Nslot;  n++) {
+      rd.slot[n].state = NODE_EMPTY;
+      rd.slot[n].pins  = 0;
+      rd.slot[n].used  = 0;
+    }
+  }
+  MPI_Barrier(rd.nodecomm);
+
+  rd.view = (AtmosBlock *) malloc(rd.Nslot * sizeof(AtmosBlock));
+  for (n = 0;  n < rd.Nslot;  n++)
+    setBlock(&rd.view[n], (double *) (base + head) + n * tileSize());
+  rd.pinned = -1;
+  rd.node   = TRUE;
+}
+/* ------- end   -------------------------- initNodeCache.c -------- */
+
+/* ------- begin -------------------------- nodeBlock.c ------------ */
+static AtmosBlock *nodeBlock(int xi, int yi)
+/* Returns the tile with column (xi, yi) from the node cache. If no
+   process of the node has read it yet, reads it into the least
+   recently used tile no process is using. The tile stays pinned until
+   the next call. */
+{
+  const char routineName[] = "nodeBlock";
+  int       n, m, tile;
+  NodeSlot *sl;
+
+  if (rd.pinned >= 0  &&  inBlock(&rd.view[rd.pinned], xi, yi))
+    return &rd.view[rd.pinned];
+
+  tile = (xi / rd.tx) * ((rd.infile->ny + rd.ty - 1) / rd.ty) + yi / rd.ty;
+  pthread_mutex_lock(&rd.nc->lock);
+  if (rd.pinned >= 0) {
+    rd.slot[rd.pinned].pins--;
+    rd.pinned = -1;
+  }
+  /* Wait if another process of the node is reading it */
+  for (;;) {
+    for (n = 0;  n < rd.Nslot;  n++)
+      if (rd.slot[n].state != NODE_EMPTY  &&  rd.slot[n].tile == tile) break;
+    if (n == rd.Nslot  ||  rd.slot[n].state == NODE_READY) break;
+    pthread_cond_wait(&rd.nc->loaded, &rd.nc->lock);
+  }
+  if (n < rd.Nslot) {
+    sl = &rd.slot[n];
+    sl->pins++;
+    sl->used = ++rd.nc->clock;
+    pthread_mutex_unlock(&rd.nc->lock);
+
+    rd.view[n].x0    = sl->x0;
+    rd.view[n].y0    = sl->y0;
+    rd.view[n].nbx   = sl->nbx;
+    rd.view[n].nby   = sl->nby;
+    rd.view[n].valid = TRUE;
+    rd.pinned = n;
+    return &rd.view[n];
+  }
+
+  for (n = -1, m = 0;  m < rd.Nslot;  m++) {
+    if (rd.slot[m].pins == 0  &&
+	(n < 0  ||  rd.slot[m].used < rd.slot[n].used)) n = m;
+  }
+  if (n < 0) {
+    pthread_mutex_unlock(&rd.nc->lock);
+    sprintf(messageStr, "No free tile in the node cache of %d tiles",
+	    rd.Nslot);
+    Error(ERROR_LEVEL_2, routineName, messageStr);
+  }
+  sl = &rd.slot[n];
+  sl->tile  = tile;
+  sl->state = NODE_LOADING;
+  sl->pins  = 1;
+  pthread_mutex_unlock(&rd.nc->lock);
+
+  readBlock(&rd.view[n], xi, yi);
+
+  pthread_mutex_lock(&rd.nc->lock);
+  sl->x0    = rd.view[n].x0;
+  sl->y0    = rd.view[n].y0;
+  sl->nbx   = rd.view[n].nbx;
+  sl->nby   = rd.view[n].nby;
+  sl->state = NODE_READY;
+  sl->used  = ++rd.nc->clock;
+  pthread_cond_broadcast(&rd.nc->loaded);
+  pthread_mutex_unlock(&rd.nc->lock);
+  rd.pinned = n;
+  return &rd.view[n];
+}
+/* ------- end   -------------------------- nodeBlock.c ------------ */
+
+/* ------- begin -------------------------- initColumnReader.c ----- */
+static void initColumnReader(Atmosphere *atmos, Input_Atmos_file *infile)
+/* Sets the tile size, allocates the tiles, starts the reader thread */
+{
+  const char routineName[] = "initColumnReader";
+  bool_t  threadsafe = FALSE;
+  int     n, status;
+  long    nz = infile->nz;
+  hsize_t chunk[4];
+  hid_t   dcpl;
+
+  rd.infile   = infile;
+  rd.NHydr    = atmos->NHydr;
+  rd.Stokes   = atmos->Stokes;
+  rd.threaded = rd.busy = rd.done = rd.request = rd.node = FALSE;
+  rd.cur      = 0;
+  rd.tx = rd.ty = 1;
+
+  /* Whole chunks of T, as far as they fit within TILE_MAXBYTES. The
+     node cache reads whole rows in y if T is not chunked. */
+  if (input.p15d_tiles  ||  input.p15d_nodecache > 0) {
+    if ((dcpl = H5Dget_create_plist(infile->T_varid)) < 0) HERR(routineName);
+    if (H5Pget_layout(dcpl) == H5D_CHUNKED) {
+      if (H5Pget_chunk(dcpl, 4, chunk) != 4) HERR(routineName);
+      rd.tx = MIN((int) chunk[1], (int) infile->nx);
+      rd.ty = MIN((int) chunk[2], (int) infile->ny);
+    } else if (input.p15d_nodecache > 0) {
+      rd.ty = infile->ny;
+    }
+    if ((H5Pclose(dcpl)) < 0) HERR(routineName);
+    while ((long) rd.tx * rd.ty > 1  &&  (long) rd.tx * rd.ty * nz *
+	   (8 + rd.NHydr) * sizeof(double) > TILE_MAXBYTES) {
+      if (rd.ty >= rd.tx)
+	rd.ty = (rd.ty + 1) / 2;
+      else
+	rd.tx = (rd.tx + 1) / 2;
+    }
+  }
+
+  if (input.p15d_nodecache > 0) {
+    initNodeCache();
+    if (input.p15d_prefetch) {
+      sprintf(messageStr, "15D_READ_AHEAD is not used with 15D_NODE_CACHE\n");
+      Error(WARNING, routineName, messageStr);
+    }
+    return;
+  }
+
+  for (n = 0;  n < 2;  n++) {
+    setBlock(&rd.blk[n], (double *) malloc(tileSize() * sizeof(double)));
+    /* The second tile is only used for reading ahead */
+    if (!input.p15d_prefetch) break;
+  }
+
+  if (!input.p15d_prefetch) return;
+#ifdef H5_HAVE_THREADSAFE
+  threadsafe = TRUE;
+#endif
+  if (!threadsafe  ||  (mpi.thread_level < MPI_THREAD_MULTIPLE)) {
+    sprintf(messageStr, "15D_READ_AHEAD needs %s, reading the atmosphere "
+	    "from the main thread\n", (threadsafe) ?
+	    "MPI_THREAD_MULTIPLE (" MPI_THREADS_ENV "=MULTIPLE)" :
+	    "a thread-safe HDF5 library");
+    Error(WARNING, routineName, messageStr);
+    return;
+  }
+  if ((status = pthread_mutex_init(&rd.lock, NULL)) ||
+      (status = pthread_cond_init(&rd.cond, NULL)) ||
+      (status = pthread_create(&rd.thread, NULL, reader_pthread, NULL))) {
+    sprintf(messageStr, "Unable to start reader thread, error: %s",
+	    strerror(status));
+    Error(ERROR_LEVEL_2, routineName, messageStr);
+  }
+  rd.threaded = TRUE;
+}
+/* ------- end   -------------------------- initColumnReader.c ----- */
+
+/* ------- begin -------------------------- closeColumnReader.c ---- */
+static void closeColumnReader(void)
+/* Stops the reader thread and frees the tiles */
+{
+  int n, noderank;
+
+  if (rd.node) {
+    /* All processes of the node must be done with the cache */
+    MPI_Barrier(rd.nodecomm);
+    MPI_Comm_rank(rd.nodecomm, &noderank);
+    if (noderank == 0) {
+      pthread_mutex_destroy(&rd.nc->lock);
+      pthread_cond_destroy(&rd.nc->loaded);
+    }
+    MPI_Win_free(&rd.win);
+    MPI_Comm_free(&rd.nodecomm);
+    free(rd.view);
+    rd.node = FALSE;
+    return;
+  }
+  if (rd.threaded) {
+    pthread_mutex_lock(&rd.lock);
+    while (rd.busy) pthread_cond_wait(&rd.cond, &rd.lock);
+    rd.done = TRUE;
+    pthread_cond_signal(&rd.cond);
+    pthread_mutex_unlock(&rd.lock);
+    pthread_join(rd.thread, NULL);
+    pthread_mutex_destroy(&rd.lock);
+    pthread_cond_destroy(&rd.cond);
+    rd.threaded = FALSE;
+  }
+  for (n = 0;  n < 2;  n++) {
+    free(rd.blk[n].T);
+    if (!input.p15d_prefetch) break;
+  }
+}
+/* ------- end   -------------------------- closeColumnReader.c ---- */
+
+/* ------- begin -------------------------- readBlock.c ------------ */
+static void readBlock(AtmosBlock *blk, int xi, int yi)
+/* Reads all variables of the tile of columns around (xi, yi), with
+   one H5Dread per variable */
+{
+  const char routineName[] = "readBlock";
+  Input_Atmos_file *infile = rd.infile;
+  hsize_t  start[] = {0, 0, 0, 0, 0}, count[] = {1, 1, 1, 1, 1}, dims[1];
+  hid_t    file_dspace, mem_dspace;
+
+  blk->x0  = xi - xi % rd.tx;
+  blk->y0  = yi - yi % rd.ty;
+  blk->nbx = MIN(rd.tx, (int) infile->nx - blk->x0);
+  blk->nby = MIN(rd.ty, (int) infile->ny - blk->y0);
+
+  /* All 4-D variables have the shape of T */
+  start[0] = input.p15d_nt;  count[0] = 1;
+  start[1] = blk->x0;        count[1] = blk->nbx;
+  start[2] = blk->y0;        count[2] = blk->nby;
+  start[3] = 0;              count[3] = infile->nz;
+  dims[0] = blk->nbx * blk->nby * infile->nz;
+  if ((mem_dspace = H5Screate_simple(1, dims, NULL)) < 0) HERR(routineName);
+  if ((file_dspace = H5Dget_space(infile->T_varid)) < 0) HERR(routineName);
+  if ((H5Sselect_hyperslab(file_dspace, H5S_SELECT_SET, start,
+			   NULL, count, NULL)) < 0) HERR(routineName);
+  if ((H5Dread(infile->T_varid, H5T_NATIVE_DOUBLE, mem_dspace, file_dspace,
+	       H5P_DEFAULT, blk->T)) < 0) HERR(routineName);
+  if (input.solve_ne == NONE) {
+    if ((H5Dread(infile->ne_varid, H5T_NATIVE_DOUBLE, mem_dspace,
+		 file_dspace, H5P_DEFAULT, blk->ne)) < 0) HERR(routineName);
+  }
+  if ((H5Dread(infile->vz_varid, H5T_NATIVE_DOUBLE, mem_dspace, file_dspace,
+	       H5P_DEFAULT, blk->vz)) < 0) HERR(routineName);
+  if (infile->vturb_varid != -1) {
+    if ((H5Dread(infile->vturb_varid, H5T_NATIVE_DOUBLE, mem_dspace,
+		 file_dspace, H5P_DEFAULT, blk->vturb)) < 0) HERR(routineName);
+  }
+  if (rd.Stokes) {
+    if ((H5Dread(infile->Bx_varid, H5T_NATIVE_DOUBLE, mem_dspace,
+		 file_dspace, H5P_DEFAULT, blk->Bx)) < 0) HERR(routineName);
+    if ((H5Dread(infile->By_varid, H5T_NATIVE_DOUBLE, mem_dspace,
+		 file_dspace, H5P_DEFAULT, blk->By)) < 0) HERR(routineName);
+    if ((H5Dread(infile->Bz_varid, H5T_NATIVE_DOUBLE, mem_dspace,
+		 file_dspace, H5P_DEFAULT, blk->Bz)) < 0) HERR(routineName);
+  }
+  /* z scale is specified for every column, or once per snapshot */
+  if (mpi.ndims_z == 4) {
+    if ((H5Dread(infile->z_varid, H5T_NATIVE_DOUBLE, mem_dspace,
+		 file_dspace, H5P_DEFAULT, blk->z)) < 0) HERR(routineName);
+  }
+  if ((H5Sclose(file_dspace)) < 0) HERR(routineName);
+  if ((H5Sclose(mem_dspace)) < 0) HERR(routineName);
+
+  if (mpi.ndims_z == 2) {
+    start[1] = 0;
+    count[1] = infile->nz;
+    dims[0]  = infile->nz;
+    if ((mem_dspace = H5Screate_simple(1, dims, NULL)) < 0) HERR(routineName);
+    if ((file_dspace = H5Dget_space(infile->z_varid)) < 0) HERR(routineName);
+    if ((H5Sselect_hyperslab(file_dspace, H5S_SELECT_SET, start,
+			     NULL, count, NULL)) < 0) HERR(routineName);
+    if ((H5Dread(infile->z_varid, H5T_NATIVE_DOUBLE, mem_dspace,
+		 file_dspace, H5P_DEFAULT, blk->z)) < 0) HERR(routineName);
+    if ((H5Sclose(file_dspace)) < 0) HERR(routineName);
+    if ((H5Sclose(mem_dspace)) < 0) HERR(routineName);
+  }
+
+  /* nH, all levels at once */
+  start[1] = 0;        count[1] = rd.NHydr;
+  start[2] = blk->x0;  count[2] = blk->nbx;
+  start[3] = blk->y0;  count[3] = blk->nby;
+  start[4] = 0;        count[4] = infile->nz;
+  dims[0] = rd.NHydr * blk->nbx * blk->nby * infile->nz;
+  if ((mem_dspace = H5Screate_simple(1, dims, NULL)) < 0) HERR(routineName);
+  if ((file_dspace = H5Dget_space(infile->nh_varid)) < 0) HERR(routineName);
+  if ((H5Sselect_hyperslab(file_dspace, H5S_SELECT_SET, start,
+			   NULL, count, NULL)) < 0) HERR(routineName);
+  if ((H5Dread(infile->nh_varid, H5T_NATIVE_DOUBLE, mem_dspace, file_dspace,
+	       H5P_DEFAULT, blk->nH)) < 0) HERR(routineName);
+  if ((H5Sclose(file_dspace)) < 0) HERR(routineName);
+  if ((H5Sclose(mem_dspace)) < 0) HERR(routineName);
+
+  blk->valid = TRUE;
+}
+/* ------- end   -------------------------- readBlock.c ------------ */
+
+/* ------- begin -------------------------- inBlock.c -------------- */
+static bool_t inBlock(AtmosBlock *blk, int xi, int yi)
+{
+  return (blk->valid  &&  xi >= blk->x0  &&  xi < blk->x0 + blk->nbx  &&
+	  yi >= blk->y0  &&  yi < blk->y0 + blk->nby);
+}
+/* ------- end   -------------------------- inBlock.c -------------- */
+
+/* ------- begin -------------------------- reader_pthread.c ------- */
+static void *reader_pthread(void *argument)
+/* Reads the requested tile into the spare block */
+{
+  AtmosBlock *blk;
+
+  pthread_mutex_lock(&rd.lock);
+  for (;;) {
+    while (!rd.busy  &&  !rd.done) pthread_cond_wait(&rd.cond, &rd.lock);
+    if (rd.done) break;
+    blk = &rd.blk[1 - rd.cur];
+    pthread_mutex_unlock(&rd.lock);
+
+    readBlock(blk, rd.rx, rd.ry);
+
+    pthread_mutex_lock(&rd.lock);
+    rd.busy = FALSE;
+    pthread_cond_broadcast(&rd.cond);
+  }
+  pthread_mutex_unlock(&rd.lock);
+  return NULL;
+}
+/* ------- end   -------------------------- reader_pthread.c ------- */
+
+/* ------- begin -------------------------- getBlock.c ------------- */
+static AtmosBlock *getBlock(int xi, int yi)
+/* Returns the tile with column (xi, yi): the current one, the one read
+   ahead, or one read now. Then starts reading ahead, if asked for. */
+{
+  AtmosBlock *blk = &rd.blk[rd.cur];
+
+  if (rd.node) return nodeBlock(xi, yi);
+  if (!inBlock(blk, xi, yi)) {
+    if (rd.threaded) {
+      pthread_mutex_lock(&rd.lock);
+      while (rd.busy) pthread_cond_wait(&rd.cond, &rd.lock);
+      pthread_mutex_unlock(&rd.lock);
+      if (inBlock(&rd.blk[1 - rd.cur], xi, yi)) {
+	rd.cur = 1 - rd.cur;
+	blk = &rd.blk[rd.cur];
+      }
+    }
+    if (!inBlock(blk, xi, yi)) readBlock(blk, xi, yi);
+  }
+
+  if (rd.request) {
+    rd.request = FALSE;
+    pthread_mutex_lock(&rd.lock);
+    if (!rd.busy  &&  !inBlock(blk, rd.qx, rd.qy)  &&
+	!inBlock(&rd.blk[1 - rd.cur], rd.qx, rd.qy)) {
+      rd.blk[1 - rd.cur].valid = FALSE;
+      rd.rx   = rd.qx;
+      rd.ry   = rd.qy;
+      rd.busy = TRUE;
+      pthread_cond_signal(&rd.cond);
+    }
+    pthread_mutex_unlock(&rd.lock);
+  }
+  return blk;
+}
+/* ------- end   -------------------------- getBlock.c ------------- */
+
+/* ------- begin -------------------------- prefetchAtmos_hdf5.c --- */
+void prefetchAtmos_hdf5(int xi, int yi)
+/* Asks for column (xi, yi) to be read ahead while the next column,
+   read with readAtmos_hdf5, is calculated. Only with 15D_READ_AHEAD,
+   and not while a tile is still being read ahead. */
+{
+  if (!rd.threaded) return;
+  rd.request = TRUE;
+  rd.qx      = xi;
+  rd.qy      = yi;
+}
+/* ------- end   -------------------------- prefetchAtmos_hdf5.c --- */
+
 /* ------- begin -------------------------- readAtmos_hdf5  --------- */
-void readAtmos_hdf5(int xi, int yi, Atmosphere *atmos, Geometry *geometry,
+void readAtmos_hdf5(Column *col, Atmosphere *atmos, Geometry *geometry,
 		    Input_Atmos_file *infile) {
-  /* Reads the variables T, ne, vel, nh for a given (xi,yi) pair */
-  const char routineName[] = "readAtmos_hdf5";
-  hsize_t     start[]    = {0, 0, 0, 0}; /* starting values */
-  hsize_t     count[]    = {1, 1, 1, 1};
-  hsize_t     start_nh[] = {0, 0, 0, 0, 0};
-  hsize_t     count_nh[] = {1, 1, 1, 1, 1};
-  hsize_t    dims_memory[2];
-  hid_t      ncid, dataspace_id, memspace_id;
-  int        ierror, i, j;
-  bool_t     old_moving;
-  double    *Bx, *By, *Bz;
-
-  ncid = infile->ncid;
+  /* Reads the variables T, ne, vel, nh for grid point (col->xi, col->yi)
+     and sets its depth cut col->zcut */
+  const char  routineName[] = "readAtmos_hdf5";
+  int         i, j, l;
+  long        c, k0, ncol;
+  bool_t      old_moving;
+  double     *Bx, *By, *Bz;
+  AtmosBlock *blk;
+
   atmos->Nspace = geometry->Ndep = infile->nz;
+  blk  = getBlock(col->xi, col->yi);
+  ncol = blk->nbx * blk->nby;
+  c    = (col->xi - blk->x0) * blk->nby + (col->yi - blk->y0);
 
-  /* read full T column, to see where to zcut */
-  /* Memory dataspace */
-  dims_memory[0] = infile->nz;
-  if ((memspace_id = H5Screate_simple(1, dims_memory, NULL)) < 0)
-    HERR(routineName);
+  /* full T column, to see where to zcut */
   atmos->T = (double *) realloc(atmos->T, infile->nz * sizeof(double));
-  /* File dataspace */
-  start[0] = input.p15d_nt; count[0] = 1;
-  start[1] = (size_t) xi;   count[1] = 1;
-  start[2] = (size_t) yi;   count[2] = 1;
-  start[3] = 0;             count[3] = infile->nz;
-  if ((dataspace_id = H5Dget_space(infile->T_varid)) < 0) HERR(routineName);
-  if ((H5Sselect_hyperslab(dataspace_id, H5S_SELECT_SET, start,
-                               NULL, count, NULL)) < 0) HERR(routineName);
-  if ((H5Dread(infile->T_varid, H5T_NATIVE_DOUBLE, memspace_id, dataspace_id,
-	      H5P_DEFAULT, atmos->T)) < 0) HERR(routineName);
-  if (( H5Sclose(dataspace_id) ) < 0) HERR(routineName);
-  if (( H5Sclose(memspace_id) ) < 0) HERR(routineName);
+  memcpy(atmos->T, blk->T + c * infile->nz, infile->nz * sizeof(double));
   /* Finds z value for Tmax cut, redefines Nspace, reallocates arrays */
   /* Tiago: not using this at the moment, only z cut in depth_refine */
   if (input.p15d_zcut) {
-    setTcut(atmos, geometry, input.p15d_tmax);
+    setTcut(col, atmos, geometry, input.p15d_tmax);
   } else {
-    mpi.zcut = 0;
-  }
-
-  /* Memory dataspace, redefine for Nspace */
-  dims_memory[0] = atmos->Nspace;
-  memspace_id = H5Screate_simple(1, dims_memory, NULL);
-  /* Get z again */
-  if ((mpi.ndims_z) == 2) {   /* z scale is specified only once per snapshot */
-    start[0] = input.p15d_nt; count[0] = 1;
-    start[1] = mpi.zcut;      count[1] = atmos->Nspace;
-  } else if ((mpi.ndims_z) == 4) {  /* z scale is specified for every column */
-    start[0] = input.p15d_nt; count[0] = 1;
-    start[1] = (size_t) xi;   count[1] = 1;
-    start[2] = (size_t) yi;   count[2] = 1;
-    start[3] = mpi.zcut;      count[3] = atmos->Nspace;
-  }
-  dataspace_id = H5Dget_space(infile->z_varid);
-  ierror = H5Sselect_hyperslab(dataspace_id, H5S_SELECT_SET, start,
-                               NULL, count, NULL);
-  if ((ierror = H5Dread(infile->z_varid, H5T_NATIVE_DOUBLE, memspace_id,
-		        dataspace_id, H5P_DEFAULT, geometry->height)) < 0)
-    HERR(routineName);
-  if (( H5Sclose(dataspace_id) ) < 0) HERR(routineName);
-  /* redefine dataspace for 4-D variables */
-  start[0] = input.p15d_nt; count[0] = 1;
-  start[1] = (size_t) xi;   count[1] = 1;
-  start[2] = (size_t) yi;   count[2] = 1;
-  start[3] = mpi.zcut;      count[3] = atmos->Nspace;
-  dataspace_id = H5Dget_space(infile->T_varid);
-  if ((ierror = H5Sselect_hyperslab(dataspace_id, H5S_SELECT_SET, start,
-                               NULL, count, NULL)) < 0) HERR(routineName);
-   /* read variables */
-  if ((ierror = H5Dread(infile->T_varid, H5T_NATIVE_DOUBLE, memspace_id,
-	          dataspace_id, H5P_DEFAULT, atmos->T)) < 0) HERR(routineName);
-  if (input.solve_ne == NONE) {
-      if ((ierror = H5Dread(infile->ne_varid, H5T_NATIVE_DOUBLE, memspace_id,
-      	          dataspace_id, H5P_DEFAULT, atmos->ne)) < 0) HERR(routineName);
+    col->zcut = 0;
   }
-  if ((ierror = H5Dread(infile->vz_varid, H5T_NATIVE_DOUBLE, memspace_id,
-	     dataspace_id, H5P_DEFAULT, geometry->vel)) < 0) HERR(routineName);
+
+  /* Copy variables from the cut point on */
+  k0 = c * infile->nz + col->zcut;
+  memcpy(atmos->T, blk->T + k0, atmos->Nspace * sizeof(double));
+  memcpy(geometry->height, blk->z + ((mpi.ndims_z == 4) ? k0 : col->zcut),
+	 atmos->Nspace * sizeof(double));
+  if (input.solve_ne == NONE)
+    memcpy(atmos->ne, blk->ne + k0, atmos->Nspace * sizeof(double));
+  memcpy(geometry->vel, blk->vz + k0, atmos->Nspace * sizeof(double));
   /* vturb, if available */
-  if (infile->vturb_varid != -1) {
-    ierror = H5Dread(infile->vturb_varid, H5T_NATIVE_DOUBLE, memspace_id,
-		   dataspace_id, H5P_DEFAULT, atmos->vturb);
-  }
-  /* Read magnetic field */
+  if (infile->vturb_varid != -1)
+    memcpy(atmos->vturb, blk->vturb + k0, atmos->Nspace * sizeof(double));
+  /* Magnetic field, convert to spherical coordinates */
   if (atmos->Stokes) {
-    Bx = (double *) malloc(atmos->Nspace * sizeof(double));
-    By = (double *) malloc(atmos->Nspace * sizeof(double));
-    Bz = (double *) malloc(atmos->Nspace * sizeof(double));
-    /* Read in cartesian coordinates */
-    ierror = H5Dread(infile->Bx_varid, H5T_NATIVE_DOUBLE, memspace_id,
-		   dataspace_id, H5P_DEFAULT, Bx);
-    ierror = H5Dread(infile->By_varid, H5T_NATIVE_DOUBLE, memspace_id,
-		   dataspace_id, H5P_DEFAULT, By);
-    ierror = H5Dread(infile->Bz_varid, H5T_NATIVE_DOUBLE, memspace_id,
-		   dataspace_id, H5P_DEFAULT, Bz);
-    /* Convert to spherical coordinates */
+    Bx = blk->Bx + k0;
+    By = blk->By + k0;
+    Bz = blk->Bz + k0;
     for (j = 0; j < atmos->Nspace; j++) {
       atmos->B[j]       = sqrt(SQ(Bx[j]) + SQ(By[j]) + SQ(Bz[j]));
       atmos->gamma_B[j] = acos(Bz[j]/atmos->B[j]);
@@ -305,30 +764,14 @@ void readAtmos_hdf5(int xi, int yi, Atmosphere *atmos, Geometry *geometry,
       if ((Bx[j] == 0) && (By[j] == 0))
 	atmos->chi_B[j]   = 1.0;
     }
-    free(Bx); free(By); free(Bz);
   }
-  if (( H5Sclose(dataspace_id) ) < 0) HERR(routineName);
-  if (( H5Sclose(memspace_id) ) < 0) HERR(routineName);
   /* allocate and zero nHtot */
   atmos->nH = matrix_double(atmos->NHydr, atmos->Nspace);
   for (j = 0; j < atmos->Nspace; j++) atmos->nHtot[j] = 0.0;
+  for (l = 0; l < atmos->NHydr; l++)
+    memcpy(atmos->nH[l], blk->nH + (l * ncol + c) * infile->nz + col->zcut,
+	   atmos->Nspace * sizeof(double));
 
-  /* read nH, all at once */
-  start_nh[0] = input.p15d_nt; count_nh[0] = 1;
-  start_nh[1] = 0;             count_nh[1] = atmos->NHydr;
-  start_nh[2] = (size_t) xi;   count_nh[2] = 1;
-  start_nh[3] = (size_t) yi;   count_nh[3] = 1;
-  start_nh[4] = mpi.zcut;      count_nh[4] = atmos->Nspace;
-  dataspace_id = H5Dget_space(infile->nh_varid);
-  ierror = H5Sselect_hyperslab(dataspace_id, H5S_SELECT_SET, start_nh,
-                               NULL, count_nh, NULL);
-  dims_memory[0] = atmos->NHydr;
-  dims_memory[1] = atmos->Nspace;
-  memspace_id = H5Screate_simple(2, dims_memory, NULL);
-  ierror = H5Dread(infile->nh_varid, H5T_NATIVE_DOUBLE,
-		   memspace_id, dataspace_id, H5P_DEFAULT, atmos->nH[0]);
-  if (( H5Sclose(dataspace_id) ) < 0) HERR(routineName);
-  if (( H5Sclose(memspace_id) ) < 0) HERR(routineName);
   /* Depth grid refinement */
   if (input.p15d_refine)
     depth_refine(atmos, geometry, input.p15d_tmax);
@@ -371,6 +814,8 @@ void close_hdf5_atmos(Atmosphere *atmos, Geometry *geometry,
     Input_Atmos_file *infile) {
   /* Closes the HDF5 file and frees memory */
   int ierror;
+
+  closeColumnReader();
   /* Close the file. */
   ierror = H5Dclose(infile->z_varid);
   ierror = H5Dclose(infile->T_varid);
@@ -22,6 +22,12 @@
          OLD_J              -- Use mean intensities from previous solution
                                (Only implemented for wavelength_table).
 
+       With 15D_WARM_START > 0, active atoms that do not read
+       OLD_POPULATIONS start instead from the departure coefficients
+       of the last converged column of this process, if that column
+       is close enough in the (x, y) grid. The departure coefficients
+       are mapped in depth on the hydrogen column density scale.
+
        --                                              -------------- */
 
 
@@ -40,17 +46,31 @@
 #include "statistics.h"
 #include "error.h"
 #include "inputs.h"
+#include "geometry.h"
 #include "parallel.h"
 
 #define IMU_FILE_TEMPLATE "scratch/Imu_p%d.dat"
 
+/* --- Last converged column of this process, for warm starts.
+       ix and iy are grid points in the atmosphere, not task indices  */
+
+typedef struct {
+  int      ix, iy, Nspace, Natom;
+  double  *lgNH, ***lgb;
+} WarmStart;
+
 
 /* --- Function prototypes --                          -------------- */
 void Escape(Atom *atom);
+void initSolution_alloc(Column *col);
+bool_t warmStart_p(Column *col, Atom *atom, int nact);
+bool_t readPrevPops_p(Column *col, Atom *atom);
+void column_NH(double *lgNH);
 
 /* --- Global variables --                             -------------- */
 
 extern Atmosphere atmos;
+extern Geometry geometry;
 extern Spectrum spectrum;
 extern InputData input;
 extern CommandLine commandline;
@@ -58,9 +78,11 @@ extern char messageStr[];
 extern MPI_data mpi;
 extern enum Topology topology;
 
+static WarmStart warm = {-1, -1, 0, 0, NULL, NULL};
+
 
 /* ------- begin -------------------------- initSolution_alloc.c ---- */
-void initSolution_alloc(void) {
+void initSolution_alloc(Column *col) {
   const char routineName[] = "initSolution_p";
   register int nspect, nact,k,kr,mu;
   char    permission[3], file_imu[MAX_MESSAGE_LENGTH];
@@ -102,61 +124,8 @@ void initSolution_alloc(void) {
       }
     }
 
-    /* --- allocate space for gII redistribution function in PRD
-       lines                                                     --- */
-    for (nact = 0;  nact < atmos.Nactiveatom;  nact++) {
-
-      atom = atmos.activeatoms[nact];
-
-      for (kr = 0;  kr < atom->Nline;  kr++) {
-
-	line = &atom->line[kr];
-
-	if (line->PRD) {
-
-	  /*	  line->gII  = (double **) malloc(atmos.Nrays * sizeof(double *));
-
-	  for (k = 0;  k < atmos.Nspace;  k++) {
-	    for (la = 0 ;  la < line->Nlambda;  la++) {
-
-	      // second index in line.gII array
-	      lak= k * line->Nlambda + line->Nlambda;
-
-	      q_emit = (line->lambda[la] - line->lambda0) * CLIGHT /
-		(line->lambda0 * atom->vbroad[k]);
-
-
-	      if (fabs(q_emit) < PRD_QCORE) {
-		q0 = -PRD_QWING;
-		qN =  PRD_QWING;
-	      } else {
-		if (fabs(q_emit) < PRD_QWING) {
-		  if (q_emit > 0.0) {
-		    q0 = -PRD_QWING;
-		    qN = q_emit + PRD_QSPREAD;
-		  } else {
-		    q0 = q_emit - PRD_QSPREAD;
-		    qN = PRD_QWING;
-		  }
-		} else {
-		  q0 = q_emit - PRD_QSPREAD;
-		  qN = q_emit + PRD_QSPREAD;
-		}
-	      }
-	      Np = (int) ((qN - q0) / PRD_DQ) + 1;
-
-	      line->gII[lak]= (double *) malloc(Np*sizeof(double));
-
-	    }
-	    }*/
-
-	  Nsr=MAX(3*PRD_QWING,2*PRD_QSPREAD)/PRD_DQ+1;
-	  if (line->gII != NULL) freeMatrix((void **) line->gII);
-	  line->gII  = matrix_double(atmos.Nspace*line->Nlambda,Nsr);
-	  line->gII[0][0] = -1.0;
-	}
-      }
-    }
+    /* --- The gII redistribution weights of the PRD lines are
+           allocated by PRDAngleApproxScatter when first needed -- */
 
    /* precompute prd_rho interpolation coefficients if requested */
     if (!input.prdh_limit_mem) {
@@ -445,7 +414,7 @@ void initSolution_alloc(void) {
 
 
   /* Things to be done only for the first task */
-  if (mpi.isfirst) {
+  if (col->isfirst) {
     /* --- Need storage for angle-dependent specific intensities for
        angle-dependent PRD --                        -------------- */
 
@@ -511,7 +480,7 @@ void initSolution_alloc(void) {
 
 /* ------- begin -------------------------- initSolution.c ---------- */
 
-void initSolution_p(void)
+void initSolution_p(Column *col)
 {
   const char routineName[] = "initSolution_p";
   register int k, i, ij, nspect, n, nact;
@@ -526,7 +495,7 @@ void initSolution_p(void)
   getCPU(2, TIME_START, NULL);
 
   /* allocate memory always (because of dynamic Nspace) */
-  initSolution_alloc();
+  initSolution_alloc(col);
 
   for (nact = 0;  nact < atmos.Nactiveatom;  nact++) {
     atom = atmos.activeatoms[nact];
@@ -543,6 +512,10 @@ void initSolution_p(void)
     }
 
 
+    if (atom->initial_solution != OLD_POPULATIONS  &&
+	(readPrevPops_p(col, atom)  ||  warmStart_p(col, atom, nact)))
+      continue;
+
     switch(atom->initial_solution) {
     case LTE_POPULATIONS:
       for (i = 0;  i < atom->Nlevel;  i++) {
@@ -620,7 +593,7 @@ void initSolution_p(void)
       break;
 
     case OLD_POPULATIONS:
-      readPopulations(atom);
+      readPopulations_p(col, atom);
       break;
 
     default:;
@@ -664,7 +637,7 @@ void initSolution_p(void)
       break;
 
     case OLD_POPULATIONS:
-      readMolPops(molecule);
+      readMolPops_p(col, molecule);
       break;
 
     default:;
@@ -687,3 +660,102 @@ void initSolution_p(void)
   }
 }
 /* ------- end ---------------------------- initSolution.c ---------- */
+
+/* ------- begin -------------------------- saveWarmStart_p.c ------- */
+
+void saveWarmStart_p(Column *col)
+{
+  /* --- Keeps departure coefficients of the active atoms of a
+         converged column, to start neighbouring columns from -- --- */
+
+  register int k, i, nact;
+
+  Atom *atom;
+
+  if (warm.lgb == NULL) {
+    warm.Natom = atmos.Nactiveatom;
+    warm.lgb   = (double ***) calloc(warm.Natom, sizeof(double **));
+  }
+  warm.ix     = col->xi;
+  warm.iy     = col->yi;
+  warm.Nspace = atmos.Nspace;
+  warm.lgNH   = (double *) realloc(warm.lgNH, atmos.Nspace * sizeof(double));
+  column_NH(warm.lgNH);
+
+  for (nact = 0;  nact < warm.Natom;  nact++) {
+    atom = atmos.activeatoms[nact];
+    if (warm.lgb[nact] != NULL) freeMatrix((void **) warm.lgb[nact]);
+    warm.lgb[nact] = matrix_double(atom->Nlevel, atmos.Nspace);
+
+    for (i = 0;  i < atom->Nlevel;  i++) {
+      for (k = 0;  k < atmos.Nspace;  k++) {
+	warm.lgb[nact][i][k] = (atom->n[i][k] > 0.0  &&  atom->nstar[i][k] > 0.0) ?
+	  log10(atom->n[i][k] / atom->nstar[i][k]) : 0.0;
+      }
+    }
+  }
+}
+/* ------- end ---------------------------- saveWarmStart_p.c ------- */
+
+/* ------- begin -------------------------- warmStart_p.c ----------- */
+
+bool_t warmStart_p(Column *col, Atom *atom, int nact)
+{
+  /* --- Sets the populations of active atom nact from the last
+         converged column, if there is one within input.p15d_warm
+         grid points of the current column. Returns FALSE otherwise.
+         --                                            -------------- */
+
+  const char routineName[] = "warmStart_p";
+  register int k, i;
+
+  bool_t hunt;
+  double *lgNH, *lgb;
+
+  if (input.p15d_warm <= 0  ||  warm.ix < 0  ||  nact >= warm.Natom)
+    return FALSE;
+  if (abs(col->xi - warm.ix) > input.p15d_warm  ||
+      abs(col->yi - warm.iy) > input.p15d_warm) return FALSE;
+
+  lgNH = (double *) malloc(atmos.Nspace * sizeof(double));
+  lgb  = (double *) malloc(atmos.Nspace * sizeof(double));
+  column_NH(lgNH);
+
+  for (i = 0;  i < atom->Nlevel;  i++) {
+    Linear(warm.Nspace, warm.lgNH, warm.lgb[nact][i],
+	   atmos.Nspace, lgNH, lgb, hunt=TRUE);
+    for (k = 0;  k < atmos.Nspace;  k++)
+      atom->n[i][k] = atom->nstar[i][k] * POW10(lgb[k]);
+  }
+  free(lgNH);
+  free(lgb);
+
+  if (nact == 0) {
+    sprintf(messageStr, "Starting from populations of column (%d, %d)\n",
+	    warm.ix, warm.iy);
+    Error(MESSAGE, routineName, messageStr);
+  }
+  return TRUE;
+}
+/* ------- end ---------------------------- warmStart_p.c ----------- */
+
+/* ------- begin -------------------------- column_NH.c ------------- */
+
+void column_NH(double *lgNH)
+{
+  /* --- Log10 of the hydrogen column density from the top, used as
+         depth scale to map populations between columns -- -------- */
+
+  register int k;
+
+  double NH;
+
+  NH = 0.5 * atmos.nHtot[0] * fabs(geometry.height[0] - geometry.height[1]);
+  lgNH[0] = log10(NH);
+  for (k = 1;  k < atmos.Nspace;  k++) {
+    NH += 0.5 * (atmos.nHtot[k-1] + atmos.nHtot[k]) *
+      fabs(geometry.height[k-1] - geometry.height[k]);
+    lgNH[k] = log10(NH);
+  }
+}
+/* ------- end ---------------------------- column_NH.c ------------- */
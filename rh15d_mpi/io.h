@@ -87,6 +87,13 @@
 #define HOSTNAME       "hostname"
 #define START_TIME     "starting_time"
 #define FINISH_TIME    "finish_time"
+#define REUSE_NAME     "reused"
+
+/* Definitions for the output shards of each process */
+#define SHARD_TEMPLATE "%s.%04d"
+#define SHARD_COLS     "shard_columns"
+#define SHARD_AXIS     "column_axis"
+#define SHARD_NUMBER   "nshards"
 
 
 /* Definitions for the Aux file */
@@ -143,6 +150,8 @@ typedef struct {
       *aux_mol_ncid,     *aux_mol_pop,      *aux_mol_poplte,   *aux_mol_E,
       *aux_mol_vbroad,
        aux_op_chi_ai,     aux_op_chi_ad,     aux_op_eta_ai,     aux_op_eta_ad;
+  /* for the aux and input data files of a previous run */
+  hid_t prev_aux_ncid,    prev_in_ncid;
   /* for atom file positions */
   long *atom_file_pos;
   /* for the ray file */
@@ -161,6 +170,22 @@ typedef struct {
 /* Default fill value for HDF5 */
 extern const float FILLVALUE;
 
+/* Per-column output, batched and possibly through the writer thread */
+void initWriteQueue_p(void);
+void writeSlab_p(hid_t dset, hid_t memtype, int rank, const hsize_t *offset,
+                 const hsize_t *count, const void *buf);
+void flushColumn_p(void);
+void syncWriteQueue_p(void);
+void closeWriteQueue_p(void);
+void abortWriteQueue_p(void);
+
+/* Column indices of a previous run (15D_PREV_INDATA) */
+void check_prev_columns(hid_t ncid, const char *file_name);
+
+/* Output shards of this process (15D_SHARDS) */
+hid_t shardSlab_p(hid_t dset, const hsize_t *offset);
+void closeShards_p(void);
+
 #endif /* !__IO_H__ */
 
 /* ---------------------------------------- io.h -------------------- */
@@ -27,13 +27,13 @@
 
 typedef struct {
   bool_t eval_operator, redistribute;
-  int    nspect;
-  double dJ;
+  int   *queue;
+  double *dJ;
 } threadinfo;
 
 /* --- Function prototypes --                          -------------- */
 
-void *Formal_pthread(void *argument);
+void Formal_pthread(int task, void *argument);
 
 
 /* --- Global variables --                             -------------- */
@@ -47,21 +47,22 @@ extern char messageStr[];
 
 /* ------- begin -------------------------- Iterate_p.c ------------- */
 
-void Iterate_p(int NmaxIter, double iterLimit)
+void Iterate_p(Column *col, int NmaxIter, double iterLimit)
 {
   const char routineName[] = "Iterate";
   register int niter, nact;
   double cswitch;
 
-  bool_t eval_operator, write_analyze_output, equilibria_only;
+  bool_t eval_operator, write_analyze_output, equilibria_only,
+         converged = FALSE;
   double dpopsmax, PRDiterlimit;
   Atom *atom;
   Molecule *molecule;
 
   if (NmaxIter <= 0) {
     /* For compatibility */
-    mpi.dpopsmax[mpi.task]    = 0;
-    mpi.convergence[mpi.task] = TRUE;
+    mpi.dpopsmax[col->slot]    = 0;
+    mpi.convergence[col->slot] = TRUE;
     return;
   }
   getCPU(1, TIME_START, NULL);
@@ -82,8 +83,6 @@ void Iterate_p(int NmaxIter, double iterLimit)
   }
   /* --- Start of the main iteration loop --             ------------ */
 
-  niter = 1;
-  
   /* Collisional-radiative switching ? */
   if (input.crsw != 0.0)
     cswitch = input.crsw_ini;
@@ -95,6 +94,15 @@ void Iterate_p(int NmaxIter, double iterLimit)
     input.prdswitch = 0.0;
   else
     input.prdswitch = 1.0;
+
+  /* --- Continue from checkpoint of this column, if any --  -------- */
+  if (input.p15d_checkpoint > 0  &&
+      (niter = readCheckpoint_p(col, &cswitch)) > 0) {
+    dpopsmax = mpi.dpopsmax_hist[col->slot][niter-2];
+    if (input.solve_ne == ITERATION)
+      Background(write_analyze_output=TRUE, equilibria_only=FALSE);
+  } else
+    niter = 1;
   
   while (niter <= NmaxIter && !StopRequested()) {
     getCPU(2, TIME_START, NULL);
@@ -134,10 +142,13 @@ void Iterate_p(int NmaxIter, double iterLimit)
     getCPU(2, TIME_POLL, messageStr);
 
     /* Save niter, dpopsmax */
-    mpi.niter[mpi.task] = niter;
-    mpi.dpopsmax_hist[mpi.task][niter-1] = dpopsmax;
+    mpi.niter[col->slot] = niter;
+    mpi.dpopsmax_hist[col->slot][niter-1] = dpopsmax;
 
-    if ((dpopsmax < iterLimit) && (cswitch <= 1.0) && (input.prdswitch >= 1.0)) break;
+    if ((dpopsmax < iterLimit) && (cswitch <= 1.0) && (input.prdswitch >= 1.0)) {
+      converged = TRUE;
+      break;
+    }
     niter++;
     
     if (input.solve_ne == ITERATION)
@@ -160,11 +171,26 @@ void Iterate_p(int NmaxIter, double iterLimit)
       }
       Hydrostatic(N_MAX_HSE_ITER, HSE_ITER_LIMIT);
     }
+
+    if (input.p15d_checkpoint > 0  &&
+	((niter - 1) % input.p15d_checkpoint) == 0)
+      writeCheckpoint_p(col, niter, cswitch);
+  }
+
+  /* --- Keep checkpoint only if iterations were interrupted -- ----- */
+  if (input.p15d_checkpoint > 0) {
+    if (!converged  &&  niter <= NmaxIter)
+      writeCheckpoint_p(col, niter, cswitch);
+    else
+      removeCheckpoint_p(col);
   }
 
   /* Save dpopsmax, convergence */
-  mpi.dpopsmax[mpi.task]    = dpopsmax;
-  mpi.convergence[mpi.task] = (dpopsmax < iterLimit);
+  mpi.dpopsmax[col->slot]    = dpopsmax;
+  mpi.convergence[col->slot] = (dpopsmax < iterLimit);
+
+  if (input.p15d_warm > 0  &&  mpi.convergence[col->slot])
+    saveWarmStart_p(col);
 
   for (nact = 0;  nact < atmos.Nactiveatom;  nact++) {
     atom = atmos.activeatoms[nact];
@@ -186,12 +212,11 @@ void Iterate_p(int NmaxIter, double iterLimit)
 
 double solveSpectrum_p(bool_t eval_operator, bool_t redistribute)
 {
-  register int nspect, nt,k;
+  register int nspect, k;
 
-  int         Nthreads, lambda_max;
+  int         Nqueue, lambda_max;
   double      dJ, dJmax;
-  pthread_t  *thread_id;
-  threadinfo *ti;
+  threadinfo  ti;
 
   /* --- Administers the formal solution for each wavelength. When
          input.Nthreads > 1 the solutions are performed concurrently
@@ -230,52 +255,33 @@ double solveSpectrum_p(bool_t eval_operator, bool_t redistribute)
 
   if (input.Nthreads > 1) {
 
-    /* --- If input.Nthreads positive then solve Nthreads wavelengths
-           concurrently in separate threads --         -------------- */
+    /* --- Solve the wavelengths concurrently in the persistent pool
+           of input.Nthreads threads (see threadpool.c). The threads
+           take the wavelengths off a queue ordered by estimated cost,
+           most expensive first, so that no thread waits for another
+           to finish a batch. --                       -------------- */
 
-    ti = (threadinfo *) malloc(input.Nthreads * sizeof(threadinfo));
-    for (nt = 0;  nt < input.Nthreads;  nt++) {
-      ti[nt].eval_operator = eval_operator;
-      ti[nt].redistribute  = redistribute;
-    }
-    thread_id = (pthread_t *) malloc(input.Nthreads * sizeof(pthread_t));
+    ti.eval_operator = eval_operator;
+    ti.redistribute  = redistribute;
+    ti.queue = (int *) malloc(spectrum.Nspect * sizeof(int));
+    ti.dJ    = (double *) calloc(spectrum.Nspect, sizeof(double));
 
-    /* --- Thread management is very simple. Submit a batch of as many
-           as input.Nthreads at the same time, then wait till all of
-           these have finished. There is no check on successful
-           submission nor completion. --               -------------- */
+    /* --- The threads add to Gamma and the rates in private slabs,
+           which are summed once all wavelengths are done -- ------- */
 
-    for (nspect = 0;  nspect < spectrum.Nspect;  nspect += input.Nthreads) {
-      if (nspect + input.Nthreads <= spectrum.Nspect)
-	Nthreads = input.Nthreads;
-      else
-	Nthreads = (spectrum.Nspect % input.Nthreads);
-
-      /* --- Start batch of concurrent threads --      -------------- */
-
-      for (nt = 0;  nt < Nthreads;  nt++) {
-	ti[nt].nspect = nspect + nt;
-	if (!redistribute ||
-	    (redistribute && containsPRDline(&spectrum.as[nspect+nt]))) {
-	  pthread_create(&thread_id[nt], &input.thread_attr,
-			 Formal_pthread, &ti[nt]);
-	} else
-	  thread_id[nt] = 0;
-      }
-      /* --- Let the finished threads of the batch join again -- ---- */
-
-      for (nt = 0;  nt < Nthreads;  nt++) {
-	if (thread_id[nt]) {
-	  pthread_join(thread_id[nt], NULL);
-	  if (ti[nt].dJ > dJmax) {
-	    dJmax = ti[nt].dJ;
-	    lambda_max = nspect + nt;
-	  }
-	}
+    Nqueue = spectrumQueue(redistribute, ti.queue);
+    openGammaSlabs();
+    runThreadPool(Nqueue, Formal_pthread, &ti);
+    reduceGammaSlabs();
+
+    for (nspect = 0;  nspect < spectrum.Nspect;  nspect++) {
+      if (ti.dJ[nspect] > dJmax) {
+	dJmax = ti.dJ[nspect];
+	lambda_max = nspect;
       }
     }
-    free(thread_id);
-    free(ti);
+    free(ti.queue);
+    free(ti.dJ);
   } else {
       
     /* --- Else call the solution for wavelengths sequentially -- --- */
@@ -225,7 +225,6 @@ void readAtmos_multi(Atmosphere *atmos, Geometry *geometry,
   infile->nz = Ndep;
   infile->x  = (double *) calloc(infile->nx, sizeof(double));
   infile->y  = (double *) calloc(infile->ny, sizeof(double));
-  mpi.zcut = 0;  /* Disabled for MULTI atmospheres */
   if (input.p15d_refine)
     depth_refine(atmos, geometry, input.p15d_tmax);
   /* --- Construct atmosID from filename and last modification date - */
@@ -45,10 +45,26 @@ extern Spectrum spectrum;
 /* ------- begin --------------------------   initParallel.c --   --- */
 void initParallel(int *argc, char **argv[], bool_t run_ray) {
   const char routineName[] = "initParallel";
-  char   logfile[MAX_LINE_SIZE];
-
-  /* Initialise MPI */
-  MPI_Init(argc,argv);
+  char   logfile[MAX_LINE_SIZE], *level;
+  bool_t level_ok = TRUE;
+  int    required = MPI_THREAD_FUNNELED;
+
+  /* Initialise MPI. Only the main thread makes MPI calls, unless
+     MPI_THREADS_ENV asks for MULTIPLE, needed for the helper threads of
+     15D_WRITE_BUFFERS and 15D_READ_AHEAD. Some MPI libraries lock every
+     call at that level, so it is not the default. The input files are
+     not read yet, hence the environment variable. */
+  if ((level = getenv(MPI_THREADS_ENV)) != NULL) {
+    if (!strcmp(level, "MULTIPLE"))
+      required = MPI_THREAD_MULTIPLE;
+    else if (!strcmp(level, "SERIALIZED"))
+      required = MPI_THREAD_SERIALIZED;
+    else if (!strcmp(level, "SINGLE"))
+      required = MPI_THREAD_SINGLE;
+    else if (strcmp(level, "FUNNELED"))
+      level_ok = FALSE;
+  }
+  MPI_Init_thread(argc, argv, required, &mpi.thread_level);
   MPI_Comm_size(MPI_COMM_WORLD, &mpi.size);
   MPI_Comm_rank(MPI_COMM_WORLD, &mpi.rank);
   MPI_Get_processor_name(mpi.name, &mpi.namelen);
@@ -67,6 +83,12 @@ void initParallel(int *argc, char **argv[], bool_t run_ray) {
   /* _IOFBF for full buffering, _IOLBF for line buffering */
   setvbuf(mpi.logfile, NULL, _IOLBF, BUFSIZ_MPILOG);
 
+  if (!level_ok) {
+    sprintf(messageStr, "Unknown value %s of %s, using FUNNELED\n",
+            level, MPI_THREADS_ENV);
+    Error(WARNING, routineName, messageStr);
+  }
+
   mpi.stop    = FALSE;
   mpi.nconv   = 0;
   mpi.nnoconv = 0;
@@ -82,6 +104,8 @@ void initParallelIO(bool_t run_ray, bool_t writej) {
   Atom  *atom;
 
   init_hdf5_aux();
+  init_prev_pops();
+  initWriteQueue_p();
   init_Background();
   if (!run_ray) {
     init_hdf5_indata();
@@ -107,8 +131,6 @@ void initParallelIO(bool_t run_ray, bool_t writej) {
   /* max with 1 is used to make sure array is allocated even with Ntasks = 0 */
   mpi.dpopsmax_hist = matrix_double(MAX(mpi.Ntasks, 1), input.NmaxIter);
 
-  mpi.zcut_hist[mpi.task] = mpi.zcut;
-
   /* Fill mpi.niter with ones, to avoid problems with crashes on 1st iteration */
   for (i=0; i < mpi.Ntasks; i++) mpi.niter[i] = 1;
 
@@ -121,11 +143,16 @@ void initParallelIO(bool_t run_ray, bool_t writej) {
 /* ------- begin --------------------------  closeParallelIO.c    --- */
 void closeParallelIO(bool_t run_ray, bool_t writej) {
 
+  /* Staged writes must go out before any file is closed */
+  closeWriteQueue_p();
+  closeShards_p();
+
   if (!run_ray) {
     close_hdf5_indata();
   }
   close_atmos(&atmos, &geometry, &infile);
   close_hdf5_aux();
+  close_prev_pops();
 
   free(io.atom_file_pos);
   free(mpi.niter);
@@ -138,8 +165,23 @@ void closeParallelIO(bool_t run_ray, bool_t writej) {
 }
 /* ------- end   --------------------------  closeParallelIO.c    --- */
 
+/* ------- begin --------------------------  setColumn.c ---       --- */
+void setColumn(Column *col, long task, long slot) {
+/* Sets up col for column taskmap[task], with results kept in element
+   slot of the per-task arrays. The depth cut is set by readAtmos. */
+
+  col->task = task;
+  col->slot = slot;
+  col->ix   = mpi.taskmap[task][0];
+  col->iy   = mpi.taskmap[task][1];
+  col->xi   = mpi.xnum[col->ix];
+  col->yi   = mpi.ynum[col->iy];
+  col->zcut = 0;
+}
+/* ------- end   --------------------------  setColumn.c ---       --- */
+
 /* ------- begin --------------------------  updateAtmosDep.c     --- */
-void UpdateAtmosDep(void) {
+void UpdateAtmosDep(Column *col) {
 /* Updates the atmos-dependent factors for the atoms and molecules */
   const char routineName[] = "UpdateAtomsDep";
   int       ierror, nact, k, kr, la, Nlamu;
@@ -152,7 +194,7 @@ void UpdateAtmosDep(void) {
   /* Put back initial Stokes mode */
   input.StokesMode = mpi.StokesMode_save;
 
-  mpi.zcut_hist[mpi.task] = mpi.zcut;
+  mpi.zcut_hist[col->slot] = col->zcut;
 
   /* For single 1D atmosphere, this is not needed */
   //if (geometry.atmos_format == MULTI) return;
@@ -312,6 +354,10 @@ void UpdateAtmosDep(void) {
 	  fclose(line->fp_GII);
 	  line->fp_GII = NULL;
 	}
+	if (line->gII != NULL) {
+	  freeMatrix((void **) line->gII);
+	  line->gII = NULL;
+	}
 
 	if (input.PRD_angle_dep == PRD_ANGLE_DEP)
 	  Nlamu = 2*atmos.Nrays * line->Nlambda;
@@ -423,6 +469,7 @@ void HERR(const char *rname) {
   /* Processes NetCDF errors */
 
   printf("Process %4d: (EEE) %s: HDF5 error.\n", mpi.rank, rname);
+  abortWriteQueue_p();
   MPI_Abort(mpi.comm, 2);
 
 }
@@ -471,6 +518,7 @@ void Error(enum errorlevel level, const char *routineName,
       /* Make exception for Singular matrix error */
       if (!strstr(messageStr,"Singular matrix")) {
 	if (errno) perror(routineName);
+	abortWriteQueue_p();
 	MPI_Abort(mpi.comm, level);
       }
     }
@@ -480,7 +528,7 @@ void Error(enum errorlevel level, const char *routineName,
 
 /* ------- begin -------------------------- copyBufVars.c ------------ */
 
-void copyBufVars(bool_t writej) {
+void copyBufVars(Column *col, bool_t writej) {
 /* Copies output variables to buffer arrays, to be written only at the end */
   const  char routineName[] = "copyBufVars";
   static long ind = 0;
@@ -493,8 +541,8 @@ void copyBufVars(bool_t writej) {
   if (writej) {
     for (nspect=0; nspect < spectrum.Nspect; nspect++) {
       i = 0;
-      for (ndep=mpi.zcut; ndep < infile.nz; ndep++, i++) {
-        iobuf.J[(mpi.task*spectrum.Nspect + nspect)*infile.nz + ndep] =
+      for (ndep=col->zcut; ndep < infile.nz; ndep++, i++) {
+        iobuf.J[(col->slot*spectrum.Nspect + nspect)*infile.nz + ndep] =
             (float) spectrum.J[nspect][i];
       }
     }
@@ -11,11 +11,15 @@
 
 #include <mpi.h>
 
+struct Atom;
+struct Molecule;
+
 typedef struct {
   char     name[MPI_MAX_PROCESSOR_NAME], rev_id[MAX_LINE_SIZE];
-  bool_t   single_log, stop, isfirst;
-  int      size, rank, namelen, nx, ny, ix, iy, *xnum, *ynum, *niter, zcut, ndims_z;
+  bool_t   single_log, stop;
+  int      size, rank, namelen, nx, ny, *xnum, *ynum, *niter, ndims_z;
   int     *zcut_hist, **rh_converged, StokesMode_save, *convergence, snap_number;
+  int    **reused, thread_level;
   long     nconv, nnoconv, ncrash, my_start, backgrrecno;
   long   **taskmap, task, Ntasks, total_tasks;
   double  *dpopsmax, **dpopsmax_hist;
@@ -24,18 +28,40 @@ typedef struct {
   MPI_Info info;
 } MPI_data;
 
+/* --- State of one column: indices ix, iy in the selected columns
+       (taskmap), grid point xi, yi in the atmosphere, depth cut, index
+       in taskmap, slot in the per-task arrays of MPI_data and whether
+       it is the first column done by this process --  -------------- */
+typedef struct Column {
+  bool_t   isfirst;
+  int      ix, iy, xi, yi, zcut;
+  long     task, slot;
+} Column;
+
+MPI_Comm setInputBcast_p(MPI_Comm comm);
+
 void init_Background();
 void Background_p(bool_t analyzeoutput, bool_t equilibria_only);
 void close_Background();
 
+void   initBackgroundTable_p(void);
+bool_t setBackgroundTable_p(void);
+void   tableHminus_p(int nspect, double *chi);
+void   tableFreeFree_p(int nspect, double *chi);
+void   fusedContinuum_p(int nspect, double *thomson, double *chi,
+			double *eta, double *chi_ai, double *eta_ai,
+			double *sca_ai);
+
 void writeJlambda_single(int nspect, double *J);
 void writeJ20_single(int nspect, double *J);
 void readJlambda_single(int nspect, double *J);
 void readJ20_single(int nspect, double *J);
 
-void initSolution_p(void);
+void initSolution_p(Column *col);
+void saveWarmStart_p(Column *col);
 
 void distribute_jobs(void);
+void order_tasks(void);
 void finish_jobs(void);
 void readConvergence(void);
 
@@ -44,39 +70,50 @@ void init_hdf5_indata_new(void);
 void init_hdf5_indata_existing(void);
 void close_hdf5_indata(void);
 void writeAtmos_all(void);
-void writeAtmos_p(void);
+void writeAtmos_p(Column *col);
 void writeMPI_all(void);
-void writeMPI_p(int task);
+void writeMPI_p(Column *col, int task);
 
 void init_hdf5_aux(void);
 void init_aux_new(void);
 void init_aux_existing(void);
 void close_hdf5_aux(void);
 void writeAux_all(void);
-void writeAux_p(void);
+void writeAux_p(Column *col);
+void readPopulations_p(Column *col, struct Atom *atom);
+void readMolPops_p(Column *col, struct Molecule *molecule);
 void writeOpacity_p(void);
+void init_prev_pops(void);
+void close_prev_pops(void);
+void copyReused(void);
 
+void setColumn(Column *col, long task, long slot);
 void initParallel(int *argc, char **argv[], bool_t run_ray);
 void initParallelIO(bool_t run_ray, bool_t writej);
 void closeParallelIO(bool_t run_ray, bool_t writej);
-void UpdateAtmosDep(void);
+void UpdateAtmosDep(Column *col);
 void RequestStop_p(void);
 bool_t StopRequested_p(void);
 void ERR(int ierror, const char *rname);
 void HERR(const char *rname);
-void copyBufVars(bool_t writej);
+void copyBufVars(Column *col, bool_t writej);
 void writeOutput(bool_t writej); 
 
-void Iterate_p(int NmaxIter, double iterLimit);
+void Iterate_p(Column *col, int NmaxIter, double iterLimit);
+void writeCheckpoint_p(Column *col, int niter, double cswitch);
+int  readCheckpoint_p(Column *col, double *cswitch);
+void removeCheckpoint_p(Column *col);
 double solveSpectrum_p(bool_t eval_operator, bool_t redistribute);
 
 void SolveLinearEq_p(int N, double **A, double *b, bool_t improve);
 
 
+#define MPI_THREADS_ENV     "RH15D_MPI_THREADS"
 #define MPILOG_TEMPLATE     "scratch/rh_p%d.log"
 #define RAY_MPILOG_TEMPLATE "scratch/solveray_p%d.log"
 #define PRD_FILE_TEMPLATE   "scratch/PRD_%s_%d-%d_p%d.dat"
 #define PRD_FILE_TEMPLATE1  "scratch/PRD_%.1s_%d-%d_p%d.dat"
+#define CHECKPOINT_FILE_TEMPLATE "scratch/checkpoint_%d-%d.dat"
 
 #endif /* !__PARALLEL_H__ */
 
@@ -85,16 +85,30 @@ void init_atmos(Atmosphere *atmos, Geometry *geometry, Input_Atmos_file *infile)
 }
 
 
-void readAtmos(int xi, int yi, Atmosphere *atmos, Geometry *geometry,
-                Input_Atmos_file *infile) {
-    /* Select read_atmos routine */
+void readAtmos(Column *col, Atmosphere *atmos, Geometry *geometry,
+               Input_Atmos_file *infile) {
+    /* Select read_atmos routine, for grid point (col->xi, col->yi).
+       Sets the depth cut col->zcut */
     switch (geometry->atmos_format) {
         case HDF5:
-            readAtmos_hdf5(xi, yi, atmos, geometry, infile);
+            readAtmos_hdf5(col, atmos, geometry, infile);
             break;
         case MULTI:
             /* Read again for consistency purposes */
             readAtmos_multi(atmos, geometry, infile);
+            col->zcut = 0;  /* Disabled for MULTI atmospheres */
+            break;
+        default:
+            break;
+    }
+}
+
+
+void prefetchAtmos(int xi, int yi, Geometry *geometry) {
+    /* Select routine to read column (xi, yi) ahead, if any */
+    switch (geometry->atmos_format) {
+        case HDF5:
+            prefetchAtmos_hdf5(xi, yi);
             break;
         default:
             break;
@@ -115,14 +129,16 @@ void close_atmos(Atmosphere *atmos, Geometry *geometry,
 }
 
 
-void setTcut(Atmosphere *atmos, Geometry *geometry, double Tmax) {
+void setTcut(Column *col, Atmosphere *atmos, Geometry *geometry,
+             double Tmax) {
   /* Find the point where temperature (in TR region) gets below Tmax,
      set atmos.Nspace to remaining points, repoint all the atmospheric
-     quantities to start at that point.  */
+     quantities to start at that point. The cut point is kept in
+     col->zcut. */
   const char routineName[] = "setTcut";
   int   i, cutpoint;
 
-  mpi.zcut =  0;
+  col->zcut =  0;
   if (Tmax < 0) return; /* Do nothing when Tmax < 0 */
   cutpoint = -1;
   for (i=0; i < atmos->Nspace; i++) {
@@ -136,10 +152,10 @@ void setTcut(Atmosphere *atmos, Geometry *geometry, double Tmax) {
 	    "\n-Could not find temperature cut point! Aborting.\n");
     Error(ERROR_LEVEL_2, routineName, messageStr);
   }
-  mpi.zcut = cutpoint;
+  col->zcut = cutpoint;
   /* subtract from total number of points */
-  atmos->Nspace  -= mpi.zcut;
-  geometry->Ndep -= mpi.zcut;
+  atmos->Nspace  -= col->zcut;
+  geometry->Ndep -= col->zcut;
   /* Reallocate arrays of Nspace */
   realloc_ndep(atmos, geometry);
 }
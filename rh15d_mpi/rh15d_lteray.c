@@ -25,7 +25,7 @@
 
 /* --- Function prototypes --                          -------------- */
 void init_hdf5_ray(void);
-void writeRay(void);
+void writeRay(Column *col);
 void close_hdf5_ray(void);
 
 /* --- Global variables --                             -------------- */
@@ -57,6 +57,7 @@ int main(int argc, char *argv[])
   double muz;
   Atom *atom;
   FILE   *fp_ray;
+  Column  col;
 
   char inputLine[MAX_LINE_SIZE];
 
@@ -77,15 +78,21 @@ int main(int argc, char *argv[])
   readInput();
   spectrum.updateJ = FALSE;
 
+  /* Input files are read by one process for all, until set up */
+  if (input.p15d_bcast) setInputBcast_p(mpi.comm);
+
   getCPU(1, TIME_START, NULL);
   init_atmos(&atmos, &geometry, &infile);
 
+  /* No iterations to save, so no columns copied from a previous run */
+  input.p15d_reuse_tol = 0.0;
+
   /* Find out the work load for each process */
   distribute_jobs();
 
   /* --- Read ray.input --                            --------------- */
   /* --- Read direction cosine for ray --              -------------- */
-  if ((fp_ray = fopen(RAY_INPUT_FILE, "r")) == NULL) {
+  if ((fp_ray = fopenInput(RAY_INPUT_FILE)) == NULL) {
     sprintf(messageStr, "Unable to open inputfile %s", RAY_INPUT_FILE);
     Error(ERROR_LEVEL_2, argv[0], messageStr);
   }
@@ -133,7 +140,8 @@ int main(int argc, char *argv[])
 
   atmos.moving = TRUE;  /* To prevent moving change from column [0, 0] */
    /* Read first atmosphere column just to get dimensions */
-  readAtmos(0, 0, &atmos, &geometry, &infile);
+  col.xi = col.yi = 0;
+  readAtmos(&col, &atmos, &geometry, &infile);
   readAtomicModels();
   readMolecularModels();
   SortLambda();
@@ -146,6 +154,7 @@ int main(int argc, char *argv[])
 
   /* --- START stuff from initParallelIO, just getting the needed parts --- */
   init_Background();
+  setInputBcast_p(MPI_COMM_NULL);
   mpi.StokesMode_save = input.StokesMode;
 
   /* Get file position of atom files (to re-read collisions) */
@@ -164,28 +173,31 @@ int main(int argc, char *argv[])
   /* Main loop over tasks */
   for (mpi.task = 0; mpi.task < mpi.Ntasks; mpi.task++) {
 
-    /* Indices of x and y */
-    mpi.ix = mpi.taskmap[mpi.task + mpi.my_start][0];
-    mpi.iy = mpi.taskmap[mpi.task + mpi.my_start][1];
+    setColumn(&col, mpi.task + mpi.my_start, mpi.task);
+    col.isfirst = FALSE;
 
     /* Printout some info */
     sprintf(messageStr,
       "Process %4d: --- START task %3ld [of %ld], (xi,yi) = (%3d,%3d)\n",
-       mpi.rank, mpi.task+1, mpi.Ntasks, mpi.xnum[mpi.ix], mpi.ynum[mpi.iy]);
+       mpi.rank, mpi.task+1, mpi.Ntasks, col.xi, col.yi);
     fprintf(mpi.main_logfile, messageStr);
     Error(MESSAGE, "main", messageStr);
 
-    /* Read atmosphere column */
-    readAtmos(mpi.xnum[mpi.ix],mpi.ynum[mpi.iy], &atmos, &geometry, &infile);
+    /* Read atmosphere column, and the next one ahead */
+    if (mpi.task + 1 < mpi.Ntasks)
+      prefetchAtmos(mpi.xnum[mpi.taskmap[mpi.task + mpi.my_start + 1][0]],
+                    mpi.ynum[mpi.taskmap[mpi.task + mpi.my_start + 1][1]],
+                    &geometry);
+    readAtmos(&col, &atmos, &geometry, &infile);
 
     /* Update quantities that depend on atmosphere and initialise others */
-    UpdateAtmosDep();
+    UpdateAtmosDep(&col);
 
     /* --- Calculate background opacities --             ------------- */
     Background_p(write_analyze_output=FALSE, equilibria_only=FALSE);
 
     getProfiles();
-    initSolution_p();
+    initSolution_p(&col);
     initScatter();
 
     getCPU(1, TIME_POLL, "Total Initialize");
@@ -193,7 +205,7 @@ int main(int argc, char *argv[])
     /* --- Solve radiative transfer equations --         -------------- */
     solveSpectrum(FALSE, FALSE);
     /* --- Write emergent spectrum to output file --     -------------- */
-    writeRay();
+    writeRay(&col);
 
     sprintf(messageStr,
       "Process %4d: *** END   task %3ld\n",
@@ -213,6 +225,7 @@ int main(int argc, char *argv[])
   /* --- Stuff that was on closeParallelIO --- */
   close_atmos(&atmos, &geometry, &infile);
   free(io.atom_file_pos);
+  closeShards_p();
   /* --- END of stuff from closeParallelIO ---*/
 
   close_hdf5_ray();
@@ -0,0 +1,273 @@
+/* ------- file: -------------------------- rh15d_merge.c -----------
+
+       Version:       rh2.0, 1.5-D plane-parallel
+       Last modified: Sun Oct 18 2026 --
+
+       --------------------------                      ----------RH-- */
+
+/* --- Merges the output shards of a run with 15D_SHARDS into the
+       shared output files. Run from the directory of the run, with as
+       many processes as wanted:
+
+         mpirun -np 8 rh15d_merge [-d] [file ...]
+
+       Without file arguments the ray, aux and input data files are
+       merged. All shards found next to a file are merged, each
+       process copying the columns of every size-th one with
+       independent writes into the shared file opened with MPI-IO.
+       Ranks of the run without a shard, the overlord or a process
+       that got no columns, are listed. With -d the shards are
+       removed once all are merged.
+                                                          --------- */
+
+#include <glob.h>
+#include <mpi.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "io.h"
+
+#define NAME_LENGTH 512
+
+
+/* --- Columns of one shard, copied into the shared file dst -- */
+
+typedef struct {
+  hid_t          dst;
+  int            axis, nx, ny;
+  unsigned char *cols;
+} MergeData;
+
+
+/* --- Global variables --                             -------------- */
+
+static int rank, size;
+
+
+/* ------- begin -------------------------- MERR.c ----------------- */
+static void MERR(const char *rname, const char *message)
+{
+  fprintf(stderr, "Process %4d: (EEE) %s: %s\n", rank, rname,
+	  (message) ? message : "HDF5 error.");
+  MPI_Abort(MPI_COMM_WORLD, 2);
+}
+/* ------- end   -------------------------- MERR.c ----------------- */
+
+/* ------- begin -------------------------- merge_dataset.c -------- */
+static herr_t merge_dataset(hid_t ncid, const char *name,
+                            const H5O_info_t *info, void *op_data)
+/* H5Ovisit callback: copies the shard columns of dataset name */
+{
+  const char routineName[] = "merge_dataset";
+  MergeData *md = (MergeData *) op_data;
+  char       message[NAME_LENGTH + 64];
+  int        ndim, a;
+  long       i, j;
+  hsize_t    dims[H5S_MAX_RANK], ddims[H5S_MAX_RANK], mdims[1];
+  hsize_t    offset[H5S_MAX_RANK], count[H5S_MAX_RANK];
+  hid_t      src, dst, type, src_dspace, dst_dspace, mem_dspace;
+  void      *buf;
+
+  if ((info->type != H5O_TYPE_DATASET)  ||  !strcmp(name, SHARD_COLS))
+    return 0;
+
+  if (( src = H5Dopen2(ncid, name, H5P_DEFAULT) ) < 0) MERR(routineName, NULL);
+  if (( dst = H5Dopen2(md->dst, name, H5P_DEFAULT) ) < 0) {
+    sprintf(message, "%s is not in the shared file", name);
+    MERR(routineName, message);
+  }
+  if (( src_dspace = H5Dget_space(src) ) < 0) MERR(routineName, NULL);
+  if (( dst_dspace = H5Dget_space(dst) ) < 0) MERR(routineName, NULL);
+  ndim = H5Sget_simple_extent_dims(src_dspace, dims, NULL);
+  if (H5Sget_simple_extent_dims(dst_dspace, ddims, NULL) != ndim) ndim = -1;
+  for (a = 0;  a < ndim;  a++) if (dims[a] != ddims[a]) ndim = -1;
+  if (ndim < md->axis + 2) {
+    sprintf(message, "%s has a different shape in the shared file", name);
+    MERR(routineName, message);
+  }
+
+  /* One column is the full extent of all other axes */
+  mdims[0] = 1;
+  for (a = 0;  a < ndim;  a++) {
+    offset[a] = 0;
+    count[a]  = dims[a];
+    if ((a != md->axis)  &&  (a != md->axis + 1)) mdims[0] *= dims[a];
+  }
+  count[md->axis]     = 1;
+  count[md->axis + 1] = 1;
+  if (( type = H5Dget_type(src) ) < 0) MERR(routineName, NULL);
+  buf = malloc(mdims[0] * H5Tget_size(type));
+  if (( mem_dspace = H5Screate_simple(1, mdims, NULL) ) < 0)
+    MERR(routineName, NULL);
+
+  for (i = 0;  i < md->nx;  i++) {
+    for (j = 0;  j < md->ny;  j++) {
+      if (!md->cols[i * md->ny + j]) continue;
+
+      offset[md->axis]     = i;
+      offset[md->axis + 1] = j;
+      if (( H5Sselect_hyperslab(src_dspace, H5S_SELECT_SET, offset,
+                                NULL, count, NULL) ) < 0) MERR(routineName, NULL);
+      if (( H5Sselect_hyperslab(dst_dspace, H5S_SELECT_SET, offset,
+                                NULL, count, NULL) ) < 0) MERR(routineName, NULL);
+      if (( H5Dread(src, type, mem_dspace, src_dspace,
+                    H5P_DEFAULT, buf) ) < 0) MERR(routineName, NULL);
+      if (( H5Dwrite(dst, type, mem_dspace, dst_dspace,
+                     H5P_DEFAULT, buf) ) < 0) MERR(routineName, NULL);
+    }
+  }
+  free(buf);
+  if (( H5Sclose(mem_dspace) ) < 0) MERR(routineName, NULL);
+  if (( H5Tclose(type) ) < 0) MERR(routineName, NULL);
+  if (( H5Sclose(dst_dspace) ) < 0) MERR(routineName, NULL);
+  if (( H5Sclose(src_dspace) ) < 0) MERR(routineName, NULL);
+  if (( H5Dclose(dst) ) < 0) MERR(routineName, NULL);
+  if (( H5Dclose(src) ) < 0) MERR(routineName, NULL);
+  return 0;
+}
+/* ------- end   -------------------------- merge_dataset.c -------- */
+
+/* ------- begin -------------------------- merge_shard.c ---------- */
+static long merge_shard(const char *shard_name, hid_t dst)
+/* Copies all columns of one shard into dst, returns their number */
+{
+  const char routineName[] = "merge_shard";
+  int       ndim;
+  long      n, Ncols = 0;
+  hsize_t   dims[2];
+  hid_t     ncid;
+  MergeData md;
+
+  if (( ncid = H5Fopen(shard_name, H5F_ACC_RDONLY, H5P_DEFAULT) ) < 0)
+    MERR(routineName, shard_name);
+  if (( H5LTget_attribute_int(ncid, "/", SHARD_AXIS, &md.axis) ) < 0)
+    MERR(routineName, NULL);
+  if (( H5LTget_dataset_ndims(ncid, SHARD_COLS, &ndim) ) < 0  ||  ndim != 2)
+    MERR(routineName, "no column mask, shard was not closed");
+  if (( H5LTget_dataset_info(ncid, SHARD_COLS, dims, NULL, NULL) ) < 0)
+    MERR(routineName, NULL);
+  md.nx   = dims[0];
+  md.ny   = dims[1];
+  md.dst  = dst;
+  md.cols = (unsigned char *) malloc(dims[0] * dims[1]);
+  if (( H5LTread_dataset(ncid, SHARD_COLS, H5T_NATIVE_UCHAR, md.cols) ) < 0)
+    MERR(routineName, NULL);
+  for (n = 0;  n < md.nx * md.ny;  n++) Ncols += md.cols[n];
+
+  if (( H5Ovisit(ncid, H5_INDEX_NAME, H5_ITER_NATIVE, merge_dataset,
+                 &md) ) < 0) MERR(routineName, NULL);
+
+  free(md.cols);
+  if (( H5Fclose(ncid) ) < 0) MERR(routineName, NULL);
+  return Ncols;
+}
+/* ------- end   -------------------------- merge_shard.c ---------- */
+
+/* ------- begin -------------------------- merge_file.c ----------- */
+static void merge_file(const char *file_name, int remove_shards)
+/* Merges all shards of file_name into it */
+{
+  const char routineName[] = "merge_file";
+  char   pattern[NAME_LENGTH + 8], message[2*NAME_LENGTH], *end;
+  int    r, s, nshards, nprocess = -1;
+  long   shard_rank, Ncols = 0, Ntotal;
+  char  *has_shard = NULL;
+  hid_t  plist, ncid;
+  glob_t found;
+
+  /* Every process finds the same shards, sorted by name. A process
+     that computed no columns has no shard, so the shards that exist
+     are merged, not those of ranks 0 .. nshards-1 */
+  sprintf(pattern, "%s.[0-9]*", file_name);
+  if (glob(pattern, 0, NULL, &found) != 0) found.gl_pathc = 0;
+  nshards = found.gl_pathc;
+  if (nshards == 0) {
+    if (rank == 0) printf("--- %s: no shards, skipped\n", file_name);
+    globfree(&found);
+    return;
+  }
+
+  /* All shards must come from the same run: their rank must be below
+     the number of processes each of them records */
+  for (s = 0;  s < nshards;  s++) {
+    shard_rank = strtol(found.gl_pathv[s] + strlen(file_name) + 1, &end, 10);
+    if (*end != '\0') {
+      sprintf(message, "%s is not a shard of %s", found.gl_pathv[s],
+	      file_name);
+      MERR(routineName, message);
+    }
+    if (( ncid = H5Fopen(found.gl_pathv[s], H5F_ACC_RDONLY,
+                         H5P_DEFAULT) ) < 0) MERR(routineName, found.gl_pathv[s]);
+    if (( H5LTget_attribute_int(ncid, "/", SHARD_NUMBER, &nprocess) ) < 0)
+      MERR(routineName, NULL);
+    if (( H5Fclose(ncid) ) < 0) MERR(routineName, NULL);
+    if (has_shard == NULL) has_shard = (char *) calloc(nprocess, 1);
+    if (shard_rank >= nprocess) {
+      sprintf(message, "%s is from a run with more than %d processes",
+	      found.gl_pathv[s], nprocess);
+      MERR(routineName, message);
+    }
+    has_shard[shard_rank] = 1;
+  }
+
+  if (( plist = H5Pcreate(H5P_FILE_ACCESS) ) < 0) MERR(routineName, NULL);
+  if (( H5Pset_fapl_mpio(plist, MPI_COMM_WORLD, MPI_INFO_NULL) ) < 0)
+    MERR(routineName, NULL);
+  if (( ncid = H5Fopen(file_name, H5F_ACC_RDWR, plist) ) < 0)
+    MERR(routineName, file_name);
+  if (( H5Pclose(plist) ) < 0) MERR(routineName, NULL);
+
+  for (s = rank;  s < nshards;  s += size)
+    Ncols += merge_shard(found.gl_pathv[s], ncid);
+  if (( H5Fclose(ncid) ) < 0) MERR(routineName, NULL);
+
+  MPI_Reduce(&Ncols, &Ntotal, 1, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+  if (rank == 0) {
+    printf("--- %s: merged %ld columns from %d shards of a %d process run\n",
+	   file_name, Ntotal, nshards, nprocess);
+    if (nshards < nprocess) {
+      printf("    no shard from rank");
+      for (r = 0;  r < nprocess;  r++)
+	if (!has_shard[r]) printf(" %d", r);
+      printf("\n");
+    }
+  }
+
+  if (remove_shards) {
+    MPI_Barrier(MPI_COMM_WORLD);
+    for (s = rank;  s < nshards;  s += size) remove(found.gl_pathv[s]);
+  }
+  free(has_shard);
+  globfree(&found);
+}
+/* ------- end   -------------------------- merge_file.c ----------- */
+
+/* ------- begin -------------------------- rh15d_merge.c ---------- */
+int main(int argc, char *argv[])
+{
+  const char *files[] = {RAY_FILE, AUX_FILE, INPUTDATA_FILE};
+  int   n, nfiles = 0, remove_shards = 0;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+  for (n = 1;  n < argc;  n++) {
+    if (!strcmp(argv[n], "-d"))
+      remove_shards = 1;
+    else if (strlen(argv[n]) >= NAME_LENGTH)
+      MERR("rh15d_merge", "file name too long");
+    else
+      nfiles++;
+  }
+  for (n = 1;  n < argc;  n++)
+    if (strcmp(argv[n], "-d")) merge_file(argv[n], remove_shards);
+  if (nfiles == 0)
+    for (n = 0;  n < 3;  n++) merge_file(files[n], remove_shards);
+
+  MPI_Finalize();
+  return 0;
+}
+/* ------- end   -------------------------- rh15d_merge.c ---------- */
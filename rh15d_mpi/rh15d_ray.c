@@ -23,10 +23,10 @@
 
 /* --- Function prototypes --                          -------------- */
 void init_hdf5_ray(void);
-void writeRay(void);
+void writeRay(Column *col);
 void close_hdf5_ray(void);
 void calculate_ray(void);
-void writeAtmos_p(void);
+void writeAtmos_p(Column *col);
 
 /* --- Global variables --                             -------------- */
 
@@ -56,6 +56,7 @@ int main(int argc, char *argv[])
          checkPoint, save_Nrays, *wave_index = NULL;
   double muz, save_muz, save_mux, save_muy, save_wmu;
   FILE  *fp_ray;
+  Column col;
 
   char  inputLine[MAX_LINE_SIZE];
 
@@ -75,6 +76,9 @@ int main(int argc, char *argv[])
   readInput();
   spectrum.updateJ = TRUE;
 
+  /* Input files are read by one process for all, until set up */
+  if (input.p15d_bcast) setInputBcast_p(mpi.comm);
+
   getCPU(1, TIME_START, NULL);
   init_atmos(&atmos, &geometry, &infile);
 
@@ -84,7 +88,7 @@ int main(int argc, char *argv[])
 
   /* --- Read ray.input --                            --------------- */
   /* --- Read direction cosine for ray --              -------------- */
-  if ((fp_ray = fopen(RAY_INPUT_FILE, "r")) == NULL) {
+  if ((fp_ray = fopenInput(RAY_INPUT_FILE)) == NULL) {
     sprintf(messageStr, "Unable to open inputfile %s", RAY_INPUT_FILE);
     Error(ERROR_LEVEL_2, argv[0], messageStr);
   }
@@ -123,7 +127,8 @@ int main(int argc, char *argv[])
 
   atmos.moving = TRUE;  /* To prevent moving change from column [0, 0] */
    /* Read first atmosphere column just to get dimensions */
-  readAtmos(0, 0, &atmos, &geometry, &infile);
+  col.xi = col.yi = 0;
+  readAtmos(&col, &atmos, &geometry, &infile);
 
   if (atmos.Stokes) Bproject();
 
@@ -143,52 +148,55 @@ int main(int argc, char *argv[])
   }
 
   initParallelIO(run_ray=FALSE, writej=FALSE);
+  setInputBcast_p(MPI_COMM_NULL);
   init_hdf5_ray();
+  copyReused();
 
   /* Main loop over tasks */
   for (mpi.task = 0; mpi.task < mpi.Ntasks; mpi.task++) {
 
-    mpi.isfirst = (mpi.task == 0);
+    setColumn(&col, mpi.task + mpi.my_start, mpi.task);
+    col.isfirst = (mpi.task == 0);
     if (mpi.stop) mpi.stop = FALSE;
 
-    /* Indices of x and y */
-    mpi.ix = mpi.taskmap[mpi.task + mpi.my_start][0];
-    mpi.iy = mpi.taskmap[mpi.task + mpi.my_start][1];
-
     /* Printout some info */
     sprintf(messageStr,
       "Process %4d: --- START task %3ld [of %ld], (xi,yi) = (%3d,%3d)\n",
-       mpi.rank, mpi.task+1, mpi.Ntasks, mpi.xnum[mpi.ix], mpi.ynum[mpi.iy]);
+       mpi.rank, mpi.task+1, mpi.Ntasks, col.xi, col.yi);
     fprintf(mpi.main_logfile, messageStr);
     Error(MESSAGE, "main", messageStr);
 
-    /* Read atmosphere column */
-    readAtmos(mpi.xnum[mpi.ix],mpi.ynum[mpi.iy], &atmos, &geometry, &infile);
+    /* Read atmosphere column, and the next one ahead */
+    if (mpi.task + 1 < mpi.Ntasks)
+      prefetchAtmos(mpi.xnum[mpi.taskmap[mpi.task + mpi.my_start + 1][0]],
+                    mpi.ynum[mpi.taskmap[mpi.task + mpi.my_start + 1][1]],
+                    &geometry);
+    readAtmos(&col, &atmos, &geometry, &infile);
     /* Update quantities that depend on atmosphere and initialise others */
-    UpdateAtmosDep();
+    UpdateAtmosDep(&col);
 
     /* --- Calculate background opacities --             ------------- */
     Background_p(write_analyze_output=TRUE, equilibria_only=FALSE);
 
     getProfiles();
-    initSolution_p();
+    initSolution_p(&col);
     initScatter();
 
     getCPU(1, TIME_POLL, "Total Initialize");
 
     /* --- Solve radiative transfer for active ingredients -- --------- */
-    Iterate_p(input.NmaxIter, input.iterLimit);
+    Iterate_p(&col, input.NmaxIter, input.iterLimit);
 
     /* Treat odd cases as a crash */
-    if (isnan(mpi.dpopsmax[mpi.task]) || isinf(mpi.dpopsmax[mpi.task]) ||
-      	(mpi.dpopsmax[mpi.task] < 0) || ((mpi.dpopsmax[mpi.task] == 0) &&
+    if (isnan(mpi.dpopsmax[col.slot]) || isinf(mpi.dpopsmax[col.slot]) ||
+      	(mpi.dpopsmax[col.slot] < 0) || ((mpi.dpopsmax[col.slot] == 0) &&
         (input.NmaxIter > 0))) mpi.stop = TRUE;
 
     /* In case of crash, write dummy data and proceed to next task */
     if (mpi.stop) {
       sprintf(messageStr,
 	      "Process %4d: *** SKIP  task %3ld (crashed after %d iterations)\n",
-	      mpi.rank, mpi.task+1, mpi.niter[mpi.task]);
+	      mpi.rank, mpi.task+1, mpi.niter[col.slot]);
       fprintf(mpi.main_logfile, messageStr);
       Error(MESSAGE, "main", messageStr);
 
@@ -196,22 +204,22 @@ int main(int argc, char *argv[])
 
       mpi.ncrash++;
       mpi.stop = FALSE;
-      mpi.dpopsmax[mpi.task] = 0.0;
-      mpi.convergence[mpi.task] = -1;
+      mpi.dpopsmax[col.slot] = 0.0;
+      mpi.convergence[col.slot] = -1;
 
       continue;
     }
 
     /* Printout some info, finished iter */
-    if (mpi.convergence[mpi.task]) {
+    if (mpi.convergence[col.slot]) {
       sprintf(messageStr,
        "Process %4d: *** END   task %3ld iter, iterations = %3d, CONVERGED\n",
-       mpi.rank, mpi.task+1, mpi.niter[mpi.task]);
+       mpi.rank, mpi.task+1, mpi.niter[col.slot]);
       mpi.nconv++;
     } else {
       sprintf(messageStr,
        "Process %4d: *** END   task %3ld iter, iterations = %3d, NO convergence\n",
-       mpi.rank, mpi.task+1, mpi.niter[mpi.task]);
+       mpi.rank, mpi.task+1, mpi.niter[col.slot]);
       mpi.nnoconv++;
     }
 
@@ -226,9 +234,9 @@ int main(int argc, char *argv[])
       niter++;
     }
 
-    copyBufVars(writej=FALSE);
+    copyBufVars(&col, writej=FALSE);
 
-    if (mpi.convergence[mpi.task]) {
+    if (mpi.convergence[col.slot]) {
       /* Redefine geometry just for this ray */
       atmos.Nrays     = 1;
       geometry.Nrays  = 1;
@@ -239,7 +247,7 @@ int main(int argc, char *argv[])
       spectrum.updateJ = FALSE;
 
       calculate_ray();
-      writeRay();
+      writeRay(&col);
 
       /* Put back previous values for geometry  */
       atmos.Nrays     = geometry.Nrays = save_Nrays;
@@ -252,7 +260,8 @@ int main(int argc, char *argv[])
 
     /* --- Write output files --                         -------------- */
     getCPU(1, TIME_START, NULL);
-    writeAtmos_p();
+    writeAtmos_p(&col);
+    flushColumn_p();
 
     getCPU(1, TIME_POLL, "Write output");
 
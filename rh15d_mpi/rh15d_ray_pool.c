@@ -16,8 +16,10 @@
 
 #define COMMENT_CHAR    "#"
 #define RAY_INPUT_FILE  "ray.input"
-#define WORKTAG 1
-#define DIETAG 2
+#define WORKTAG  1
+#define DIETAG   2
+#define IDLETAG  3
+#define AHEADTAG 4
 
 #ifndef REV_ID
 #define REV_ID "UNKNOWN"
@@ -25,11 +27,14 @@
 
 /* --- Function prototypes --                          -------------- */
 void init_hdf5_ray(void);
-void writeRay(void);
+void writeRay(Column *col);
 void close_hdf5_ray(void);
 void calculate_ray(void);
 void overlord(void);
 void drone(void);
+void counter(void);
+void do_task(long task);
+long **matrix_long(long Nrow, long Ncol);
 
 /* --- Global variables --                             -------------- */
 
@@ -59,14 +64,13 @@ int main(int argc, char *argv[])
   bool_t run_ray, writej, exit_on_EOF;
   int    i, Nread, Nrequired, checkPoint;
   FILE  *fp_ray;
+  Column col;
 
   char  inputLine[MAX_LINE_SIZE];
 
   /* --- Set up MPI ----------------------             -------------- */
   initParallel(&argc, &argv, run_ray=FALSE);
 
-  mpi.size -= 1; /* Remove overlord from count, as it is not doing work */
-
   setOptions(argc, argv);
   getCPU(0, TIME_START, NULL);
   SetFPEtraps();
@@ -75,23 +79,31 @@ int main(int argc, char *argv[])
   mpi.main_logfile     = commandline.logfile;
   commandline.logfile  = mpi.logfile;
 
-  if (mpi.size == 0) {
-    sprintf(messageStr, "Must run rh15d_ray_pool with more than one process. Aborting.");
-    Error(ERROR_LEVEL_2, argv[0], messageStr);
-  }
-
   strcpy(mpi.rev_id, REV_ID); /* save revision */
 
   /* --- Read input data and initialize --             -------------- */
   readInput();
   spectrum.updateJ = TRUE;
 
+  /* Input files are read by one process for all, until set up */
+  if (input.p15d_bcast) setInputBcast_p(mpi.comm);
+
+  /* With a shared task counter all processes work, otherwise
+     remove overlord from count, as it is not doing work */
+  if (!input.p15d_counter) mpi.size -= 1;
+
+  if (mpi.size == 0) {
+    sprintf(messageStr, "Must run rh15d_ray_pool with more than one process"
+	    " (or set 15D_POOL_COUNTER). Aborting.");
+    Error(ERROR_LEVEL_2, argv[0], messageStr);
+  }
+
   getCPU(1, TIME_START, NULL);
   init_atmos(&atmos, &geometry, &infile);
 
   /* --- Read ray.input --                            --------------- */
   /* --- Read direction cosine for ray --              -------------- */
-  if ((fp_ray = fopen(RAY_INPUT_FILE, "r")) == NULL) {
+  if ((fp_ray = fopenInput(RAY_INPUT_FILE)) == NULL) {
     sprintf(messageStr, "Unable to open inputfile %s", RAY_INPUT_FILE);
     Error(ERROR_LEVEL_2, argv[0], messageStr);
   }
@@ -132,9 +144,13 @@ int main(int argc, char *argv[])
   distribute_jobs();
   mpi.Ntasks = 1;
 
+  /* Largest columns first, if requested */
+  order_tasks();
+
   atmos.moving = TRUE;  /* To prevent moving change from column [0, 0] */
   /* Read first atmosphere column just to get dimensions */
-  readAtmos(0, 0, &atmos, &geometry, &infile);
+  col.xi = col.yi = 0;
+  readAtmos(&col, &atmos, &geometry, &infile);
 
   if (atmos.Stokes) Bproject();
 
@@ -154,12 +170,18 @@ int main(int argc, char *argv[])
     }
 
   initParallelIO(run_ray=FALSE, writej=FALSE);
+  setInputBcast_p(MPI_COMM_NULL);
   init_hdf5_ray();
+  copyReused();
 
   /*//////////////////////
   ////////////////////////
   //////////////////////*/
-  if (mpi.rank == 0) {
+  if (input.p15d_counter) {
+
+    counter();
+
+  } else if (mpi.rank == 0) {
 
     overlord();
 
@@ -197,197 +219,266 @@ int main(int argc, char *argv[])
 
 /* ------- start ---------------------------- overlord.c ------------ */
 void overlord(void) {
-  MPI_Status status;
-  int result;
-  long rank, current_task=0;
-
-  if (mpi.total_tasks == 1) {
-      /* Send task to first process */
-      MPI_Sendrecv(&current_task, 1, MPI_LONG, 1, WORKTAG,
-		   &result, 1, MPI_INT, 1, MPI_ANY_TAG,
-		   MPI_COMM_WORLD, &status);
-      /* Tell all the drones to exit by sending an empty message with the DIETAG. */
-     for (rank = 1; rank <= mpi.size; ++rank) {
-       MPI_Ssend(0, 0, MPI_INT, rank, DIETAG, MPI_COMM_WORLD);
-     }
-  } else {
-    /* Seed the drones; send one unit of work to each drone. */
-    for (rank = 1; rank <= mpi.size; ++rank) {
-      if (rank > mpi.total_tasks)
-	break;
-
-      /* Send it to each rank */
-      MPI_Ssend(&current_task, 1, MPI_LONG, rank, WORKTAG, MPI_COMM_WORLD);
-      ++current_task;
-    }
-
-    /* Loop over getting new work requests until there is no more work to be done */
-    while (current_task < mpi.total_tasks) {
-      /* Receive results from a drone */
-      MPI_Recv(&result, 1, MPI_INT, MPI_ANY_SOURCE, MPI_ANY_TAG,
-	       MPI_COMM_WORLD, &status);
-      /* Send the drone a new work unit */
-      MPI_Ssend(&current_task, 1, MPI_LONG, status.MPI_SOURCE, WORKTAG,
-	        MPI_COMM_WORLD);
-      /* Get the next unit of work to be done */
-      ++current_task;
-    }
-
-    /* There's no more work to be done, so receive all the outstanding results
-       from the drones. */
-    for (rank = 1; rank <= mpi.size; ++rank) {
-      if (rank > mpi.total_tasks)
-	break;
-      MPI_Recv(&result, 1, MPI_INT, MPI_ANY_SOURCE,
-	       MPI_ANY_TAG, MPI_COMM_WORLD, &status);
-    }
-
-    /* Tell all the drones to exit by sending an empty message with the DIETAG. */
-    for (rank = 1; rank <= mpi.size; ++rank) {
-      MPI_Ssend(0, 0, MPI_INT, rank, DIETAG, MPI_COMM_WORLD);
+  /* Hands out tasks to the drones in chunks. The chunk size decreases
+     as the work runs out (guided scheduling), from input.p15d_chunk
+     down to a single column. Drones ask for their next chunk while
+     still working on their last column (AHEADTAG); these requests are
+     only granted while there is plenty of work left, so that no
+     column is left waiting behind a busy drone at the end of the run.
+     Idle drones (IDLETAG) always get work, or are told to exit.     */
+  MPI_Status   status;
+  MPI_Request *sendreq;
+  int          result, ndead = 0;
+  long         rank, i, n, maxchunk, remain, current_task = 0, **sendbuf;
+
+  maxchunk = MAX(1, input.p15d_chunk);
+  sendbuf  = matrix_long(mpi.size + 1, maxchunk);
+  sendreq  = (MPI_Request *) malloc((mpi.size + 1) * sizeof(MPI_Request));
+  for (rank = 0; rank <= mpi.size; ++rank) sendreq[rank] = MPI_REQUEST_NULL;
+
+  /* Loop over work requests until all the drones have been sent home */
+  while (ndead < mpi.size) {
+    MPI_Recv(&result, 1, MPI_INT, MPI_ANY_SOURCE, MPI_ANY_TAG,
+	     MPI_COMM_WORLD, &status);
+    rank   = status.MPI_SOURCE;
+    remain = mpi.total_tasks - current_task;
+
+    /* Make sure previous message to this drone has gone out */
+    MPI_Wait(&sendreq[rank], MPI_STATUS_IGNORE);
+
+    if ((status.MPI_TAG == AHEADTAG) && (remain <= mpi.size)) {
+      /* Not enough work left to queue ahead, send empty chunk */
+      MPI_Isend(sendbuf[rank], 0, MPI_LONG, rank, WORKTAG,
+		MPI_COMM_WORLD, &sendreq[rank]);
+    } else if (remain > 0) {
+      n = MIN(maxchunk, MAX(1, remain / (2 * mpi.size)));
+      for (i = 0; i < n; i++) sendbuf[rank][i] = current_task++;
+      MPI_Isend(sendbuf[rank], n, MPI_LONG, rank, WORKTAG,
+		MPI_COMM_WORLD, &sendreq[rank]);
+    } else {
+      /* No more work to be done, tell the drone to exit */
+      MPI_Isend(0, 0, MPI_LONG, rank, DIETAG, MPI_COMM_WORLD, &sendreq[rank]);
+      ndead++;
     }
   }
+  MPI_Waitall(mpi.size + 1, sendreq, MPI_STATUSES_IGNORE);
+
+  freeMatrix((void **) sendbuf);
+  free(sendreq);
 }
 /* ------- end   ---------------------------- overlord.c ------------ */
 
 /* ------- start ---------------------------- drone.c --------------- */
 void drone(void) {
-  MPI_Status status;
-  bool_t write_analyze_output, equilibria_only;
-  int niter, result=1;
-  long task=1;
-
-  mpi.isfirst = TRUE;
+  /* Keeps a queue of task indices. When the last task in the queue is
+     started, the next chunk is requested with non-blocking calls, so
+     that it has arrived by the time the column is finished.         */
+  MPI_Status  status;
+  MPI_Request recvreq = MPI_REQUEST_NULL, sendreq = MPI_REQUEST_NULL;
+  bool_t      pending = FALSE;
+  int         result = 1, nwork = 0, iwork = 0, nrecv;
+  long        maxchunk, task = 1, *work, *next;
+
+  maxchunk = MAX(1, input.p15d_chunk);
+  work = (long *) malloc(maxchunk * sizeof(long));
+  next = (long *) malloc(maxchunk * sizeof(long));
 
   /* Main loop over tasks */
   while (1) {
-      if (mpi.stop) mpi.stop = FALSE;
-
-      /* Receive a message from the overlord */
-      MPI_Recv(&mpi.task, 1, MPI_LONG, 0, MPI_ANY_TAG,
-               MPI_COMM_WORLD, &status);
+    if (iwork == nwork) {
+      /* Queue is empty: wait for chunk asked ahead, or ask for one now */
+      if (!pending) {
+	MPI_Wait(&sendreq, MPI_STATUS_IGNORE);
+	MPI_Irecv(next, maxchunk, MPI_LONG, 0, MPI_ANY_TAG,
+		  MPI_COMM_WORLD, &recvreq);
+	MPI_Isend(&result, 1, MPI_INT, 0, IDLETAG, MPI_COMM_WORLD, &sendreq);
+      }
+      MPI_Wait(&recvreq, &status);
+      pending = FALSE;
 
       /* Check the tag of the received message. */
-      if (status.MPI_TAG == DIETAG) return;
+      if (status.MPI_TAG == DIETAG) break;
 
-      ++task;
+      MPI_Get_count(&status, MPI_LONG, &nrecv);
+      if (nrecv == 0) continue;  /* Nothing queued ahead, ask again */
+      SWAPPOINTER(work, next);
+      nwork = nrecv;
+      iwork = 0;
+    }
+    mpi.task = work[iwork++];
+    if (iwork < nwork)
+      prefetchAtmos(mpi.xnum[mpi.taskmap[work[iwork]][0]],
+                    mpi.ynum[mpi.taskmap[work[iwork]][1]], &geometry);
+
+    /* Starting last task in the queue, ask for the next chunk */
+    if (iwork == nwork) {
+      MPI_Wait(&sendreq, MPI_STATUS_IGNORE);
+      MPI_Irecv(next, maxchunk, MPI_LONG, 0, MPI_ANY_TAG,
+		MPI_COMM_WORLD, &recvreq);
+      MPI_Isend(&result, 1, MPI_INT, 0, AHEADTAG, MPI_COMM_WORLD, &sendreq);
+      pending = TRUE;
+    }
+    ++task;
 
-      /* Do the work */
+    do_task(task);
+  }
+  MPI_Wait(&sendreq, MPI_STATUS_IGNORE);
 
-      /* Indices of x and y */
-      mpi.ix = mpi.taskmap[mpi.task][0];
-      mpi.iy = mpi.taskmap[mpi.task][1];
+  free(work);
+  free(next);
+}
+/* ------- end   ---------------------------- drone.c --------------- */
+
+/* ------- start ---------------------------- counter.c ------------- */
+void counter(void) {
+  /* Scheduling without an overlord: every process, including rank 0,
+     claims its next task by atomically incrementing a counter that
+     lives in an RMA window on rank 0 (MPI_Fetch_and_op). Tasks are
+     claimed one at a time, so the order of mpi.taskmap is kept.     */
+  MPI_Win  win;
+  MPI_Aint winsize;
+  long     count = 0, one = 1, claim, task = 1;
+
+  winsize = (mpi.rank == 0) ? sizeof(long) : 0;
+  MPI_Win_create(&count, winsize, sizeof(long), MPI_INFO_NULL,
+		 mpi.comm, &win);
+  MPI_Win_lock_all(0, win);
 
-      /* To use only first element of Ntasks arrays, set mpi.task to zero */
-      mpi.task = 0;
+  /* Main loop over tasks */
+  while (1) {
+    MPI_Fetch_and_op(&one, &claim, MPI_LONG, 0, 0, MPI_SUM, win);
+    MPI_Win_flush(0, win);
+    if (claim >= mpi.total_tasks) break;
 
-      /* Printout some info */
-      sprintf(messageStr,
-        "Process %4d: --- START task %3ld, (xi,yi) = (%3d,%3d)\n",
-         mpi.rank, task-1, mpi.xnum[mpi.ix], mpi.ynum[mpi.iy]);
-      fprintf(mpi.main_logfile, messageStr);
-      Error(MESSAGE, "main", messageStr);
+    mpi.task = claim;
+    ++task;
 
-      /* Read atmosphere column */
-      readAtmos(mpi.xnum[mpi.ix],mpi.ynum[mpi.iy], &atmos, &geometry, &infile);
+    do_task(task);
+  }
+  MPI_Win_unlock_all(win);
+  MPI_Win_free(&win);
+}
+/* ------- end   ---------------------------- counter.c ------------- */
 
-      /* Update quantities that depend on atmosphere and initialise others */
-      UpdateAtmosDep();
+/* ------- start ---------------------------- do_task.c ------------- */
+void do_task(long task) {
+  /* Calculates the column given by taskmap[mpi.task] and writes output */
+  static bool_t isfirst = TRUE;
+  bool_t write_analyze_output, equilibria_only;
+  int niter;
+  Column col;
 
-      /* --- Calculate background opacities --             ------------- */
-      Background_p(write_analyze_output=TRUE, equilibria_only=FALSE);
+  if (mpi.stop) mpi.stop = FALSE;
 
-      getProfiles();
-      initSolution_p();
-      initScatter();
+  /* Only first element of Ntasks arrays is used, the column gets slot 0 */
+  setColumn(&col, mpi.task, 0);
+  col.isfirst = isfirst;
 
-      mpi.isfirst = FALSE; /* Put down here because initSolution_p uses it */
+  /* Printout some info */
+  sprintf(messageStr,
+    "Process %4d: --- START task %3ld, (xi,yi) = (%3d,%3d)\n",
+     mpi.rank, task-1, col.xi, col.yi);
+  fprintf(mpi.main_logfile, messageStr);
+  Error(MESSAGE, "main", messageStr);
 
-      getCPU(1, TIME_POLL, "Total Initialize");
+  /* Read atmosphere column */
+  readAtmos(&col, &atmos, &geometry, &infile);
 
-      /* --- Solve radiative transfer for active ingredients -- --------- */
-      Iterate_p(input.NmaxIter, input.iterLimit);
+  /* Update quantities that depend on atmosphere and initialise others */
+  UpdateAtmosDep(&col);
 
-      /* Treat odd cases as a crash */
-      if (isnan(mpi.dpopsmax[mpi.task]) || isinf(mpi.dpopsmax[mpi.task]) ||
-	  (mpi.dpopsmax[mpi.task] < 0) || ((mpi.dpopsmax[mpi.task] == 0) && (input.NmaxIter > 0)))
-        mpi.stop = TRUE;
+  /* --- Calculate background opacities --             ------------- */
+  Background_p(write_analyze_output=TRUE, equilibria_only=FALSE);
 
+  getProfiles();
+  initSolution_p(&col);
+  initScatter();
 
-    /* In case of crash, write dummy data and proceed to next task */
-    if (mpi.stop) {
-      sprintf(messageStr,
-	      "Process %4d: *** SKIP  task %3ld (crashed after %d iterations)\n",
-	      mpi.rank, task-1, mpi.niter[mpi.task]);
-      fprintf(mpi.main_logfile, messageStr);
-      Error(MESSAGE, "main", messageStr);
+  isfirst = FALSE;
 
-      close_Background();  /* To avoid many open files */
+  getCPU(1, TIME_POLL, "Total Initialize");
 
-      mpi.ncrash++;
-      mpi.stop = FALSE;
-      mpi.dpopsmax[mpi.task] = 0.0;
-      mpi.convergence[mpi.task] = -1;
+  /* --- Solve radiative transfer for active ingredients -- --------- */
+  Iterate_p(&col, input.NmaxIter, input.iterLimit);
 
-      /* Write MPI output and send result to overlord*/
-      writeMPI_p(task);
-      MPI_Send(&result, 1, MPI_INT, 0, 0, MPI_COMM_WORLD);
-      continue;
-    }
+  /* Treat odd cases as a crash */
+  if (isnan(mpi.dpopsmax[col.slot]) || isinf(mpi.dpopsmax[col.slot]) ||
+      (mpi.dpopsmax[col.slot] < 0) || ((mpi.dpopsmax[col.slot] == 0) && (input.NmaxIter > 0)))
+    mpi.stop = TRUE;
 
-    /* Printout some info, finished iter */
-    if (mpi.convergence[mpi.task]) {
-      sprintf(messageStr,
-       "Process %4d: *** END   task %3ld iter, iterations = %3d, CONVERGED\n",
-       mpi.rank, task-1, mpi.niter[mpi.task]);
-      mpi.nconv++;
-    } else {
-      sprintf(messageStr,
-       "Process %4d: *** END   task %3ld iter, iterations = %3d, NO convergence\n",
-       mpi.rank, task-1, mpi.niter[mpi.task]);
-      mpi.nnoconv++;
-    }
 
+  /* In case of crash, write dummy data and proceed to next task */
+  if (mpi.stop) {
+    sprintf(messageStr,
+	    "Process %4d: *** SKIP  task %3ld (crashed after %d iterations)\n",
+	    mpi.rank, task-1, mpi.niter[col.slot]);
     fprintf(mpi.main_logfile, messageStr);
     Error(MESSAGE, "main", messageStr);
 
-    /* Lambda iterate mean radiation field */
-    adjustStokesMode();
-    niter = 0;
-    while (niter < input.NmaxScatter) {
-      if (solveSpectrum(FALSE, FALSE) <= input.iterLimit) break;
-      niter++;
-    }
+    close_Background();  /* To avoid many open files */
 
-    if (mpi.convergence[mpi.task]) {
-      /* Make sure aux written before ray redefined */
-      writeAux_p();
-      writeAtmos_p();
-      /* Redefine geometry just for this ray */
-      atmos.Nrays     = 1;
-      geometry.Nrays  = 1;
-      geometry.muz[0] = muz;
-      geometry.mux[0] = sqrt(1.0 - SQ(geometry.muz[0]));
-      geometry.muy[0] = 0.0;
-      geometry.wmu[0] = 1.0;
-      spectrum.updateJ = FALSE;
-
-      calculate_ray();
-      writeRay();
-
-      /* Put back previous values for geometry  */
-      atmos.Nrays     = geometry.Nrays = save_Nrays;
-      geometry.muz[0] = save_muz;
-      geometry.mux[0] = save_mux;
-      geometry.muy[0] = save_muy;
-      geometry.wmu[0] = save_wmu;
-      spectrum.updateJ = TRUE;
-    }
+    mpi.ncrash++;
+    mpi.stop = FALSE;
+    mpi.dpopsmax[col.slot] = 0.0;
+    mpi.convergence[col.slot] = -1;
+
+    /* Write MPI output */
+    writeMPI_p(&col, task);
+    syncWriteQueue_p();
+    return;
+  }
 
-    /* --- Write output MPI group, send result to overlord ---------- */
-    writeMPI_p(task);
-    MPI_Send(&result, 1, MPI_INT, 0, 0, MPI_COMM_WORLD);
+  /* Printout some info, finished iter */
+  if (mpi.convergence[col.slot]) {
+    sprintf(messageStr,
+     "Process %4d: *** END   task %3ld iter, iterations = %3d, CONVERGED\n",
+     mpi.rank, task-1, mpi.niter[col.slot]);
+    mpi.nconv++;
+  } else {
+    sprintf(messageStr,
+     "Process %4d: *** END   task %3ld iter, iterations = %3d, NO convergence\n",
+     mpi.rank, task-1, mpi.niter[col.slot]);
+    mpi.nnoconv++;
+  }
+
+  fprintf(mpi.main_logfile, messageStr);
+  Error(MESSAGE, "main", messageStr);
+
+  /* Lambda iterate mean radiation field */
+  adjustStokesMode();
+  niter = 0;
+  while (niter < input.NmaxScatter) {
+    if (solveSpectrum(FALSE, FALSE) <= input.iterLimit) break;
+    niter++;
+  }
+
+  if (mpi.convergence[col.slot]) {
+    /* Make sure aux written before ray redefined */
+    writeAux_p(&col);
+    writeAtmos_p(&col);
+    /* Redefine geometry just for this ray */
+    atmos.Nrays     = 1;
+    geometry.Nrays  = 1;
+    geometry.muz[0] = muz;
+    geometry.mux[0] = sqrt(1.0 - SQ(geometry.muz[0]));
+    geometry.muy[0] = 0.0;
+    geometry.wmu[0] = 1.0;
+    spectrum.updateJ = FALSE;
+
+    calculate_ray();
+    writeRay(&col);
+
+    /* Put back previous values for geometry  */
+    atmos.Nrays     = geometry.Nrays = save_Nrays;
+    geometry.muz[0] = save_muz;
+    geometry.mux[0] = save_mux;
+    geometry.muy[0] = save_muy;
+    geometry.wmu[0] = save_wmu;
+    spectrum.updateJ = TRUE;
+  }
 
-  } /* End of main task loop */
+  /* --- Write output MPI group --                     ------------- */
+  writeMPI_p(&col, task);
+  flushColumn_p();
 }
-/* ------- end   ---------------------------- drone.c ------------ */
+/* ------- end   ---------------------------- do_task.c ------------- */
@@ -0,0 +1,197 @@
+/* ------- file: -------------------------- shard_p.c ---------------
+
+       Version:       rh2.0, 1.5-D plane-parallel
+       Last modified: Sun Oct 18 2026 --
+
+       --------------------------                      ----------RH-- */
+
+/* --- Sharded output (15D_SHARDS). Each process writes the columns it
+       calculates into its own shard of every output file, named with
+       SHARD_TEMPLATE after the shared file, instead of into the shared
+       file itself. The shared files are still created as usual and
+       hold everything that is not per column; rh15d_merge copies the
+       columns of all shards into them after the run.
+
+       A shard dataset has the path, type, shape and fill value of the
+       shared dataset it stands for, but is chunked by column so that
+       only the columns of this process take up space. It is created
+       when the first column is written to it. At the end SHARD_COLS
+       marks the columns the shard holds.
+                                                          --------- */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "rh.h"
+#include "error.h"
+#include "inputs.h"
+#include "parallel.h"
+#include "io.h"
+
+#define SHARD_MAXFILE 3
+
+
+/* --- Shard of one output file --                     -------------- */
+
+typedef struct {
+  char           name[MAX_LINE_SIZE];
+  hid_t          ncid;
+  int            axis;
+  unsigned char *cols;
+} ShardFile;
+
+/* --- Shard dataset dst of the shared dataset src -- -------------- */
+
+typedef struct {
+  hid_t      src, dst;
+  ShardFile *file;
+} ShardDset;
+
+
+/* --- Global variables --                             -------------- */
+
+extern InputData input;
+extern char messageStr[];
+extern MPI_data mpi;
+
+static int        Nfile = 0, Ndset = 0, Nalloc = 0;
+static ShardFile  shard[SHARD_MAXFILE];
+static ShardDset *sdset = NULL;
+
+
+/* ------- begin -------------------------- shardFile.c ------------ */
+static ShardFile *shardFile(hid_t dset)
+/* Returns the shard of the file of dset, creating it if needed */
+{
+  const char routineName[] = "shardFile";
+  char       name[MAX_LINE_SIZE], shard_name[MAX_LINE_SIZE + 8];
+  int        n, Nprocess;
+  ShardFile *sf;
+
+  if (H5Fget_name(dset, name, MAX_LINE_SIZE) < 0) HERR(routineName);
+  for (n = 0;  n < Nfile;  n++)
+    if (!strcmp(shard[n].name, name)) return &shard[n];
+
+  if (Nfile == SHARD_MAXFILE) {
+    sprintf(messageStr, "Too many output files for shards, at %s", name);
+    Error(ERROR_LEVEL_2, routineName, messageStr);
+  }
+  sf = &shard[Nfile++];
+  strcpy(sf->name, name);
+  /* Columns are along axes 1 and 2 of the aux file, 0 and 1 elsewhere */
+  sf->axis = (strcmp(name, AUX_FILE)) ? 0 : 1;
+  sf->cols = (unsigned char *) calloc(mpi.nx * mpi.ny, sizeof(unsigned char));
+
+  sprintf(shard_name, SHARD_TEMPLATE, name, mpi.rank);
+  if (( sf->ncid = H5Fcreate(shard_name, H5F_ACC_TRUNC, H5P_DEFAULT,
+                             H5P_DEFAULT) ) < 0) HERR(routineName);
+  if (( H5LTset_attribute_int(sf->ncid, "/", SHARD_AXIS, &sf->axis, 1) ) < 0)
+    HERR(routineName);
+  /* Number of processes in the run, mpi.size leaves out the overlord */
+  MPI_Comm_size(mpi.comm, &Nprocess);
+  if (( H5LTset_attribute_int(sf->ncid, "/", SHARD_NUMBER, &Nprocess, 1) ) < 0)
+    HERR(routineName);
+  return sf;
+}
+/* ------- end   -------------------------- shardFile.c ------------ */
+
+/* ------- begin -------------------------- shardDataset.c --------- */
+static ShardDset *shardDataset(hid_t dset)
+/* Creates the shard dataset of the shared dataset dset */
+{
+  const char routineName[] = "shardDataset";
+  char       path[MAX_LINE_SIZE];
+  int        rank, a;
+  hsize_t    dims[H5S_MAX_RANK], chunk[H5S_MAX_RANK];
+  hid_t      type, dspace, dcpl, lcpl;
+  ShardDset *sd;
+
+  if (Ndset == Nalloc) {
+    Nalloc = MAX(2 * Nalloc, 16);
+    sdset  = (ShardDset *) realloc(sdset, Nalloc * sizeof(ShardDset));
+  }
+  sd = &sdset[Ndset];
+  sd->src  = dset;
+  sd->file = shardFile(dset);
+
+  if (H5Iget_name(dset, path, MAX_LINE_SIZE) < 0) HERR(routineName);
+  if (( dspace = H5Dget_space(dset) ) < 0) HERR(routineName);
+  if (( rank = H5Sget_simple_extent_dims(dspace, dims, NULL) ) < 0)
+    HERR(routineName);
+  a = sd->file->axis;
+  if ((rank < a + 2)  ||  (dims[a] != (hsize_t) mpi.nx)  ||
+      (dims[a + 1] != (hsize_t) mpi.ny)) {
+    sprintf(messageStr, "%s in %s has no (x, y) axes, cannot write it "
+	    "to a shard", path, sd->file->name);
+    Error(ERROR_LEVEL_2, routineName, messageStr);
+  }
+  /* One chunk per column, keeping the fill value of the shared file */
+  for (a = 0;  a < rank;  a++) chunk[a] = dims[a];
+  chunk[sd->file->axis]     = 1;
+  chunk[sd->file->axis + 1] = 1;
+  if (( dcpl = H5Dget_create_plist(dset) ) < 0) HERR(routineName);
+  if (( H5Pset_chunk(dcpl, rank, chunk) ) < 0) HERR(routineName);
+  if (( H5Pset_alloc_time(dcpl, H5D_ALLOC_TIME_INCR) ) < 0) HERR(routineName);
+  if (( lcpl = H5Pcreate(H5P_LINK_CREATE) ) < 0) HERR(routineName);
+  if (( H5Pset_create_intermediate_group(lcpl, 1) ) < 0) HERR(routineName);
+  if (( type = H5Dget_type(dset) ) < 0) HERR(routineName);
+  if (( sd->dst = H5Dcreate(sd->file->ncid, path, type, dspace, lcpl, dcpl,
+                            H5P_DEFAULT) ) < 0) HERR(routineName);
+  if (( H5Tclose(type) ) < 0) HERR(routineName);
+  if (( H5Pclose(lcpl) ) < 0) HERR(routineName);
+  if (( H5Pclose(dcpl) ) < 0) HERR(routineName);
+  if (( H5Sclose(dspace) ) < 0) HERR(routineName);
+
+  Ndset++;
+  return sd;
+}
+/* ------- end   -------------------------- shardDataset.c --------- */
+
+/* ------- begin -------------------------- shardSlab_p.c ---------- */
+hid_t shardSlab_p(hid_t dset, const hsize_t *offset)
+/* Returns the shard dataset to write the column at offset of the
+   shared dataset dset to, and marks the column as written */
+{
+  int        n, a;
+  ShardDset *sd = NULL;
+
+  for (n = 0;  n < Ndset;  n++) {
+    if (sdset[n].src == dset) {
+      sd = &sdset[n];
+      break;
+    }
+  }
+  if (sd == NULL) sd = shardDataset(dset);
+
+  a = sd->file->axis;
+  sd->file->cols[offset[a] * mpi.ny + offset[a + 1]] = 1;
+  return sd->dst;
+}
+/* ------- end   -------------------------- shardSlab_p.c ---------- */
+
+/* ------- begin -------------------------- closeShards_p.c -------- */
+void closeShards_p(void)
+/* Writes the column masks and closes all shards. Staged writes
+   must have gone out before. */
+{
+  const char routineName[] = "closeShards_p";
+  int     n;
+  hsize_t dims[2];
+
+  for (n = 0;  n < Ndset;  n++)
+    if (( H5Dclose(sdset[n].dst) ) < 0) HERR(routineName);
+
+  dims[0] = mpi.nx;
+  dims[1] = mpi.ny;
+  for (n = 0;  n < Nfile;  n++) {
+    if (( H5LTmake_dataset(shard[n].ncid, SHARD_COLS, 2, dims,
+                           H5T_NATIVE_UCHAR, shard[n].cols) ) < 0)
+      HERR(routineName);
+    if (( H5Fclose(shard[n].ncid) ) < 0) HERR(routineName);
+    free(shard[n].cols);
+  }
+  if (sdset) free(sdset);
+  sdset = NULL;
+  Ndset = Nalloc = Nfile = 0;
+}
+/* ------- end   -------------------------- closeShards_p.c -------- */
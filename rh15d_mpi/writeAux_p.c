@@ -9,6 +9,7 @@
 /* --- Writes auxiliary data to output file            --------------- */
 
 #include <ctype.h>
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -572,11 +573,8 @@ void close_hdf5_aux(void)
 
 /* ------- begin --------------------------   writeAux_all.c   --- */
 void writeAux_all(void) {
-  const char routineName[] = "writeAux_all";
   hsize_t  offset[] = {0, 0, 0, 0};
   hsize_t  count[] = {1, 1, 1, 1};
-  hsize_t  dims[4];
-  hid_t    file_dspace, mem_dspace;
   Atom      *atom;
   Molecule  *molecule;
   int        nact, task;
@@ -589,11 +587,6 @@ void writeAux_all(void) {
     for (task = 0; task < mpi.Ntasks; task++) {
       /* If there was a crash, no data were written into buffer variables */
       if (mpi.convergence[task] < 0) continue;
-      /* Memory dataspace */
-      dims[0] = atom->Nlevel;
-      dims[1] = infile.nz - mpi.zcut_hist[task];
-      if (( mem_dspace = H5Screate_simple(2, dims, NULL) ) < 0)
-        HERR(routineName);
       /* File dataspace */
       offset[0] = 0;
       offset[1] = mpi.taskmap[task + mpi.my_start][0];
@@ -604,58 +597,22 @@ void writeAux_all(void) {
       count[2] = 1;
       count[3] = infile.nz - mpi.zcut_hist[task];
       if (input.p15d_wpop) {
-        if (( file_dspace = H5Dget_space(io.aux_atom_pop[nact]) ) < 0)
-          HERR(routineName);
-        if (( H5Sselect_hyperslab(file_dspace, H5S_SELECT_SET, offset,
-                                    NULL, count, NULL) ) < 0) HERR(routineName);
-        if (( H5Dwrite(io.aux_atom_pop[nact], H5T_NATIVE_DOUBLE,
-               mem_dspace, file_dspace, H5P_DEFAULT,
-               &iobuf.n[nact][ind * atom->Nlevel]) ) < 0) HERR(routineName);
-        if (( H5Dwrite(io.aux_atom_poplte[nact], H5T_NATIVE_DOUBLE,
-               mem_dspace, file_dspace, H5P_DEFAULT,
-               &iobuf.nstar[nact][ind * atom->Nlevel]) ) < 0) HERR(routineName);
-        /* release dataspace resources */
-        if (( H5Sclose(mem_dspace) ) < 0) HERR(routineName);
-        if (( H5Sclose(file_dspace) ) < 0) HERR(routineName);
+        writeSlab_p(io.aux_atom_pop[nact], H5T_NATIVE_DOUBLE, 4, offset,
+                    count, &iobuf.n[nact][ind * atom->Nlevel]);
+        writeSlab_p(io.aux_atom_poplte[nact], H5T_NATIVE_DOUBLE, 4, offset,
+                    count, &iobuf.nstar[nact][ind * atom->Nlevel]);
       }
       if (input.p15d_wrates) {
-        /* Memory dataspace */
-        dims[0] = atom->Nline;
-        if (( mem_dspace = H5Screate_simple(2, dims, NULL) ) < 0)
-          HERR(routineName);
         count[0] = atom->Nline;
-        if (( file_dspace = H5Dget_space(io.aux_atom_RijL[nact]) ) < 0)
-          HERR(routineName);
-        if (( H5Sselect_hyperslab(file_dspace, H5S_SELECT_SET, offset,
-                                  NULL, count, NULL) ) < 0) HERR(routineName);
-        if (( H5Dwrite(io.aux_atom_RijL[nact], H5T_NATIVE_DOUBLE,
-                 mem_dspace, file_dspace, H5P_DEFAULT,
-                 &iobuf.RijL[nact][ind * atom->Nline]) ) < 0) HERR(routineName);
-        if (( H5Dwrite(io.aux_atom_RjiL[nact], H5T_NATIVE_DOUBLE,
-                 mem_dspace, file_dspace, H5P_DEFAULT,
-                 &iobuf.RjiL[nact][ind * atom->Nline]) ) < 0) HERR(routineName);
-        /* release dataspace resources */
-        if (( H5Sclose(mem_dspace) ) < 0) HERR(routineName);
-        if (( H5Sclose(file_dspace) ) < 0) HERR(routineName);
-
-        /* Memory dataspace */
-        dims[0] = atom->Ncont;
-        if (( mem_dspace = H5Screate_simple(2, dims, NULL) ) < 0)
-          HERR(routineName);
+        writeSlab_p(io.aux_atom_RijL[nact], H5T_NATIVE_DOUBLE, 4, offset,
+                    count, &iobuf.RijL[nact][ind * atom->Nline]);
+        writeSlab_p(io.aux_atom_RjiL[nact], H5T_NATIVE_DOUBLE, 4, offset,
+                    count, &iobuf.RjiL[nact][ind * atom->Nline]);
         count[0] = atom->Ncont;
-        if (( file_dspace = H5Dget_space(io.aux_atom_RijC[nact]) ) < 0)
-          HERR(routineName);
-        if (( H5Sselect_hyperslab(file_dspace, H5S_SELECT_SET, offset,
-                                  NULL, count, NULL) ) < 0) HERR(routineName);
-        if (( H5Dwrite(io.aux_atom_RijC[nact], H5T_NATIVE_DOUBLE,
-                 mem_dspace, file_dspace, H5P_DEFAULT,
-                 &iobuf.RijC[nact][ind * atom->Ncont]) ) < 0) HERR(routineName);
-        if (( H5Dwrite(io.aux_atom_RjiC[nact], H5T_NATIVE_DOUBLE,
-                 mem_dspace, file_dspace, H5P_DEFAULT,
-                 &iobuf.RjiC[nact][ind * atom->Ncont]) ) < 0) HERR(routineName);
-        /* release dataspace resources */
-        if (( H5Sclose(mem_dspace) ) < 0) HERR(routineName);
-        if (( H5Sclose(file_dspace) ) < 0) HERR(routineName);
+        writeSlab_p(io.aux_atom_RijC[nact], H5T_NATIVE_DOUBLE, 4, offset,
+                    count, &iobuf.RijC[nact][ind * atom->Ncont]);
+        writeSlab_p(io.aux_atom_RjiC[nact], H5T_NATIVE_DOUBLE, 4, offset,
+                    count, &iobuf.RjiC[nact][ind * atom->Ncont]);
       }
       ind += count[3];
     }
@@ -668,32 +625,18 @@ void writeAux_all(void) {
     for (task = 0; task < mpi.Ntasks; task++) {
       /* If there was a crash, no data were written into buffer variables */
       if (mpi.convergence[task] < 0) continue;
+      /* File dataspace */
+      offset[0] = 0;
+      offset[1] = mpi.taskmap[task + mpi.my_start][0];
+      offset[2] = mpi.taskmap[task + mpi.my_start][1];
+      offset[3] = mpi.zcut_hist[task];
+      count[0] = molecule->Nv;
+      count[3] = infile.nz - mpi.zcut_hist[task];
       if (input.p15d_wpop) {
-        /* Memory dataspace */
-        dims[0] = molecule->Nv;
-        dims[1] = infile.nz - mpi.zcut_hist[task];
-        if (( mem_dspace = H5Screate_simple(2, dims, NULL) ) < 0)
-          HERR(routineName);
-        /* File dataspace */
-        offset[0] = 0;
-        offset[1] = mpi.taskmap[task + mpi.my_start][0];
-        offset[2] = mpi.taskmap[task + mpi.my_start][1];
-        offset[3] = mpi.zcut_hist[task];
-        count[0] = molecule->Nv;
-        count[3] = infile.nz - mpi.zcut_hist[task];
-        if (( file_dspace = H5Dget_space(io.aux_mol_pop[nact]) ) < 0)
-          HERR(routineName);
-        if (( H5Sselect_hyperslab(file_dspace, H5S_SELECT_SET, offset,
-                                  NULL, count, NULL) ) < 0) HERR(routineName);
-        if (( H5Dwrite(io.aux_mol_pop[nact], H5T_NATIVE_DOUBLE,
-                mem_dspace, file_dspace, H5P_DEFAULT,
-                &iobuf.nv[nact][ind * molecule->Nv]) ) < 0) HERR(routineName);
-        if (( H5Dwrite(io.aux_mol_poplte[nact], H5T_NATIVE_DOUBLE,
-               mem_dspace, file_dspace, H5P_DEFAULT,
-              &iobuf.nvstar[nact][ind * molecule->Nv]) ) < 0) HERR(routineName);
-        /* release dataspace resources */
-        if (( H5Sclose(mem_dspace) ) < 0) HERR(routineName);
-        if (( H5Sclose(file_dspace) ) < 0) HERR(routineName);
+        writeSlab_p(io.aux_mol_pop[nact], H5T_NATIVE_DOUBLE, 4, offset,
+                    count, &iobuf.nv[nact][ind * molecule->Nv]);
+        writeSlab_p(io.aux_mol_poplte[nact], H5T_NATIVE_DOUBLE, 4, offset,
+                    count, &iobuf.nvstar[nact][ind * molecule->Nv]);
       }
       ind += count[3];
     }
@@ -704,14 +647,11 @@ void writeAux_all(void) {
 
 
 /* ------- begin --------------------------   writeAux_p.c     --- */
-void writeAux_p(void) {
+void writeAux_p(Column *col) {
   /* this will write: populations, radrates, coll, damping */
-  const char routineName[] = "writeAux_p";
   int      nact, kr;
   hsize_t  offset[] = {0, 0, 0, 0};
   hsize_t  count[] = {1, 1, 1, 1};
-  hsize_t  dims[4];
-  hid_t    file_dspace, mem_dspace;
   Atom      *atom;
   Molecule  *molecule;
   AtomicLine      *line;
@@ -721,60 +661,38 @@ void writeAux_p(void) {
   for (nact = 0;  nact < atmos.Nactiveatom;  nact++) {
     atom = atmos.activeatoms[nact];
     /* Write populations */
-    /* Memory dataspace */
-    dims[0] = atom->Nlevel;
-    dims[1] = atmos.Nspace;
-    /* File dataspace */
+    /* File hyperslab */
     offset[0] = 0;
-    offset[1] = mpi.ix;
-    offset[2] = mpi.iy;
-    offset[3] = mpi.zcut;
+    offset[1] = col->ix;
+    offset[2] = col->iy;
+    offset[3] = col->zcut;
     count[0] = atom->Nlevel;
     count[3] = atmos.Nspace;
     if (input.p15d_wpop) {
-      if (( mem_dspace = H5Screate_simple(2, dims, NULL) ) < 0)
-          HERR(routineName);
-      if (( file_dspace = H5Dget_space(io.aux_atom_pop[nact]) ) < 0)
-          HERR(routineName);
-      if (( H5Sselect_hyperslab(file_dspace, H5S_SELECT_SET, offset,
-                                NULL, count, NULL) ) < 0) HERR(routineName);
-      if (( H5Dwrite(io.aux_atom_pop[nact], H5T_NATIVE_DOUBLE, mem_dspace,
-                  file_dspace, H5P_DEFAULT, atom->n[0]) ) < 0) HERR(routineName);
-      if (( H5Dwrite(io.aux_atom_poplte[nact], H5T_NATIVE_DOUBLE, mem_dspace,
-             file_dspace, H5P_DEFAULT, atom->nstar[0]) ) < 0) HERR(routineName);
-      if (( H5Sclose(mem_dspace) ) < 0) HERR(routineName);
-      if (( H5Sclose(file_dspace) ) < 0) HERR(routineName);
+      writeSlab_p(io.aux_atom_pop[nact], H5T_NATIVE_DOUBLE, 4, offset, count,
+                  atom->n[0]);
+      writeSlab_p(io.aux_atom_poplte[nact], H5T_NATIVE_DOUBLE, 4, offset,
+                  count, atom->nstar[0]);
     }
     if (input.p15d_wrates) {
       /* Write radiative rates */
-      dims[0] = atmos.Nspace;
       count[0] = 1;
-      if (( mem_dspace = H5Screate_simple(1, dims, NULL) ) < 0)
-          HERR(routineName);
-      if (( file_dspace = H5Dget_space(io.aux_atom_RijL[nact]) ) < 0)
-          HERR(routineName);
       for (kr=0; kr < atom->Nline; kr++) {
           offset[0] = kr;
           line = &atom->line[kr];
-          if (( H5Sselect_hyperslab(file_dspace, H5S_SELECT_SET, offset,
-                                    NULL, count, NULL) ) < 0) HERR(routineName);
-          if (( H5Dwrite(io.aux_atom_RijL[nact], H5T_NATIVE_DOUBLE, mem_dspace,
-                  file_dspace, H5P_DEFAULT, line->Rij) ) < 0) HERR(routineName);
-          if (( H5Dwrite(io.aux_atom_RjiL[nact], H5T_NATIVE_DOUBLE, mem_dspace,
-                  file_dspace, H5P_DEFAULT, line->Rji) ) < 0) HERR(routineName);
+          writeSlab_p(io.aux_atom_RijL[nact], H5T_NATIVE_DOUBLE, 4, offset,
+                      count, line->Rij);
+          writeSlab_p(io.aux_atom_RjiL[nact], H5T_NATIVE_DOUBLE, 4, offset,
+                      count, line->Rji);
       }
       for (kr=0; kr < atom->Ncont; kr++) {
           offset[0] = kr;
           continuum = &atom->continuum[kr];
-          if (( H5Sselect_hyperslab(file_dspace, H5S_SELECT_SET, offset,
-                                    NULL, count, NULL) ) < 0) HERR(routineName);
-          if (( H5Dwrite(io.aux_atom_RijC[nact], H5T_NATIVE_DOUBLE, mem_dspace,
-             file_dspace, H5P_DEFAULT, continuum->Rij) ) < 0) HERR(routineName);
-          if (( H5Dwrite(io.aux_atom_RjiC[nact], H5T_NATIVE_DOUBLE, mem_dspace,
-             file_dspace, H5P_DEFAULT, continuum->Rji) ) < 0) HERR(routineName);
+          writeSlab_p(io.aux_atom_RijC[nact], H5T_NATIVE_DOUBLE, 4, offset,
+                      count, continuum->Rij);
+          writeSlab_p(io.aux_atom_RjiC[nact], H5T_NATIVE_DOUBLE, 4, offset,
+                      count, continuum->Rji);
       }
-      if (( H5Sclose(mem_dspace) ) < 0) HERR(routineName);
-      if (( H5Sclose(file_dspace) ) < 0) HERR(routineName);
     }
   }
 
@@ -783,26 +701,16 @@ void writeAux_p(void) {
     molecule = atmos.activemols[nact];
     if (input.p15d_wpop) {
       /* Write populations */
-      dims[0] = molecule->Nv;
-      dims[1] = atmos.Nspace;
-      if (( mem_dspace = H5Screate_simple(2, dims, NULL) ) < 0)
-          HERR(routineName);
       offset[0] = 0;
-      offset[1] = mpi.ix;
-      offset[2] = mpi.iy;
-      offset[3] = mpi.zcut;
+      offset[1] = col->ix;
+      offset[2] = col->iy;
+      offset[3] = col->zcut;
       count[0] = molecule->Nv;
       count[3] = atmos.Nspace;
-      if (( file_dspace = H5Dget_space(io.aux_mol_pop[nact]) ) < 0)
-          HERR(routineName);
-      if (( H5Sselect_hyperslab(file_dspace, H5S_SELECT_SET, offset,
-                                NULL, count, NULL) ) < 0) HERR(routineName);
-      if (( H5Dwrite(io.aux_mol_pop[nact], H5T_NATIVE_DOUBLE, mem_dspace,
-            file_dspace, H5P_DEFAULT, molecule->nv[0]) ) < 0) HERR(routineName);
-      if (( H5Dwrite(io.aux_mol_poplte[nact], H5T_NATIVE_DOUBLE, mem_dspace,
-        file_dspace, H5P_DEFAULT, molecule->nvstar[0]) ) < 0) HERR(routineName);
-      if (( H5Sclose(mem_dspace) ) < 0) HERR(routineName);
-      if (( H5Sclose(file_dspace) ) < 0) HERR(routineName);
+      writeSlab_p(io.aux_mol_pop[nact], H5T_NATIVE_DOUBLE, 4, offset, count,
+                  molecule->nv[0]);
+      writeSlab_p(io.aux_mol_poplte[nact], H5T_NATIVE_DOUBLE, 4, offset,
+                  count, molecule->nvstar[0]);
     }
   }
   return;
@@ -810,9 +718,9 @@ void writeAux_p(void) {
 /* ------- end   --------------------------   writeAux_p.c     --- */
 
 /* ------- begin -------------------------- readPopulations_p.c -- */
-void readPopulations(Atom *atom) {
+void readPopulations_p(Column *col, Atom *atom) {
 
-  /* --- Read populations from file.
+  /* --- Read populations of column col from file.
 
    Note: readPopulations only reads the true populations and not
          the LTE populations.
@@ -875,9 +783,9 @@ void readPopulations(Atom *atom) {
   if (( mem_dspace = H5Screate_simple(2, dims, NULL) ) < 0) HERR(routineName);
   /* File dataspace */
   offset[0] = 0;
-  offset[1] = mpi.ix;
-  offset[2] = mpi.iy;
-  offset[3] = mpi.zcut;
+  offset[1] = col->ix;
+  offset[2] = col->iy;
+  offset[3] = col->zcut;
   count[0] = atom->Nlevel;
   count[3] = atmos.Nspace;
   if (( file_dspace = H5Dget_space(pop_var) ) < 0) HERR(routineName);
@@ -893,17 +801,264 @@ void readPopulations(Atom *atom) {
 }
 /* ------- end   -------------------------- readPopulations_p.c -- */
 
+/* ------- begin -------------------------- readPopulations.c ---- */
+void readPopulations(Atom *atom) {
+
+  /* --- Library version, called by readAtom for passive atoms with
+         OLD_POPULATIONS before any column is read. In rh15d the
+         populations belong to a column, see readPopulations_p.
+         --                                            -------------- */
+  const char routineName[] = "readPopulations";
+
+  sprintf(messageStr, "Cannot read populations of passive atom %s in rh15d",
+          atom->ID);
+  Error(ERROR_LEVEL_2, routineName, messageStr);
+}
+/* ------- end   -------------------------- readPopulations.c ---- */
+
+
+/* ------- begin -------------------------- init_prev_pops.c ----- */
+void init_prev_pops(void) {
+  /* Opens the aux file (and optionally the input data file) of a
+     previous run, whose populations are used as initial solution for
+     the same columns. Every process opens the files read-only.     */
+  const char routineName[] = "init_prev_pops";
+  int nx, ny;
+
+  io.prev_aux_ncid = -1;
+  io.prev_in_ncid  = -1;
+  if (!strcmp(input.p15d_prev_aux, "none")) return;
+
+  if (!strcmp(input.p15d_prev_aux, AUX_FILE)) {
+    sprintf(messageStr, "15D_PREV_AUX cannot be %s, which is overwritten "
+	    "by this run. Copy it elsewhere first.", AUX_FILE);
+    Error(ERROR_LEVEL_2, routineName, messageStr);
+  }
+  if (input.p15d_refine  &&  !strcmp(input.p15d_prev_indata, "none")) {
+    sprintf(messageStr, "15D_PREV_INDATA is needed with 15D_DEPTH_REFINE, "
+	    "to map the depth scale of 15D_PREV_AUX");
+    Error(ERROR_LEVEL_2, routineName, messageStr);
+  }
+  if (( io.prev_aux_ncid = H5Fopen(input.p15d_prev_aux, H5F_ACC_RDONLY,
+				   H5P_DEFAULT) ) < 0) HERR(routineName);
+  if (( H5LTget_attribute_int(io.prev_aux_ncid, "/", "nx", &nx) ) < 0)
+    HERR(routineName);
+  if (( H5LTget_attribute_int(io.prev_aux_ncid, "/", "ny", &ny) ) < 0)
+    HERR(routineName);
+  if ((nx != mpi.nx)  ||  (ny != mpi.ny)) {
+    sprintf(messageStr, "%s has (nx, ny) = (%d, %d), but this run has "
+	    "(%d, %d)", input.p15d_prev_aux, nx, ny, mpi.nx, mpi.ny);
+    Error(ERROR_LEVEL_2, routineName, messageStr);
+  }
+
+  if (strcmp(input.p15d_prev_indata, "none")) {
+    if (( io.prev_in_ncid = H5Fopen(input.p15d_prev_indata, H5F_ACC_RDONLY,
+				    H5P_DEFAULT) ) < 0) HERR(routineName);
+    check_prev_columns(io.prev_in_ncid, input.p15d_prev_indata);
+  }
+  return;
+}
+/* ------- end   -------------------------- init_prev_pops.c ----- */
+
+/* ------- begin -------------------------- check_prev_columns.c - */
+void check_prev_columns(hid_t ncid, const char *file_name) {
+  /* Checks that the input data file of a previous run was calculated
+     for the same columns (x and y indices) of the atmosphere as this
+     run, not only for a grid of the same size.                       */
+  const char routineName[] = "check_prev_columns";
+  int   nx, ny, i, *xnum, *ynum;
+  hid_t ncid_mpi;
+
+  if (( H5LTget_attribute_int(ncid, "/", "nx", &nx) ) < 0) HERR(routineName);
+  if (( H5LTget_attribute_int(ncid, "/", "ny", &ny) ) < 0) HERR(routineName);
+  if ((nx != mpi.nx)  ||  (ny != mpi.ny)) {
+    sprintf(messageStr, "%s has (nx, ny) = (%d, %d), but this run has "
+	    "(%d, %d)", file_name, nx, ny, mpi.nx, mpi.ny);
+    Error(ERROR_LEVEL_2, routineName, messageStr);
+  }
+  xnum = (int *) malloc(nx * sizeof(int));
+  ynum = (int *) malloc(ny * sizeof(int));
+  if (( ncid_mpi = H5Gopen(ncid, "mpi", H5P_DEFAULT) ) < 0) HERR(routineName);
+  if (( H5LTread_dataset_int(ncid_mpi, XNUM_NAME, xnum) ) < 0)
+    HERR(routineName);
+  if (( H5LTread_dataset_int(ncid_mpi, YNUM_NAME, ynum) ) < 0)
+    HERR(routineName);
+  if (( H5Gclose(ncid_mpi) ) < 0) HERR(routineName);
+
+  for (i = 0;  i < nx;  i++) {
+    if (xnum[i] != mpi.xnum[i]) {
+      sprintf(messageStr, "%s has x index %d at position %d, but this run "
+	      "has %d", file_name, xnum[i], i, mpi.xnum[i]);
+      Error(ERROR_LEVEL_2, routineName, messageStr);
+    }
+  }
+  for (i = 0;  i < ny;  i++) {
+    if (ynum[i] != mpi.ynum[i]) {
+      sprintf(messageStr, "%s has y index %d at position %d, but this run "
+	      "has %d", file_name, ynum[i], i, mpi.ynum[i]);
+      Error(ERROR_LEVEL_2, routineName, messageStr);
+    }
+  }
+  free(xnum);
+  free(ynum);
+  return;
+}
+/* ------- end   -------------------------- check_prev_columns.c - */
+
+/* ------- begin -------------------------- close_prev_pops.c ---- */
+void close_prev_pops(void) {
+  const char routineName[] = "close_prev_pops";
+
+  if (io.prev_aux_ncid >= 0)
+    if (( H5Fclose(io.prev_aux_ncid) ) < 0) HERR(routineName);
+  if (io.prev_in_ncid >= 0)
+    if (( H5Fclose(io.prev_in_ncid) ) < 0) HERR(routineName);
+  return;
+}
+/* ------- end   -------------------------- close_prev_pops.c ---- */
+
+/* ------- begin -------------------------- readPrevPops_p.c ----- */
+bool_t readPrevPops_p(Column *col, Atom *atom) {
+  /* Sets the populations of atom from those of the same column in a
+     previous run. Departure coefficients are interpolated in height,
+     using the height scale of the previous input data file if given,
+     otherwise the depth indices of both runs are assumed to refer to
+     the same z grid of the atmosphere file. Returns FALSE when the
+     atom or column are not in the previous run.                     */
+  const char routineName[] = "readPrevPops_p";
+  char     group_name[ARR_STRLEN];
+  bool_t   hunt;
+  int      nz, nlevel, i, k, Nvalid;
+  hsize_t  offset[] = {0, 0, 0, 0};
+  hsize_t  count[]  = {1, 1, 1, 1};
+  hsize_t  dims[2];
+  hid_t    ncid, file_dspace, mem_dspace, var;
+  double **n, **nstar, *z, *zindex, *zcur, *lgb;
+
+  if (io.prev_aux_ncid < 0) return FALSE;
+
+  sprintf(group_name,(atom->ID[1] == ' ') ? "atom_%.1s" : "atom_%.2s", atom->ID);
+  if (H5Lexists(io.prev_aux_ncid, group_name, H5P_DEFAULT) <= 0) return FALSE;
+  if (( ncid = H5Gopen(io.prev_aux_ncid, group_name, H5P_DEFAULT) ) < 0)
+    HERR(routineName);
+  if (( H5LTget_attribute_int(ncid, ".", "nlevel", &nlevel) ) < 0)
+    HERR(routineName);
+  if ((nlevel != atom->Nlevel)  ||
+      (H5Lexists(ncid, POP_NAME, H5P_DEFAULT) <= 0)  ||
+      (H5Lexists(ncid, POPLTE_NAME, H5P_DEFAULT) <= 0)) {
+    if (( H5Gclose(ncid) ) < 0) HERR(routineName);
+    return FALSE;
+  }
+  if (( H5LTget_attribute_int(io.prev_aux_ncid, "/", "nz", &nz) ) < 0)
+    HERR(routineName);
+
+  /* --- Read populations and LTE populations of this column --- */
+  n     = matrix_double(atom->Nlevel, nz);
+  nstar = matrix_double(atom->Nlevel, nz);
+  dims[0] = atom->Nlevel;
+  dims[1] = nz;
+  if (( mem_dspace = H5Screate_simple(2, dims, NULL) ) < 0) HERR(routineName);
+  offset[1] = col->ix;
+  offset[2] = col->iy;
+  count[0]  = atom->Nlevel;
+  count[3]  = nz;
+
+  if (( var = H5Dopen2(ncid, POP_NAME, H5P_DEFAULT)) < 0) HERR(routineName);
+  if (( file_dspace = H5Dget_space(var) ) < 0) HERR(routineName);
+  if (( H5Sselect_hyperslab(file_dspace, H5S_SELECT_SET, offset,
+                            NULL, count, NULL) ) < 0) HERR(routineName);
+  if (( H5Dread(var, H5T_NATIVE_DOUBLE, mem_dspace,
+                file_dspace, H5P_DEFAULT, n[0]) ) < 0) HERR(routineName);
+  if (( H5Sclose(file_dspace) ) < 0) HERR(routineName);
+  if (( H5Dclose(var) ) < 0) HERR(routineName);
+
+  if (( var = H5Dopen2(ncid, POPLTE_NAME, H5P_DEFAULT)) < 0) HERR(routineName);
+  if (( file_dspace = H5Dget_space(var) ) < 0) HERR(routineName);
+  if (( H5Sselect_hyperslab(file_dspace, H5S_SELECT_SET, offset,
+                            NULL, count, NULL) ) < 0) HERR(routineName);
+  if (( H5Dread(var, H5T_NATIVE_DOUBLE, mem_dspace,
+                file_dspace, H5P_DEFAULT, nstar[0]) ) < 0) HERR(routineName);
+  if (( H5Sclose(file_dspace) ) < 0) HERR(routineName);
+  if (( H5Dclose(var) ) < 0) HERR(routineName);
+  if (( H5Sclose(mem_dspace) ) < 0) HERR(routineName);
+  if (( H5Gclose(ncid) ) < 0) HERR(routineName);
+
+  /* --- Depth scale of previous run --- */
+  z = (double *) malloc(nz * sizeof(double));
+  if (io.prev_in_ncid >= 0) {
+    dims[0] = nz;
+    if (( mem_dspace = H5Screate_simple(1, dims, NULL) ) < 0)
+      HERR(routineName);
+    offset[0] = col->ix;  count[0] = 1;
+    offset[1] = col->iy;  count[1] = 1;
+    offset[2] = 0;        count[2] = nz;
+    if (( var = H5Dopen2(io.prev_in_ncid, "/atmos/height_scale",
+			 H5P_DEFAULT)) < 0) HERR(routineName);
+    if (( file_dspace = H5Dget_space(var) ) < 0) HERR(routineName);
+    if (( H5Sselect_hyperslab(file_dspace, H5S_SELECT_SET, offset,
+			      NULL, count, NULL) ) < 0) HERR(routineName);
+    if (( H5Dread(var, H5T_NATIVE_DOUBLE, mem_dspace,
+		  file_dspace, H5P_DEFAULT, z) ) < 0) HERR(routineName);
+    if (( H5Sclose(file_dspace) ) < 0) HERR(routineName);
+    if (( H5Dclose(var) ) < 0) HERR(routineName);
+    if (( H5Sclose(mem_dspace) ) < 0) HERR(routineName);
+  } else {
+    /* Same z grid: depth index k of this run is k + zcut in file */
+    for (k = 0;  k < nz;  k++) z[k] = (double) (k - col->zcut);
+  }
+
+  /* --- Keep only depths written in the previous run --- */
+  Nvalid = 0;
+  for (k = 0;  k < nz;  k++) {
+    if (z[k] == FILLVALUE) continue;
+    for (i = 0;  i < atom->Nlevel;  i++)
+      if ((n[i][k] == FILLVALUE)  ||  (n[i][k] <= 0.0)  ||
+	  (nstar[i][k] <= 0.0)) break;
+    if (i < atom->Nlevel) continue;
+
+    z[Nvalid] = z[k];
+    for (i = 0;  i < atom->Nlevel;  i++)
+      n[i][Nvalid] = log10(n[i][k] / nstar[i][k]);
+    Nvalid++;
+  }
+
+  if (Nvalid >= 2) {
+    zindex = (double *) malloc(atmos.Nspace * sizeof(double));
+    lgb    = (double *) malloc(atmos.Nspace * sizeof(double));
+    for (k = 0;  k < atmos.Nspace;  k++) zindex[k] = (double) k;
+    zcur = (io.prev_in_ncid >= 0) ? geometry.height : zindex;
+
+    for (i = 0;  i < atom->Nlevel;  i++) {
+      Linear(Nvalid, z, n[i], atmos.Nspace, zcur, lgb, hunt=TRUE);
+      for (k = 0;  k < atmos.Nspace;  k++)
+	atom->n[i][k] = atom->nstar[i][k] * POW10(lgb[k]);
+    }
+    free(zindex);
+    free(lgb);
+
+    sprintf(messageStr, "Initial populations of %.2s from %s\n",
+	    atom->ID, input.p15d_prev_aux);
+    Error(MESSAGE, routineName, messageStr);
+  }
+  free(z);
+  freeMatrix((void **) n);
+  freeMatrix((void **) nstar);
+
+  return (Nvalid >= 2);
+}
+/* ------- end   -------------------------- readPrevPops_p.c ----- */
+
 
 /* ------- begin -------------------------- readMolPops_p.c -- */
-void readMolPops(Molecule *molecule) {
+void readMolPops_p(Column *col, Molecule *molecule) {
 
-  /* --- Read populations from file.
+  /* --- Read populations of column col from file.
 
    Note: readPopulations only reads the true populations and not
          the LTE populations.
          --                                            -------------- */
 
-  const char routineName[] = "readMolPops";
+  const char routineName[] = "readMolPops_p";
   char    group_name[ARR_STRLEN], *atmosID;
 
   int nz, nlevel;
@@ -958,9 +1113,9 @@ void readMolPops(Molecule *molecule) {
   if (( mem_dspace = H5Screate_simple(2, dims, NULL) ) < 0) HERR(routineName);
   /* File dataspace */
   offset[0] = 0;
-  offset[1] = mpi.ix;
-  offset[2] = mpi.iy;
-  offset[3] = mpi.zcut;
+  offset[1] = col->ix;
+  offset[2] = col->iy;
+  offset[3] = col->zcut;
   count[0] = molecule->Nv;
   count[3] = atmos.Nspace;
   if (( file_dspace = H5Dget_space(pop_var) ) < 0) HERR(routineName);
@@ -976,6 +1131,18 @@ void readMolPops(Molecule *molecule) {
 }
 /* ------- end   -------------------------- readMolPops_p.c -- */
 
+/* ------- begin -------------------------- readMolPops.c -------- */
+void readMolPops(Molecule *molecule) {
+
+  /* --- Library version, see readPopulations --       -------------- */
+  const char routineName[] = "readMolPops";
+
+  sprintf(messageStr, "Cannot read populations of molecule %s in rh15d",
+          molecule->ID);
+  Error(ERROR_LEVEL_2, routineName, messageStr);
+}
+/* ------- end   -------------------------- readMolPops.c -------- */
+
 /* ------- begin -------------------------- writeMolPops.c ---------- */
 
 void writeMolPops(struct Molecule *molecule)
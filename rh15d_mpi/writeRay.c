@@ -425,38 +425,28 @@ void close_hdf5_ray(void) {
 
 
 /* ------- begin -------------------------- writeRay.c --------------- */
-void writeRay(void) {
+void writeRay(Column *col) {
   /* Writes ray data to file. */
-  const char routineName[] = "writeRay";
   int        idx, ncid, k, l, nspect;
   double    *J;
   float    **chi, **S, **sca, *tau_one, tau_cur, tau_prev, tmp, *chi_tmp;
   float    **Jnu;
   hsize_t    offset[] = {0, 0, 0, 0};
   hsize_t    count[] = {1, 1, 1, 1};
-  hsize_t    dims[4];
   bool_t     write_xtra, crosscoupling, to_obs, initialize,prdh_limit_mem_save;
   ActiveSet *as;
-  hid_t      file_dataspace, mem_dataspace;
 
   write_xtra = (io.ray_nwave_sel > 0);
   ncid = io.ray_ncid;
 
-  /* Memory dataspace */
-  dims[0] = spectrum.Nspect;
-  if (( mem_dataspace = H5Screate_simple(1, dims, NULL) ) < 0)
-    HERR(routineName);
-  /* File dataspace */
-  offset[0] = mpi.ix;
-  offset[1] = mpi.iy;
+  /* File hyperslab */
+  offset[0] = col->ix;
+  offset[1] = col->iy;
   count[2] = spectrum.Nspect;
-  if (( file_dataspace = H5Dget_space(io.ray_int_var) ) < 0) HERR(routineName);
-  if (( H5Sselect_hyperslab(file_dataspace, H5S_SELECT_SET, offset,
-                            NULL, count, NULL) ) < 0) HERR(routineName);
 
   /* Write intensity */
-  if (( H5Dwrite(io.ray_int_var, H5T_NATIVE_DOUBLE, mem_dataspace,
-          file_dataspace, H5P_DEFAULT, spectrum.I[0]) ) < 0) HERR(routineName);
+  writeSlab_p(io.ray_int_var, H5T_NATIVE_DOUBLE, 3, offset, count,
+              spectrum.I[0]);
 
   /* Calculate height of tau=1 and write to file*/
   if (input.p15d_wtau) {
@@ -483,7 +473,7 @@ void writeRay(void) {
       tau_cur  = 0.0;
 
       for (k = 0;  k < atmos.Nspace;  k++) {
-        l = k + mpi.zcut;
+        l = k + col->zcut;
         chi_tmp[l] = (float) (as->chi[k] + as->chi_c[k]);
 
         /* Calculate tau=1 depth, manual linear interpolation */
@@ -509,8 +499,7 @@ void writeRay(void) {
       free(chi_tmp);
     }
     /* Write to file */
-    if (( H5Dwrite(io.ray_tau1_var, H5T_NATIVE_FLOAT, mem_dataspace,
-                 file_dataspace, H5P_DEFAULT, tau_one) ) < 0) HERR(routineName);
+    writeSlab_p(io.ray_tau1_var, H5T_NATIVE_FLOAT, 3, offset, count, tau_one);
     /* set back PRD input option */
     if (input.PRD_angle_dep == PRD_ANGLE_APPROX && atmos.NPRDactive > 0)
       input.prdh_limit_mem = prdh_limit_mem_save ;
@@ -518,19 +507,13 @@ void writeRay(void) {
   }
 
   if (atmos.Stokes || input.backgr_pol) { /* Write rest of Stokes vector */
-    if (( H5Dwrite(io.ray_stokes_q_var, H5T_NATIVE_DOUBLE, mem_dataspace,
-                   file_dataspace, H5P_DEFAULT,
-                   spectrum.Stokes_Q[0]) ) < 0) HERR(routineName);
-    if (( H5Dwrite(io.ray_stokes_u_var, H5T_NATIVE_DOUBLE, mem_dataspace,
-                   file_dataspace, H5P_DEFAULT,
-                   spectrum.Stokes_U[0]) ) < 0) HERR(routineName);
-    if (( H5Dwrite(io.ray_stokes_v_var, H5T_NATIVE_DOUBLE, mem_dataspace,
-                   file_dataspace, H5P_DEFAULT,
-                   spectrum.Stokes_V[0]) ) < 0) HERR(routineName);
+    writeSlab_p(io.ray_stokes_q_var, H5T_NATIVE_DOUBLE, 3, offset, count,
+                spectrum.Stokes_Q[0]);
+    writeSlab_p(io.ray_stokes_u_var, H5T_NATIVE_DOUBLE, 3, offset, count,
+                spectrum.Stokes_U[0]);
+    writeSlab_p(io.ray_stokes_v_var, H5T_NATIVE_DOUBLE, 3, offset, count,
+                spectrum.Stokes_V[0]);
   }
-  /* release dataspace resources */
-  if (( H5Sclose(mem_dataspace) ) < 0) HERR(routineName);
-  if (( H5Sclose(file_dataspace) ) < 0) HERR(routineName);
 
   if (write_xtra) {
     /* Write opacity and emissivity for line and continuum */
@@ -574,7 +557,7 @@ void writeRay(void) {
       }
 
       for (k = 0;  k < atmos.Nspace;  k++) {
-        l = k + mpi.zcut;
+        l = k + col->zcut;
         chi[l][nspect] = (float) (as->chi[k] + as->chi_c[k]);
       	sca[l][nspect] = (float) (as->sca_c[k] * J[k]);
       	S[l][nspect]   = (float) ((as->eta[k] + as->eta_c[k] +
@@ -589,34 +572,19 @@ void writeRay(void) {
       input.prdh_limit_mem = prdh_limit_mem_save;
 
     /* Write variables */
-    /* Memory dataspace */
-    dims[0] = infile.nz;
-    dims[1] = io.ray_nwave_sel;
-    if (( mem_dataspace = H5Screate_simple(2, dims, NULL) ) < 0)
-      HERR(routineName);
-    /* File dataspace */
-    offset[0] = mpi.ix;  count[0] = 1;
-    offset[1] = mpi.iy;  count[1] = 1;
+    /* File hyperslab */
+    offset[0] = col->ix;  count[0] = 1;
+    offset[1] = col->iy;  count[1] = 1;
     offset[2] = 0;       count[2] = infile.nz;
     offset[3] = 0;       count[3] = io.ray_nwave_sel;
-    if (( file_dataspace = H5Dget_space(io.ray_S_var) ) < 0) HERR(routineName);
-    if (( H5Sselect_hyperslab(file_dataspace, H5S_SELECT_SET, offset,
-                              NULL, count, NULL) ) < 0) HERR(routineName);
-    if (( H5Dwrite(io.ray_chi_var, H5T_NATIVE_FLOAT, mem_dataspace,
-                 file_dataspace, H5P_DEFAULT, chi[0]) ) < 0) HERR(routineName);
-    if (( H5Dwrite(io.ray_S_var, H5T_NATIVE_FLOAT, mem_dataspace,
-                 file_dataspace, H5P_DEFAULT, S[0]) ) < 0) HERR(routineName);
-    if (( H5Dwrite(io.ray_j_var, H5T_NATIVE_FLOAT, mem_dataspace,
-                 file_dataspace, H5P_DEFAULT, Jnu[0]) ) < 0) HERR(routineName);
-    if (( H5Dwrite(io.ray_sca_c_var, H5T_NATIVE_FLOAT, mem_dataspace,
-                 file_dataspace, H5P_DEFAULT, sca[0]) ) < 0) HERR(routineName);
+    writeSlab_p(io.ray_chi_var, H5T_NATIVE_FLOAT, 4, offset, count, chi[0]);
+    writeSlab_p(io.ray_S_var, H5T_NATIVE_FLOAT, 4, offset, count, S[0]);
+    writeSlab_p(io.ray_j_var, H5T_NATIVE_FLOAT, 4, offset, count, Jnu[0]);
+    writeSlab_p(io.ray_sca_c_var, H5T_NATIVE_FLOAT, 4, offset, count, sca[0]);
     freeMatrix((void **) chi);
     freeMatrix((void **) S);
     freeMatrix((void **) Jnu);
     freeMatrix((void **) sca);
-    /* release dataspace resources */
-    if (( H5Sclose(mem_dataspace) ) < 0) HERR(routineName);
-    if (( H5Sclose(file_dataspace) ) < 0) HERR(routineName);
     if (input.limit_memory) free(J);
   }
   close_Background();  /* To avoid many open files */
@@ -28,6 +28,16 @@
 /* --- Function prototypes --                          -------------- */
 
 
+/* --- Group of a previous output file whose datasets are copied for
+       the reused columns, with the matching group of the new file -- */
+
+typedef struct {
+  hid_t   dst;
+  bool_t  aux;
+  char   *file_name;
+} CopyGroup;
+
+
 /* --- Global variables --                             -------------- */
 
 extern Atmosphere atmos;
@@ -466,6 +476,23 @@ void init_hdf5_indata_new(void)
   if (( H5LTset_attribute_int(ncid_mpi, ".", "y_step",
                               &input.p15d_yst, 1) ) < 0) HERR(routineName);
 
+  /* Columns copied from a previous snapshot (see reuse_columns) */
+  if (mpi.reused != NULL) {
+    if (( H5LTset_attribute_double(ncid_mpi, ".", "reuse_tolerance",
+                      &input.p15d_reuse_tol, 1) ) < 0) HERR(routineName);
+    if (( H5LTset_attribute_int(ncid_mpi, ".", "reuse_snapshot",
+                      &input.p15d_prev_nt, 1) ) < 0) HERR(routineName);
+    dims[0] = mpi.nx;
+    dims[1] = mpi.ny;
+    if (( H5LTmake_dataset(ncid_mpi, REUSE_NAME, 2, dims,
+                  H5T_NATIVE_INT, mpi.reused[0]) ) < 0) HERR(routineName);
+    if (( id_tmp = H5Dopen2(ncid_mpi, REUSE_NAME,
+                            H5P_DEFAULT)) < 0) HERR(routineName);
+    if (( H5DSattach_scale(id_tmp, id_x, 0)) < 0) HERR(routineName);
+    if (( H5DSattach_scale(id_tmp, id_y, 1)) < 0) HERR(routineName);
+    if (( H5Dclose(id_tmp) ) < 0) HERR(routineName);
+  }
+
   /* Tiago: most of the arrays involving Ntasks or rank as index are not
             currently being written. They should eventually be migrated into
             arrays of [ix, iy] and be written for each task. This is to
@@ -582,7 +609,7 @@ void close_hdf5_indata(void)
 /* ------- end   --------------------------   close_hdf5_indata.c --- */
 
 /* ------- begin --------------------------   writeAtmos_p.c --- */
-void writeAtmos_p(void)
+void writeAtmos_p(Column *col)
 {
   /* Write atmos arrays. This has now been modified and writes the interpolated
      arrays, from depth_refine. With that, now this is the only viable option
@@ -594,33 +621,19 @@ void writeAtmos_p(void)
                 space and computational time.
 
      */
-  const char routineName[] = "writeAtmos_p";
   hsize_t  offset[] = {0, 0, 0, 0};
   hsize_t  count[] = {1, 1, 1, 1};
-  hsize_t  dims[4];
-  hid_t    file_dspace, mem_dspace;
 
-  /* Memory dataspace */
-  dims[0] = atmos.Nspace;
-  if (( mem_dspace = H5Screate_simple(1, dims, NULL) ) < 0)
-    HERR(routineName);
-  /* File dataspace */
-  offset[0] = mpi.ix;
-  offset[1] = mpi.iy;
-  offset[2] = mpi.zcut;
+  /* File hyperslab */
+  offset[0] = col->ix;
+  offset[1] = col->iy;
+  offset[2] = col->zcut;
   count[2] = atmos.Nspace;
-  if (( file_dspace = H5Dget_space(io.in_atmos_T) ) < 0) HERR(routineName);
-  if (( H5Sselect_hyperslab(file_dspace, H5S_SELECT_SET, offset,
-                            NULL, count, NULL) ) < 0) HERR(routineName);
-  if (( H5Dwrite(io.in_atmos_T, H5T_NATIVE_DOUBLE, mem_dspace,
-                file_dspace, H5P_DEFAULT, atmos.T) ) < 0) HERR(routineName);
-  if (( H5Dwrite(io.in_atmos_vz, H5T_NATIVE_DOUBLE, mem_dspace,
-           file_dspace, H5P_DEFAULT, geometry.vel) ) < 0) HERR(routineName);
-  if (( H5Dwrite(io.in_atmos_z, H5T_NATIVE_DOUBLE, mem_dspace,
-        file_dspace, H5P_DEFAULT, geometry.height) ) < 0) HERR(routineName);
-  /* release dataspace resources */
-  if (( H5Sclose(mem_dspace) ) < 0) HERR(routineName);
-  if (( H5Sclose(file_dspace) ) < 0) HERR(routineName);
+  writeSlab_p(io.in_atmos_T, H5T_NATIVE_DOUBLE, 3, offset, count, atmos.T);
+  writeSlab_p(io.in_atmos_vz, H5T_NATIVE_DOUBLE, 3, offset, count,
+              geometry.vel);
+  writeSlab_p(io.in_atmos_z, H5T_NATIVE_DOUBLE, 3, offset, count,
+              geometry.height);
   return;
 }
 /* ------- end   --------------------------   writeAtmos_p.c --- */
@@ -628,51 +641,27 @@ void writeAtmos_p(void)
 /* ------- begin --------------------------   writeMPI_all.c --- */
 void writeMPI_all(void) {
 /* Writes output on indata file, MPI group, all tasks at once */
-  const char routineName[] = "writeMPI_all";
   int      task;
   hsize_t  offset[] = {0, 0, 0, 0};
   hsize_t  count[] = {1, 1, 1, 1};
-  hsize_t  dims[4];
-  hid_t    file_dspace, mem_dspace;
-
-  /* Write single values of Ntasks, one value at a time */
-  dims[0] = 1;
-  if (( mem_dspace = H5Screate_simple(1, dims, NULL) ) < 0)
-    HERR(routineName);
-
-  for (task = 0; task < mpi.Ntasks; task++) {
-    offset[0] = mpi.taskmap[task + mpi.my_start][0];
-    offset[1] = mpi.taskmap[task + mpi.my_start][1];
-    if (( file_dspace = H5Dget_space(io.in_mpi_it) ) < 0) HERR(routineName);
-    if (( H5Sselect_hyperslab(file_dspace, H5S_SELECT_SET, offset,
-                              NULL, count, NULL) ) < 0) HERR(routineName);
-    if (( H5Dwrite(io.in_mpi_it, H5T_NATIVE_INT, mem_dspace, file_dspace,
-                   H5P_DEFAULT, &mpi.niter[task]) ) < 0) HERR(routineName);
-    if (( H5Dwrite(io.in_mpi_conv, H5T_NATIVE_INT, mem_dspace, file_dspace,
-                H5P_DEFAULT, &mpi.convergence[task]) ) < 0) HERR(routineName);
-    if (( H5Dwrite(io.in_mpi_zc, H5T_NATIVE_INT, mem_dspace, file_dspace,
-                  H5P_DEFAULT, &mpi.zcut_hist[task]) ) < 0) HERR(routineName);
-    if (( H5Dwrite(io.in_mpi_dm, H5T_NATIVE_DOUBLE, mem_dspace, file_dspace,
-                   H5P_DEFAULT, &mpi.dpopsmax[task]) ) < 0) HERR(routineName);
-    if (( H5Sclose(file_dspace) ) < 0) HERR(routineName);
-  }
-  if (( H5Sclose(mem_dspace) ) < 0) HERR(routineName);
 
-  /* Write array with multiple values */
   for (task = 0; task < mpi.Ntasks; task++) {
-    dims[0] = mpi.niter[task];
-    if (( mem_dspace = H5Screate_simple(1, dims, NULL) ) < 0)
-      HERR(routineName);
     offset[0] = mpi.taskmap[task + mpi.my_start][0];
     offset[1] = mpi.taskmap[task + mpi.my_start][1];
+    writeSlab_p(io.in_mpi_it, H5T_NATIVE_INT, 2, offset, count,
+                &mpi.niter[task]);
+    writeSlab_p(io.in_mpi_conv, H5T_NATIVE_INT, 2, offset, count,
+                &mpi.convergence[task]);
+    writeSlab_p(io.in_mpi_zc, H5T_NATIVE_INT, 2, offset, count,
+                &mpi.zcut_hist[task]);
+    writeSlab_p(io.in_mpi_dm, H5T_NATIVE_DOUBLE, 2, offset, count,
+                &mpi.dpopsmax[task]);
+
+    /* Array with multiple values */
     count[2] = mpi.niter[task];
-    if (( file_dspace = H5Dget_space(io.in_mpi_dmh) ) < 0) HERR(routineName);
-    if (( H5Sselect_hyperslab(file_dspace, H5S_SELECT_SET, offset,
-                              NULL, count, NULL) ) < 0) HERR(routineName);
-    if (( H5Dwrite(io.in_mpi_dmh, H5T_NATIVE_DOUBLE, mem_dspace, file_dspace,
-               H5P_DEFAULT, mpi.dpopsmax_hist[task]) ) < 0) HERR(routineName);
-    if (( H5Sclose(file_dspace) ) < 0) HERR(routineName);
-    if (( H5Sclose(mem_dspace) ) < 0) HERR(routineName);
+    writeSlab_p(io.in_mpi_dmh, H5T_NATIVE_DOUBLE, 3, offset, count,
+                mpi.dpopsmax_hist[task]);
+    count[2] = 1;
   }
   return;
 }
@@ -680,48 +669,27 @@ void writeMPI_all(void) {
 
 
 /* ------- begin --------------------------   writeMPI_p.c ----- */
-void writeMPI_p(int task) {
+void writeMPI_p(Column *col, int task) {
 /* Writes output on indata file, MPI group, one task at once */
-  const char routineName[] = "writeMPI_p";
   hsize_t  offset[] = {0, 0, 0, 0};
   hsize_t  count[] = {1, 1, 1, 1};
-  hsize_t  dims[4];
-  hid_t    file_dspace, mem_dspace;
-
-  dims[0] = 1;
-  if (( mem_dspace = H5Screate_simple(1, dims, NULL) ) < 0) HERR(routineName);
-  offset[0] = mpi.ix;
-  offset[1] = mpi.iy;
-  if (( file_dspace = H5Dget_space(io.in_mpi_tm) ) < 0) HERR(routineName);
-  if (( H5Sselect_hyperslab(file_dspace, H5S_SELECT_SET, offset,
-                            NULL, count, NULL) ) < 0) HERR(routineName);
-  if (( H5Dwrite(io.in_mpi_tm, H5T_NATIVE_INT, mem_dspace, file_dspace,
-                   H5P_DEFAULT, &mpi.rank) ) < 0) HERR(routineName);
-  if (( H5Dwrite(io.in_mpi_tn, H5T_NATIVE_INT, mem_dspace, file_dspace,
-                   H5P_DEFAULT, &task) ) < 0) HERR(routineName);
-  if (( H5Dwrite(io.in_mpi_it, H5T_NATIVE_INT, mem_dspace, file_dspace,
-                   H5P_DEFAULT, &mpi.niter[0]) ) < 0) HERR(routineName);
-  if (( H5Dwrite(io.in_mpi_conv, H5T_NATIVE_INT, mem_dspace, file_dspace,
-                   H5P_DEFAULT, &mpi.convergence[0]) ) < 0) HERR(routineName);
-  if (( H5Dwrite(io.in_mpi_zc, H5T_NATIVE_INT, mem_dspace, file_dspace,
-                   H5P_DEFAULT, &mpi.zcut_hist[0]) ) < 0) HERR(routineName);
-  if (( H5Dwrite(io.in_mpi_dm, H5T_NATIVE_DOUBLE, mem_dspace, file_dspace,
-                   H5P_DEFAULT, &mpi.dpopsmax[0]) ) < 0) HERR(routineName);
-  if (( H5Sclose(file_dspace) ) < 0) HERR(routineName);
-  if (( H5Sclose(mem_dspace) ) < 0) HERR(routineName);
-
-  dims[0] = mpi.niter[0];
-  if (( mem_dspace = H5Screate_simple(1, dims, NULL) ) < 0) HERR(routineName);
-  offset[0] = mpi.ix;
-  offset[1] = mpi.iy;
-  count[2] = mpi.niter[0];
-  if (( file_dspace = H5Dget_space(io.in_mpi_dmh) ) < 0) HERR(routineName);
-  if (( H5Sselect_hyperslab(file_dspace, H5S_SELECT_SET, offset,
-                            NULL, count, NULL) ) < 0) HERR(routineName);
-  if (( H5Dwrite(io.in_mpi_dmh, H5T_NATIVE_DOUBLE, mem_dspace, file_dspace,
-                 H5P_DEFAULT, mpi.dpopsmax_hist[0]) ) < 0) HERR(routineName);
-  if (( H5Sclose(file_dspace) ) < 0) HERR(routineName);
-  if (( H5Sclose(mem_dspace) ) < 0) HERR(routineName);
+  long     s = col->slot;
+
+  offset[0] = col->ix;
+  offset[1] = col->iy;
+  writeSlab_p(io.in_mpi_tm, H5T_NATIVE_INT, 2, offset, count, &mpi.rank);
+  writeSlab_p(io.in_mpi_tn, H5T_NATIVE_INT, 2, offset, count, &task);
+  writeSlab_p(io.in_mpi_it, H5T_NATIVE_INT, 2, offset, count, &mpi.niter[s]);
+  writeSlab_p(io.in_mpi_conv, H5T_NATIVE_INT, 2, offset, count,
+              &mpi.convergence[s]);
+  writeSlab_p(io.in_mpi_zc, H5T_NATIVE_INT, 2, offset, count,
+              &mpi.zcut_hist[s]);
+  writeSlab_p(io.in_mpi_dm, H5T_NATIVE_DOUBLE, 2, offset, count,
+              &mpi.dpopsmax[s]);
+
+  count[2] = mpi.niter[s];
+  writeSlab_p(io.in_mpi_dmh, H5T_NATIVE_DOUBLE, 3, offset, count,
+              mpi.dpopsmax_hist[s]);
   return;
 }
 /* ------- end   --------------------------   writeMPI_p.c ------- */
@@ -786,3 +754,165 @@ void readConvergence(void) {
   return;
 }
 /* ------- end   -------------------------- readConvergence.c  --- */
+
+/* ------- begin -------------------------- copy_dataset.c ------- --- */
+static void copy_dataset(hid_t src, CopyGroup *cg, const char *name)
+/* Copies the reused columns of dataset name, shared among processes */
+{
+  const char routineName[] = "copyReused";
+  int      rank, a, axis, nproc, n;
+  long     i, j;
+  size_t   size;
+  hsize_t  dims[H5S_MAX_RANK], ddims[H5S_MAX_RANK], mdims[1];
+  hsize_t  offset[H5S_MAX_RANK], count[H5S_MAX_RANK];
+  hid_t    dst, src_dspace, dst_dspace, mem_dspace, type;
+  void    *buf;
+
+  if (!strcmp(name, REUSE_NAME)  ||
+      (H5Lexists(cg->dst, name, H5P_DEFAULT) <= 0)) return;
+
+  /* Only datasets with an (nx, ny) pair of axes hold columns */
+  axis = (cg->aux) ? 1 : 0;
+  if (( src_dspace = H5Dget_space(src) ) < 0) HERR(routineName);
+  if (( rank = H5Sget_simple_extent_dims(src_dspace, dims, NULL) ) < 0)
+    HERR(routineName);
+  if ((rank < axis + 2)  ||  (dims[axis] != (hsize_t) mpi.nx)  ||
+      (dims[axis + 1] != (hsize_t) mpi.ny)) {
+    if (( H5Sclose(src_dspace) ) < 0) HERR(routineName);
+    return;
+  }
+  if (( dst = H5Dopen2(cg->dst, name, H5P_DEFAULT) ) < 0) HERR(routineName);
+  if (( dst_dspace = H5Dget_space(dst) ) < 0) HERR(routineName);
+  if (H5Sget_simple_extent_dims(dst_dspace, ddims, NULL) != rank) {
+    sprintf(messageStr, "%s in %s has a different shape in this run",
+	    name, cg->file_name);
+    Error(ERROR_LEVEL_2, routineName, messageStr);
+  }
+  for (a = 0;  a < rank;  a++) {
+    if (ddims[a] != dims[a]) {
+      sprintf(messageStr, "%s in %s has a different shape in this run",
+	      name, cg->file_name);
+      Error(ERROR_LEVEL_2, routineName, messageStr);
+    }
+  }
+  if (( type = H5Dget_type(src) ) < 0) HERR(routineName);
+  if (H5Tis_variable_str(type) > 0) {
+    if (( H5Tclose(type) ) < 0) HERR(routineName);
+    if (( H5Sclose(dst_dspace) ) < 0) HERR(routineName);
+    if (( H5Sclose(src_dspace) ) < 0) HERR(routineName);
+    if (( H5Dclose(dst) ) < 0) HERR(routineName);
+    return;
+  }
+
+  /* One column is the full extent of all other axes */
+  mdims[0] = 1;
+  for (a = 0;  a < rank;  a++) {
+    offset[a] = 0;
+    count[a]  = dims[a];
+    if ((a != axis)  &&  (a != axis + 1)) mdims[0] *= dims[a];
+  }
+  count[axis]     = 1;
+  count[axis + 1] = 1;
+  size = H5Tget_size(type);
+  buf  = malloc(mdims[0] * size);
+  if (( mem_dspace = H5Screate_simple(1, mdims, NULL) ) < 0)
+    HERR(routineName);
+
+  MPI_Comm_size(mpi.comm, &nproc);
+  n = 0;
+  for (i = 0;  i < mpi.nx;  i++) {
+    for (j = 0;  j < mpi.ny;  j++) {
+      if (!mpi.reused[i][j]) continue;
+      if ((n++ % nproc) != mpi.rank) continue;
+
+      offset[axis]     = i;
+      offset[axis + 1] = j;
+      if (( H5Sselect_hyperslab(src_dspace, H5S_SELECT_SET, offset,
+                                NULL, count, NULL) ) < 0) HERR(routineName);
+      if (( H5Sselect_hyperslab(dst_dspace, H5S_SELECT_SET, offset,
+                                NULL, count, NULL) ) < 0) HERR(routineName);
+      if (( H5Dread(src, type, mem_dspace, src_dspace,
+                    H5P_DEFAULT, buf) ) < 0) HERR(routineName);
+      if (( H5Dwrite(dst, type, mem_dspace, dst_dspace,
+                     H5P_DEFAULT, buf) ) < 0) HERR(routineName);
+    }
+  }
+  free(buf);
+  if (( H5Sclose(mem_dspace) ) < 0) HERR(routineName);
+  if (( H5Tclose(type) ) < 0) HERR(routineName);
+  if (( H5Sclose(dst_dspace) ) < 0) HERR(routineName);
+  if (( H5Sclose(src_dspace) ) < 0) HERR(routineName);
+  if (( H5Dclose(dst) ) < 0) HERR(routineName);
+  return;
+}
+/* ------- end   -------------------------- copy_dataset.c ------- --- */
+
+/* ------- begin -------------------------- copy_link.c ---------- --- */
+static herr_t copy_link(hid_t group, const char *name,
+                        const H5L_info_t *info, void *op_data)
+/* H5Literate callback: copies a dataset or descends into a group */
+{
+  const char routineName[] = "copyReused";
+  CopyGroup *cg = (CopyGroup *) op_data, sub;
+  hid_t      obj;
+
+  if (( obj = H5Oopen(group, name, H5P_DEFAULT) ) < 0) HERR(routineName);
+
+  switch (H5Iget_type(obj)) {
+  case H5I_GROUP:
+    if (H5Lexists(cg->dst, name, H5P_DEFAULT) > 0) {
+      sub = *cg;
+      if (( sub.dst = H5Gopen(cg->dst, name, H5P_DEFAULT) ) < 0)
+        HERR(routineName);
+      if (( H5Literate(obj, H5_INDEX_NAME, H5_ITER_NATIVE, NULL,
+                       copy_link, &sub) ) < 0) HERR(routineName);
+      if (( H5Gclose(sub.dst) ) < 0) HERR(routineName);
+    }
+    break;
+  case H5I_DATASET:
+    copy_dataset(obj, cg, name);
+    break;
+  default:
+    break;
+  }
+  if (( H5Oclose(obj) ) < 0) HERR(routineName);
+  return 0;
+}
+/* ------- end   -------------------------- copy_link.c ---------- --- */
+
+/* ------- begin -------------------------- copy_file.c ---------- --- */
+static void copy_file(char *file_name, hid_t dst, bool_t aux)
+{
+  const char routineName[] = "copyReused";
+  CopyGroup cg;
+  hid_t     ncid;
+
+  if (( ncid = H5Fopen(file_name, H5F_ACC_RDONLY, H5P_DEFAULT) ) < 0)
+    HERR(routineName);
+  cg.dst       = dst;
+  cg.aux       = aux;
+  cg.file_name = file_name;
+  if (( H5Literate(ncid, H5_INDEX_NAME, H5_ITER_NATIVE, NULL,
+                   copy_link, &cg) ) < 0) HERR(routineName);
+  if (( H5Fclose(ncid) ) < 0) HERR(routineName);
+  return;
+}
+/* ------- end   -------------------------- copy_file.c ---------- --- */
+
+/* ------- begin -------------------------- copyReused.c --------- --- */
+void copyReused(void) {
+  /* Copies the output of the columns marked by reuse_columns from the
+     output files of the previous run. Every dataset that exists in
+     both runs and has the (x, y) axes is copied, so the previous run
+     must have the same wavelengths, atoms and output options. The
+     columns are shared among all processes. Must be called after all
+     output files are open.                                           */
+
+  if (mpi.reused == NULL) return;
+
+  copy_file(input.p15d_prev_ray,    (hid_t) io.ray_ncid, FALSE);
+  copy_file(input.p15d_prev_aux,    (hid_t) io.aux_ncid, TRUE);
+  copy_file(input.p15d_prev_indata, (hid_t) io.in_ncid,  FALSE);
+  return;
+}
+/* ------- end   -------------------------- copyReused.c --------- --- */
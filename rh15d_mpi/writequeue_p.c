@@ -0,0 +1,479 @@
+/* ------- file: -------------------------- writequeue_p.c ----------
+
+       Version:       rh2.0, 1.5-D plane-parallel
+       Last modified: Sun Oct 18 2026 --
+
+       --------------------------                      ----------RH-- */
+
+/* --- Output of the per-column results. Writes of finished columns
+       are copied with writeSlab_p into a staging block, which holds
+       up to 15D_WRITE_BATCH columns. A full block is written with one
+       H5Dwrite per dataset, the columns joined into a single union
+       hyperslab selection.
+
+       With 15D_WRITE_BUFFERS > 0 blocks are written by a background
+       thread, so that the HDF5 writes overlap with the next columns.
+       At most 15D_WRITE_BUFFERS blocks are kept in memory; when all
+       are in use, flushColumn_p waits for the writer (so there is
+       only overlap with two buffers or more). The writer thread needs
+       a thread-safe HDF5 library and MPI_THREAD_MULTIPLE, which is only
+       requested with RH15D_MPI_THREADS=MULTIPLE (see initParallel).
+
+       Without batching or writer thread, writes are done directly.
+                                                          --------- */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "rh.h"
+#include "error.h"
+#include "inputs.h"
+#include "parallel.h"
+#include "io.h"
+
+
+/* --- Function prototypes --                          -------------- */
+
+void *writeQueue_pthread(void *argument);
+
+
+/* --- One H5Dwrite of a staged column, data at start in the block -- */
+
+#define WQ_MAXRANK 5
+
+typedef struct {
+  hid_t    dset, memtype;
+  int      rank;
+  hsize_t  offset[WQ_MAXRANK], count[WQ_MAXRANK];
+  size_t   start, nbytes;
+} WriteReq;
+
+/* --- Staged writes of up to Ncol columns, the first Nreq_col of
+       them belonging to columns already finished -- */
+
+typedef struct {
+  int       Nreq, Nreq_col, Nalloc, Ncol;
+  size_t    size, alloc;
+  WriteReq *req;
+  char     *data;
+} StagedBlock;
+
+/* --- Contiguous piece of a request, at position pos in the file -- */
+
+typedef struct {
+  hsize_t     pos;
+  size_t      nbytes;
+  const char *src;
+} WriteRun;
+
+typedef struct {
+  bool_t           stage, threaded, done, aborting;
+  int              Nslot, Ncol, head, tail, Nfull;
+  StagedBlock     *slot;
+  pthread_t        thread;
+  pthread_mutex_t  lock;
+  pthread_cond_t   filled, emptied;
+} WriteQueue;
+
+
+/* --- Global variables --                             -------------- */
+
+extern InputData input;
+extern char messageStr[];
+extern MPI_data mpi;
+
+static WriteQueue wq = {FALSE, FALSE, FALSE, FALSE, 0, 1, 0, 0, 0, NULL};
+static WriteReq  *sort_req;
+
+
+/* ------- begin -------------------------- writeReq.c ------------- */
+static void writeReq(WriteReq *req, const void *buf)
+/* Writes buf to the hyperslab offset/count of req->dset */
+{
+  const char routineName[] = "writeReq";
+  int      n;
+  hsize_t  dims[1];
+  hid_t    file_dspace, mem_dspace;
+
+  dims[0] = 1;
+  for (n = 0;  n < req->rank;  n++) dims[0] *= req->count[n];
+  if (( mem_dspace = H5Screate_simple(1, dims, NULL) ) < 0)
+    HERR(routineName);
+  if (( file_dspace = H5Dget_space(req->dset) ) < 0) HERR(routineName);
+  if (( H5Sselect_hyperslab(file_dspace, H5S_SELECT_SET, req->offset,
+                            NULL, req->count, NULL) ) < 0) HERR(routineName);
+  if (( H5Dwrite(req->dset, req->memtype, mem_dspace, file_dspace,
+                 H5P_DEFAULT, buf) ) < 0) HERR(routineName);
+  if (( H5Sclose(file_dspace) ) < 0) HERR(routineName);
+  if (( H5Sclose(mem_dspace) ) < 0) HERR(routineName);
+}
+/* ------- end   -------------------------- writeReq.c ------------- */
+
+/* ------- begin -------------------------- qsreq.c ---------------- */
+static int qsreq(const void *v1, const void *v2)
+/* Orders request indices by dataset, memory type and staging order */
+{
+  const WriteReq *r1 = &sort_req[*(const int *) v1],
+                 *r2 = &sort_req[*(const int *) v2];
+
+  if (r1->dset != r2->dset) return (r1->dset < r2->dset) ? -1 : 1;
+  if (r1->memtype != r2->memtype) return (r1->memtype < r2->memtype) ? -1 : 1;
+  return *(const int *) v1 - *(const int *) v2;
+}
+/* ------- end   -------------------------- qsreq.c ---------------- */
+
+/* ------- begin -------------------------- qsrun.c ---------------- */
+static int qsrun(const void *v1, const void *v2)
+{
+  hsize_t p1 = ((const WriteRun *) v1)->pos, p2 = ((const WriteRun *) v2)->pos;
+
+  return (p1 < p2) ? -1 : (p1 > p2) ? 1 : 0;
+}
+/* ------- end   -------------------------- qsrun.c ---------------- */
+
+/* ------- begin -------------------------- writeUnion.c ----------- */
+static void writeUnion(StagedBlock *blk, int *idx, int Nreq)
+/* Writes Nreq requests to the same dataset with a single H5Dwrite.
+   HDF5 fills a union of hyperslabs in file order, so the data are
+   reordered by file position, one contiguous run (last axis of a
+   request) at a time. Overlapping requests are written one by one. */
+{
+  const char routineName[] = "writeUnion";
+  int       rank, n, a, r, Nrun = 0, Ntot;
+  size_t    elsize, runbytes;
+  hsize_t   dims[WQ_MAXRANK], stride[WQ_MAXRANK], i[WQ_MAXRANK], pos;
+  hsize_t   mdims[1];
+  hid_t     dset, file_dspace, mem_dspace;
+  char     *buf;
+  WriteReq *req;
+  WriteRun *run;
+
+  dset = blk->req[idx[0]].dset;
+  if (( file_dspace = H5Dget_space(dset) ) < 0) HERR(routineName);
+  if (( rank = H5Sget_simple_extent_dims(file_dspace, dims, NULL) ) < 0)
+    HERR(routineName);
+  stride[rank - 1] = 1;
+  for (a = rank - 2;  a >= 0;  a--) stride[a] = stride[a + 1] * dims[a + 1];
+
+  /* --- Count runs and build the union selection --- */
+  elsize  = H5Tget_size(blk->req[idx[0]].memtype);
+  mdims[0] = 0;
+  for (n = 0;  n < Nreq;  n++) {
+    req = &blk->req[idx[n]];
+    for (r = 1, a = 0;  a < rank - 1;  a++) r *= req->count[a];
+    Nrun     += r;
+    mdims[0] += r * req->count[rank - 1];
+    if (( H5Sselect_hyperslab(file_dspace, (n == 0) ? H5S_SELECT_SET :
+			      H5S_SELECT_OR, req->offset, NULL, req->count,
+			      NULL) ) < 0) HERR(routineName);
+  }
+  if (H5Sget_select_npoints(file_dspace) != (hssize_t) mdims[0]) {
+    if (( H5Sclose(file_dspace) ) < 0) HERR(routineName);
+    for (n = 0;  n < Nreq;  n++)
+      writeReq(&blk->req[idx[n]], blk->data + blk->req[idx[n]].start);
+    return;
+  }
+
+  /* --- Contiguous runs in file order --- */
+  run  = (WriteRun *) malloc(Nrun * sizeof(WriteRun));
+  Ntot = 0;
+  for (n = 0;  n < Nreq;  n++) {
+    req = &blk->req[idx[n]];
+    runbytes = req->count[rank - 1] * elsize;
+    for (a = 0;  a < rank;  a++) i[a] = 0;
+    for (r = 0;  ;  r++) {
+      pos = req->offset[rank - 1];
+      for (a = 0;  a < rank - 1;  a++) pos += (req->offset[a] + i[a]) * stride[a];
+      run[Ntot].pos    = pos;
+      run[Ntot].nbytes = runbytes;
+      run[Ntot++].src  = blk->data + req->start + r * runbytes;
+
+      /* Next index of all but the last axis */
+      for (a = rank - 2;  a >= 0;  a--) {
+	if (++i[a] < req->count[a]) break;
+	i[a] = 0;
+      }
+      if (a < 0) break;
+    }
+  }
+  qsort(run, Nrun, sizeof(WriteRun), qsrun);
+
+  buf = (char *) malloc(mdims[0] * elsize);
+  for (n = 0, pos = 0;  n < Nrun;  n++) {
+    memcpy(buf + pos, run[n].src, run[n].nbytes);
+    pos += run[n].nbytes;
+  }
+  free(run);
+
+  if (( mem_dspace = H5Screate_simple(1, mdims, NULL) ) < 0)
+    HERR(routineName);
+  if (( H5Dwrite(dset, blk->req[idx[0]].memtype, mem_dspace, file_dspace,
+                 H5P_DEFAULT, buf) ) < 0) HERR(routineName);
+  if (( H5Sclose(mem_dspace) ) < 0) HERR(routineName);
+  if (( H5Sclose(file_dspace) ) < 0) HERR(routineName);
+  free(buf);
+}
+/* ------- end   -------------------------- writeUnion.c ----------- */
+
+/* ------- begin -------------------------- writeBlock.c ----------- */
+static void writeBlock(StagedBlock *blk, int Nreq)
+/* Writes the first Nreq requests of blk, one H5Dwrite per dataset,
+   and empties the block */
+{
+  int n, m, *idx;
+
+  if (Nreq > 0) {
+    idx = (int *) malloc(Nreq * sizeof(int));
+    for (n = 0;  n < Nreq;  n++) idx[n] = n;
+    sort_req = blk->req;
+    qsort(idx, Nreq, sizeof(int), qsreq);
+
+    for (n = 0;  n < Nreq;  n = m) {
+      for (m = n + 1;  m < Nreq;  m++)
+	if ((blk->req[idx[m]].dset != blk->req[idx[n]].dset) ||
+	    (blk->req[idx[m]].memtype != blk->req[idx[n]].memtype)) break;
+      if (m - n == 1)
+	writeReq(&blk->req[idx[n]], blk->data + blk->req[idx[n]].start);
+      else
+	writeUnion(blk, idx + n, m - n);
+    }
+    free(idx);
+  }
+  blk->Nreq = blk->Nreq_col = blk->Ncol = 0;
+  blk->size = 0;
+}
+/* ------- end   -------------------------- writeBlock.c ----------- */
+
+/* ------- begin -------------------------- initWriteQueue_p.c ----- */
+void initWriteQueue_p(void)
+{
+  const char routineName[] = "initWriteQueue_p";
+  bool_t threadsafe = FALSE;
+  int    status;
+
+  wq.stage    = FALSE;
+  wq.threaded = FALSE;
+  wq.aborting = FALSE;
+  wq.Ncol     = MAX(input.p15d_wbatch, 1);
+  wq.Nslot    = 1;
+
+  if (input.p15d_wbuf > 0) {
+#ifdef H5_HAVE_THREADSAFE
+    threadsafe = TRUE;
+#endif
+    if (!threadsafe  ||  (mpi.thread_level < MPI_THREAD_MULTIPLE)) {
+      sprintf(messageStr, "15D_WRITE_BUFFERS needs %s, writing output "
+	      "from the main thread\n", (threadsafe) ?
+	      "MPI_THREAD_MULTIPLE (" MPI_THREADS_ENV "=MULTIPLE)" :
+	      "a thread-safe HDF5 library");
+      Error(WARNING, routineName, messageStr);
+    } else {
+      wq.threaded = TRUE;
+      wq.Nslot    = input.p15d_wbuf;
+    }
+  }
+  if (!wq.threaded  &&  wq.Ncol == 1) return;
+
+  wq.slot  = (StagedBlock *) calloc(wq.Nslot, sizeof(StagedBlock));
+  wq.head  = wq.tail = wq.Nfull = 0;
+  wq.done  = FALSE;
+  wq.stage = TRUE;
+
+  if (!wq.threaded) return;
+  if ((status = pthread_mutex_init(&wq.lock, NULL)) ||
+      (status = pthread_cond_init(&wq.filled, NULL)) ||
+      (status = pthread_cond_init(&wq.emptied, NULL)) ||
+      (status = pthread_create(&wq.thread, NULL,
+                               writeQueue_pthread, NULL))) {
+    sprintf(messageStr, "Unable to start writer thread, error: %s",
+	    strerror(status));
+    Error(ERROR_LEVEL_2, routineName, messageStr);
+  }
+}
+/* ------- end   -------------------------- initWriteQueue_p.c ----- */
+
+/* ------- begin -------------------------- writeSlab_p.c ---------- */
+void writeSlab_p(hid_t dset, hid_t memtype, int rank, const hsize_t *offset,
+                 const hsize_t *count, const void *buf)
+/* Writes the contiguous buffer buf to the hyperslab offset/count of
+   dset (or of its shard), or stages a copy of it in the current block */
+{
+  int          n;
+  WriteReq    *req, now;
+  StagedBlock *blk;
+
+  if (input.p15d_shard) dset = shardSlab_p(dset, offset);
+  if (!wq.stage) {
+    now.dset    = dset;
+    now.memtype = memtype;
+    now.rank    = rank;
+    for (n = 0;  n < rank;  n++) {
+      now.offset[n] = offset[n];
+      now.count[n]  = count[n];
+    }
+    writeReq(&now, buf);
+    return;
+  }
+  /* The head block belongs to this thread until it is handed over */
+  blk = &wq.slot[wq.head];
+  if (blk->Nreq == blk->Nalloc) {
+    blk->Nalloc = MAX(2 * blk->Nalloc, 16);
+    blk->req = (WriteReq *) realloc(blk->req, blk->Nalloc * sizeof(WriteReq));
+  }
+  req = &blk->req[blk->Nreq++];
+  req->dset    = dset;
+  req->memtype = memtype;
+  req->rank    = rank;
+  req->nbytes  = H5Tget_size(memtype);
+  for (n = 0;  n < rank;  n++) {
+    req->offset[n] = offset[n];
+    req->count[n]  = count[n];
+    req->nbytes   *= count[n];
+  }
+  req->start = blk->size;
+  if (blk->size + req->nbytes > blk->alloc) {
+    blk->alloc = MAX(2 * blk->alloc, blk->size + req->nbytes);
+    blk->data  = (char *) realloc(blk->data, blk->alloc);
+  }
+  memcpy(blk->data + req->start, buf, req->nbytes);
+  blk->size += req->nbytes;
+}
+/* ------- end   -------------------------- writeSlab_p.c ---------- */
+
+/* ------- begin -------------------------- handOver.c ------------- */
+static void handOver(void)
+/* Writes the head block, or hands it to the writer thread, waiting
+   if all blocks are in use */
+{
+  StagedBlock *blk = &wq.slot[wq.head];
+
+  if (blk->Nreq == 0) return;
+  if (!wq.threaded) {
+    writeBlock(blk, blk->Nreq);
+    return;
+  }
+  pthread_mutex_lock(&wq.lock);
+  wq.head = (wq.head + 1) % wq.Nslot;
+  wq.Nfull++;
+  pthread_cond_signal(&wq.filled);
+  while (wq.Nfull == wq.Nslot) pthread_cond_wait(&wq.emptied, &wq.lock);
+  pthread_mutex_unlock(&wq.lock);
+}
+/* ------- end   -------------------------- handOver.c ------------- */
+
+/* ------- begin -------------------------- flushColumn_p.c -------- */
+void flushColumn_p(void)
+/* Marks the end of the output of a column, the block goes out when it
+   has 15D_WRITE_BATCH columns */
+{
+  StagedBlock *blk;
+
+  if (!wq.stage) return;
+
+  blk = &wq.slot[wq.head];
+  if (blk->Nreq > blk->Nreq_col) {
+    blk->Nreq_col = blk->Nreq;
+    blk->Ncol++;
+  }
+  if (blk->Ncol >= wq.Ncol) handOver();
+}
+/* ------- end   -------------------------- flushColumn_p.c -------- */
+
+/* ------- begin -------------------------- syncWriteQueue_p.c ----- */
+void syncWriteQueue_p(void)
+/* Sends out the current block without waiting for it to be full */
+{
+  if (!wq.stage) return;
+
+  flushColumn_p();
+  handOver();
+}
+/* ------- end   -------------------------- syncWriteQueue_p.c ----- */
+
+/* ------- begin -------------------------- writeQueue_pthread.c --- */
+void *writeQueue_pthread(void *argument)
+{
+  StagedBlock *blk;
+
+  pthread_mutex_lock(&wq.lock);
+  for (;;) {
+    while (wq.Nfull == 0  &&  !wq.done)
+      pthread_cond_wait(&wq.filled, &wq.lock);
+    if (wq.Nfull == 0) break;
+    blk = &wq.slot[wq.tail];
+    pthread_mutex_unlock(&wq.lock);
+
+    writeBlock(blk, blk->Nreq);
+
+    pthread_mutex_lock(&wq.lock);
+    wq.tail = (wq.tail + 1) % wq.Nslot;
+    wq.Nfull--;
+    pthread_cond_signal(&wq.emptied);
+  }
+  pthread_mutex_unlock(&wq.lock);
+  return NULL;
+}
+/* ------- end   -------------------------- writeQueue_pthread.c --- */
+
+/* ------- begin -------------------------- stopWriter.c ----------- */
+static void stopWriter(void)
+/* Lets the writer thread finish the queued blocks and waits for it */
+{
+  pthread_mutex_lock(&wq.lock);
+  wq.done = TRUE;
+  pthread_cond_signal(&wq.filled);
+  pthread_mutex_unlock(&wq.lock);
+  pthread_join(wq.thread, NULL);
+}
+/* ------- end   -------------------------- stopWriter.c ----------- */
+
+/* ------- begin -------------------------- closeWriteQueue_p.c ---- */
+void closeWriteQueue_p(void)
+/* Writes all staged columns and stops the writer thread. Must be
+   called before the output files are closed. */
+{
+  int n;
+
+  if (!wq.stage) return;
+
+  syncWriteQueue_p();
+  if (wq.threaded) {
+    stopWriter();
+    pthread_cond_destroy(&wq.filled);
+    pthread_cond_destroy(&wq.emptied);
+    pthread_mutex_destroy(&wq.lock);
+  }
+  for (n = 0;  n < wq.Nslot;  n++) {
+    if (wq.slot[n].req)  free(wq.slot[n].req);
+    if (wq.slot[n].data) free(wq.slot[n].data);
+  }
+  free(wq.slot);
+  wq.stage    = FALSE;
+  wq.threaded = FALSE;
+}
+/* ------- end   -------------------------- closeWriteQueue_p.c ---- */
+
+/* ------- begin -------------------------- abortWriteQueue_p.c ---- */
+void abortWriteQueue_p(void)
+/* Called before a fatal abort: writes out the staged output of all
+   finished columns and closes the shards. Does nothing if the error
+   came from the writer thread, or from writing during a previous
+   call. */
+{
+  StagedBlock *blk;
+
+  if (wq.aborting) return;
+  if (wq.threaded  &&  pthread_equal(pthread_self(), wq.thread)) return;
+  wq.aborting = TRUE;
+
+  if (wq.stage) {
+    if (wq.threaded) stopWriter();
+    blk = &wq.slot[wq.head];
+    writeBlock(blk, blk->Nreq_col);
+  }
+  closeShards_p();
+}
+/* ------- end   -------------------------- abortWriteQueue_p.c ---- */
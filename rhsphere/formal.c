@@ -217,7 +217,7 @@ void addtoRates_sphere(int nspect, Ray *ray, double *P,
   twohc = 2.0*HPLANCK*CLIGHT / CUBE(NM_TO_M);
 
   as = &spectrum.as[nspect];
-  nt = nspect % input.Nthreads;
+  nt = threadSlot();
 
   for (nact = 0;  nact < atmos.Nactiveatom;  nact++) {
     atom = atmos.activeatoms[nact];
@@ -291,7 +291,7 @@ void addtoGamma_sphere(int nspect, Ray *ray, double *P, double *Psi)
   twohc = 2.0*HPLANCK*CLIGHT / CUBE(NM_TO_M);
 
   as = &spectrum.as[nspect];
-  nt = nspect % input.Nthreads;
+  nt = threadSlot();
 
   if (containsActive(as))
     Ieff = (double *) malloc(atmos.Nspace * sizeof(double));
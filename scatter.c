@@ -51,16 +51,14 @@ extern char messageStr[];
 void PRDScatter(AtomicLine *PRDline, enum Interpolation representation)
 {
   const char routineName[] = "scatterIntegral";
-  register int  la, k, lap, kr, ip, kxrd;
+  register int  la, k, kr, ip, kxrd;
 
   char    filename[MAX_LINE_SIZE];
-  bool_t  hunt, initialize;
-  int     Np, Nread, Nwrite, ij, Nsubordinate;
-  double  q_emit, q0, qN, *q_abs = NULL, *qp = NULL, *wq = NULL,
-         *qpp = NULL, *gii = NULL, *adamp, cDop, gnorm, *J = NULL,
-          Jbar, scatInt, *J_k = NULL, *Pj, gamma, waveratio;
+  bool_t  initialize;
+  int     ij, Nsubordinate;
+  double *adamp, cDop, *Pj;
   Atom *atom;
-  AtomicLine *line, **XRD, *XRDline;
+  AtomicLine *line, **XRD;
   AtomicContinuum *continuum;
 
   /* --- This the static case --                       -------------- */ 
@@ -145,154 +143,12 @@ void PRDScatter(AtomicLine *PRDline, enum Interpolation representation)
       if (continuum->i == PRDline->j) Pj[k] += continuum->Rij[k];
     }
   }
-  /* --- Loop over subordinate lines --                -------------- */
+  /* --- Scattering integrals of the subordinate lines -- --------- */
 
-  for (kxrd = 0;  kxrd < Nsubordinate;  kxrd++) {
-    XRDline = XRD[kxrd];
-    waveratio = XRDline->lambda0 / PRDline->lambda0;
+  prdRedistribute(PRDline, XRD, Nsubordinate, representation,
+		  initialize, Pj, adamp, spectrum.J);
 
-    J_k   = realloc(J_k, XRDline->Nlambda * sizeof(double));
-    q_abs = realloc(q_abs, XRDline->Nlambda * sizeof(double));
-
-    /* --- Loop over all spatial locations --          -------------- */
-
-    for (k = 0;  k < atmos.Nspace;  k++) {
-      gamma = atom->n[XRDline->i][k] / atom->n[PRDline->j][k] *
-	XRDline->Bij / Pj[k];
-      Jbar = XRDline->Rij[k] / XRDline->Bij;
-
-      /* --- Get local mean intensity and wavelength in Doppler units */
-
-      for (la = 0;  la < XRDline->Nlambda;  la++) {
-	J_k[la]   = spectrum.J[XRDline->Nblue + la][k];
-	q_abs[la] = (XRDline->lambda[la] - XRDline->lambda0) * CLIGHT /
-	  (XRDline->lambda0 * atom->vbroad[k]);
-      }
-      switch (representation) {
-      case LINEAR:
-	break;
-      case SPLINE:
-	splineCoef(XRDline->Nlambda, q_abs, J_k);
-	break;
-      case EXP_SPLINE:
-	exp_splineCoef(XRDline->Nlambda, q_abs, J_k, TENSION);
-	break;
-      }
-      /* --- Outer wavelength loop over emission wavelengths -- ----- */
-
-      for (la = 0;  la < PRDline->Nlambda;  la++) {
-	q_emit = (PRDline->lambda[la] - PRDline->lambda0) * CLIGHT /
-	  (PRDline->lambda0 * atom->vbroad[k]);
-
-	/* --- Establish integration limits over absorption wavelength,
-	       using only regions where the redistribution function is
-	       non-zero. (See also function GII.) --   -------------- */
- 
-	if (fabs(q_emit) < PRD_QCORE) {
-	  q0 = -PRD_QWING;
-	  qN =  PRD_QWING;
-	} else {
-	  if (fabs(q_emit) < PRD_QWING) {
-	    if (q_emit > 0.0) {
-	      q0 = -PRD_QWING;
-	      qN = waveratio * (q_emit + PRD_QSPREAD);
-	    } else {
-	      q0 = waveratio * (q_emit - PRD_QSPREAD);
-	      qN = PRD_QWING;
-	    }
-	  } else {
-	    q0 = waveratio * (q_emit - PRD_QSPREAD);
-	    qN = waveratio * (q_emit + PRD_QSPREAD);
-	  }
-	}
-	Np = (int) ((qN - q0) / PRD_DQ) + 1;
-	qp = (double *) realloc(qp,  Np * sizeof(double));
-	for (lap = 1, qp[0] = q0;  lap < Np;  lap++)
-	  qp[lap] = qp[lap - 1] + PRD_DQ;
-
-	/* --- Fold interpolation of J for symmetric lines. -- ------ */
-
-	if (XRDline->symmetric) {
-	  qpp = (double *) realloc(qpp,  Np * sizeof(double));
-	  for (lap = 0;  lap < Np;  lap++) qpp[lap] = fabs(qp[lap]);
-	}
-
-	/* --- Interpolate mean intensity onto fine grid. Choose linear,
-	       spline or exponential spline interpolation -- -------- */
-
-	J = (double *) realloc(J,  Np * sizeof(double));
-	switch (representation) {
-	case LINEAR:
-	  Linear(XRDline->Nlambda, q_abs, J_k, Np,
-		 (XRDline->symmetric) ? qpp : qp, J, hunt=TRUE);
-	  break;
-	case SPLINE:
-	  splineEval(Np, (XRDline->symmetric) ? qpp : qp, J, hunt=TRUE);
-	  break;
-	case EXP_SPLINE:
-	  exp_splineEval(Np, (XRDline->symmetric) ? qpp : qp, J, hunt=TRUE);
-	  break;
-	}
-	/* --- Compute the redistribution weights --   -------------- */
-
-	gii = (double *) realloc(gii, Np * sizeof(double));
-	if (initialize) {
-
-	  /* --- Integration weights (See: Press et al. Numerical Recipes,
-	         p. 107, eq. 4.1.12) --                -------------- */
-
-	  wq = (double *) realloc(wq,  Np * sizeof(double));
-	  wq[0] = 5.0/12.0  * PRD_DQ;
-	  wq[1] = 13.0/12.0 * PRD_DQ;
-	  for (lap = 2;  lap < Np-2;  lap++) wq[lap] = PRD_DQ;
-	  wq[Np-1] = 5.0/12.0  * PRD_DQ;
-	  wq[Np-2] = 13.0/12.0 * PRD_DQ;
-
-	  for (lap = 0;  lap < Np;  lap++)
-	    gii[lap] = GII(adamp[k], waveratio, q_emit, qp[lap]) * wq[lap];
-
-	  if ((Nwrite =
-	       fwrite(gii, sizeof(double), Np, PRDline->fp_GII)) != Np) {
-	    sprintf(messageStr,
-		  "Unable to write proper number of redistribution weights\n"
-		  " Wrote %d instead of %d.\n Line %d -> %d, la = %d, k = %d",
-		    Nwrite, Np, XRDline->j, XRDline->i, la, k);
-	    Error(ERROR_LEVEL_2, routineName, messageStr);
-	  }
-	} else {
-	  if ((Nread =
-	       fread(gii, sizeof(double), Np, PRDline->fp_GII)) != Np) {
-	    sprintf(messageStr,
-		  "Unable to read proper number of redistribution weights\n"
-		  " Read %d instead of %d.\n Line %d -> %d, la = %d, k = %d",
-		  Nread, Np, XRDline->j, XRDline->i, la, k);
-	    Error(ERROR_LEVEL_2, routineName, messageStr);
-	  }
-	}
-	/* --- Inner wavelength loop doing actual wavelength integration
-               over absorption wavelengths --          -------------- */
-
-	gnorm   = 0.0;
-	scatInt = 0.0;
-	for (lap = 0;  lap < Np;  lap++) {
-	  gnorm   += gii[lap];
-	  scatInt += J[lap] * gii[lap];
-	}
-	PRDline->rho_prd[la][k] += gamma*(scatInt/gnorm - Jbar);
-      }
-    }
-  }
-  /* --- Clean temporary variable space --             -------------- */
-
-  for (kxrd = 0;  kxrd < Nsubordinate;  kxrd++) {
-    if (XRD[kxrd]->symmetric) {
-      free(qpp);
-      break;
-    }
-  }
-  free(J_k);    free(q_abs);  free(gii);
-  free(qp);     free(wq);     free(J);
-  free(XRD);    free(Pj);     free(adamp);
+  free(XRD);  free(Pj);  free(adamp);
 
   sprintf(messageStr, "Scatter Int %5.1f", PRDline->lambda0);
   getCPU(3, TIME_POLL, messageStr);
@@ -303,17 +159,15 @@ void PRDScatter(AtomicLine *PRDline, enum Interpolation representation)
 
 void PRDAngleApproxScatter(AtomicLine *PRDline, enum Interpolation representation)
 {
- const char routineName[] = "PRDAngleApproxScatter";
-  register int  la, k, lap, kr, ip, kxrd;
+  const char routineName[] = "PRDAngleApproxScatter";
+  register int  la, k, kr, ip, kxrd;
 
   char    filename[MAX_LINE_SIZE];
-  bool_t  hunt, initialize;
-  int     Np, Nread, Nwrite, ij, Nsubordinate;
-  double  q_emit, q0, qN, *q_abs = NULL, *qp = NULL, *wq = NULL,
-         *qpp = NULL, *gii = NULL, *adamp, cDop, gnorm, *J = NULL,
-          Jbar, scatInt, *J_k = NULL, *Pj, gamma, waveratio;
+  bool_t  initialize;
+  int     ij, Nsubordinate;
+  double *adamp, cDop, *Pj;
   Atom *atom;
-  AtomicLine *line, **XRD, *XRDline;
+  AtomicLine *line, **XRD;
   AtomicContinuum *continuum;
 
   /* --- This the static case --                       -------------- */ 
@@ -398,154 +252,12 @@ void PRDAngleApproxScatter(AtomicLine *PRDline, enum Interpolation representatio
       if (continuum->i == PRDline->j) Pj[k] += continuum->Rij[k];
     }
   }
-  /* --- Loop over subordinate lines --                -------------- */
+  /* --- Scattering integrals of the subordinate lines -- --------- */
 
-  for (kxrd = 0;  kxrd < Nsubordinate;  kxrd++) {
-    XRDline = XRD[kxrd];
-    waveratio = XRDline->lambda0 / PRDline->lambda0;
+  prdRedistribute(PRDline, XRD, Nsubordinate, representation,
+		  initialize, Pj, adamp, spectrum.Jgas);
 
-    J_k   = realloc(J_k, XRDline->Nlambda * sizeof(double));
-    q_abs = realloc(q_abs, XRDline->Nlambda * sizeof(double));
-
-    /* --- Loop over all spatial locations --          -------------- */
-
-    for (k = 0;  k < atmos.Nspace;  k++) {
-      gamma = atom->n[XRDline->i][k] / atom->n[PRDline->j][k] *
-	XRDline->Bij / Pj[k];
-      Jbar = XRDline->Rij[k] / XRDline->Bij;
-
-      /* --- Get local mean intensity and wavelength in Doppler units */
-
-      for (la = 0;  la < XRDline->Nlambda;  la++) {
-	J_k[la]   = spectrum.Jgas[XRDline->Nblue + la][k];
-	q_abs[la] = (XRDline->lambda[la] - XRDline->lambda0) * CLIGHT /
-	  (XRDline->lambda0 * atom->vbroad[k]);
-      }
-      switch (representation) {
-      case LINEAR:
-	break;
-      case SPLINE:
-	splineCoef(XRDline->Nlambda, q_abs, J_k);
-	break;
-      case EXP_SPLINE:
-	exp_splineCoef(XRDline->Nlambda, q_abs, J_k, TENSION);
-	break;
-      }
-      /* --- Outer wavelength loop over emission wavelengths -- ----- */
-
-      for (la = 0;  la < PRDline->Nlambda;  la++) {
-	q_emit = (PRDline->lambda[la] - PRDline->lambda0) * CLIGHT /
-	  (PRDline->lambda0 * atom->vbroad[k]);
-
-	/* --- Establish integration limits over absorption wavelength,
-	       using only regions where the redistribution function is
-	       non-zero. (See also function GII.) --   -------------- */
- 
-	if (fabs(q_emit) < PRD_QCORE) {
-	  q0 = -PRD_QWING;
-	  qN =  PRD_QWING;
-	} else {
-	  if (fabs(q_emit) < PRD_QWING) {
-	    if (q_emit > 0.0) {
-	      q0 = -PRD_QWING;
-	      qN = waveratio * (q_emit + PRD_QSPREAD);
-	    } else {
-	      q0 = waveratio * (q_emit - PRD_QSPREAD);
-	      qN = PRD_QWING;
-	    }
-	  } else {
-	    q0 = waveratio * (q_emit - PRD_QSPREAD);
-	    qN = waveratio * (q_emit + PRD_QSPREAD);
-	  }
-	}
-	Np = (int) ((qN - q0) / PRD_DQ) + 1;
-	qp = (double *) realloc(qp,  Np * sizeof(double));
-	for (lap = 1, qp[0] = q0;  lap < Np;  lap++)
-	  qp[lap] = qp[lap - 1] + PRD_DQ;
-
-	/* --- Fold interpolation of J for symmetric lines. -- ------ */
-
-	if (XRDline->symmetric) {
-	  qpp = (double *) realloc(qpp,  Np * sizeof(double));
-	  for (lap = 0;  lap < Np;  lap++) qpp[lap] = fabs(qp[lap]);
-	}
-
-	/* --- Interpolate mean intensity onto fine grid. Choose linear,
-	       spline or exponential spline interpolation -- -------- */
-
-	J = (double *) realloc(J,  Np * sizeof(double));
-	switch (representation) {
-	case LINEAR:
-	  Linear(XRDline->Nlambda, q_abs, J_k, Np,
-		 (XRDline->symmetric) ? qpp : qp, J, hunt=TRUE);
-	  break;
-	case SPLINE:
-	  splineEval(Np, (XRDline->symmetric) ? qpp : qp, J, hunt=TRUE);
-	  break;
-	case EXP_SPLINE:
-	  exp_splineEval(Np, (XRDline->symmetric) ? qpp : qp, J, hunt=TRUE);
-	  break;
-	}
-	/* --- Compute the redistribution weights --   -------------- */
-
-	gii = (double *) realloc(gii, Np * sizeof(double));
-	if (initialize) {
-
-	  /* --- Integration weights (See: Press et al. Numerical Recipes,
-	         p. 107, eq. 4.1.12) --                -------------- */
-
-	  wq = (double *) realloc(wq,  Np * sizeof(double));
-	  wq[0] = 5.0/12.0  * PRD_DQ;
-	  wq[1] = 13.0/12.0 * PRD_DQ;
-	  for (lap = 2;  lap < Np-2;  lap++) wq[lap] = PRD_DQ;
-	  wq[Np-1] = 5.0/12.0  * PRD_DQ;
-	  wq[Np-2] = 13.0/12.0 * PRD_DQ;
-
-	  for (lap = 0;  lap < Np;  lap++)
-	    gii[lap] = GII(adamp[k], waveratio, q_emit, qp[lap]) * wq[lap];
-
-	  if ((Nwrite =
-	       fwrite(gii, sizeof(double), Np, PRDline->fp_GII)) != Np) {
-	    sprintf(messageStr,
-		  "Unable to write proper number of redistribution weights\n"
-		  " Wrote %d instead of %d.\n Line %d -> %d, la = %d, k = %d",
-		    Nwrite, Np, XRDline->j, XRDline->i, la, k);
-	    Error(ERROR_LEVEL_2, routineName, messageStr);
-	  }
-	} else {
-	  if ((Nread =
-	       fread(gii, sizeof(double), Np, PRDline->fp_GII)) != Np) {
-	    sprintf(messageStr,
-		  "Unable to read proper number of redistribution weights\n"
-		  " Read %d instead of %d.\n Line %d -> %d, la = %d, k = %d",
-		  Nread, Np, XRDline->j, XRDline->i, la, k);
-	    Error(ERROR_LEVEL_2, routineName, messageStr);
-	  }
-	}
-	/* --- Inner wavelength loop doing actual wavelength integration
-               over absorption wavelengths --          -------------- */
-
-	gnorm   = 0.0;
-	scatInt = 0.0;
-	for (lap = 0;  lap < Np;  lap++) {
-	  gnorm   += gii[lap];
-	  scatInt += J[lap] * gii[lap];
-	}
-	PRDline->rho_prd[la][k] += gamma*(scatInt/gnorm - Jbar);
-      }
-    }
-  }
-  /* --- Clean temporary variable space --             -------------- */
-
-  for (kxrd = 0;  kxrd < Nsubordinate;  kxrd++) {
-    if (XRD[kxrd]->symmetric) {
-      free(qpp);
-      break;
-    }
-  }
-  free(J_k);    free(q_abs);  free(gii);
-  free(qp);     free(wq);     free(J);
-  free(XRD);    free(Pj);     free(adamp);
+  free(XRD);  free(Pj);  free(adamp);
 
   sprintf(messageStr, "Scatter Int %5.1f", PRDline->lambda0);
   getCPU(3, TIME_POLL, messageStr);
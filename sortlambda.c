@@ -64,7 +64,7 @@ void SortLambda()
   result = TRUE;
 
   if (strcmp(input.wavetable_input, "none")) {
-    if ((fp_wavetable = fopen(input.wavetable_input, "r")) == NULL) {
+    if ((fp_wavetable = fopenInput(input.wavetable_input)) == NULL) {
       sprintf(messageStr, "Unable to open input file %s",
 	      input.wavetable_input);
       Error(ERROR_LEVEL_2, routineName, messageStr);
@@ -338,6 +338,11 @@ void SortLambda()
 	free(continuum->lambda);
 	continuum->lambda = spectrum.lambda + continuum->Nblue;
 	free(alpha_original);
+
+	/* --- Spline table belongs to the original wavelength grid - */
+
+	free(continuum->alpha_M2);
+	continuum->alpha_M2 = NULL;
       }
     }
     /* --- Then go through the bound-bound transitions -- ----------- */
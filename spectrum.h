@@ -68,6 +68,7 @@ bool_t containsPolarized(ActiveSet *as);
 bool_t containsBoundBound(ActiveSet *as);
 bool_t containsPRDline(ActiveSet *as);
 bool_t containsActive(ActiveSet *as);
+int    spectrumQueue(bool_t redistribute, int *queue);
 
 void init_as(ActiveSet *as);
 void alloc_as(int nspect, bool_t crosscoupling);
@@ -19,27 +19,21 @@
 
 /* --- Global variables --                             -------------- */
 
-static bool_t  ascend;
 static int     Ntable;
-static double *xtable, xmin, xmax;
+static double *xtable, *ytable, *M = NULL;
 
-/* ------- begin -------------------------- splineCoef.c ------------ */
-
-static double *M = NULL, *ytable;
+/* ------- begin -------------------------- splineTable.c ----------- */
 
-void splineCoef(int N, double *x, double *y)
+void splineTable(int N, double *x, double *y, double *M2, double *u)
 {
   register int j;
-  static double *u = NULL;
 
   double  p, *q, hj, hj1, D, D1, mu;
 
-  ascend = (x[1] > x[0]) ? TRUE : FALSE;
-  xmin = (ascend) ? x[0] : x[N-1];
-  xmax = (ascend) ? x[N-1] : x[0];
+  /* --- Second derivatives M2 of the natural cubic spline through
+         (x, y). u is scratch space of length N. --    -------------- */
 
-  q = M = (double *) realloc(M, N * sizeof(double));
-  u = (double *) realloc(u, N * sizeof(double));
+  q = M2;
   hj = x[1] - x[0];
   D  = (y[1] - y[0]) / hj;
 
@@ -56,23 +50,30 @@ void splineCoef(int N, double *x, double *y)
     hj = hj1;  D = D1;
   }
 
-  M[N - 1] = 0.0;
+  M2[N - 1] = 0.0;
   for (j = N-2;  j >= 0;  j--) {
-    M[j] = q[j]*M[j+1] + u[j];
+    M2[j] = q[j]*M2[j+1] + u[j];
   }
-  Ntable = N;
-  xtable = x;  ytable = y;
 }
-/* ------- end ---------------------------- splineCoef.c ------------ */
+/* ------- end ---------------------------- splineTable.c ----------- */
 
-/* ---------------------------------------- splineEval.c ------------ */
+/* ------- begin -------------------------- splineTableEval.c ------- */
 
-void splineEval(int N, double *x, double *y, bool_t hunt)
+void splineTableEval(int Ntable, double *xtable, double *ytable,
+		     double *M2, int N, double *x, double *y, bool_t hunt)
 {
   register int n;
 
+  bool_t ascend;
   int    j = 0;
-  double hj, fx, fx1;
+  double hj, fx, fx1, xmin, xmax;
+
+  /* --- Evaluates at x the spline with second derivatives M2 from
+         splineTable --                                -------------- */
+
+  ascend = (xtable[1] > xtable[0]) ? TRUE : FALSE;
+  xmin = (ascend) ? xtable[0] : xtable[Ntable-1];
+  xmax = (ascend) ? xtable[Ntable-1] : xtable[0];
 
   for (n = 0;  n < N;  n++) {
     if (x[n] <= xmin)
@@ -90,8 +91,31 @@ void splineEval(int N, double *x, double *y, bool_t hunt)
       fx1 = 1 - fx;
 
       y[n] = fx1*ytable[j] + fx*ytable[j+1] +
-	(fx1*(SQ(fx1) - 1) * M[j] + fx*(SQ(fx) - 1) * M[j+1]) * SQ(hj)/6.0;
+	(fx1*(SQ(fx1) - 1) * M2[j] + fx*(SQ(fx) - 1) * M2[j+1]) * SQ(hj)/6.0;
     }
   }
 }
+/* ------- end ---------------------------- splineTableEval.c ------- */
+
+/* ------- begin -------------------------- splineCoef.c ------------ */
+
+void splineCoef(int N, double *x, double *y)
+{
+  static double *u = NULL;
+
+  M = (double *) realloc(M, N * sizeof(double));
+  u = (double *) realloc(u, N * sizeof(double));
+  splineTable(N, x, y, M, u);
+
+  Ntable = N;
+  xtable = x;  ytable = y;
+}
+/* ------- end ---------------------------- splineCoef.c ------------ */
+
+/* ---------------------------------------- splineEval.c ------------ */
+
+void splineEval(int N, double *x, double *y, bool_t hunt)
+{
+  splineTableEval(Ntable, xtable, ytable, M, N, x, y, hunt);
+}
 /* ------- end ---------------------------- splineEval.c ------------ */
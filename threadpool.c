@@ -0,0 +1,220 @@
+/* ------- file: -------------------------- threadpool.c ------------
+
+       Version:       rh2.0
+       Last modified: Sun Oct 18 2026 --
+
+       --------------------------                      ----------RH-- */
+
+/* --- Persistent pool of input.Nthreads worker threads. The threads
+       are created at the first call of runThreadPool and then wait
+       for work for the rest of the run. runThreadPool hands them
+       Ntask tasks, which they take off a shared counter one at a time
+       until none are left, so that a slow task does not hold up the
+       others. The caller waits until all tasks are done. With
+       STATIC_THREADS the worker in slot s takes tasks s, s + Nthreads,
+       ... instead, so that which thread does which task, and in which
+       order, is the same in every run.
+
+       Each worker has a fixed slot number 0 <= slot < input.Nthreads,
+       returned by threadSlot, to index per-thread scratch space such
+       as atom->rhth. Outside the pool threadSlot returns 0.
+
+       runThreadPool is not reentrant: tasks may not call it.
+       --                                              -------------- */
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "rh.h"
+#include "atom.h"
+#include "atmos.h"
+#include "spectrum.h"
+#include "error.h"
+#include "inputs.h"
+
+
+typedef struct {
+  pthread_t      *thread;
+  pthread_mutex_t lock;
+  pthread_cond_t  start, done;
+  pthread_key_t   slot;
+  int    Nthreads, Ntask, Nbusy, next;
+  long   generation;
+  void (*work)(int task, void *arg);
+  void  *arg;
+} ThreadPool;
+
+
+/* --- Function prototypes --                          -------------- */
+
+void *poolWorker(void *argument);
+
+
+/* --- Global variables --                             -------------- */
+
+extern Atmosphere atmos;
+extern Spectrum spectrum;
+extern InputData input;
+extern char messageStr[];
+
+static ThreadPool pool;
+
+
+/* ------- begin -------------------------- initThreadPool.c -------- */
+
+void initThreadPool(void)
+{
+  const char routineName[] = "initThreadPool";
+  register int nt;
+
+  int status;
+
+  if ((status = pthread_mutex_init(&pool.lock, NULL)) ||
+      (status = pthread_cond_init(&pool.start, NULL)) ||
+      (status = pthread_cond_init(&pool.done, NULL)) ||
+      (status = pthread_key_create(&pool.slot, NULL))) {
+    sprintf(messageStr, "Unable to initialize thread pool, status = %d",
+	    status);
+    Error(ERROR_LEVEL_2, routineName, messageStr);
+  }
+  pool.generation = 0;
+  pool.Nbusy      = 0;
+  pool.thread = (pthread_t *) malloc(input.Nthreads * sizeof(pthread_t));
+
+  for (nt = 0;  nt < input.Nthreads;  nt++) {
+    if ((status = pthread_create(&pool.thread[nt], &input.thread_attr,
+				 poolWorker, (void *) (intptr_t) nt))) {
+      sprintf(messageStr, "Unable to create thread %d, status = %d",
+	      nt, status);
+      Error(ERROR_LEVEL_2, routineName, messageStr);
+    }
+  }
+  pool.Nthreads = input.Nthreads;
+}
+/* ------- end ---------------------------- initThreadPool.c -------- */
+
+/* ------- begin -------------------------- poolWorker.c ------------ */
+
+void *poolWorker(void *argument)
+{
+  int  task, slot = (int) (intptr_t) argument;
+  long generation = 0;
+
+  /* --- Worker thread: waits for a new generation of tasks, works
+         through the tasks until the counter runs out, reports done
+         and waits again --                            -------------- */
+
+  pthread_setspecific(pool.slot, argument);
+
+  pthread_mutex_lock(&pool.lock);
+  for (;;) {
+    while (pool.generation == generation)
+      pthread_cond_wait(&pool.start, &pool.lock);
+    generation = pool.generation;
+    pthread_mutex_unlock(&pool.lock);
+
+    if (input.static_threads) {
+      for (task = slot;  task < pool.Ntask;  task += pool.Nthreads)
+	pool.work(task, pool.arg);
+    } else {
+      while ((task = __sync_fetch_and_add(&pool.next, 1)) < pool.Ntask)
+	pool.work(task, pool.arg);
+    }
+
+    pthread_mutex_lock(&pool.lock);
+    if (--pool.Nbusy == 0) pthread_cond_signal(&pool.done);
+  }
+  return NULL;
+}
+/* ------- end ---------------------------- poolWorker.c ------------ */
+
+/* ------- begin -------------------------- runThreadPool.c --------- */
+
+void runThreadPool(int Ntask, void (*work)(int task, void *arg), void *arg)
+{
+  /* --- Performs work(task, arg) for 0 <= task < Ntask in the pool,
+         in order of task number as far as threads are free, and
+         returns when all are done --                  -------------- */
+
+  if (Ntask == 0) return;
+  if (pool.Nthreads == 0) initThreadPool();
+
+  pthread_mutex_lock(&pool.lock);
+  pool.work  = work;
+  pool.arg   = arg;
+  pool.Ntask = Ntask;
+  pool.next  = 0;
+  pool.Nbusy = pool.Nthreads;
+  pool.generation++;
+  pthread_cond_broadcast(&pool.start);
+
+  while (pool.Nbusy > 0) pthread_cond_wait(&pool.done, &pool.lock);
+  pthread_mutex_unlock(&pool.lock);
+}
+/* ------- end ---------------------------- runThreadPool.c --------- */
+
+/* ------- begin -------------------------- threadSlot.c ------------ */
+
+int threadSlot(void)
+{
+  /* --- Slot number of the calling thread, 0 outside the pool -- --- */
+
+  if (pool.Nthreads == 0) return 0;
+  return (int) (intptr_t) pthread_getspecific(pool.slot);
+}
+/* ------- end ---------------------------- threadSlot.c ------------ */
+
+/* ------- begin -------------------------- spectrumQueue.c --------- */
+
+static double *queue_cost;
+
+static int queue_descend(const void *v1, const void *v2)
+{
+  double cost1 = queue_cost[*(int *) v1], cost2 = queue_cost[*(int *) v2];
+
+  if (cost1 > cost2)
+    return -1;
+  else if (cost1 < cost2)
+    return 1;
+  else
+    return *(int *) v1 - *(int *) v2;
+}
+
+int spectrumQueue(bool_t redistribute, int *queue)
+{
+  register int nspect, nact;
+
+  /* --- Fills queue with the wavelengths to solve, only those with an
+         active PRD line if redistribute is set, ordered by estimated
+         cost of their formal solution, most expensive first. The
+         estimate is the number of active transitions, times four
+         with polarized lines and times two with PRD lines. Returns
+         the number of wavelengths in queue. --        -------------- */
+
+  int     Nqueue = 0;
+  double  cost;
+  ActiveSet *as;
+
+  queue_cost = (double *) malloc(spectrum.Nspect * sizeof(double));
+
+  for (nspect = 0;  nspect < spectrum.Nspect;  nspect++) {
+    as = &spectrum.as[nspect];
+    if (redistribute  &&  !containsPRDline(as)) continue;
+
+    cost = 1.0;
+    for (nact = 0;  nact < atmos.Nactiveatom;  nact++)
+      cost += as->Nactiveatomrt[nact];
+    for (nact = 0;  nact < atmos.Nactivemol;  nact++)
+      cost += as->Nactivemolrt[nact];
+    if (containsPolarized(as)) cost *= 4.0;
+    if (containsPRDline(as))   cost *= 2.0;
+
+    queue_cost[nspect] = cost;
+    queue[Nqueue++]    = nspect;
+  }
+  qsort(queue, Nqueue, sizeof(int), queue_descend);
+
+  free(queue_cost);
+  return Nqueue;
+}
+/* ------- end ---------------------------- spectrumQueue.c --------- */